@@ -11,6 +11,12 @@ DEPROOT := $(LOCAL_PATH)/dep
 COMMON_OPT_CFLAGS := -march=armv6j -mtune=arm1136j-s -msoft-float
 COMMON_OPT_CPPFLAGS := -march=armv6j -mtune=arm1136j-s -msoft-float
 
+# the -7 variants of the core and of the hot plugins
+# armv7-a/neon, softfp keeps them ABI compatible with the armv6j ones
+# loaded instead of the default ones when the CPU reports NEON
+COMMON_ARMV7_CFLAGS := -march=armv7-a -mtune=cortex-a8 -mfloat-abi=softfp -mfpu=neon
+COMMON_ARMV7_CPPFLAGS := -march=armv7-a -mtune=cortex-a8 -mfloat-abi=softfp -mfpu=neon
+
 include $(CLEAR_VARS)
 
 include $(call all-makefiles-under,$(LOCAL_PATH))
@@ -1,13 +1,6 @@
-
 LOCAL_PATH:= $(call my-dir)
 
-include $(CLEAR_VARS)
-
-LOCAL_ARM_MODE := arm
-
-LOCAL_MODULE := vlccore
-
-LOCAL_CFLAGS += \
+VLCCORE_CFLAGS := \
     -D__arm__ \
     -D__linux__ \
     -std=c99 \
@@ -23,9 +16,7 @@ LOCAL_CFLAGS += \
     -DPKGLIBDIR=\"/data/data/\"PACKAGENAME\"/cache/lib\" \
     -DICONV_CONST=
 
-LOCAL_CFLAGS += $(COMMON_OPT_CFLAGS)
-
-LOCAL_C_INCLUDES += \
+VLCCORE_C_INCLUDES := \
     $(VLCROOT)/compat \
     $(VLCROOT) \
     $(VLCROOT)/include \
@@ -33,7 +24,7 @@ LOCAL_C_INCLUDES += \
     $(EXTROOT)/cpufeatures \
     $(EXTROOT)/iconv/include
 
-LOCAL_SRC_FILES := \
+VLCCORE_SRC_FILES := \
     src/jni.c \
     src/libvlc-module.c \
     src/libvlc.c \
@@ -176,6 +167,21 @@ LOCAL_SRC_FILES := \
     src/video_output/vout_wrapper.c \
     src/video_output/window.c
 
+# libvlccore.so
+
+include $(CLEAR_VARS)
+
+LOCAL_ARM_MODE := arm
+
+LOCAL_MODULE := vlccore
+
+LOCAL_CFLAGS += $(VLCCORE_CFLAGS)
+LOCAL_CFLAGS += $(COMMON_OPT_CFLAGS)
+
+LOCAL_C_INCLUDES += $(VLCCORE_C_INCLUDES)
+
+LOCAL_SRC_FILES := $(VLCCORE_SRC_FILES)
+
 LOCAL_LDLIBS += -llog
 
 LOCAL_STATIC_LIBRARIES += compat pthread-compat cpufeatures 
@@ -186,5 +192,34 @@ LOCAL_WHOLE_STATIC_LIBRARIES += iconv charset freetype ass
 
 include $(BUILD_SHARED_LIBRARY)
 
+# libvlccore-7.so
+
+include $(CLEAR_VARS)
+
+LOCAL_ARM_MODE := arm
+
+LOCAL_MODULE := vlccore-7
+
+LOCAL_CFLAGS += $(VLCCORE_CFLAGS)
+LOCAL_CFLAGS += $(COMMON_ARMV7_CFLAGS)
+
+LOCAL_C_INCLUDES += $(VLCCORE_C_INCLUDES)
+
+LOCAL_SRC_FILES := $(VLCCORE_SRC_FILES)
+
+LOCAL_LDLIBS += -llog
+
+# the plugins are linked against libvlccore.so, keep the soname so that
+# this one can stand in for it, see org.videolan.VLC.load()
+LOCAL_LDFLAGS += -Wl,-soname,libvlccore.so
+
+LOCAL_STATIC_LIBRARIES += compat pthread-compat cpufeatures 
+
+# please try to use the latest NDK
+# http://code.google.c \om/p/android/issues/detail?id=9439
+LOCAL_WHOLE_STATIC_LIBRARIES += iconv charset freetype ass
+
+include $(BUILD_SHARED_LIBRARY)
+
 include $(call all-makefiles-under,$(LOCAL_PATH))
 
@@ -167,6 +167,7 @@ static inline void block_Release( block_t *p_block )
 
 VLC_EXPORT( block_t *, block_heap_Alloc, (void *, void *, size_t) LIBVLC_USED );
 VLC_EXPORT( block_t *, block_mmap_Alloc, (void *addr, size_t length) LIBVLC_USED );
+VLC_EXPORT( block_t *, block_foreign_Alloc, (void *, void (*)(void *), void *, size_t, size_t) LIBVLC_USED );
 VLC_EXPORT( block_t *, block_File, (int fd) LIBVLC_USED );
 
 static inline void block_Cleanup (void *block)
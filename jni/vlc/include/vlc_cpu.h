@@ -58,8 +58,12 @@
 
 # if defined (__arm__)
 #  define CPU_CAPABILITY_NEON    (1<<24)
+#  define CPU_CAPABILITY_ARMv7   (1<<25)
+#  define CPU_CAPABILITY_VFPv3   (1<<26)
 # else
 #  define CPU_CAPABILITY_NEON    (0)
+#  define CPU_CAPABILITY_ARMv7   (0)
+#  define CPU_CAPABILITY_VFPv3   (0)
 # endif
 
 VLC_EXPORT( unsigned, vlc_CPU, ( void ) );
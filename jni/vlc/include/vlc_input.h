@@ -456,6 +456,9 @@ enum input_query_e
     /* input variable "time" */
     INPUT_GET_TIME,             /* arg1= int64_t *      res=    */
     INPUT_SET_TIME,             /* arg1= int64_t        res=can fail    */
+    /* same, for a fast (true) or a precise (false) seek instead of the
+     * input-fast-seek setting of the input */
+    INPUT_SEEK_TIME,            /* arg1= int64_t, arg2= bool    res=can fail */
 
     /* input variable "rate" (nominal is INPUT_RATE_DEFAULT) */
     INPUT_GET_RATE,             /* arg1= int *          res=    */
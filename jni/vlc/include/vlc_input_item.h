@@ -281,6 +281,8 @@ struct input_stats_t
     int64_t i_read_bytes;
     float f_input_bitrate;
     float f_average_input_bitrate;
+    int64_t i_stream_cache_size;    /* bytes held by the stream cache */
+    int64_t i_stream_cache_resizes;
 
     /* Demux */
     int64_t i_demux_read_packets;
@@ -297,6 +299,7 @@ struct input_stats_t
     /* Vout */
     int64_t i_displayed_pictures;
     int64_t i_lost_pictures;
+    int64_t i_copied_pictures;
 
     /* Sout */
     int64_t i_sent_packets;
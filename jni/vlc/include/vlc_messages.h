@@ -187,6 +187,7 @@ enum
     STATS_SOUT_SEND_BITRATE,
     STATS_DISPLAYED_PICTURES,
     STATS_LOST_PICTURES,
+    STATS_COPIED_PICTURES,
 
     STATS_TIMER_PLAYLIST_BUILD,
     STATS_TIMER_ML_LOAD,
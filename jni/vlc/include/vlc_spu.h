@@ -97,6 +97,15 @@ VLC_EXPORT( void, spu_ClearChannel, ( spu_t *, int ) );
  */
 VLC_EXPORT( void, spu_ChangeFilters, ( spu_t *, const char * ) );
 
+/**
+ * It returns the input the spu is attached to, or NULL.
+ *
+ * The sub filters are children of the spu, so they can follow the input
+ * whoever created it. The returned value if non NULL must be released by
+ * vlc_object_release().
+ */
+VLC_EXPORT( input_thread_t *, spu_HoldInput, ( spu_t * ) ) LIBVLC_USED;
+
 /** @}*/
 
 #ifdef __cplusplus
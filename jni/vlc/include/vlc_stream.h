@@ -111,6 +111,10 @@ enum stream_query_e
 
     /* XXX only data read through stream_Read/Block will be recorded */
     STREAM_SET_RECORD_STATE,     /**< arg1=bool, arg2=const char *psz_ext (if arg1 is true)  res=can fail */
+
+    /* Takes the INPUT_UPDATE_* flags of the access with its title and
+     * seekpoint, while no read-ahead thread is inside the access */
+    STREAM_GET_ACCESS_UPDATE,    /**< arg1= int *pi_update, arg2= int *pi_title, arg3= int *pi_seekpoint  res=can fail */
 };
 
 VLC_EXPORT( int, stream_Read, ( stream_t *s, void *p_read, int i_read ) );
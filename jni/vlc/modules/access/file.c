@@ -62,6 +62,9 @@
 #   include <unistd.h>
 #endif
 #include <dirent.h>
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 
 #if defined( WIN32 ) && !defined( UNDER_CE )
 #   ifdef lseek
@@ -76,11 +79,15 @@
 #include <vlc_fs.h>
 #include <vlc_url.h>
 
+/* Size of the windows mapped by FileBlock() */
+#define FILE_MMAP_SIZE (1 << 20)
+
 struct access_sys_t
 {
     unsigned int i_nb_reads;
 
     int fd;
+    size_t page_size;
 
     /* */
     unsigned caching;
@@ -216,8 +223,10 @@ int Open( vlc_object_t *p_this )
     p_access->p_sys = p_sys;
     p_sys->i_nb_reads = 0;
     p_sys->fd = fd;
+    p_sys->page_size = 0;
     p_sys->caching = var_InheritInteger (p_access, "file-caching");
-    if (IsRemote(fd))
+    const bool b_remote = IsRemote(fd);
+    if (b_remote)
         p_sys->caching += var_InheritInteger (p_access, "network-caching");
     p_sys->b_pace_control = true;
 
@@ -246,6 +255,23 @@ int Open( vlc_object_t *p_this )
 # endif
 #endif
     }
+
+#ifdef HAVE_MMAP
+    /* Map local regular files instead of reading them. Remote files could
+     * be truncated behind our back (SIGBUS) and off_t must address the
+     * whole file. The stream does not start its read-ahead thread for
+     * pf_block, the kernel reads the windows ahead (see FileBlock()). */
+    if (S_ISREG (st.st_mode) && !b_remote
+     && (sizeof (off_t) >= 8 || st.st_size <= INT32_MAX - FILE_MMAP_SIZE)
+     && var_InheritBool (p_access, "file-mmap"))
+    {
+        p_access->pf_read = NULL;
+        p_access->pf_block = FileBlock;
+        p_sys->page_size = sysconf (_SC_PAGESIZE);
+        msg_Dbg (p_access, "mapping file in windows of %u KiB",
+                 FILE_MMAP_SIZE / 1024);
+    }
+#endif
     return VLC_SUCCESS;
 
 error:
@@ -260,7 +286,7 @@ void Close (vlc_object_t * p_this)
 {
     access_t     *p_access = (access_t*)p_this;
 
-    if (p_access->pf_read == NULL)
+    if (p_access->pf_block == DirBlock)
     {
         DirClose (p_this);
         return;
@@ -332,6 +358,69 @@ ssize_t FileRead( access_t *p_access, uint8_t *p_buffer, size_t i_len )
 }
 
 
+#ifdef HAVE_MMAP
+/*****************************************************************************
+ * Block: map a window of the file, the block points into the mapping.
+ *****************************************************************************/
+block_t *FileBlock (access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    struct stat st;
+
+    /* The file may have changed, and touching a page past its end
+     * would raise SIGBUS */
+    if ((fstat (p_sys->fd, &st) == 0)
+     && (p_access->info.i_size != (uint64_t)st.st_size))
+    {
+        p_access->info.i_size = st.st_size;
+        p_access->info.i_update |= INPUT_UPDATE_SIZE;
+    }
+
+    if (p_access->info.i_pos >= p_access->info.i_size)
+    {
+        p_access->info.b_eof = true;
+        return NULL;
+    }
+
+    /* Start the mapping on a page boundary */
+    const uint64_t page_mask = p_sys->page_size - 1;
+    uint64_t outer_offset = p_access->info.i_pos & ~page_mask;
+    size_t inner_offset = p_access->info.i_pos & page_mask;
+    size_t length = FILE_MMAP_SIZE;
+    if (outer_offset + length > p_access->info.i_size)
+        length = p_access->info.i_size - outer_offset;
+
+    /* MAP_PRIVATE: the block may be modified down the chain without
+     * touching the file */
+    void *addr = mmap (NULL, length, PROT_READ|PROT_WRITE, MAP_PRIVATE,
+                       p_sys->fd, outer_offset);
+    if (addr == MAP_FAILED)
+    {
+        msg_Err (p_access, "memory mapping failed (%m)");
+        dialog_Fatal (p_access, _("File reading failed"), "%s",
+                      _("VLC could not read the file."));
+        p_access->info.b_eof = true;
+        return NULL;
+    }
+    /* Read the window ahead, in order */
+    madvise (addr, length, MADV_WILLNEED);
+    madvise (addr, length, MADV_SEQUENTIAL);
+
+    block_t *block = block_mmap_Alloc (addr, length);
+    if (block == NULL)
+    {
+        p_access->info.b_eof = true;
+        return NULL;
+    }
+    block->p_buffer += inner_offset;
+    block->i_buffer -= inner_offset;
+
+    p_access->info.i_pos = outer_offset + length;
+    p_sys->i_nb_reads++;
+    return block;
+}
+#endif
+
 /*****************************************************************************
  * Seek: seek to a specific location in a file
  *****************************************************************************/
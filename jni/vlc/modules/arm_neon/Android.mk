@@ -0,0 +1,100 @@
+LOCAL_PATH := $(call my-dir)
+
+# NEON only, so there are no -6 variants
+
+# libaudio_format_neon_plugin-7.so
+
+include $(CLEAR_VARS)
+
+LOCAL_ARM_MODE := arm
+
+LOCAL_MODULE := audio_format_neon_plugin-7
+
+LOCAL_CFLAGS += \
+    -std=gnu99 \
+    -D__THROW= \
+    -DHAVE_CONFIG_H \
+    -DNDEBUG \
+    -D__PLUGIN__ \
+    -DMODULE_STRING=\"audio_format_neon\"
+
+LOCAL_CFLAGS += $(COMMON_ARMV7_CFLAGS)
+
+LOCAL_C_INCLUDES += \
+    $(VLCROOT)/compat \
+    $(VLCROOT) \
+    $(VLCROOT)/include \
+    $(VLCROOT)/src
+
+LOCAL_SRC_FILES := \
+    audio_format.c \
+    s32_s16.S
+
+LOCAL_SHARED_LIBRARIES += vlccore
+
+include $(BUILD_SHARED_LIBRARY)
+
+# libi420_yuy2_neon_plugin-7.so
+
+include $(CLEAR_VARS)
+
+LOCAL_ARM_MODE := arm
+
+LOCAL_MODULE := i420_yuy2_neon_plugin-7
+
+LOCAL_CFLAGS += \
+    -std=gnu99 \
+    -D__THROW= \
+    -DHAVE_CONFIG_H \
+    -DNDEBUG \
+    -D__PLUGIN__ \
+    -DMODULE_STRING=\"i420_yuy2_neon\"
+
+LOCAL_CFLAGS += $(COMMON_ARMV7_CFLAGS)
+
+LOCAL_C_INCLUDES += \
+    $(VLCROOT)/compat \
+    $(VLCROOT) \
+    $(VLCROOT)/include \
+    $(VLCROOT)/src
+
+LOCAL_SRC_FILES := \
+    i420_yuy2.c \
+    i420_yuyv.S
+
+LOCAL_SHARED_LIBRARIES += vlccore
+
+include $(BUILD_SHARED_LIBRARY)
+
+# libi420_rgb_neon_plugin-7.so
+
+include $(CLEAR_VARS)
+
+LOCAL_ARM_MODE := arm
+
+LOCAL_MODULE := i420_rgb_neon_plugin-7
+
+LOCAL_CFLAGS += \
+    -std=gnu99 \
+    -D__THROW= \
+    -DHAVE_CONFIG_H \
+    -DNDEBUG \
+    -D__PLUGIN__ \
+    -DMODULE_STRING=\"i420_rgb_neon\"
+
+LOCAL_CFLAGS += $(COMMON_ARMV7_CFLAGS)
+
+LOCAL_C_INCLUDES += \
+    $(VLCROOT)/compat \
+    $(VLCROOT) \
+    $(VLCROOT)/include \
+    $(VLCROOT)/src
+
+LOCAL_SRC_FILES := \
+    i420_rgb.c \
+    i420_rgb565.S
+
+LOCAL_SHARED_LIBRARIES += vlccore
+
+include $(BUILD_SHARED_LIBRARY)
+
@@ -26,24 +26,37 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
+#include <vlc_modules.h>
+#include <vlc_cpu.h>
 
 #include <assert.h>
 
 static int Open (vlc_object_t *);
 
+#define BENCH_TEXT N_("Benchmark against converter_fixed")
+#define BENCH_LONGTEXT N_( \
+    "Compare the speed of these conversions with the C ones when they are " \
+    "opened.")
+
 vlc_module_begin ()
     set_description (N_("ARM NEON audio format conversions") )
     set_capability ("audio filter", 20)
+    add_bool ("neon-audio-benchmark", false, BENCH_TEXT, BENCH_LONGTEXT,
+              true)
     set_callbacks (Open, NULL)
 vlc_module_end ()
 
 static block_t *Do_F32_S32 (filter_t *, block_t *);
+static block_t *Do_F32_S16 (filter_t *, block_t *);
 static block_t *Do_S32_S16 (filter_t *, block_t *);
+static void Benchmark (filter_t *);
 
 static int Open (vlc_object_t *obj)
 {
     filter_t *filter = (filter_t *)obj;
 
+    if (!(vlc_CPU () & CPU_CAPABILITY_NEON))
+        return VLC_EGENERIC;
     if (!AOUT_FMTS_SIMILAR (&filter->fmt_in.audio, &filter->fmt_out.audio))
         return VLC_EGENERIC;
 
@@ -55,6 +68,9 @@ static int Open (vlc_object_t *obj)
                 case VLC_CODEC_FI32:
                     filter->pf_audio_filter = Do_F32_S32;
                     break;
+                case VLC_CODEC_S16N:
+                    filter->pf_audio_filter = Do_F32_S16;
+                    break;
                 default:
                     return VLC_EGENERIC;
             }
@@ -73,6 +89,9 @@ static int Open (vlc_object_t *obj)
         default:
             return VLC_EGENERIC;
     }
+
+    if (var_InheritBool (obj, "neon-audio-benchmark"))
+        Benchmark (filter);
     return VLC_SUCCESS;
 }
 
@@ -129,6 +148,70 @@ static block_t *Do_F32_S32 (filter_t *filter, block_t *inbuf)
     return inbuf;
 }
 
+/**
+ * Single-precision floating point to signed 16-bits integer conversion,
+ * saves the intermediate FI32 pass of the fixed point pipeline.
+ * Samples are scaled by 2^16 with saturation, then rounded to 2^15.
+ */
+static block_t *Do_F32_S16 (filter_t *filter, block_t *inbuf)
+{
+    unsigned nb_samples = inbuf->i_nb_samples
+                     * aout_FormatNbChannels (&filter->fmt_in.audio);
+    const float *inp = (const float *)inbuf->p_buffer;
+    const float *endp = inp + nb_samples;
+    int16_t *outp = (int16_t *)inbuf->p_buffer;
+
+    /* in place: the output never catches up with the input */
+    if (nb_samples & 1)
+    {
+        asm volatile (
+            "vldr.32 s0, [%[inp]]\n"
+            "vcvt.s32.f32 d0, d0, #16\n"
+            "vqrshrn.s32 d4, q0, #1\n"
+            "vst1.16 {d4[0]}, [%[outp]]!\n"
+            : [outp] "+r" (outp)
+            : [inp] "r" (inp)
+            : "q0", "d4", "memory");
+        inp++;
+    }
+
+    if (nb_samples & 2)
+        asm volatile (
+            "vld1.f32 {d0}, [%[inp]]!\n"
+            "vcvt.s32.f32 d0, d0, #16\n"
+            "vqrshrn.s32 d4, q0, #1\n"
+            "vst1.16 {d4[0]}, [%[outp]]!\n"
+            "vst1.16 {d4[1]}, [%[outp]]!\n"
+            : [outp] "+r" (outp), [inp] "+r" (inp)
+            :
+            : "q0", "d4", "memory");
+
+    if (nb_samples & 4)
+        asm volatile (
+            "vld1.f32 {q0}, [%[inp]]!\n"
+            "vcvt.s32.f32 q0, q0, #16\n"
+            "vqrshrn.s32 d4, q0, #1\n"
+            "vst1.16 {d4}, [%[outp]]!\n"
+            : [outp] "+r" (outp), [inp] "+r" (inp)
+            :
+            : "q0", "d4", "memory");
+
+    while (inp != endp)
+        asm volatile (
+            "vld1.f32 {q0-q1}, [%[inp]]!\n"
+            "vcvt.s32.f32 q0, q0, #16\n"
+            "vcvt.s32.f32 q1, q1, #16\n"
+            "vqrshrn.s32 d4, q0, #1\n"
+            "vqrshrn.s32 d5, q1, #1\n"
+            "vst1.16 {q2}, [%[outp]]!\n"
+            : [outp] "+r" (outp), [inp] "+r" (inp)
+            :
+            : "q0", "q1", "q2", "memory");
+
+    inbuf->i_buffer /= 2;
+    return inbuf;
+}
+
 void s32_s16_neon_unaligned (int16_t *out, const int32_t *in, unsigned nb);
 void s32_s16_neon (int16_t *out, const int32_t *in, unsigned nb);
 
@@ -158,3 +241,128 @@ static block_t *Do_S32_S16 (filter_t *filter, block_t *inbuf)
     inbuf->i_buffer /= 2;
     return inbuf;
 }
+
+/*****************************************************************************
+ * Benchmark
+ *****************************************************************************/
+static block_t *Convert (filter_t *filter, const void *in, size_t size,
+                         unsigned nb_samples)
+{
+    block_t *block = block_Alloc (size);
+    if (block == NULL)
+        return NULL;
+    memcpy (block->p_buffer, in, size);
+    block->i_nb_samples = nb_samples;
+    return filter->pf_audio_filter (filter, block);
+}
+
+/**
+ * Runs the same conversion through converter_fixed (FL32 goes through FI32
+ * there) and through this module, checks both agree within one LSB and
+ * logs timings. Block allocation and copy are included in both timings.
+ */
+static void Benchmark (filter_t *filter)
+{
+    const vlc_fourcc_t from = filter->fmt_in.audio.i_format;
+    const vlc_fourcc_t to = filter->fmt_out.audio.i_format;
+    const unsigned frames = 1024, runs = 200;
+    const unsigned nb = frames * aout_FormatNbChannels (&filter->fmt_in.audio);
+    const size_t size = nb * 4;
+    filter_t *ref[2] = { NULL, NULL };
+    unsigned refs = 0;
+    void *in = malloc (size);
+    uint32_t seed = 0x12345678;
+
+    if (to != VLC_CODEC_S16N || in == NULL)
+        goto out;
+
+    /* a bit more than full scale, to exercise saturation */
+    for (unsigned i = 0; i < nb; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        float f = ((int32_t)seed) / (float)INT32_MAX * 1.1f;
+        if (from == VLC_CODEC_FL32)
+            ((float *)in)[i] = f;
+        else
+            ((int32_t *)in)[i] = f * (1 << 28);
+    }
+
+    if (from == VLC_CODEC_FL32)
+    {
+        ref[refs++] = vlc_object_create (filter, sizeof (filter_t));
+        ref[refs++] = vlc_object_create (filter, sizeof (filter_t));
+    }
+    else
+        ref[refs++] = vlc_object_create (filter, sizeof (filter_t));
+
+    for (unsigned i = 0; i < refs; i++)
+    {
+        if (ref[i] == NULL)
+            goto out;
+        ref[i]->fmt_in.audio = filter->fmt_in.audio;
+        ref[i]->fmt_out.audio = filter->fmt_out.audio;
+        if (i > 0 || refs == 1)
+            ref[i]->fmt_in.audio.i_format = VLC_CODEC_FI32;
+        if (i < refs - 1)
+            ref[i]->fmt_out.audio.i_format = VLC_CODEC_FI32;
+        ref[i]->fmt_in.i_codec = ref[i]->fmt_in.audio.i_format;
+        ref[i]->fmt_out.i_codec = ref[i]->fmt_out.audio.i_format;
+        ref[i]->p_module = module_need (ref[i], "audio filter",
+                                        "converter_fixed", true);
+        if (ref[i]->p_module == NULL)
+        {
+            msg_Warn (filter, "benchmark: converter_fixed not available");
+            goto out;
+        }
+    }
+
+    block_t *a = NULL, *b = NULL;
+    mtime_t t0 = mdate ();
+    for (unsigned i = 0; i < runs; i++)
+    {
+        block_t *block = Convert (ref[0], in, size, frames);
+        if (block != NULL && refs > 1)
+            block = ref[1]->pf_audio_filter (ref[1], block);
+        if (a != NULL)
+            block_Release (a);
+        a = block;
+    }
+    mtime_t t1 = mdate ();
+    for (unsigned i = 0; i < runs; i++)
+    {
+        block_t *block = Convert (filter, in, size, frames);
+        if (b != NULL)
+            block_Release (b);
+        b = block;
+    }
+    mtime_t t2 = mdate ();
+
+    if (a != NULL && b != NULL)
+    {
+        const int16_t *pa = (const int16_t *)a->p_buffer;
+        const int16_t *pb = (const int16_t *)b->p_buffer;
+        int diff = 0;
+
+        for (unsigned i = 0; i < nb; i++)
+            if (abs (pa[i] - pb[i]) > diff)
+                diff = abs (pa[i] - pb[i]);
+        msg_Info (filter, "benchmark %4.4s->%4.4s, %u samples: "
+                  "converter_fixed %"PRId64" us, NEON %"PRId64" us per block, "
+                  "max difference %d%s", (const char *)&from,
+                  (const char *)&to, nb, (t1 - t0) / runs, (t2 - t1) / runs,
+                  diff, (diff > 1) ? " (MISMATCH)" : "");
+    }
+    if (a != NULL)
+        block_Release (a);
+    if (b != NULL)
+        block_Release (b);
+out:
+    for (unsigned i = 0; i < refs; i++)
+        if (ref[i] != NULL)
+        {
+            if (ref[i]->p_module != NULL)
+                module_unneed (ref[i], ref[i]->p_module);
+            vlc_object_release (ref[i]);
+        }
+    free (in);
+}
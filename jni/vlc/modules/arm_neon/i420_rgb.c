@@ -0,0 +1,230 @@
+/*****************************************************************************
+ * i420_rgb.c : ARM NEONv1 YUV 4:2:0 to RGB 5:6:5 chroma conversion for VLC
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+#include <vlc_cpu.h>
+
+#include "i420_rgb565.h"
+
+static int Open (vlc_object_t *);
+
+#define BENCH_TEXT N_("Benchmark against i420_rgb")
+#define BENCH_LONGTEXT N_( \
+    "Compare the speed of this converter with the C one when it is opened.")
+
+vlc_module_begin ()
+    set_description (N_("ARM NEON YUV to RGB conversions"))
+    set_capability ("video filter2", 250)
+    add_bool ("neon-chroma-benchmark", false, BENCH_TEXT, BENCH_LONGTEXT,
+              true)
+    set_callbacks (Open, NULL)
+vlc_module_end ()
+
+/**
+ * Reference for i420_rgb565_neon(), also converts the width % 16 tail.
+ */
+static void i420_rgb565_c (uint16_t *dst, const uint8_t *y, const uint8_t *u,
+                           const uint8_t *v, unsigned width)
+{
+    for (unsigned i = 0; i < width; i++)
+        dst[i] = yuv_rgb565 (y[i], u[i / 2], v[i / 2]);
+}
+
+static void I420_RGB565 (filter_t *filter, picture_t *src, picture_t *dst)
+{
+    const unsigned width = filter->fmt_in.video.i_width;
+    const unsigned height = filter->fmt_in.video.i_height;
+    const unsigned fast = width & ~15;
+    /* YV12 only differs by the order of the chroma planes */
+    const bool yv12 = filter->fmt_in.video.i_chroma == VLC_CODEC_YV12;
+    const plane_t *py = &src->p[Y_PLANE];
+    const plane_t *pu = &src->p[yv12 ? V_PLANE : U_PLANE];
+    const plane_t *pv = &src->p[yv12 ? U_PLANE : V_PLANE];
+
+    for (unsigned j = 0; j < height; j++)
+    {
+        uint16_t *out = (uint16_t *)(dst->p->p_pixels + j * dst->p->i_pitch);
+        const uint8_t *y = py->p_pixels + j * py->i_pitch;
+        const uint8_t *u = pu->p_pixels + (j / 2) * pu->i_pitch;
+        const uint8_t *v = pv->p_pixels + (j / 2) * pv->i_pitch;
+
+        if (fast)
+            i420_rgb565_neon (out, y, u, v, fast);
+        if (fast != width)
+            i420_rgb565_c (out + fast, y + fast, u + fast / 2, v + fast / 2,
+                           width - fast);
+    }
+}
+
+VIDEO_FILTER_WRAPPER (I420_RGB565)
+
+/*****************************************************************************
+ * Benchmark
+ *****************************************************************************/
+static picture_t *NewPicture (filter_t *filter)
+{
+    return picture_NewFromFormat (&filter->fmt_out.video);
+}
+
+static void DelPicture (filter_t *filter, picture_t *pic)
+{
+    VLC_UNUSED(filter);
+    picture_Release (pic);
+}
+
+static void Run (filter_t *filter, picture_t *src)
+{
+    picture_Hold (src); /* the filters release their input */
+    picture_t *pic = filter->pf_video_filter (filter, src);
+    if (pic != NULL)
+        picture_Release (pic);
+}
+
+static void Benchmark (filter_t *filter)
+{
+    const int runs = 20;
+    filter_t *ref = vlc_object_create (filter, sizeof (*ref));
+    picture_t *src = picture_NewFromFormat (&filter->fmt_in.video);
+    picture_t *out = NULL;
+    uint32_t seed = 0x12345678;
+
+    if (ref == NULL || src == NULL)
+        goto out;
+
+    for (int i = 0; i < src->i_planes; i++)
+        for (int j = 0; j < src->p[i].i_lines * src->p[i].i_pitch; j++)
+        {
+            seed = seed * 1103515245 + 12345;
+            src->p[i].p_pixels[j] = seed >> 24;
+        }
+
+    es_format_Copy (&ref->fmt_in, &filter->fmt_in);
+    es_format_Copy (&ref->fmt_out, &filter->fmt_out);
+    ref->pf_video_buffer_new = NewPicture;
+    ref->pf_video_buffer_del = DelPicture;
+    ref->p_module = module_need (ref, "video filter2", "i420_rgb", true);
+    if (ref->p_module == NULL)
+    {
+        msg_Warn (filter, "benchmark: i420_rgb not available");
+        goto out;
+    }
+
+    /* do not draw pictures from the owner pool */
+    picture_t *(*pf_new) (filter_t *) = filter->pf_video_buffer_new;
+    void (*pf_del) (filter_t *, picture_t *) = filter->pf_video_buffer_del;
+    filter->pf_video_buffer_new = NewPicture;
+    filter->pf_video_buffer_del = DelPicture;
+
+    mtime_t t0 = mdate ();
+    for (int i = 0; i < runs; i++)
+        Run (ref, src);
+    mtime_t t1 = mdate ();
+    for (int i = 0; i < runs; i++)
+        Run (filter, src);
+    mtime_t t2 = mdate ();
+
+    /* the NEON kernel must match its C reference */
+    out = NewPicture (filter);
+    picture_Hold (src);
+    picture_t *res = filter->pf_video_filter (filter, src);
+    if (out != NULL && res != NULL)
+    {
+        const unsigned width = filter->fmt_in.video.i_width;
+        bool ok = true;
+
+        for (unsigned j = 0; j < filter->fmt_in.video.i_height; j++)
+        {
+            const plane_t *py = &src->p[Y_PLANE], *pu = &src->p[U_PLANE],
+                          *pv = &src->p[V_PLANE];
+            uint16_t *a = (uint16_t *)(out->p->p_pixels + j * out->p->i_pitch);
+            const uint16_t *b =
+                (uint16_t *)(res->p->p_pixels + j * res->p->i_pitch);
+
+            if (filter->fmt_in.video.i_chroma == VLC_CODEC_YV12)
+                pu = &src->p[V_PLANE], pv = &src->p[U_PLANE];
+            i420_rgb565_c (a, py->p_pixels + j * py->i_pitch,
+                           pu->p_pixels + (j / 2) * pu->i_pitch,
+                           pv->p_pixels + (j / 2) * pv->i_pitch, width);
+            ok = ok && !memcmp (a, b, width * 2);
+        }
+        msg_Info (filter, "benchmark %ux%u: i420_rgb %"PRId64" us, NEON "
+                  "%"PRId64" us per picture, output %s",
+                  width, filter->fmt_in.video.i_height,
+                  (t1 - t0) / runs, (t2 - t1) / runs, ok ? "ok" : "MISMATCH");
+    }
+    if (res != NULL)
+        picture_Release (res);
+    filter->pf_video_buffer_new = pf_new;
+    filter->pf_video_buffer_del = pf_del;
+    module_unneed (ref, ref->p_module);
+out:
+    if (out != NULL)
+        picture_Release (out);
+    if (src != NULL)
+        picture_Release (src);
+    if (ref != NULL)
+    {
+        es_format_Clean (&ref->fmt_in);
+        es_format_Clean (&ref->fmt_out);
+        vlc_object_release (ref);
+    }
+}
+
+static int Open (vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+    const video_format_t *fmt = &filter->fmt_out.video;
+
+    if (!(vlc_CPU () & CPU_CAPABILITY_NEON))
+        return VLC_EGENERIC;
+
+    if (((filter->fmt_in.video.i_width | filter->fmt_in.video.i_height) & 1)
+     || (filter->fmt_in.video.i_width != filter->fmt_out.video.i_width)
+     || (filter->fmt_in.video.i_height != filter->fmt_out.video.i_height))
+        return VLC_EGENERIC;
+
+    switch (filter->fmt_in.video.i_chroma)
+    {
+        case VLC_CODEC_YV12:
+        case VLC_CODEC_I420:
+            if (fmt->i_chroma != VLC_CODEC_RGB16)
+                return VLC_EGENERIC;
+            /* R5G6B5 only */
+            if ((fmt->i_rmask | fmt->i_gmask | fmt->i_bmask)
+             && (fmt->i_rmask != 0xf800 || fmt->i_gmask != 0x07e0
+              || fmt->i_bmask != 0x001f))
+                return VLC_EGENERIC;
+            filter->pf_video_filter = I420_RGB565_Filter;
+            break;
+
+        default:
+            return VLC_EGENERIC;
+    }
+
+    if (var_InheritBool (obj, "neon-chroma-benchmark"))
+        Benchmark (filter);
+    return VLC_SUCCESS;
+}
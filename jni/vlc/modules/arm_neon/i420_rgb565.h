@@ -0,0 +1,62 @@
+/*****************************************************************************
+ * i420_rgb565.h : ARM NEONv1 YUV 4:2:0 to RGB 5:6:5 line kernels
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_ARM_NEON_I420_RGB565_H
+#define VLC_ARM_NEON_I420_RGB565_H 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Convert one line, width must be a non-zero multiple of 16 */
+void i420_rgb565_neon (uint16_t *dst, const uint8_t *y, const uint8_t *u,
+                       const uint8_t *v, unsigned width);
+void nv12_rgb565_neon (uint16_t *dst, const uint8_t *y, const uint8_t *uv,
+                       unsigned width);
+
+#ifdef __cplusplus
+}
+#endif
+
+static inline int yuv_rgb565_sat16 (int v)
+{
+    return (v > INT16_MAX) ? INT16_MAX : (v < INT16_MIN) ? INT16_MIN : v;
+}
+
+static inline unsigned yuv_rgb565_clip8 (int v)
+{
+    v = (v + 32) >> 6;
+    return (v > 255) ? 255 : (v < 0) ? 0 : v;
+}
+
+/**
+ * Converts one pixel the way the NEON kernels do, see i420_rgb565.S.
+ */
+static inline uint16_t yuv_rgb565 (int y, int u, int v)
+{
+    int l = 74 * y - 1184;
+    int cu = u - 128, cv = v - 128;
+    unsigned r = yuv_rgb565_clip8 (yuv_rgb565_sat16 (l + 102 * cv));
+    unsigned g = yuv_rgb565_clip8 (yuv_rgb565_sat16 (l - (52 * cv + 25 * cu)));
+    unsigned b = yuv_rgb565_clip8 (yuv_rgb565_sat16 (l + 129 * cu));
+
+    return ((r & 0xf8) << 8) | ((g & 0xfc) << 3) | (b >> 3);
+}
+
+#endif
@@ -1,3 +1,66 @@
 LOCAL_PATH := $(call my-dir)
+
+# libscaletempo_plugin-6.so
+
+include $(CLEAR_VARS)
+
+LOCAL_ARM_MODE := arm
+
+LOCAL_MODULE := scaletempo_plugin-6
+
+LOCAL_CFLAGS += \
+    -std=c99 \
+    -D__THROW= \
+    -DHAVE_CONFIG_H \
+    -DNDEBUG \
+    -D__PLUGIN__ \
+    -DMODULE_STRING=\"scaletempo\"
+
+LOCAL_CFLAGS += $(COMMON_OPT_CFLAGS)
+
+LOCAL_C_INCLUDES += \
+    $(VLCROOT)/compat \
+    $(VLCROOT) \
+    $(VLCROOT)/include \
+    $(VLCROOT)/src
+
+LOCAL_SRC_FILES := \
+    scaletempo.c
+
+LOCAL_SHARED_LIBRARIES += vlccore
+
+include $(BUILD_SHARED_LIBRARY)
+
+# libscaletempo_plugin-7.so
+
+include $(CLEAR_VARS)
+
+LOCAL_ARM_MODE := arm
+
+LOCAL_MODULE := scaletempo_plugin-7
+
+LOCAL_CFLAGS += \
+    -std=c99 \
+    -D__THROW= \
+    -DHAVE_CONFIG_H \
+    -DNDEBUG \
+    -D__PLUGIN__ \
+    -DMODULE_STRING=\"scaletempo\"
+
+LOCAL_CFLAGS += $(COMMON_ARMV7_CFLAGS)
+
+LOCAL_C_INCLUDES += \
+    $(VLCROOT)/compat \
+    $(VLCROOT) \
+    $(VLCROOT)/include \
+    $(VLCROOT)/src
+
+LOCAL_SRC_FILES := \
+    scaletempo.c
+
+LOCAL_SHARED_LIBRARIES += vlccore
+
+include $(BUILD_SHARED_LIBRARY)
+
 include $(CLEAR_VARS)
 include $(call all-makefiles-under,$(LOCAL_PATH))
@@ -1,13 +1,13 @@
 
 LOCAL_PATH := $(call my-dir)
 
-# libsimple_channel_mixer_plugin.so
+# libsimple_channel_mixer_plugin-6.so
 
 include $(CLEAR_VARS)
 
 LOCAL_ARM_MODE := arm
 
-LOCAL_MODULE := simple_channel_mixer_plugin
+LOCAL_MODULE := simple_channel_mixer_plugin-6
 
 LOCAL_CFLAGS += \
     -std=c99 \
@@ -32,3 +32,34 @@ LOCAL_SHARED_LIBRARIES += vlccore
 
 include $(BUILD_SHARED_LIBRARY)
 
+# libsimple_channel_mixer_plugin-7.so
+
+include $(CLEAR_VARS)
+
+LOCAL_ARM_MODE := arm
+
+LOCAL_MODULE := simple_channel_mixer_plugin-7
+
+LOCAL_CFLAGS += \
+    -std=c99 \
+    -D__THROW= \
+    -DHAVE_CONFIG_H \
+    -DNDEBUG \
+    -D__PLUGIN__ \
+    -DMODULE_STRING=\"simple_channel_mixer\"
+
+LOCAL_CFLAGS += $(COMMON_ARMV7_CFLAGS)
+
+LOCAL_C_INCLUDES += \
+    $(VLCROOT)/compat \
+    $(VLCROOT) \
+    $(VLCROOT)/include \
+    $(VLCROOT)/src
+
+LOCAL_SRC_FILES := \
+    simple.c
+
+LOCAL_SHARED_LIBRARIES += vlccore
+
+include $(BUILD_SHARED_LIBRARY)
+
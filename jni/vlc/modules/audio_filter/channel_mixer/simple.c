@@ -39,13 +39,14 @@
  * Module descriptor
  *****************************************************************************/
 static int  OpenFilter( vlc_object_t * );
+static void CloseFilter( vlc_object_t * );
 
 vlc_module_begin ()
     set_description( N_("Audio filter for simple channel mixing") )
     set_category( CAT_AUDIO )
     set_subcategory( SUBCAT_AUDIO_MISC )
     set_capability( "audio filter", 10 )
-    set_callbacks( OpenFilter, NULL )
+    set_callbacks( OpenFilter, CloseFilter )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -69,6 +70,18 @@ static bool IsSupported( const audio_format_t *p_input, const audio_format_t *p_
 
 static block_t *Filter( filter_t *, block_t * );
 
+/* The integer formats go through a matrix built from the float code, with
+ * coefficients in Q14 */
+#define COEF_BITS 14
+#define COEF(x) ((int)((x) * (1 << COEF_BITS) + .5))
+
+struct filter_sys_t
+{
+    unsigned i_input_nb;
+    unsigned i_output_nb;
+    int      pi_coef[4][8]; /* [output][input] */
+};
+
 /*****************************************************************************
  * DoWork: convert a buffer
  *****************************************************************************/
@@ -224,6 +237,139 @@ static void DoWork( filter_t * p_filter,
     }
 }
 
+/*****************************************************************************
+ * SetupMatrix: mirror DoWork() for DoWorkS16() and DoWorkFI32()
+ *****************************************************************************/
+static void SetupMatrix( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_input_physical = p_filter->fmt_in.audio.i_physical_channels;
+
+    const bool b_input_7_0 = (i_input_physical & ~AOUT_CHAN_LFE) == AOUT_CHANS_7_0;
+    const bool b_input_5_0 = !b_input_7_0 &&
+                             ( (i_input_physical & AOUT_CHANS_5_0) == AOUT_CHANS_5_0 ||
+                               (i_input_physical & AOUT_CHANS_5_0_MIDDLE) == AOUT_CHANS_5_0_MIDDLE );
+    const bool b_input_4_center_rear =  !b_input_7_0 && !b_input_5_0 &&
+                             (i_input_physical & ~AOUT_CHAN_LFE) == AOUT_CHANS_4_CENTER_REAR;
+    const bool b_input_3_0 = !b_input_7_0 && !b_input_5_0 && !b_input_4_center_rear &&
+                             (i_input_physical & ~AOUT_CHAN_LFE) == AOUT_CHANS_3_0;
+    int (*c)[8] = p_sys->pi_coef;
+
+    p_sys->i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    p_sys->i_output_nb = aout_FormatNbChannels( &p_filter->fmt_out.audio );
+    memset( p_sys->pi_coef, 0, sizeof(p_sys->pi_coef) );
+
+    if( p_filter->fmt_out.audio.i_physical_channels == AOUT_CHANS_2_0 )
+    {
+        if( b_input_7_0 )
+        {
+            c[0][6] = c[1][6] = COEF(1.);
+            c[0][0] = c[1][1] = COEF(.5);
+            c[0][2] = c[1][3] = c[0][4] = c[1][5] = COEF(.25);
+        }
+        else if( b_input_5_0 )
+        {
+            c[0][4] = c[1][4] = COEF(1.);
+            c[0][0] = c[1][1] = COEF(.5);
+            c[0][2] = c[1][3] = COEF(.33);
+        }
+        else if( b_input_3_0 )
+        {
+            c[0][2] = c[1][2] = COEF(1.);
+            c[0][0] = c[1][1] = COEF(.5);
+        }
+        else if( b_input_4_center_rear )
+        {
+            c[0][2] = c[1][2] = c[0][3] = c[1][3] = COEF(1.);
+            c[0][0] = c[1][1] = COEF(.5);
+        }
+    }
+    else if( p_filter->fmt_out.audio.i_physical_channels == AOUT_CHAN_CENTER )
+    {
+        if( b_input_7_0 )
+        {
+            c[0][6] = COEF(1.);
+            c[0][0] = c[0][1] = COEF(.25);
+            c[0][2] = c[0][3] = c[0][4] = c[0][5] = COEF(.125);
+        }
+        else if( b_input_5_0 )
+        {
+            c[0][4] = COEF(1.);
+            c[0][0] = c[0][1] = COEF(.25);
+            c[0][2] = c[0][3] = COEF(1. / 6);
+        }
+        else if( b_input_3_0 )
+        {
+            c[0][2] = COEF(1.);
+            c[0][0] = c[0][1] = COEF(.25);
+        }
+        else
+            c[0][0] = c[0][1] = COEF(.5);
+    }
+    else
+    {
+        if( b_input_7_0 )
+        {
+            c[0][6] = c[1][6] = c[2][4] = c[3][5] = COEF(1.);
+            c[0][0] = c[1][1] = COEF(.5);
+            c[0][2] = c[1][3] = c[2][2] = c[3][3] = COEF(1. / 6);
+        }
+        else
+        {
+            c[0][4] = c[1][4] = c[2][2] = c[3][3] = COEF(1.);
+            c[0][0] = c[1][1] = COEF(.5);
+        }
+    }
+}
+
+/*****************************************************************************
+ * DoWorkS16/DoWorkFI32: convert a buffer without floats
+ *****************************************************************************/
+static void DoWorkS16( filter_t * p_filter,
+                       aout_buffer_t * p_in_buf, aout_buffer_t * p_out_buf )
+{
+    const filter_sys_t *p_sys = p_filter->p_sys;
+    int16_t *p_dest = (int16_t *)p_out_buf->p_buffer;
+    const int16_t *p_src = (const int16_t *)p_in_buf->p_buffer;
+    const unsigned i_input_nb = __MIN( p_sys->i_input_nb, 8 );
+
+    for( unsigned i = p_in_buf->i_nb_samples; i--; )
+    {
+        for( unsigned j = 0; j < p_sys->i_output_nb; j++ )
+        {
+            /* the coefficients of an output add up to 2.5 at most */
+            int32_t i_sum = 0;
+            for( unsigned k = 0; k < i_input_nb; k++ )
+                i_sum += p_src[k] * p_sys->pi_coef[j][k];
+            i_sum >>= COEF_BITS;
+            *p_dest++ = i_sum > INT16_MAX ? INT16_MAX :
+                        i_sum < INT16_MIN ? INT16_MIN : i_sum;
+        }
+        p_src += p_sys->i_input_nb;
+    }
+}
+
+static void DoWorkFI32( filter_t * p_filter,
+                        aout_buffer_t * p_in_buf, aout_buffer_t * p_out_buf )
+{
+    const filter_sys_t *p_sys = p_filter->p_sys;
+    vlc_fixed_t *p_dest = (vlc_fixed_t *)p_out_buf->p_buffer;
+    const vlc_fixed_t *p_src = (const vlc_fixed_t *)p_in_buf->p_buffer;
+    const unsigned i_input_nb = __MIN( p_sys->i_input_nb, 8 );
+
+    for( unsigned i = p_in_buf->i_nb_samples; i--; )
+    {
+        for( unsigned j = 0; j < p_sys->i_output_nb; j++ )
+        {
+            int64_t i_sum = 0;
+            for( unsigned k = 0; k < i_input_nb; k++ )
+                i_sum += (int64_t)p_src[k] * p_sys->pi_coef[j][k];
+            *p_dest++ = i_sum >> COEF_BITS;
+        }
+        p_src += p_sys->i_input_nb;
+    }
+}
+
 /*****************************************************************************
  * OpenFilter:
  *****************************************************************************/
@@ -240,11 +386,30 @@ static int OpenFilter( vlc_object_t *p_this )
     if( !IsSupported( &fmt_in, &fmt_out ) )
         return -1;
 
+    p_filter->p_sys = NULL;
+    if( fmt_in.i_format != VLC_CODEC_FL32 )
+    {
+        p_filter->p_sys = malloc( sizeof(*p_filter->p_sys) );
+        if( !p_filter->p_sys )
+            return -1;
+        SetupMatrix( p_filter );
+    }
+
     p_filter->pf_audio_filter = Filter;
 
     return 0;
 }
 
+/*****************************************************************************
+ * CloseFilter:
+ *****************************************************************************/
+static void CloseFilter( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    free( p_filter->p_sys );
+}
+
 /*****************************************************************************
  * Filter:
  *****************************************************************************/
@@ -274,7 +439,12 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
     p_out->i_pts = p_block->i_pts;
     p_out->i_length = p_block->i_length;
 
-    DoWork( p_filter, p_block, p_out );
+    if( p_filter->fmt_in.audio.i_format == VLC_CODEC_S16N )
+        DoWorkS16( p_filter, p_block, p_out );
+    else if( p_filter->fmt_in.audio.i_format == VLC_CODEC_FI32 )
+        DoWorkFI32( p_filter, p_block, p_out );
+    else
+        DoWork( p_filter, p_block, p_out );
 
     block_Release( p_block );
 
@@ -286,7 +456,9 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
  *****************************************************************************/
 static bool IsSupported( const audio_format_t *p_input, const audio_format_t *p_output )
 {
-    if( p_input->i_format != VLC_CODEC_FL32 ||
+    if( ( p_input->i_format != VLC_CODEC_FL32 &&
+          p_input->i_format != VLC_CODEC_FI32 &&
+          p_input->i_format != VLC_CODEC_S16N ) ||
           p_input->i_format != p_output->i_format ||
           p_input->i_rate != p_output->i_rate )
         return false;
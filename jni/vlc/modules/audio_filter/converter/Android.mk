@@ -1,13 +1,13 @@
 
 LOCAL_PATH := $(call my-dir)
 
-# libconverter_fixed_plugin.so
+# libconverter_fixed_plugin-6.so
 
 include $(CLEAR_VARS)
 
 LOCAL_ARM_MODE := arm
 
-LOCAL_MODULE := converter_fixed_plugin
+LOCAL_MODULE := converter_fixed_plugin-6
 
 LOCAL_CFLAGS += \
     -std=c99 \
@@ -32,3 +32,34 @@ LOCAL_SHARED_LIBRARIES += vlccore
 
 include $(BUILD_SHARED_LIBRARY)
 
+# libconverter_fixed_plugin-7.so
+
+include $(CLEAR_VARS)
+
+LOCAL_ARM_MODE := arm
+
+LOCAL_MODULE := converter_fixed_plugin-7
+
+LOCAL_CFLAGS += \
+    -std=c99 \
+    -D__THROW= \
+    -DHAVE_CONFIG_H \
+    -DNDEBUG \
+    -D__PLUGIN__ \
+    -DMODULE_STRING=\"converter_fixed\"
+
+LOCAL_CFLAGS += $(COMMON_ARMV7_CFLAGS)
+
+LOCAL_C_INCLUDES += \
+    $(VLCROOT)/compat \
+    $(VLCROOT) \
+    $(VLCROOT)/include \
+    $(VLCROOT)/src
+
+LOCAL_SRC_FILES := \
+    fixed.c
+
+LOCAL_SHARED_LIBRARIES += vlccore
+
+include $(BUILD_SHARED_LIBRARY)
+
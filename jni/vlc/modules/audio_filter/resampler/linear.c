@@ -0,0 +1,231 @@
+/*****************************************************************************
+ * linear.c : fixed point linear interpolation resampler
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* The bandlimited resampler only takes float samples. This one works on S16
+ * and FI32 with a Q16 position, and keeps the last input frame so that the
+ * interpolation goes on across buffers. The input rate may change between
+ * buffers, as the aout adjusts it to follow the clock. */
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+static int  Create    ( vlc_object_t * );
+static void Close     ( vlc_object_t * );
+
+static block_t *DoWork( filter_t *, block_t * );
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+vlc_module_begin ()
+    set_description( N_("Audio filter for fixed point linear resampling") )
+    set_capability( "audio filter", 10 )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_MISC )
+    set_callbacks( Create, Close )
+vlc_module_end ()
+
+#define POS_BITS 16
+#define POS_ONE  (1 << POS_BITS)
+
+struct filter_sys_t
+{
+    uint32_t i_pos;     /* of the next output frame, from p_prev, in Q16 */
+    unsigned i_channels;
+    int32_t  p_prev[]; /* last input frame */
+};
+
+/*****************************************************************************
+ * Create: allocate linear resampler
+ *****************************************************************************/
+static int Create( vlc_object_t *p_this )
+{
+    filter_t * p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys;
+    const unsigned i_channels =
+        aout_FormatNbChannels( &p_filter->fmt_in.audio );
+
+    if ( p_filter->fmt_in.audio.i_rate == p_filter->fmt_out.audio.i_rate
+          || p_filter->fmt_in.audio.i_format != p_filter->fmt_out.audio.i_format
+          || p_filter->fmt_in.audio.i_physical_channels
+              != p_filter->fmt_out.audio.i_physical_channels
+          || p_filter->fmt_in.audio.i_original_channels
+              != p_filter->fmt_out.audio.i_original_channels
+          || (p_filter->fmt_in.audio.i_format != VLC_CODEC_S16N
+               && p_filter->fmt_in.audio.i_format != VLC_CODEC_FI32) )
+    {
+        return VLC_EGENERIC;
+    }
+
+    p_sys = calloc( 1, sizeof(*p_sys) + i_channels * sizeof(int32_t) );
+    if( !p_sys )
+        return VLC_ENOMEM;
+    /* the first output frame is the first input frame */
+    p_sys->i_pos = POS_ONE;
+    p_sys->i_channels = i_channels;
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_audio_filter = DoWork;
+    return VLC_SUCCESS;
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t * p_filter = (filter_t *)p_this;
+
+    free( p_filter->p_sys );
+}
+
+/*****************************************************************************
+ * ResampleS16/ResampleFI32: interpolate, returns the number of output frames
+ *****************************************************************************
+ * Frame -1 is p_prev, the output frames are at i_pos + n * i_step from it.
+ *****************************************************************************/
+static unsigned ResampleS16( filter_sys_t *p_sys, int16_t *p_out,
+                             const int16_t *p_in, unsigned i_in,
+                             uint32_t i_step )
+{
+    const unsigned i_channels = p_sys->i_channels;
+    const uint64_t i_end = (uint64_t)i_in << POS_BITS;
+    uint64_t i_pos = p_sys->i_pos;
+    unsigned i_out = 0;
+
+    for( ; i_pos < i_end; i_pos += i_step, i_out++ )
+    {
+        const unsigned i_index = i_pos >> POS_BITS;
+        /* Q15, so that the products fit in 32 bits */
+        const int i_frac = (i_pos & (POS_ONE - 1)) >> 1;
+        const int16_t *p_b = &p_in[i_index * i_channels];
+
+        for( unsigned c = 0; c < i_channels; c++ )
+        {
+            const int i_a = i_index ? p_b[c - i_channels] : p_sys->p_prev[c];
+
+            *p_out++ = i_a + (((p_b[c] - i_a) * i_frac) >> 15);
+        }
+    }
+
+    for( unsigned c = 0; c < i_channels; c++ )
+        p_sys->p_prev[c] = p_in[(i_in - 1) * i_channels + c];
+    p_sys->i_pos = i_pos - i_end;
+    return i_out;
+}
+
+static unsigned ResampleFI32( filter_sys_t *p_sys, vlc_fixed_t *p_out,
+                              const vlc_fixed_t *p_in, unsigned i_in,
+                              uint32_t i_step )
+{
+    const unsigned i_channels = p_sys->i_channels;
+    const uint64_t i_end = (uint64_t)i_in << POS_BITS;
+    uint64_t i_pos = p_sys->i_pos;
+    unsigned i_out = 0;
+
+    for( ; i_pos < i_end; i_pos += i_step, i_out++ )
+    {
+        const unsigned i_index = i_pos >> POS_BITS;
+        const int32_t i_frac = i_pos & (POS_ONE - 1);
+        const vlc_fixed_t *p_b = &p_in[i_index * i_channels];
+
+        for( unsigned c = 0; c < i_channels; c++ )
+        {
+            const vlc_fixed_t i_a = i_index ? p_b[c - i_channels]
+                                            : p_sys->p_prev[c];
+
+            *p_out++ = i_a + ((((int64_t)p_b[c] - i_a) * i_frac) >> POS_BITS);
+        }
+    }
+
+    for( unsigned c = 0; c < i_channels; c++ )
+        p_sys->p_prev[c] = p_in[(i_in - 1) * i_channels + c];
+    p_sys->i_pos = i_pos - i_end;
+    return i_out;
+}
+
+/*****************************************************************************
+ * DoWork: convert a buffer
+ *****************************************************************************/
+static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_in_rate = p_filter->fmt_in.audio.i_rate;
+    const unsigned i_out_rate = p_filter->fmt_out.audio.i_rate;
+    const unsigned i_in = p_in_buf->i_nb_samples;
+    const unsigned i_sample_bytes = p_filter->fmt_in.audio.i_bytes_per_frame;
+
+    if( i_in == 0 )
+        return p_in_buf;
+
+    /* Check if we really need to run the resampler */
+    if( i_out_rate == i_in_rate )
+    {
+        /* Keep the last frame for when the rate moves again */
+        const uint8_t *p_last = p_in_buf->p_buffer + (i_in - 1) * i_sample_bytes;
+        for( unsigned c = 0; c < p_sys->i_channels; c++ )
+            p_sys->p_prev[c] =
+                p_filter->fmt_in.audio.i_format == VLC_CODEC_S16N
+                ? ((const int16_t *)p_last)[c]
+                : ((const vlc_fixed_t *)p_last)[c];
+        p_sys->i_pos = POS_ONE;
+        return p_in_buf;
+    }
+
+    const uint32_t i_step = ((uint64_t)i_in_rate << POS_BITS) / i_out_rate;
+    const uint64_t i_end = (uint64_t)i_in << POS_BITS;
+    const unsigned i_out_max = i_end > p_sys->i_pos
+                             ? (i_end - p_sys->i_pos + i_step - 1) / i_step : 0;
+
+    block_t *p_out_buf = block_Alloc( __MAX( i_out_max, 1u ) * i_sample_bytes );
+    if( !p_out_buf )
+    {
+        block_Release( p_in_buf );
+        return NULL;
+    }
+
+    unsigned i_out;
+    if( p_filter->fmt_in.audio.i_format == VLC_CODEC_S16N )
+        i_out = ResampleS16( p_sys, (int16_t *)p_out_buf->p_buffer,
+                             (const int16_t *)p_in_buf->p_buffer, i_in,
+                             i_step );
+    else
+        i_out = ResampleFI32( p_sys, (vlc_fixed_t *)p_out_buf->p_buffer,
+                              (const vlc_fixed_t *)p_in_buf->p_buffer, i_in,
+                              i_step );
+
+    p_out_buf->i_nb_samples = i_out;
+    p_out_buf->i_buffer = i_out * i_sample_bytes;
+    p_out_buf->i_pts = p_in_buf->i_pts;
+    p_out_buf->i_length = p_out_buf->i_nb_samples *
+        1000000 / p_filter->fmt_out.audio.i_rate;
+
+    block_Release( p_in_buf );
+    return p_out_buf;
+}
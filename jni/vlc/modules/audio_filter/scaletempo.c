@@ -32,9 +32,19 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
 
 #include <string.h> /* for memset */
 #include <limits.h> /* form INT_MIN */
+#ifdef __ARM_NEON__
+# include <arm_neon.h>
+#endif
+
+#if defined(__ARM_ARCH_6__) || defined(__ARM_ARCH_6J__) || \
+    defined(__ARM_ARCH_6K__) || defined(__ARM_ARCH_6Z__) || \
+    defined(__ARM_ARCH_6ZK__) || defined(__ARM_ARCH_7A__)
+# define CAN_SMLALD 1 /* ARMv6 dual 16-bit multiply accumulate long */
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -75,7 +85,14 @@ vlc_module_end ()
  * sample: a single audio sample for one channel
  * frame: a single set of samples, one for each channel
  * VLC uses these terms differently
+ *
+ * Without FPU, S16 is processed with Q15 tables. The cross correlation is
+ * then done with 64-bit accumulators, two samples at a time with SMLALD on
+ * ARMv6 or eight with NEON, and the search first tries every
+ * SEARCH_STEP_S16 frames before refining around the best one.
  */
+#define SEARCH_STEP_S16 4
+
 struct filter_sys_t
 {
     /* Filter static config */
@@ -89,6 +106,7 @@ struct filter_sys_t
     unsigned  bytes_per_sample;
     unsigned  bytes_per_frame;
     unsigned  sample_rate;
+    bool      s16;                /* else fl32 */
     /* stride */
     double    frames_stride_scaled;
     double    frames_stride_error;
@@ -150,6 +168,85 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     return best_off * p->bytes_per_frame;
 }
 
+/*****************************************************************************
+ * dot_s16: sum of a[i] * b[i]
+ *****************************************************************************/
+static int64_t dot_s16( const int16_t *a, const int16_t *b, unsigned n )
+{
+    int64_t sum = 0;
+
+#if defined(__ARM_NEON__)
+    int64x2_t acc = vdupq_n_s64( 0 );
+    for( ; n >= 8; n -= 8, a += 8, b += 8 ) {
+        int16x8_t va = vld1q_s16( a );
+        int16x8_t vb = vld1q_s16( b );
+        acc = vpadalq_s32( acc, vmull_s16( vget_low_s16( va ), vget_low_s16( vb ) ) );
+        acc = vpadalq_s32( acc, vmull_s16( vget_high_s16( va ), vget_high_s16( vb ) ) );
+    }
+    sum = vgetq_lane_s64( acc, 0 ) + vgetq_lane_s64( acc, 1 );
+#elif defined(CAN_SMLALD)
+    /* a is the aligned pre-correlation buffer, b is in the queue */
+    if( !( (uintptr_t)b & 3 ) ) {
+        const uint32_t *pa = (const uint32_t *)a;
+        const uint32_t *pb = (const uint32_t *)b;
+        for( ; n >= 2; n -= 2 )
+            __asm__( "smlald %Q0, %R0, %1, %2"
+                     : "+r" (sum) : "r" (*pa++), "r" (*pb++) );
+        a = (const int16_t *)pa;
+        b = (const int16_t *)pb;
+    }
+#endif
+    while( n-- )
+        sum += *a++ * *b++;
+    return sum;
+}
+
+static unsigned best_overlap_offset_s16( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    const unsigned n = p->samples_overlap - p->samples_per_frame;
+    const int16_t *pw, *po;
+    int16_t *ppc;
+    const int16_t *search_start = (int16_t *)p->buf_queue + p->samples_per_frame;
+    int64_t best_corr = INT64_MIN;
+    unsigned best_off = 0;
+    unsigned i, off, first, last;
+
+    pw  = p->table_window;
+    po  = p->buf_overlap;
+    po += p->samples_per_frame;
+    ppc = p->buf_pre_corr;
+    for( i = 0; i < n; i++ ) {
+      *ppc++ = ( *pw++ * *po++ ) >> 15;
+    }
+
+    /* coarse */
+    for( off = 0; off < p->frames_search; off += SEARCH_STEP_S16 ) {
+      int64_t corr = dot_s16( p->buf_pre_corr,
+                              search_start + off * p->samples_per_frame, n );
+      if( corr > best_corr ) {
+        best_corr = corr;
+        best_off  = off;
+      }
+    }
+
+    /* fine */
+    first = best_off > SEARCH_STEP_S16 - 1 ? best_off - ( SEARCH_STEP_S16 - 1 ) : 0;
+    last  = __MIN( best_off + SEARCH_STEP_S16, p->frames_search );
+    for( off = first; off < last; off++ ) {
+      if( off == best_off )
+        continue;
+      int64_t corr = dot_s16( p->buf_pre_corr,
+                              search_start + off * p->samples_per_frame, n );
+      if( corr > best_corr ) {
+        best_corr = corr;
+        best_off  = off;
+      }
+    }
+
+    return best_off * p->bytes_per_frame;
+}
+
 /*****************************************************************************
  * output_overlap: blend end of previous stride with beginning of current stride
  *****************************************************************************/
@@ -168,6 +265,21 @@ static void output_overlap_float( filter_t        *p_filter,
     }
 }
 
+static void output_overlap_s16( filter_t        *p_filter,
+                                void            *buf_out,
+                                unsigned         bytes_off )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    int16_t *pout = buf_out;
+    const int16_t *pb  = p->table_blend;
+    const int16_t *po  = p->buf_overlap;
+    const int16_t *pin = (int16_t *)( p->buf_queue + bytes_off );
+    unsigned i;
+    for( i = 0; i < p->samples_overlap; i++ ) {
+        *pout++ = *po + ( ( ( *pin++ - *po ) * *pb++ ) >> 15 ); po++;
+    }
+}
+
 /*****************************************************************************
  * fill_queue: fill p_sys->buf_queue as much possible, skipping samples as needed
  *****************************************************************************/
@@ -306,15 +418,29 @@ static int reinit_buffers( filter_t *p_filter )
         if( p->bytes_overlap > prev_overlap )
             memset( (uint8_t *)p->buf_overlap + prev_overlap, 0, p->bytes_overlap - prev_overlap );
 
-        float *pb = p->table_blend;
-        float t = (float)frames_overlap;
-        for( i = 0; i<frames_overlap; i++ )
+        if( p->s16 )
         {
-            float v = i / t;
-            for( j = 0; j < p->samples_per_frame; j++ )
-                *pb++ = v;
+            int16_t *pb = p->table_blend;
+            for( i = 0; i<frames_overlap; i++ )
+            {
+                int16_t v = i * 32768 / frames_overlap;
+                for( j = 0; j < p->samples_per_frame; j++ )
+                    *pb++ = v;
+            }
+            p->output_overlap = output_overlap_s16;
+        }
+        else
+        {
+            float *pb = p->table_blend;
+            float t = (float)frames_overlap;
+            for( i = 0; i<frames_overlap; i++ )
+            {
+                float v = i / t;
+                for( j = 0; j < p->samples_per_frame; j++ )
+                    *pb++ = v;
+            }
+            p->output_overlap = output_overlap_float;
         }
-        p->output_overlap = output_overlap_float;
     }
 
     /* best overlap */
@@ -330,14 +456,31 @@ static int reinit_buffers( filter_t *p_filter )
         p->table_window = malloc( bytes_pre_corr );
         if( ! p->buf_pre_corr || ! p->table_window )
             return VLC_ENOMEM;
-        float *pw = p->table_window;
-        for( i = 1; i<frames_overlap; i++ )
+        if( p->s16 )
+        {
+            /* same window, scaled to Q15 */
+            const uint64_t max = ( frames_overlap / 2 ) *
+                                 ( frames_overlap - frames_overlap / 2 );
+            int16_t *pw = p->table_window;
+            for( i = 1; i<frames_overlap; i++ )
+            {
+                int16_t v = (uint64_t)i * ( frames_overlap - i ) * 32767 / max;
+                for( j = 0; j < p->samples_per_frame; j++ )
+                    *pw++ = v;
+            }
+            p->best_overlap_offset = best_overlap_offset_s16;
+        }
+        else
         {
-            float v = i * ( frames_overlap - i );
-            for( j = 0; j < p->samples_per_frame; j++ )
-                *pw++ = v;
+            float *pw = p->table_window;
+            for( i = 1; i<frames_overlap; i++ )
+            {
+                float v = i * ( frames_overlap - i );
+                for( j = 0; j < p->samples_per_frame; j++ )
+                    *pw++ = v;
+            }
+            p->best_overlap_offset = best_overlap_offset_float;
         }
-        p->best_overlap_offset = best_overlap_offset_float;
     }
 
     unsigned new_size = ( p->frames_search + frames_stride + frames_overlap ) * p->bytes_per_frame;
@@ -375,7 +518,7 @@ static int reinit_buffers( filter_t *p_filter )
              (int)( p->bytes_overlap / p->bytes_per_frame ),
              p->frames_search,
              (int)( p->bytes_queue_max / p->bytes_per_frame ),
-             "fl32");
+             p->s16 ? "s16" : "fl32");
 
     return VLC_SUCCESS;
 }
@@ -389,11 +532,13 @@ static int Open( vlc_object_t *p_this )
     filter_sys_t *p_sys;
     bool b_fit = true;
 
-    if( p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32 ||
-        p_filter->fmt_out.audio.i_format != VLC_CODEC_FL32 )
+    if( ( p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32 &&
+          p_filter->fmt_in.audio.i_format != VLC_CODEC_S16N ) ||
+        p_filter->fmt_out.audio.i_format != p_filter->fmt_in.audio.i_format )
     {
         b_fit = false;
-        p_filter->fmt_in.audio.i_format = p_filter->fmt_out.audio.i_format = VLC_CODEC_FL32;
+        p_filter->fmt_in.audio.i_format = p_filter->fmt_out.audio.i_format =
+            HAVE_FPU ? VLC_CODEC_FL32 : VLC_CODEC_S16N;
         msg_Warn( p_filter, "bad input or output format" );
     }
     if( ! AOUT_FMTS_SIMILAR( &p_filter->fmt_in.audio, &p_filter->fmt_out.audio ) )
@@ -416,14 +561,15 @@ static int Open( vlc_object_t *p_this )
     p_sys->scale             = 1.0;
     p_sys->sample_rate       = p_filter->fmt_in.audio.i_rate;
     p_sys->samples_per_frame = aout_FormatNbChannels( &p_filter->fmt_in.audio );
-    p_sys->bytes_per_sample  = 4;
+    p_sys->s16               = p_filter->fmt_in.audio.i_format == VLC_CODEC_S16N;
+    p_sys->bytes_per_sample  = p_sys->s16 ? 2 : 4;
     p_sys->bytes_per_frame   = p_sys->samples_per_frame * p_sys->bytes_per_sample;
 
     msg_Dbg( p_this, "format: %5i rate, %i nch, %i bps, %s",
              p_sys->sample_rate,
              p_sys->samples_per_frame,
              p_sys->bytes_per_sample,
-             "fl32" );
+             p_sys->s16 ? "s16" : "fl32" );
 
     p_sys->ms_stride       = var_InheritInteger( p_this, "scaletempo-stride" );
     p_sys->percent_overlap = var_InheritFloat( p_this, "scaletempo-overlap" );
@@ -0,0 +1,188 @@
+/*****************************************************************************
+ * integer.c : fixed point and S16 audio mixer implementation
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Same job as the float32 mixer, for the builds without FPU: the gains are
+ * turned into integers once per buffer and the samples are never converted
+ * to float. */
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stddef.h>
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+static int  Create    ( vlc_object_t * );
+
+static void DoWork    ( aout_mixer_t *, aout_buffer_t * );
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+vlc_module_begin ()
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_MISC )
+    set_description( N_("Integer audio mixer") )
+    set_capability( "audio mixer", 10 )
+    set_callbacks( Create, NULL )
+vlc_module_end ()
+
+/* Gains are in Q12, enough for AOUT_VOLUME_MAX with S16 samples in 32 bits */
+#define GAIN_BITS 12
+
+/* Scales i_nb_words words at p_in into p_out, or adds them if b_add */
+typedef void (*mix_words_t)( void *p_out, const void *p_in, size_t i_nb_words,
+                             int32_t i_gain, bool b_add );
+
+/*****************************************************************************
+ * Create: allocate mixer
+ *****************************************************************************/
+static int Create( vlc_object_t *p_this )
+{
+    aout_mixer_t * p_mixer = (aout_mixer_t *)p_this;
+
+    if ( p_mixer->fmt.i_format != VLC_CODEC_FI32
+          && p_mixer->fmt.i_format != VLC_CODEC_S16N )
+        return -1;
+
+    /* Use the trivial mixer when we can */
+    if ( p_mixer->input_count == 1 && p_mixer->multiplier == 1.0 )
+    {
+        if( p_mixer->input[0]->multiplier == 1.0 )
+            return -1;
+    }
+
+    p_mixer->mix = DoWork;
+    return 0;
+}
+
+/*****************************************************************************
+ * MixS16/MixFI32: scale or average input words
+ *****************************************************************************/
+static void MixS16( void *p_out_buf, const void *p_in_buf, size_t i_nb_words,
+                    int32_t i_gain, bool b_add )
+{
+    int16_t *p_out = p_out_buf;
+    const int16_t *p_in = p_in_buf;
+
+    for ( size_t i = i_nb_words; i--; )
+    {
+        int32_t i_sample = ( *p_in++ * i_gain ) >> GAIN_BITS;
+
+        if ( b_add )
+            i_sample += *p_out;
+        *p_out++ = i_sample > INT16_MAX ? INT16_MAX :
+                   i_sample < INT16_MIN ? INT16_MIN : i_sample;
+    }
+}
+
+static void MixFI32( void *p_out_buf, const void *p_in_buf, size_t i_nb_words,
+                     int32_t i_gain, bool b_add )
+{
+    vlc_fixed_t *p_out = p_out_buf;
+    const vlc_fixed_t *p_in = p_in_buf;
+
+    /* FI32 has headroom above 1.0, the output converter clips */
+    for ( size_t i = i_nb_words; i--; )
+    {
+        vlc_fixed_t i_sample = ( (int64_t)*p_in++ * i_gain ) >> GAIN_BITS;
+
+        if ( b_add )
+            *p_out++ += i_sample;
+        else
+            *p_out++ = i_sample;
+    }
+}
+
+/*****************************************************************************
+ * DoWork: mix a new output buffer
+ *****************************************************************************
+ * Terminology : in this function a word designates a single sample of a
+ * single channel, eg. a stereo sample is consituted of two words.
+ *****************************************************************************/
+static void DoWork( aout_mixer_t * p_mixer, aout_buffer_t * p_buffer )
+{
+    const int i_nb_inputs = p_mixer->input_count;
+    const int i_nb_channels = aout_FormatNbChannels( &p_mixer->fmt );
+    const size_t i_word = p_mixer->fmt.i_bitspersample / 8;
+    const mix_words_t pf_mix = p_mixer->fmt.i_format == VLC_CODEC_S16N
+                             ? MixS16 : MixFI32;
+    bool b_add = false;
+
+    for ( int i_input = 0; i_input < i_nb_inputs; i_input++ )
+    {
+        ptrdiff_t i_nb_words = p_buffer->i_nb_samples * i_nb_channels;
+        aout_mixer_input_t * p_input = p_mixer->input[i_input];
+
+        uint8_t * p_out = p_buffer->p_buffer;
+        uint8_t * p_in = p_input->begin;
+
+        if ( p_input->is_invalid )
+            continue;
+
+        /* The only float operations, once per buffer */
+        const int32_t i_gain = p_mixer->multiplier * p_input->multiplier
+                             * (1 << GAIN_BITS) / i_nb_inputs;
+
+        for ( ; ; )
+        {
+            ptrdiff_t i_available_words =
+                 ( p_input->fifo.p_first->p_buffer - p_in ) / i_word
+                     + p_input->fifo.p_first->i_nb_samples * i_nb_channels;
+
+            if ( i_available_words < i_nb_words )
+            {
+                aout_buffer_t * p_old_buffer;
+
+                if ( i_available_words > 0 )
+                    pf_mix( p_out, p_in, i_available_words, i_gain, b_add );
+
+                i_nb_words -= i_available_words;
+                p_out += i_available_words * i_word;
+
+                /* Next buffer */
+                p_old_buffer = aout_FifoPop( NULL, &p_input->fifo );
+                aout_BufferFree( p_old_buffer );
+                if ( p_input->fifo.p_first == NULL )
+                {
+                    msg_Err( p_mixer, "internal amix error" );
+                    return;
+                }
+                p_in = p_input->fifo.p_first->p_buffer;
+            }
+            else
+            {
+                if ( i_nb_words > 0 )
+                    pf_mix( p_out, p_in, i_nb_words, i_gain, b_add );
+                p_input->begin = p_in + i_nb_words * i_word;
+                break;
+            }
+        }
+        b_add = true;
+    }
+}
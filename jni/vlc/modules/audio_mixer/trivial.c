@@ -60,7 +60,8 @@ static int Create( vlc_object_t *p_this )
     aout_mixer_t *p_mixer = (aout_mixer_t *)p_this;
 
     if ( p_mixer->fmt.i_format != VLC_CODEC_FL32
-          && p_mixer->fmt.i_format != VLC_CODEC_FI32 )
+          && p_mixer->fmt.i_format != VLC_CODEC_FI32
+          && p_mixer->fmt.i_format != VLC_CODEC_S16N )
     {
         return -1;
     }
@@ -77,9 +78,8 @@ static void DoWork( aout_mixer_t *p_mixer, aout_buffer_t * p_buffer )
 {
     unsigned i = 0;
     aout_mixer_input_t * p_input = p_mixer->input[i];
-    int i_nb_channels = aout_FormatNbChannels( &p_mixer->fmt );
-    int i_buffer = p_buffer->i_nb_samples * sizeof(int32_t)
-                      * i_nb_channels;
+    const int i_bytes_per_frame = p_mixer->fmt.i_bytes_per_frame;
+    int i_buffer = p_buffer->i_nb_samples * i_bytes_per_frame;
     uint8_t * p_in;
     uint8_t * p_out;
 
@@ -97,8 +97,7 @@ static void DoWork( aout_mixer_t *p_mixer, aout_buffer_t * p_buffer )
         ptrdiff_t i_available_bytes = (p_input->fifo.p_first->p_buffer
                                         - p_in)
                                         + p_input->fifo.p_first->i_nb_samples
-                                           * sizeof(int32_t)
-                                           * i_nb_channels;
+                                           * i_bytes_per_frame;
 
         if ( i_available_bytes < i_buffer )
         {
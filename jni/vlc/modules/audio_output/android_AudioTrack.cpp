@@ -1,4 +1,3 @@
-
 #ifdef HAVE_CONFIG_H
 # include "config.h"
 #endif
@@ -16,18 +15,32 @@
 
 using namespace android;
 
+/* The track is fed from its own callback thread, which pulls the buffers
+ * from the aout with the date they will be heard at, like the alsa output.
+ * That date is computed from the frames written, the playback head and the
+ * latency below the track, so the aout clock follows the device. */
+
+#define CHANNELS_QUAD (AOUT_CHAN_LEFT | AOUT_CHAN_RIGHT | \
+                       AOUT_CHAN_REARLEFT | AOUT_CHAN_REARRIGHT)
+#define CHANNELS_5_1  (CHANNELS_QUAD | AOUT_CHAN_CENTER | AOUT_CHAN_LFE)
+
 struct aout_sys_t {
-    int type;
-    int rate;
-    int channel;
-    int format;
-    int size;
     AudioTrack *handle;
+    int rate;
+    int bytes_per_frame;
+    mtime_t hw_latency;     // below the track buffer
+    uint32_t written;       // frames given to the track, silence included
+    aout_buffer_t *buffer;  // partly written buffer
+    size_t offset;
+    bool reorder;
+    int chan_table[AOUT_CHAN_MAX];
 };
 
 static int  Open(vlc_object_t *);
 static void Close(vlc_object_t *);
 static void Play(aout_instance_t *);
+static void PlayIgnore(aout_instance_t *);
+static void AudioCallback(int, void *, void *);
 
 vlc_module_begin ()
     set_shortname("AndroidAudioTrack")
@@ -39,47 +52,61 @@ vlc_module_begin ()
     set_callbacks(Open, Close)
 vlc_module_end ()
 
+#if __PLATFORM__ >= 5
+// WAVE order, which AudioFlinger expects: the mixer outputs the VLC (wg4)
+// order, so the buffers are reordered
+static const uint32_t pi_android_order[] = {
+    AOUT_CHAN_LEFT, AOUT_CHAN_RIGHT, AOUT_CHAN_CENTER, AOUT_CHAN_LFE,
+    AOUT_CHAN_REARLEFT, AOUT_CHAN_REARRIGHT, 0
+};
+#endif
+
+static AudioTrack *NewTrack(aout_instance_t *p_aout, int type, int rate, int format, int channel, int frames) {
+    AudioTrack *track = new AudioTrack(type, rate, format, channel, frames, 0,
+                                       AudioCallback, p_aout, frames / 2);
+    if (track->initCheck() != NO_ERROR) {
+        delete track;
+        return NULL;
+    }
+    return track;
+}
+
 static int Open(vlc_object_t *p_this) {
     struct aout_sys_t *p_sys;
     aout_instance_t *p_aout = (aout_instance_t*)(p_this);
+    audio_sample_format_t *fmt = &p_aout->output.output;
     status_t status;
+    int afSampleRate, minFrameCount;
 #if __PLATFORM__ < 9
-    int afSampleRate, afFrameCount, afLatency, minBufCount, minFrameCount;
+    int afFrameCount, afLatency, minBufCount;
 #endif
-    int type, channel, rate, format, size;
+    int type, channel, rate, format;
 
-    p_sys = (struct aout_sys_t*)malloc(sizeof(aout_sys_t));
+    p_sys = (struct aout_sys_t*)calloc(1, sizeof(aout_sys_t));
     if (p_sys == NULL)
         return VLC_ENOMEM;
     p_aout->output.p_sys = p_sys;
     type = AudioSystem::MUSIC;
-    p_sys->type = type;
-    // 8000 <= frequency <= 48000
-    if (p_aout->output.output.i_rate < 8000)
-        p_aout->output.output.i_rate = 8000;
-    if (p_aout->output.output.i_rate > 48000)
-        p_aout->output.output.i_rate = 48000;
-    rate = p_aout->output.output.i_rate;
+    status = AudioSystem::getOutputSamplingRate(&afSampleRate, type);
+    if (status != NO_ERROR) {
+        msg_Err(p_aout, "AudioSystem is not initialized!");
+        free(p_sys);
+        return VLC_EGENERIC;
+    }
+    // AudioFlinger resamples up to twice its own rate
+    if (fmt->i_rate < 4000)
+        fmt->i_rate = 4000;
+    if (fmt->i_rate > (unsigned)afSampleRate * 2)
+        fmt->i_rate = afSampleRate * 2;
+    rate = fmt->i_rate;
     p_sys->rate = rate;
     // U8/S16 only
-    if (p_aout->output.output.i_format != VLC_CODEC_U8 && p_aout->output.output.i_format != VLC_CODEC_S16L)
-        p_aout->output.output.i_format = VLC_CODEC_S16L;
-    format = (p_aout->output.output.i_format == VLC_CODEC_S16L) ? AudioSystem::PCM_16_BIT : AudioSystem::PCM_8_BIT;
-    p_sys->format = format;
-    // TODO: android supports more channels
-    channel = aout_FormatNbChannels(&p_aout->output.output);
-    if (channel > 2) {
-        channel = 2;
-        p_aout->output.output.i_physical_channels = AOUT_CHAN_LEFT | AOUT_CHAN_RIGHT;
-    }
-#if __PLATFORM__ >= 5
-    channel = (channel == 2) ? AudioSystem::CHANNEL_OUT_STEREO : AudioSystem::CHANNEL_OUT_MONO;
-#endif
-    p_sys->channel = channel;
-    // use the minium value
+    if (fmt->i_format != VLC_CODEC_U8 && fmt->i_format != VLC_CODEC_S16L)
+        fmt->i_format = VLC_CODEC_S16L;
+    format = (fmt->i_format == VLC_CODEC_S16L) ? AudioSystem::PCM_16_BIT : AudioSystem::PCM_8_BIT;
+    // use the minimum value, the callback thread keeps it filled
 #if __PLATFORM__ < 9
-    status = AudioSystem::getOutputSamplingRate(&afSampleRate, type);
-    status ^= AudioSystem::getOutputFrameCount(&afFrameCount, type);
+    status = AudioSystem::getOutputFrameCount(&afFrameCount, type);
     status ^= AudioSystem::getOutputLatency((uint32_t*)(&afLatency), type);
     if (status != NO_ERROR) {
         msg_Err(p_aout, "AudioSystem is not initialized!");
@@ -90,26 +117,60 @@ static int Open(vlc_object_t *p_this) {
     if (minBufCount < 2)
         minBufCount = 2;
     minFrameCount = (afFrameCount * rate * minBufCount) / afSampleRate;
-    p_aout->output.i_nb_samples = minFrameCount;
 #else
-    status = AudioTrack::getMinFrameCount(&p_aout->output.i_nb_samples, type, rate);
+    status = AudioTrack::getMinFrameCount(&minFrameCount, type, rate);
     if (status != NO_ERROR) {
         msg_Err(p_aout, "AudioTrack::getMinFrameCount() failed!");
         free(p_sys);
         return VLC_EGENERIC;
     }
 #endif
-    p_aout->output.i_nb_samples <<= 1;
-    p_sys->size = p_aout->output.i_nb_samples;
-    p_sys->handle = new AudioTrack(p_sys->type, p_sys->rate, p_sys->format, p_sys->channel, p_sys->size);
-    status = p_sys->handle->initCheck();
-    if (status != NO_ERROR) {
+    p_sys->handle = NULL;
+#if __PLATFORM__ >= 5
+    // multichannel tracks are downmixed by AudioFlinger if needed
+    channel = 0;
+    if (fmt->i_physical_channels == CHANNELS_5_1)
+        channel = AudioSystem::CHANNEL_OUT_5POINT1;
+    else if (fmt->i_physical_channels == CHANNELS_QUAD)
+        channel = AudioSystem::CHANNEL_OUT_QUAD;
+    if (channel != 0) {
+        p_sys->handle = NewTrack(p_aout, type, rate, format, channel, minFrameCount);
+        if (p_sys->handle == NULL)
+            msg_Warn(p_aout, "%d channels are not supported, using stereo",
+                     aout_FormatNbChannels(fmt));
+        else
+            p_sys->reorder = aout_CheckChannelReorder(NULL, pi_android_order,
+                    fmt->i_physical_channels, aout_FormatNbChannels(fmt),
+                    p_sys->chan_table);
+    }
+#endif
+    if (p_sys->handle == NULL) {
+        channel = aout_FormatNbChannels(fmt);
+        if (channel > 2 || channel == 0 || (channel == 2 &&
+            fmt->i_physical_channels != (AOUT_CHAN_LEFT | AOUT_CHAN_RIGHT))) {
+            channel = 2;
+            fmt->i_physical_channels = AOUT_CHAN_LEFT | AOUT_CHAN_RIGHT;
+        }
+#if __PLATFORM__ >= 5
+        channel = (channel == 2) ? AudioSystem::CHANNEL_OUT_STEREO : AudioSystem::CHANNEL_OUT_MONO;
+#endif
+        p_sys->handle = NewTrack(p_aout, type, rate, format, channel, minFrameCount);
+    }
+    if (p_sys->handle == NULL) {
         msg_Err(p_aout, "Cannot create AudioTrack!");
-        delete p_sys->handle;
         free(p_sys);
         return VLC_EGENERIC;
     }
-    p_sys->handle->start();
+    aout_FormatPrepare(fmt);
+    p_sys->bytes_per_frame = fmt->i_bytes_per_frame;
+    // the aout fills one notification period at a time
+    p_aout->output.i_nb_samples = p_sys->handle->frameCount() / 2;
+    p_sys->hw_latency = (mtime_t)p_sys->handle->latency() * 1000
+                      - (mtime_t)CLOCK_FREQ * p_sys->handle->frameCount() / rate;
+    if (p_sys->hw_latency < 0)
+        p_sys->hw_latency = 0;
+    msg_Dbg(p_aout, "track of %u frames, %d ms below it",
+            p_sys->handle->frameCount(), (int)(p_sys->hw_latency / 1000));
     p_aout->output.pf_play = Play;
     return VLC_SUCCESS;
 }
@@ -118,31 +179,72 @@ static void Close(vlc_object_t *p_this) {
     aout_instance_t *p_aout = (aout_instance_t*)p_this;
     struct aout_sys_t *p_sys = p_aout->output.p_sys;
 
+    // the destructor waits for the callback thread
     p_sys->handle->stop();
-    p_sys->handle->flush();
     delete p_sys->handle;
-    vlc_object_kill(p_aout);
-    vlc_thread_join(p_aout);
-    p_aout->b_die = false;
+    if (p_sys->buffer != NULL)
+        aout_BufferFree(p_sys->buffer);
     free(p_sys);
 }
 
+// The first buffer is ready: start the track, it pulls the others
 static void Play(aout_instance_t *p_aout) {
+    p_aout->output.pf_play = PlayIgnore;
+    p_aout->output.p_sys->handle->start();
+}
+
+static void PlayIgnore(aout_instance_t *p_aout) {
+    VLC_UNUSED(p_aout);
+}
+
+static void AudioCallback(int event, void *user, void *info) {
+    aout_instance_t *p_aout = (aout_instance_t*)user;
     struct aout_sys_t *p_sys = p_aout->output.p_sys;
-    int length;
-    aout_buffer_t *p_buffer;
-
-    while (vlc_object_alive(p_aout)) {
-        p_buffer = aout_FifoPop(p_aout, &p_aout->output.fifo);
-        if (p_buffer != NULL) {
-            length = 0;
-            while (length < p_buffer->i_buffer) {
-                length += p_sys->handle->write((char*)(p_buffer->p_buffer) + length, p_buffer->i_buffer - length);
-            }
-            aout_BufferFree(p_buffer);
+    AudioTrack::Buffer *buffer = (AudioTrack::Buffer*)info;
+    uint8_t *out;
+    size_t left;
+
+    if (event != AudioTrack::EVENT_MORE_DATA)
+        return;
+
+    out = (uint8_t*)buffer->raw;
+    left = buffer->size;
+    while (left > 0) {
+        if (p_sys->buffer == NULL) {
+            uint32_t position;
+            mtime_t delay = 0;
+
+            if (p_sys->handle->getPosition(&position) == NO_ERROR)
+                delay = (mtime_t)CLOCK_FREQ * (int32_t)(p_sys->written - position) / p_sys->rate;
+            if (delay < 0)
+                delay = 0;
+            // the frames already copied in this callback play first
+            delay += (mtime_t)CLOCK_FREQ * ((buffer->size - left) / p_sys->bytes_per_frame) / p_sys->rate;
+            p_sys->buffer = aout_OutputNextBuffer(p_aout, mdate() + delay + p_sys->hw_latency, false);
+            if (p_sys->buffer == NULL)
+                break;
+            p_sys->offset = 0;
+            if (p_sys->reorder)
+                aout_ChannelReorder(p_sys->buffer->p_buffer, p_sys->buffer->i_buffer,
+                                    aout_FormatNbChannels(&p_aout->output.output),
+                                    p_sys->chan_table,
+                                    p_aout->output.output.i_bitspersample);
+        }
+
+        size_t length = p_sys->buffer->i_buffer - p_sys->offset;
+        if (length > left)
+            length = left;
+        memcpy(out, p_sys->buffer->p_buffer + p_sys->offset, length);
+        out += length;
+        left -= length;
+        p_sys->offset += length;
+        if (p_sys->offset >= p_sys->buffer->i_buffer) {
+            aout_BufferFree(p_sys->buffer);
+            p_sys->buffer = NULL;
         }
-        else
-            break;
     }
+    // starving: play silence rather than letting the track underrun
+    if (left > 0)
+        memset(out, p_aout->output.output.i_format == VLC_CODEC_U8 ? 0x80 : 0, left);
+    p_sys->written += buffer->size / p_sys->bytes_per_frame;
 }
-
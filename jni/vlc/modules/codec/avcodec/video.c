@@ -99,8 +99,15 @@ struct decoder_sys_t
 };
 
 #ifdef HAVE_AVCODEC_MT
+/* The decoder thread only lets the frame threads call ffmpeg_GetFrameBuf()
+ * while it is itself inside avcodec, so that the direct rendering path does
+ * not race with it on p_dec->fmt_out and the decoder owner. */
 #   define wait_mt(s) vlc_sem_wait( &s->sem_mt )
 #   define post_mt(s) vlc_sem_post( &s->sem_mt )
+
+/* One decoding thread per this many pixels, up to the number of CPUs */
+#   define FFMPEG_THREAD_PIXELS (640 * 360)
+#   define FFMPEG_THREADS_MAX   (8)
 #else
 #   define wait_mt(s)
 #   define post_mt(s)
@@ -123,6 +130,30 @@ static enum PixelFormat ffmpeg_GetFormat( AVCodecContext *,
                                           const enum PixelFormat * );
 #endif
 
+#ifdef HAVE_AVCODEC_MT
+/*****************************************************************************
+ * ffmpeg_GetThreadCount: number of decoding threads for a given resolution
+ *****************************************************************************
+ * Small pictures do not decode faster with more threads, while each frame
+ * thread adds one picture of latency and one picture buffer.
+ *****************************************************************************/
+static int ffmpeg_GetThreadCount( decoder_t *p_dec, int i_width, int i_height )
+{
+    int i_thread_count = var_InheritInteger( p_dec, "ffmpeg-threads" );
+    if( i_thread_count > 0 )
+        return __MIN( i_thread_count, FFMPEG_THREADS_MAX );
+
+    i_thread_count = vlc_GetCPUCount();
+    if( i_width > 0 && i_height > 0 )
+    {
+        int i_needed = ( i_width * i_height + FFMPEG_THREAD_PIXELS - 1 )
+                           / FFMPEG_THREAD_PIXELS;
+        i_thread_count = __MIN( i_thread_count, i_needed );
+    }
+    return __MAX( 1, __MIN( i_thread_count, FFMPEG_THREADS_MAX ) );
+}
+#endif
+
 static uint32_t ffmpeg_CodecTag( vlc_fourcc_t fcc )
 {
     uint8_t *p = (uint8_t*)&fcc;
@@ -334,11 +365,19 @@ int InitVideoDec( decoder_t *p_dec, AVCodecContext *p_context,
     p_sys->p_context->opaque = p_dec;
 
 #ifdef HAVE_AVCODEC_MT
-    int i_thread_count = var_InheritInteger( p_dec, "ffmpeg-threads" );
-    if( i_thread_count <= 0 )
-        i_thread_count = vlc_GetCPUCount();
+    int i_thread_count = ffmpeg_GetThreadCount( p_dec,
+                                                p_dec->fmt_in.video.i_width,
+                                                p_dec->fmt_in.video.i_height );
     msg_Dbg( p_dec, "allowing %d thread(s) for decoding", i_thread_count );
     p_sys->p_context->thread_count = i_thread_count;
+    p_sys->p_context->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    /* ffmpeg_GetFrameBuf() serializes itself with the decoder thread, so
+     * the frame threads need not wait for it to request their buffers */
+    p_sys->p_context->thread_safe_callbacks = 1;
+    /* Each frame thread holds a picture while decoding */
+    if( i_thread_count > 1 &&
+        (p_sys->p_codec->capabilities & CODEC_CAP_FRAME_THREADS) )
+        p_dec->i_extra_picture_buffers = 2 * i_thread_count;
 #endif
 
 #ifdef HAVE_AVCODEC_VA
@@ -453,7 +492,12 @@ picture_t *DecodeVideo( decoder_t *p_dec, block_t **pp_block )
         p_sys->i_late_frames = 0;
 
         if( p_block->i_flags & BLOCK_FLAG_DISCONTINUITY )
+        {
+            /* The frame threads may be waiting in ffmpeg_GetFrameBuf() */
+            post_mt( p_sys );
             avcodec_flush_buffers( p_context );
+            wait_mt( p_sys );
+        }
 
         block_Release( p_block );
         return NULL;
@@ -599,9 +643,13 @@ picture_t *DecodeVideo( decoder_t *p_dec, block_t **pp_block )
             block_Release( p_block );
             return NULL;
         }
-        else if( i_used > p_block->i_buffer ||
-                 p_context->thread_count > 1 )
+        else if( i_used > p_block->i_buffer
+#ifdef HAVE_AVCODEC_MT
+              || (p_context->active_thread_type & FF_THREAD_FRAME)
+#endif
+               )
         {
+            /* Frame threads always consume the whole packet */
             i_used = p_block->i_buffer;
         }
 
@@ -929,7 +977,9 @@ static int ffmpeg_GetFrameBuf( struct AVCodecContext *p_context,
     decoder_sys_t *p_sys = p_dec->p_sys;
     picture_t *p_pic;
 
-    /* */
+    /* With frame threading, p_context is the context of the thread decoding
+     * this frame, which holds the timestamp of its packet: always use it
+     * rather than p_sys->p_context below. */
     p_ff_pic->reordered_opaque = p_context->reordered_opaque;
     p_ff_pic->opaque = NULL;
 
@@ -971,9 +1021,9 @@ static int ffmpeg_GetFrameBuf( struct AVCodecContext *p_context,
     /* Some codecs set pix_fmt only after the 1st frame has been decoded,
      * so we need to check for direct rendering again. */
 
-    int i_width = p_sys->p_context->width;
-    int i_height = p_sys->p_context->height;
-    avcodec_align_dimensions( p_sys->p_context, &i_width, &i_height );
+    int i_width = p_context->width;
+    int i_height = p_context->height;
+    avcodec_align_dimensions( p_context, &i_width, &i_height );
 
     if( GetVlcChroma( &p_dec->fmt_out.video, p_context->pix_fmt ) != VLC_SUCCESS ||
         p_context->pix_fmt == PIX_FMT_PAL8 )
@@ -982,7 +1032,7 @@ static int ffmpeg_GetFrameBuf( struct AVCodecContext *p_context,
     p_dec->fmt_out.i_codec = p_dec->fmt_out.video.i_chroma;
 
     /* Get a new picture */
-    p_pic = ffmpeg_NewPictBuf( p_dec, p_sys->p_context );
+    p_pic = ffmpeg_NewPictBuf( p_dec, p_context );
     if( !p_pic )
         goto no_dr;
     bool b_compatible = true;
@@ -1028,7 +1078,7 @@ static int ffmpeg_GetFrameBuf( struct AVCodecContext *p_context,
         p_sys->i_direct_rendering_used = 1;
     }
 
-    p_sys->p_context->draw_horiz_band = NULL;
+    p_context->draw_horiz_band = NULL;
 
     p_ff_pic->opaque = (void*)p_pic;
     p_ff_pic->type = FF_BUFFER_TYPE_USER;
@@ -1088,6 +1138,9 @@ static void ffmpeg_ReleaseFrameBuf( struct AVCodecContext *p_context,
     {
         picture_t *p_pic = (picture_t*)p_ff_pic->opaque;
 
+        /* Frame threads release their buffers from the decoder thread, this
+         * may run concurrently with ffmpeg_GetFrameBuf() but the picture
+         * reference counting is locked by the video output. */
         decoder_UnlinkPicture( p_dec, p_pic );
     }
     for( int i = 0; i < 4; i++ )
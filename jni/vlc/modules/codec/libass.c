@@ -74,18 +74,33 @@ vlc_module_end ()
  *****************************************************************************/
 static subpicture_t *DecodeBlock( decoder_t *, block_t ** );
 
-/* Yes libass sux with threads */
 typedef struct
 {
-    vlc_object_t   *p_libvlc;
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+} rectangle_t;
+
+/* Maximum number of regions of a subpicture */
+#define MAX_REGION 4
+
+/* Image of a region, relative to the region */
+typedef struct
+{
+    int      x, y, w, h;
+    uint32_t i_color;
+    uint32_t i_hash;    /* of the bitmap */
+} image_key_t;
 
-    int             i_refcount;
-    ASS_Library     *p_library;
-    ASS_Renderer    *p_renderer;
-    video_format_t  fmt;
-} ass_handle_t;
-static ass_handle_t *AssHandleHold( decoder_t *p_dec );
-static void AssHandleRelease( ass_handle_t * );
+/* Region drawn by the last update, reused while its images are unchanged */
+typedef struct
+{
+    rectangle_t  rect;
+    picture_t   *p_picture;
+    int          i_image;
+    image_key_t *p_image;
+} region_cache_t;
 
 /* */
 struct decoder_sys_t
@@ -96,12 +111,23 @@ struct decoder_sys_t
     vlc_mutex_t  lock;
     int          i_refcount;
 
-    /* */
-    ass_handle_t *p_ass;
+    /* Yes libass sux with threads: each track has its own library and
+     * renderer, protected by the lock, so that the tracks do not wait on
+     * each other */
+    ASS_Library    *p_library;
+    ASS_Renderer   *p_renderer;
+    video_format_t fmt;
 
     /* */
     ASS_Track    *p_track;
+
+    /* */
+    region_cache_t cache[MAX_REGION];
+    int            i_cache;
 };
+static int  AssInit( decoder_t *p_dec, decoder_sys_t *p_sys );
+static void AssClean( decoder_sys_t *p_sys );
+static void CacheClean( decoder_sys_t *p_sys );
 static void DecSysRelease( decoder_sys_t *p_sys );
 static void DecSysHold( decoder_sys_t *p_sys );
 
@@ -126,18 +152,10 @@ struct subpicture_updater_sys_t
     ASS_Image     *p_img;
 };
 
-typedef struct
-{
-    int x0;
-    int y0;
-    int x1;
-    int y1;
-} rectangle_t;
-
 static int BuildRegions( rectangle_t *p_region, int i_max_region, ASS_Image *p_img_list, int i_width, int i_height );
-static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img );
-
-static vlc_mutex_t libass_lock = VLC_STATIC_MUTEX;
+static int RegionKeys( image_key_t **pp_key, const rectangle_t *p_rect, ASS_Image *p_img );
+static picture_t *RegionRender( decoder_sys_t *p_sys, const video_format_t *p_fmt,
+                                const region_cache_t *p_new, ASS_Image *p_img );
 
 //#define DEBUG_REGION
 
@@ -161,8 +179,9 @@ static int Create( vlc_object_t *p_this )
 
     /* */
     p_sys->i_max_stop = VLC_TS_INVALID;
-    p_sys->p_ass = AssHandleHold( p_dec );
-    if( !p_sys->p_ass )
+    p_sys->p_track = NULL;
+    p_sys->i_cache = 0;
+    if( AssInit( p_dec, p_sys ) )
     {
         free( p_sys );
         return VLC_EGENERIC;
@@ -171,16 +190,13 @@ static int Create( vlc_object_t *p_this )
     p_sys->i_refcount = 1;
 
     /* Add a track */
-    vlc_mutex_lock( &libass_lock );
-    p_sys->p_track = p_track = ass_new_track( p_sys->p_ass->p_library );
+    p_sys->p_track = p_track = ass_new_track( p_sys->p_library );
     if( !p_track )
     {
-        vlc_mutex_unlock( &libass_lock );
         DecSysRelease( p_sys );
         return VLC_EGENERIC;
     }
     ass_process_codec_private( p_track, p_dec->fmt_in.p_extra, p_dec->fmt_in.i_extra );
-    vlc_mutex_unlock( &libass_lock );
 
     p_dec->fmt_out.i_cat = SPU_ES;
     p_dec->fmt_out.i_codec = VLC_CODEC_RGBA;
@@ -217,12 +233,10 @@ static void DecSysRelease( decoder_sys_t *p_sys )
     vlc_mutex_unlock( &p_sys->lock );
     vlc_mutex_destroy( &p_sys->lock );
 
-    vlc_mutex_lock( &libass_lock );
+    CacheClean( p_sys );
     if( p_sys->p_track )
         ass_free_track( p_sys->p_track );
-    vlc_mutex_unlock( &libass_lock );
-
-    AssHandleRelease( p_sys->p_ass );
+    AssClean( p_sys );
     free( p_sys );
 }
 
@@ -297,13 +311,13 @@ static subpicture_t *DecodeBlock( decoder_t *p_dec, block_t **pp_block )
 
     p_sys->i_max_stop = p_spu->i_stop;
 
-    vlc_mutex_lock( &libass_lock );
+    vlc_mutex_lock( &p_sys->lock );
     if( p_sys->p_track )
     {
         ass_process_chunk( p_sys->p_track, p_spu_sys->p_subs_data, p_spu_sys->i_subs_len,
                            p_block->i_pts / 1000, p_block->i_length / 1000 );
     }
-    vlc_mutex_unlock( &libass_lock );
+    vlc_mutex_unlock( &p_sys->lock );
 
     DecSysHold( p_sys ); /* Keep a reference for the returned subpicture */
 
@@ -321,9 +335,8 @@ static int SubpictureValidate( subpicture_t *p_subpic,
                                mtime_t i_ts )
 {
     decoder_sys_t *p_sys = p_subpic->updater.p_sys->p_dec_sys;
-    ass_handle_t *p_ass = p_sys->p_ass;
 
-    vlc_mutex_lock( &libass_lock );
+    vlc_mutex_lock( &p_sys->lock );
 
     /* FIXME why this mix of src/dst */
     video_format_t fmt = *p_fmt_dst;
@@ -338,25 +351,26 @@ static int SubpictureValidate( subpicture_t *p_subpic,
 
     if( b_fmt_src || b_fmt_dst )
     {
-        ass_set_frame_size( p_ass->p_renderer, fmt.i_width, fmt.i_height );
+        ass_set_frame_size( p_sys->p_renderer, fmt.i_width, fmt.i_height );
 #if defined( LIBASS_VERSION ) && LIBASS_VERSION >= 0x00907000
-        ass_set_aspect_ratio( p_ass->p_renderer, 1.0, 1.0 ); // TODO ?
+        ass_set_aspect_ratio( p_sys->p_renderer, 1.0, 1.0 ); // TODO ?
 #else
-        ass_set_aspect_ratio( p_ass->p_renderer, 1.0 ); // TODO ?
+        ass_set_aspect_ratio( p_sys->p_renderer, 1.0 ); // TODO ?
 #endif
-        p_ass->fmt = fmt;
+        p_sys->fmt = fmt;
+        CacheClean( p_sys );
     }
 
     /* */
     const mtime_t i_stream_date = p_subpic->updater.p_sys->i_pts + (i_ts - p_subpic->i_start);
     int i_changed;
-    ASS_Image *p_img = ass_render_frame( p_ass->p_renderer, p_sys->p_track,
+    ASS_Image *p_img = ass_render_frame( p_sys->p_renderer, p_sys->p_track,
                                          i_stream_date/1000, &i_changed );
 
     if( !i_changed && !b_fmt_src && !b_fmt_dst &&
         (p_img != NULL) == (p_subpic->p_region != NULL) )
     {
-        vlc_mutex_unlock( &libass_lock );
+        vlc_mutex_unlock( &p_sys->lock );
         return VLC_SUCCESS;
     }
     p_subpic->updater.p_sys->p_img = p_img;
@@ -373,11 +387,10 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
     VLC_UNUSED( p_fmt_src ); VLC_UNUSED( p_fmt_dst ); VLC_UNUSED( i_ts );
 
     decoder_sys_t *p_sys = p_subpic->updater.p_sys->p_dec_sys;
-    ass_handle_t *p_ass = p_sys->p_ass;
 
-    video_format_t fmt = p_ass->fmt;
+    video_format_t fmt = p_sys->fmt;
     ASS_Image *p_img = p_subpic->updater.p_sys->p_img;
-    //vlc_assert_locked( &libass_lock );
+    //vlc_assert_locked( &p_sys->lock );
 
     /* */
     p_subpic->i_original_picture_height = fmt.i_height;
@@ -389,19 +402,21 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
      * reinstanciate a lot the scaler, and as we do not support subpel blending
      * it looks ugly (text unaligned).
      */
-    const int i_max_region = 4;
-    rectangle_t region[i_max_region];
-    const int i_region = BuildRegions( region, i_max_region, p_img, fmt.i_width, fmt.i_height );
+    rectangle_t region[MAX_REGION];
+    const int i_region = BuildRegions( region, MAX_REGION, p_img, fmt.i_width, fmt.i_height );
 
     if( i_region <= 0 )
     {
-        vlc_mutex_unlock( &libass_lock );
+        CacheClean( p_sys );
+        vlc_mutex_unlock( &p_sys->lock );
         return;
     }
 
-    /* Allocate the regions and draw them */
-    subpicture_region_t *pp_region[i_max_region];
+    /* Allocate the regions and draw them, the pictures of the last update
+     * are reused for the parts that did not change */
     subpicture_region_t **pp_region_last = &p_subpic->p_region;
+    region_cache_t cache[MAX_REGION];
+    int i_cache = 0;
 
     for( int i = 0; i < i_region; i++ )
     {
@@ -415,21 +430,46 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
         fmt_region.i_height =
         fmt_region.i_visible_height = region[i].y1 - region[i].y0;
 
-        pp_region[i] = r = subpicture_region_New( &fmt_region );
+        region_cache_t *c = &cache[i_cache];
+        c->rect = region[i];
+        c->i_image = RegionKeys( &c->p_image, &region[i], p_img );
+        c->p_picture = RegionRender( p_sys, &fmt_region, c, p_img );
+        if( !c->p_picture )
+        {
+            free( c->p_image );
+            break;
+        }
+
+        /* The region does not allocate its own picture */
+        fmt_region.i_chroma = VLC_CODEC_TEXT;
+        r = subpicture_region_New( &fmt_region );
         if( !r )
+        {
+            picture_Release( c->p_picture );
+            free( c->p_image );
             break;
+        }
+        r->fmt.i_chroma = VLC_CODEC_RGBA;
+        r->p_picture = picture_Hold( c->p_picture );
         r->i_x = region[i].x0;
         r->i_y = region[i].y0;
         r->i_align = SUBPICTURE_ALIGN_TOP | SUBPICTURE_ALIGN_LEFT;
 
-        /* */
-        RegionDraw( r, p_img );
+        /* A region whose images are unknown can not be reused */
+        if( c->i_image >= 0 )
+            i_cache++;
+        else
+            picture_Release( c->p_picture );
 
         /* */
         *pp_region_last = r;
         pp_region_last = &r->p_next;
     }
-    vlc_mutex_unlock( &libass_lock );
+
+    CacheClean( p_sys );
+    memcpy( p_sys->cache, cache, i_cache * sizeof(*cache) );
+    p_sys->i_cache = i_cache;
+    vlc_mutex_unlock( &p_sys->lock );
 
 }
 static void SubpictureDestroy( subpicture_t *p_subpic )
@@ -592,19 +632,35 @@ static int BuildRegions( rectangle_t *p_region, int i_max_region, ASS_Image *p_i
     return i_region;
 }
 
-static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img )
+static bool r_inside( const rectangle_t *r, const ASS_Image *p_img )
+{
+    return p_img->dst_x >= r->x0 && p_img->dst_x + p_img->w <= r->x1 &&
+           p_img->dst_y >= r->y0 && p_img->dst_y + p_img->h <= r->y1;
+}
+
+/* Draws the images of the region p_rect that intersect p_dirty, both in
+ * frame coordinates, after clearing p_dirty */
+static void RegionDraw( picture_t *p_picture, const rectangle_t *p_rect,
+                        const rectangle_t *p_dirty, ASS_Image *p_img )
 {
-    const plane_t *p = &p_region->p_picture->p[0];
-    const int i_x = p_region->i_x;
-    const int i_y = p_region->i_y;
-    const int i_width  = p_region->fmt.i_width;
-    const int i_height = p_region->fmt.i_height;
+    const plane_t *p = &p_picture->p[0];
+    const int i_x = p_rect->x0;
+    const int i_y = p_rect->y0;
+
+    for( int y = p_dirty->y0; y < p_dirty->y1; y++ )
+        memset( &p->p_pixels[(y - i_y) * p->i_pitch + 4 * (p_dirty->x0 - i_x)],
+                0x00, 4 * (p_dirty->x1 - p_dirty->x0) );
 
-    memset( p->p_pixels, 0x00, p->i_pitch * p->i_lines );
     for( ; p_img != NULL; p_img = p_img->next )
     {
-        if( p_img->dst_x < i_x || p_img->dst_x + p_img->w > i_x + i_width ||
-            p_img->dst_y < i_y || p_img->dst_y + p_img->h > i_y + i_height )
+        if( !r_inside( p_rect, p_img ) )
+            continue;
+
+        const int x0 = __MAX( p_img->dst_x, p_dirty->x0 ) - p_img->dst_x;
+        const int x1 = __MIN( p_img->dst_x + p_img->w, p_dirty->x1 ) - p_img->dst_x;
+        const int y0 = __MAX( p_img->dst_y, p_dirty->y0 ) - p_img->dst_y;
+        const int y1 = __MIN( p_img->dst_y + p_img->h, p_dirty->y1 ) - p_img->dst_y;
+        if( x0 >= x1 || y0 >= y1 )
             continue;
 
         const unsigned r = (p_img->color >> 24)&0xff;
@@ -613,9 +669,9 @@ static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img )
         const unsigned a = (p_img->color      )&0xff;
         int x, y;
 
-        for( y = 0; y < p_img->h; y++ )
+        for( y = y0; y < y1; y++ )
         {
-            for( x = 0; x < p_img->w; x++ )
+            for( x = x0; x < x1; x++ )
             {
                 const unsigned alpha = p_img->bitmap[y*p_img->stride+x];
                 const unsigned an = (255 - a) * alpha / 255;
@@ -657,41 +713,154 @@ static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img )
 #endif
 }
 
-/* */
-static ass_handle_t *AssHandleHold( decoder_t *p_dec )
+/*****************************************************************************
+ * Region cache: karaoke and effects usually change a few images of a line
+ * only, so the pictures of the last update are kept and only the area of
+ * the images that differ is drawn again.
+ *****************************************************************************/
+static uint32_t ImageHash( const ASS_Image *p_img )
 {
-    vlc_mutex_lock( &libass_lock );
+    uint32_t i_hash = 2166136261u;
 
-    ass_handle_t *p_ass = NULL;
-    ASS_Library *p_library = NULL;
-    ASS_Renderer *p_renderer = NULL;
-    vlc_value_t val;
+    for( int y = 0; y < p_img->h; y++ )
+    {
+        const unsigned char *p_line = &p_img->bitmap[y * p_img->stride];
+        for( int x = 0; x < p_img->w; x++ )
+            i_hash = ( i_hash ^ p_line[x] ) * 16777619u;
+    }
+    return i_hash;
+}
 
-    var_Create( p_dec->p_libvlc, "libass-handle", VLC_VAR_ADDRESS );
-    if( var_Get( p_dec->p_libvlc, "libass-handle", &val ) )
-        val.p_address = NULL;
+/* Describes the images drawn in a region, returns -1 on error */
+static int RegionKeys( image_key_t **pp_key, const rectangle_t *p_rect, ASS_Image *p_img )
+{
+    ASS_Image *p_tmp;
+    int i_count = 0;
 
-    if( val.p_address )
+    for( p_tmp = p_img; p_tmp != NULL; p_tmp = p_tmp->next )
+        if( r_inside( p_rect, p_tmp ) )
+            i_count++;
+
+    image_key_t *p_key = *pp_key = malloc( __MAX( i_count, 1 ) * sizeof(*p_key) );
+    if( !p_key )
+        return -1;
+
+    for( p_tmp = p_img; p_tmp != NULL; p_tmp = p_tmp->next )
     {
-        p_ass = val.p_address;
+        if( !r_inside( p_rect, p_tmp ) )
+            continue;
+        p_key->x = p_tmp->dst_x - p_rect->x0;
+        p_key->y = p_tmp->dst_y - p_rect->y0;
+        p_key->w = p_tmp->w;
+        p_key->h = p_tmp->h;
+        p_key->i_color = p_tmp->color;
+        p_key->i_hash = ImageHash( p_tmp );
+        p_key++;
+    }
+    return i_count;
+}
 
-        p_ass->i_refcount++;
+static bool KeyEqual( const image_key_t *a, const image_key_t *b )
+{
+    return a->x == b->x && a->y == b->y && a->w == b->w && a->h == b->h &&
+           a->i_color == b->i_color && a->i_hash == b->i_hash;
+}
 
-        vlc_mutex_unlock( &libass_lock );
-        return p_ass;
+static void CacheClean( decoder_sys_t *p_sys )
+{
+    for( int i = 0; i < p_sys->i_cache; i++ )
+    {
+        if( p_sys->cache[i].p_picture )
+            picture_Release( p_sys->cache[i].p_picture );
+        free( p_sys->cache[i].p_image );
     }
+    p_sys->i_cache = 0;
+}
 
-    /* */
-    p_ass = malloc( sizeof(*p_ass) );
-    if( !p_ass )
-        goto error;
+/* Returns the picture of the region p_new, drawing only what changed since
+ * the last update when the same region existed */
+static picture_t *RegionRender( decoder_sys_t *p_sys, const video_format_t *p_fmt,
+                                const region_cache_t *p_new, ASS_Image *p_img )
+{
+    const rectangle_t *p_rect = &p_new->rect;
+    region_cache_t *p_old = NULL;
+    picture_t *p_picture;
 
-    /* */
-    p_ass->p_libvlc = VLC_OBJECT(p_dec->p_libvlc);
-    p_ass->i_refcount = 1;
+    for( int i = 0; i < p_sys->i_cache && p_new->i_image >= 0; i++ )
+    {
+        region_cache_t *c = &p_sys->cache[i];
+        if( c->p_picture && !memcmp( &c->rect, p_rect, sizeof(*p_rect) ) )
+        {
+            p_old = c;
+            break;
+        }
+    }
+    if( !p_old )
+        goto redraw;
+
+    /* Union of the images that differ */
+    rectangle_t dirty = { INT_MAX, INT_MAX, INT_MIN, INT_MIN };
+    for( int i = 0; i < __MAX( p_old->i_image, p_new->i_image ); i++ )
+    {
+        const image_key_t *o = i < p_old->i_image ? &p_old->p_image[i] : NULL;
+        const image_key_t *n = i < p_new->i_image ? &p_new->p_image[i] : NULL;
+
+        if( o && n && KeyEqual( o, n ) )
+            continue;
+        if( o )
+        {
+            rectangle_t r = r_create( o->x, o->y, o->x + o->w, o->y + o->h );
+            r_add( &dirty, &r );
+        }
+        if( n )
+        {
+            rectangle_t r = r_create( n->x, n->y, n->x + n->w, n->y + n->h );
+            r_add( &dirty, &r );
+        }
+    }
+
+    p_picture = p_old->p_picture;
+    p_old->p_picture = NULL;
+    if( dirty.x0 >= dirty.x1 )
+        return p_picture;
+
+    const bool b_full = 2 * r_surface( &dirty ) > r_surface( p_rect );
+
+    /* The last picture may still be blended by the vout */
+    if( picture_IsReferenced( p_picture ) )
+    {
+        picture_t *p_copy = b_full ? NULL : picture_NewFromFormat( p_fmt );
+        if( p_copy )
+            picture_Copy( p_copy, p_picture );
+        picture_Release( p_picture );
+        p_picture = p_copy;
+        if( !p_picture )
+            goto redraw;
+    }
+
+    if( b_full )
+        dirty = *p_rect;
+    else
+        dirty = r_create( p_rect->x0 + dirty.x0, p_rect->y0 + dirty.y0,
+                          p_rect->x0 + dirty.x1, p_rect->y0 + dirty.y1 );
+    RegionDraw( p_picture, p_rect, &dirty, p_img );
+    return p_picture;
+
+redraw:
+    p_picture = picture_NewFromFormat( p_fmt );
+    if( p_picture )
+        RegionDraw( p_picture, p_rect, p_rect, p_img );
+    return p_picture;
+}
+
+/* */
+static int AssInit( decoder_t *p_dec, decoder_sys_t *p_sys )
+{
+    ASS_Library *p_library;
+    ASS_Renderer *p_renderer = NULL;
 
     /* Create libass library */
-    p_ass->p_library = p_library = ass_library_init();
+    p_sys->p_library = p_library = ass_library_init();
     if( !p_library )
         goto error;
 
@@ -712,7 +881,7 @@ static ass_handle_t *AssHandleHold( decoder_t *p_dec )
         {
             msg_Dbg( p_dec, "adding embedded font %s", p_attach->psz_name );
 
-            ass_add_font( p_ass->p_library, p_attach->psz_name, p_attach->p_data, p_attach->i_data );
+            ass_add_font( p_library, p_attach->psz_name, p_attach->p_data, p_attach->i_data );
         }
         vlc_input_attachment_Delete( p_attach );
     }
@@ -722,10 +891,9 @@ static ass_handle_t *AssHandleHold( decoder_t *p_dec )
     ass_set_style_overrides( p_library, NULL );
 
     /* Create the renderer */
-    p_ass->p_renderer = p_renderer = ass_renderer_init( p_library );
+    p_sys->p_renderer = p_renderer = ass_renderer_init( p_library );
     if( !p_renderer )
         goto error;
-
     ass_set_use_margins( p_renderer, false);
     //if( false )
     //    ass_set_margins( p_renderer, int t, int b, int l, int r);
@@ -766,15 +934,8 @@ static ass_handle_t *AssHandleHold( decoder_t *p_dec )
     ass_set_fonts_nofc( p_renderer, psz_font, psz_family );
 #endif
 #endif
-    memset( &p_ass->fmt, 0, sizeof(p_ass->fmt) );
-
-    /* */
-    val.p_address = p_ass;
-    var_Set( p_dec->p_libvlc, "libass-handle", val );
-
-    /* */
-    vlc_mutex_unlock( &libass_lock );
-    return p_ass;
+    memset( &p_sys->fmt, 0, sizeof(p_sys->fmt) );
+    return VLC_SUCCESS;
 
 error:
     if( p_renderer )
@@ -783,28 +944,10 @@ error:
         ass_library_done( p_library );
 
     msg_Warn( p_dec, "Libass creation failed" );
-
-    free( p_ass );
-    vlc_mutex_unlock( &libass_lock );
-    return NULL;
+    return VLC_EGENERIC;
 }
-static void AssHandleRelease( ass_handle_t *p_ass )
+static void AssClean( decoder_sys_t *p_sys )
 {
-    vlc_mutex_lock( &libass_lock );
-    p_ass->i_refcount--;
-    if( p_ass->i_refcount > 0 )
-    {
-        vlc_mutex_unlock( &libass_lock );
-        return;
-    }
-
-    ass_renderer_done( p_ass->p_renderer );
-    ass_library_done( p_ass->p_library );
-
-    vlc_value_t val;
-    val.p_address = NULL;
-    var_Set( p_ass->p_libvlc, "libass-handle", val );
-
-    vlc_mutex_unlock( &libass_lock );
-    free( p_ass );
+    ass_renderer_done( p_sys->p_renderer );
+    ass_library_done( p_sys->p_library );
 }
@@ -13,7 +13,8 @@
 #include <vlc_interface.h>
 #include <vlc_aout.h>
 #include <vlc_vout.h>
-#include <vlc_playlist.h>
+#include <vlc_input.h>
+#include <vlc_charset.h>
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -22,43 +23,131 @@
 #ifdef HAVE_POLL
 #include <poll.h>
 #endif
-#include <vlc_network.h>
+
+/* org.videolan.VLM, see src/jni.c */
+extern int PostEvent(int, int64_t, int64_t, int64_t, bool);
+extern void SetCommandHandler(void (*)(void *, int, int64_t, int64_t, const char *), void *);
+extern input_thread_t *GetInput(void);
+
+/* keep in sync with org.videolan.VLM, open, close and stop are run by the
+ * media player directly */
+enum {
+    COMMAND_INPUT = 0, /* the media player has a new input */
+    COMMAND_PLAY = 3,
+    COMMAND_PAUSE = 4,
+    COMMAND_SEEK = 6,
+    COMMAND_FAST_FORWARD,
+    COMMAND_FAST_BACKWARD,
+};
+
+#define SEEK_FAST     1
+#define SEEK_PRECISE  2
+#define SEEK_RELATIVE 4
+
+/* keep in sync with org.videolan.VLI */
+enum {
+    EVENT_INPUT_STATE = 0,
+    EVENT_INPUT_POSITION = 4,
+    EVENT_INPUT_LENGTH = 5,
+    EVENT_INPUT_VOUT = 23,
+    EVENT_INPUT_SEEK_DONE = 1101,
+    EVENT_INPUT_CAN_PAUSE,
+    EVENT_INPUT_CAN_SEEK,
+    EVENT_INPUT_SPEED,
+    EVENT_INPUT_ERROR,
+};
+
+enum {
+    ERROR_NO_INPUT = 1,
+    ERROR_CANNOT_SEEK,
+    ERROR_BAD_ARGUMENT,
+};
 
 static int  Activate(vlc_object_t *);
 static void Deactivate(vlc_object_t *);
 static void Run(intf_thread_t *);
 
-static void Notify(intf_thread_t *, const char*, ...);
+static int Notify(intf_thread_t *, int, int64_t, int64_t, int64_t);
 
-static void ProcessCommand(intf_thread_t *, const char *);
+static void PostCommand(void *, int, int64_t, int64_t, const char *);
+static void ProcessCommands(intf_thread_t *);
+static mtime_t FlushTime(intf_thread_t *);
+
+static void Seek(intf_thread_t *, mtime_t, int);
+static void SetSpeed(intf_thread_t *, int);
+static void Speed(intf_thread_t *, int, int);
+static void ScanStop(intf_thread_t *);
+static mtime_t ScanTick(intf_thread_t *);
 
 static int InputEvent(vlc_object_t *p_this, char const *psz_cmd, vlc_value_t oldval, vlc_value_t newval, void *p_data);
 
+typedef struct {
+    int i_cmd;
+    int64_t i_arg1;
+    int64_t i_arg2;
+    char *psz_arg;
+} command_t;
+
+/* pending commands, more are dropped */
+#define NOTIFY_COMMANDS_MAX 16
+
 struct intf_sys_t {
-    int i_socket;
-    int *pi_socket;
     int i_wakeup[2];
-    char p_read_buffer[512];
-    int i_read_offset;
-    vlc_mutex_t o_write_lock;
-    char p_write_buffer[4096];
-    int i_write_offset;
-    int i_write_length;
-    playlist_t *p_playlist;
+    /* commands from VLM, run by the interface thread */
+    vlc_mutex_t o_command_lock;
+    command_t p_commands[NOTIFY_COMMANDS_MAX];
+    int i_commands;
+    /* last position, sent at most every i_time_period, under o_time_lock */
+    vlc_mutex_t o_time_lock;
+    mtime_t i_time;
+    mtime_t i_time_date;
+    mtime_t i_time_period;
+    bool b_time_pending;
+    /* last time sent, in seconds */
+    int64_t i_time_sent;
+    input_thread_t *p_input;
+    /* last seek, for the latency report, under o_seek_lock */
+    vlc_mutex_t o_seek_lock;
+    mtime_t i_seek_date;
+    mtime_t i_seek_target;
+    bool b_seek_fast;
+    bool b_seek_started;
+    bool b_seek_report;
+    /* ff/fb: speed factor, negative backwards, 1 when playing normally */
+    int i_speed;
+    /* scan mode: the speed is too high to decode everything (or backwards),
+     * jump from key frame to key frame instead */
+    bool b_scan;
+    bool b_scan_muted;
+    mtime_t i_scan_time;
+    mtime_t i_scan_date;
 };
 
+/* up to this speed ff only changes the playback rate */
+#define NOTIFY_RATE_MAX 4
+/* fastest ff/fb */
+#define NOTIFY_SPEED_MAX 32
+/* interval between two key frame seeks in scan mode */
+#define NOTIFY_SCAN_PERIOD (CLOCK_FREQ / 4)
+/* give up waiting for a seek to complete after */
+#define NOTIFY_SEEK_TIMEOUT (2 * CLOCK_FREQ)
+
+#define TIME_PERIOD_TEXT N_("Time report period")
+#define TIME_PERIOD_LONGTEXT N_("Minimum interval between two reports of " \
+    "the playback time, in milliseconds.")
+
 vlc_module_begin ()
     set_shortname(N_("notify"))
     set_category(CAT_INTERFACE)
     set_subcategory(SUBCAT_INTERFACE_MAIN)
-    set_description(N_("interactive TCP remote control interface"))
+    set_description(N_("Android JNI remote control interface"))
     set_capability("interface", 25)
+    add_integer("notify-time-period", 500, TIME_PERIOD_TEXT,
+                TIME_PERIOD_LONGTEXT, true)
     set_callbacks(Activate, Deactivate)
 vlc_module_end ()
 
 static int Activate(vlc_object_t *p_this) {
-    int i_port = 21178;
-    const char* psz_host = "127.0.0.1";
     intf_thread_t *p_intf = (intf_thread_t*)(p_this);
     intf_sys_t *p_sys;
 
@@ -69,20 +158,23 @@ static int Activate(vlc_object_t *p_this) {
         free(p_sys);
         return VLC_EGENERIC;
     }
-    p_sys->pi_socket = net_ListenTCP(p_this, psz_host, i_port);
-    if (p_sys->pi_socket == NULL) {
-        free(p_sys);
-        msg_Err(p_intf, "can't listen to %s port %i", psz_host, i_port);
-        return VLC_EGENERIC;
-    }
-    p_sys->i_socket = -1;    
-    vlc_mutex_init(&p_sys->o_write_lock);
-    p_sys->i_read_offset = 0;
-    p_sys->i_write_offset = 0;
-    p_sys->i_write_length = 0;
+    vlc_mutex_init(&p_sys->o_command_lock);
+    vlc_mutex_init(&p_sys->o_time_lock);
+    vlc_mutex_init(&p_sys->o_seek_lock);
+    p_sys->i_commands = 0;
+    p_sys->p_input = NULL;
+    p_sys->i_seek_date = 0;
+    p_sys->i_speed = 1;
+    p_sys->b_scan = false;
+    p_sys->b_scan_muted = false;
+    p_sys->i_time_period = var_InheritInteger(p_intf, "notify-time-period") * 1000;
+    p_sys->i_time_date = 0;
+    p_sys->b_time_pending = false;
+    p_sys->i_time_sent = -1;
 
     p_intf->p_sys = p_sys;
     p_intf->pf_run = Run;
+    SetCommandHandler(PostCommand, p_intf);
 
     return VLC_SUCCESS;
 }
@@ -91,10 +183,13 @@ static void Deactivate(vlc_object_t *p_this) {
     intf_thread_t *p_intf = (intf_thread_t*)p_this;
     intf_sys_t *p_sys = p_intf->p_sys;
 
-    net_ListenClose(p_sys->pi_socket);
-    if(p_sys->i_socket != -1)
-        net_Close(p_sys->i_socket);
-    vlc_mutex_destroy(&p_sys->o_write_lock);
+    /* returns once no call is in progress */
+    SetCommandHandler(NULL, NULL);
+    for (int i = 0; i < p_sys->i_commands; i++)
+        free(p_sys->p_commands[i].psz_arg);
+    vlc_mutex_destroy(&p_sys->o_command_lock);
+    vlc_mutex_destroy(&p_sys->o_time_lock);
+    vlc_mutex_destroy(&p_sys->o_seek_lock);
     close(p_sys->i_wakeup[0]);
     close(p_sys->i_wakeup[1]);
     free(p_sys);
@@ -103,344 +198,328 @@ static void Deactivate(vlc_object_t *p_this) {
 static void Run(intf_thread_t *p_intf) {
     intf_sys_t *p_sys = p_intf->p_sys;
     input_thread_t *p_input = NULL;
-    playlist_t *p_playlist = pl_Get(p_intf);
-    int *pi_fd, i_listen = 0, i_err;
-
-    p_intf->p_sys->p_playlist = p_playlist;
+    int i_err;
 
-    for (pi_fd = p_sys->pi_socket; *pi_fd != -1; pi_fd++)
-        i_listen++;
     for (; vlc_object_alive(p_intf);) {
-        vlc_value_t val;
-        struct pollfd fd[i_listen + 2];
+        struct pollfd fd;
 
         vlc_testcancel();
 
-        if (p_input == NULL) {
-            p_input = playlist_CurrentInput(p_playlist);
-            if (p_input) {
-                var_AddCallback(p_input, "intf-event", InputEvent, p_intf);
-            }
-        }
-        else {
-            if (p_input->b_dead || !vlc_object_alive(p_input)) {
-                var_DelCallback(p_input, "intf-event", InputEvent, p_intf);
-                vlc_object_release(p_input);
-                p_input = NULL;
-            }
+        /* the media player replaces its input for each file */
+        input_thread_t *p_current = GetInput();
+        if (p_input && (p_input != p_current || p_input->b_dead || !vlc_object_alive(p_input))) {
+            var_DelCallback(p_input, "intf-event", InputEvent, p_intf);
+            vlc_object_release(p_input);
+            p_input = NULL;
         }
-        memset(&fd, 0, sizeof(fd[0]) * (i_listen + 1));
-        if (p_sys->i_socket == -1) {
-            for (int i = 0; i < i_listen; i++) {
-                fd[i].fd = p_sys->pi_socket[i];
-                fd[i].events = POLLIN;
-                fd[i].revents = 0;
-            }
+        if (!p_input && p_current && !p_current->b_dead) {
+            p_input = vlc_object_hold(p_current);
+            var_AddCallback(p_input, "intf-event", InputEvent, p_intf);
         }
-        else {
-            fd[0].fd = p_sys->i_wakeup[0];
-            fd[0].events = POLLIN;
-            fd[0].revents = 0;
-            fd[1].fd = p_sys->i_socket;
-            fd[1].events = POLLIN | (p_sys->i_write_length > 0 ? POLLOUT : 0);
-            fd[1].revents = 0;
+        if (p_current)
+            vlc_object_release(p_current);
+        if (p_sys->p_input != p_input) {
+            p_sys->p_input = p_input;
+            ScanStop(p_intf);
+            p_sys->i_speed = 1;
+            vlc_mutex_lock(&p_sys->o_seek_lock);
+            p_sys->i_seek_date = 0;
+            vlc_mutex_unlock(&p_sys->o_seek_lock);
         }
-        i_err = poll(fd, (p_sys->i_socket != -1) ? 2 : i_listen, -1);
+        ProcessCommands(p_intf);
+        mtime_t i_timer = ScanTick(p_intf);
+        mtime_t i_flush = FlushTime(p_intf);
+        if (i_flush > 0 && (i_timer <= 0 || i_flush < i_timer))
+            i_timer = i_flush;
+        fd.fd = p_sys->i_wakeup[0];
+        fd.events = POLLIN;
+        fd.revents = 0;
+        i_err = poll(&fd, 1, i_timer > 0 ? (i_timer + 999) / 1000 : -1);
         if (i_err < 0) {
+            if (errno == EINTR)
+                continue;
             msg_Dbg(p_intf, "poll() failed");
             vlc_object_kill(p_intf);
             break;
         }
-        if (i_err == 0)
-            continue;
-        if (p_sys->i_socket == -1) {
-            for (int i = 0; i < i_listen; i++) {
-                if (fd[i].revents & POLLIN) {
-                    int client = net_AcceptSingle(VLC_OBJECT(p_intf), fd[i].fd);
-                    if (client == -1)
-                        continue;
-                    p_sys->i_socket = client;
-                    break;
-                }
-            }
-        }
-        else {
-            if (fd[0].revents & POLLIN) {
-                char ch;
+        if (fd.revents & POLLIN) {
+            char buf[64];
 
-                read(fd[0].fd, &ch, 1);
-            }
-            if (fd[1].revents & (POLLERR|POLLHUP|POLLNVAL)) {
-                net_Close(fd[0].fd);
-                p_sys->i_socket = -1;
-                msg_Dbg(VLC_OBJECT(p_intf), "connection error");
-                continue;
-            }
-            ssize_t i_len, i_test;
-            if (fd[1].revents & POLLIN) {
-                //msg_Dbg(VLC_OBJECT(p_intf), "poll in");
-                bool b_line = false;
-                while ((i_len = recv(fd[1].fd, p_sys->p_read_buffer + p_sys->i_read_offset, 1, 0)) > 0) {
-                    char ch;
-
-                    ch = p_sys->p_read_buffer[p_sys->i_read_offset];
-                    switch (ch) {
-                    case '\r':
-                    case '\n':
-                        p_sys->p_read_buffer[p_sys->i_read_offset] = '\0';
-                        b_line = true;
-                        break;
-                    case '\0':
-                        b_line = true;
-                        break;
-                    default:
-                        break;
-                    }
-                    p_sys->i_read_offset++;
-                    if (p_sys->i_read_offset == sizeof(p_sys->p_read_buffer) && !b_line) {
-                        net_Close(p_sys->i_socket);
-                        p_sys->i_socket = -1;
-                        msg_Dbg(VLC_OBJECT(p_intf), "input is too long, close connection");
-                        break;
-                    }
-                }
-                if (b_line && strlen(p_sys->p_read_buffer)) {
-                    p_sys->i_read_offset = 0;
-                    //msg_Dbg(VLC_OBJECT(p_intf), "%s\n", p_sys->p_read_buffer);
-                    ProcessCommand(p_intf, p_sys->p_read_buffer);
-                }
-                if(i_len == 0) {
-                    net_Close(p_sys->i_socket);
-                    p_sys->i_socket = -1;
-                    msg_Dbg(VLC_OBJECT(p_intf), "connection is closed by client");
-                }
-            }
-            if (fd[1].revents & POLLOUT) {
-                vlc_mutex_lock(&p_sys->o_write_lock);
-                if (p_sys->i_write_length) {
-                    int i_first, i_second;
-
-                    i_first = sizeof(p_sys->p_write_buffer) - p_sys->i_write_offset;
-                    i_second = (p_sys->i_write_offset + p_sys->i_write_length) % sizeof(p_sys->p_write_buffer);
-                    i_test = 0;
-                    if (i_first >= p_sys->i_write_length)
-                        i_len = send(fd[1].fd, p_sys->p_write_buffer + p_sys->i_write_offset, p_sys->i_write_length, 0);
-                    else {
-                        i_len = send(fd[1].fd, p_sys->p_write_buffer + p_sys->i_write_offset, i_first, 0);
-                        if (i_len == i_first)
-                            i_test = send(fd[1].fd, p_sys->p_write_buffer, i_second, 0);
-                        if (i_test > 0)
-                            i_len += i_test;
-                    }
-                    if (i_len > 0) {
-                        p_sys->i_write_offset += i_len;
-                        p_sys->i_write_offset %= sizeof(p_sys->p_write_buffer);
-                        p_sys->i_write_length -= i_len;
-                        if (p_sys->i_write_length == 0)
-                            p_sys->i_write_offset = 0;
-                    }
-                }
-                vlc_mutex_unlock(&p_sys->o_write_lock);
-            }
+            read(fd.fd, buf, sizeof(buf));
         }
     }
 }
 
-static void Notify(intf_thread_t *p_intf, const char* psz_format, ...) {
-    va_list args;
+/* Called by VLM on its own thread, the command is run by the interface
+ * thread so that the seek and speed state stay with it */
+static void PostCommand(void *p_data, int i_cmd, int64_t i_arg1, int64_t i_arg2, const char *psz_arg) {
+    intf_thread_t *p_intf = p_data;
     intf_sys_t *p_sys = p_intf->p_sys;
-    int i_size;
-    char *psz_message;
+    command_t *p_cmd;
+    bool b_wakeup;
 
-    va_start(args, psz_format);
-    i_size = vasprintf(&psz_message, psz_format, args);
-    va_end(args);
-    if (!psz_message)
+    vlc_mutex_lock(&p_sys->o_command_lock);
+    if (p_sys->i_commands == NOTIFY_COMMANDS_MAX) {
+        vlc_mutex_unlock(&p_sys->o_command_lock);
+        msg_Dbg(VLC_OBJECT(p_intf), "too many commands, discard %d", i_cmd);
         return;
-    vlc_mutex_lock(&p_sys->o_write_lock);
-    if (p_sys->i_write_length + i_size < sizeof(p_sys->p_write_buffer)) {
-        int i_first, i_second;
-
-        i_first = sizeof(p_sys->p_write_buffer) - p_sys->i_write_offset - p_sys->i_write_length;
-        i_second = (p_sys->i_write_offset + p_sys->i_write_length + i_size) % sizeof(p_sys->p_write_buffer);
-        if (i_first >= i_size) {
-            memcpy(p_sys->p_write_buffer + p_sys->i_write_offset + p_sys->i_write_length, psz_message, i_size);
-        }
-        else {
-            memcpy(p_sys->p_write_buffer + p_sys->i_write_offset + p_sys->i_write_length, psz_message, i_first);
-            memcpy(p_sys->p_write_buffer, psz_message + i_first, i_second);
-        }
-        p_sys->i_write_length += i_size;
     }
-    else {
-        msg_Dbg(VLC_OBJECT(p_intf), "buffer is full, discard current message");
+    b_wakeup = p_sys->i_commands == 0;
+    p_cmd = &p_sys->p_commands[p_sys->i_commands++];
+    p_cmd->i_cmd = i_cmd;
+    p_cmd->i_arg1 = i_arg1;
+    p_cmd->i_arg2 = i_arg2;
+    p_cmd->psz_arg = psz_arg ? strdup(psz_arg) : NULL;
+    vlc_mutex_unlock(&p_sys->o_command_lock);
+    if (b_wakeup)
+        write(p_sys->i_wakeup[1], &p_sys, 1);
+}
+
+static void ProcessCommands(intf_thread_t *p_intf) {
+    intf_sys_t *p_sys = p_intf->p_sys;
+    command_t p_commands[NOTIFY_COMMANDS_MAX];
+    int i_commands;
+
+    vlc_mutex_lock(&p_sys->o_command_lock);
+    i_commands = p_sys->i_commands;
+    memcpy(p_commands, p_sys->p_commands, i_commands * sizeof(command_t));
+    p_sys->i_commands = 0;
+    vlc_mutex_unlock(&p_sys->o_command_lock);
+
+    for (int i = 0; i < i_commands; i++) {
+        command_t *p_cmd = &p_commands[i];
+
+        switch (p_cmd->i_cmd) {
+        case COMMAND_INPUT:
+            /* picked up by Run() */
+            break;
+        case COMMAND_PLAY:
+            if (p_sys->i_speed != 1)
+                SetSpeed(p_intf, 1);
+            else if (p_sys->p_input)
+                input_Control(p_sys->p_input, INPUT_SET_STATE, PLAYING_S);
+            break;
+        case COMMAND_PAUSE:
+            ScanStop(p_intf);
+            if (p_sys->p_input && var_GetBool(p_sys->p_input, "can-pause"))
+                input_Control(p_sys->p_input, INPUT_SET_STATE, PAUSE_S);
+            break;
+        case COMMAND_SEEK:
+            Seek(p_intf, p_cmd->i_arg1 * 1000, p_cmd->i_arg2);
+            break;
+        case COMMAND_FAST_FORWARD:
+            Speed(p_intf, 1, p_cmd->i_arg1);
+            break;
+        case COMMAND_FAST_BACKWARD:
+            Speed(p_intf, -1, p_cmd->i_arg1);
+            break;
+        default:
+            msg_Dbg(VLC_OBJECT(p_intf), "unknown command %d", p_cmd->i_cmd);
+            break;
+        }
+        free(p_cmd->psz_arg);
     }
-    vlc_mutex_unlock(&p_sys->o_write_lock);
-    free(psz_message);
-    write(p_sys->i_wakeup[1], &p_sys, 1);
 }
 
-static int ParseLineCommand(char *p_string, char*** p_argv) {
-    if (!p_string || !strlen(p_string)) {
-        if (p_argv)
-            p_argv = NULL;
+/* Only the position may be dropped, it is sent again later. The other
+ * events wait for VLM to read the queue. */
+static int Notify(intf_thread_t *p_intf, int i_type, int64_t i_arg1, int64_t i_arg2, int64_t i_arg3) {
+    const bool b_droppable = i_type == EVENT_INPUT_POSITION;
+
+    if (PostEvent(i_type, i_arg1, i_arg2, i_arg3, b_droppable) == 0)
+        return 0;
+    if (b_droppable)
+        msg_Dbg(VLC_OBJECT(p_intf), "event queue is busy, delay the position");
+    else
+        msg_Err(VLC_OBJECT(p_intf), "event queue is full, discard event %d", i_type);
+    return -1;
+}
+
+/* Sends the last position if it is due, returns the delay until it is, or
+ * 0 if there is none pending */
+static mtime_t FlushTime(intf_thread_t *p_intf) {
+    intf_sys_t *p_sys = p_intf->p_sys;
+    mtime_t i_now = mdate(), i_time;
+
+    vlc_mutex_lock(&p_sys->o_time_lock);
+    if (!p_sys->b_time_pending) {
+        vlc_mutex_unlock(&p_sys->o_time_lock);
         return 0;
     }
-    bool b_start = false;
-    bool b_quote = false;
-    int i_len = strlen(p_string);
-    int i_count = 0;
-    for (int i = 0; i < i_len; i++) {
-        char ch = p_string[i];
-
-        if (ch == '\"')
-            b_quote = !b_quote;
-        if (!b_quote && (ch == ' ' || ch == '\t')) {
-            b_start = false;
-            p_string[i] = 0;
-        }
-        if (ch != ' ' && ch != '\t') {
-            if (!b_start) {
-                b_start = true;
-                i_count++;
-            }
-        }
+    if (i_now < p_sys->i_time_date) {
+        vlc_mutex_unlock(&p_sys->o_time_lock);
+        return p_sys->i_time_date - i_now;
     }
-    if (p_argv) {
-        if (i_count) {
-            int n = 0;
-
-            *p_argv = malloc(i_count * sizeof(char*));
-            if (!(*p_argv))
-                return i_count;
-            b_start = false;
-            for (int i = 0; i < i_len; i++) {
-                char ch = p_string[i];
-
-                if (ch != '\0') {
-                    if (!b_start) {
-                        b_start = true;
-                        b_quote = false;
-                        if (p_string[i] == '\"') {
-                            p_string[i + strlen(p_string + i) - 1] = '\0';
-                            p_string[i] = '\0';
-                            b_quote = true;
-                        }
-                        (*p_argv)[n++] = p_string + i + (b_quote ? 1 : 0);
-                    }
-                    else
-                        continue;
-                }
-                else
-                    b_start = false;
-            }
-        }
-        else
-            p_argv = NULL;
+    i_time = p_sys->i_time / CLOCK_FREQ;
+    p_sys->b_time_pending = false;
+    p_sys->i_time_date = i_now + p_sys->i_time_period;
+    vlc_mutex_unlock(&p_sys->o_time_lock);
+
+    if (i_time == p_sys->i_time_sent)
+        return 0;
+    if (Notify(p_intf, EVENT_INPUT_POSITION, i_time, 0, 0) == 0) {
+        p_sys->i_time_sent = i_time;
+        return 0;
     }
-    return i_count;
+    /* retry in a period, unless a newer position comes first */
+    vlc_mutex_lock(&p_sys->o_time_lock);
+    if (!p_sys->b_time_pending) {
+        p_sys->b_time_pending = true;
+        p_sys->i_time = i_time * CLOCK_FREQ;
+    }
+    vlc_mutex_unlock(&p_sys->o_time_lock);
+    return p_sys->i_time_period;
 }
 
-static void ProcessCommand(intf_thread_t *p_intf, const char *p_string) {
+/* Starts a seek to i_time, the input reports its completion through the
+ * cache event, see InputEvent() */
+static void SeekTo(intf_thread_t *p_intf, mtime_t i_time, bool b_fast, bool b_report) {
     intf_sys_t *p_sys = p_intf->p_sys;
-    playlist_t *p_playlist = p_sys->p_playlist;
-    char *p_line = strdup(p_string);
-    int i_argc;
-    char** p_argv = NULL;
-
-    i_argc = ParseLineCommand(p_line, &p_argv);
-    if (i_argc == 0 || !p_argv)
-        goto msg;
-    if (i_argc == 1) {
-        if (!strcmp(p_argv[0], "help")) {
-            Notify(p_intf, "woshenmedoubuzhidao\n");
-        }
-        else if (!strcmp(p_argv[0], "play")) {
-            playlist_Play(p_playlist);
-        }
-        else if (!strcmp(p_argv[0], "pause")) {
-            playlist_Pause(p_playlist);
-        }
-        else if (!strcmp(p_argv[0], "stop")) {
-            playlist_Stop(p_playlist);
-        }
-        else if (!strcmp(p_argv[0], "close")) {
-            playlist_Clear(p_playlist, pl_Unlocked);
-        }
-        else if (!strcmp(p_argv[0], "ff")) {
-        }
-        else if (!strcmp(p_argv[0], "fb")) {
-        }
-        else if (!strcmp(p_argv[0], "quit")) {
-            net_Close(p_sys->i_socket);
-            p_sys->i_socket = -1;
-        }
-        else if (!strcmp(p_argv[0], "shutdown")) {
+    input_thread_t *p_input = p_sys->p_input;
+
+    vlc_mutex_lock(&p_sys->o_seek_lock);
+    p_sys->i_seek_date = mdate();
+    p_sys->i_seek_target = i_time;
+    p_sys->b_seek_fast = b_fast;
+    p_sys->b_seek_started = false;
+    p_sys->b_seek_report = b_report;
+    vlc_mutex_unlock(&p_sys->o_seek_lock);
+    input_Control(p_input, INPUT_SEEK_TIME, (int64_t)i_time, b_fast);
+}
 
-        }
-        else
-            goto msg;
+/* i_flags is a mix of SEEK_*: fast stops at a key frame, precise decodes
+ * up to the exact time, neither uses the input-fast-seek default */
+static void Seek(intf_thread_t *p_intf, mtime_t i_time, int i_flags) {
+    intf_sys_t *p_sys = p_intf->p_sys;
+    input_thread_t *p_input = p_sys->p_input;
+    bool b_fast;
+
+    if (!p_input) {
+        Notify(p_intf, EVENT_INPUT_ERROR, COMMAND_SEEK, ERROR_NO_INPUT, 0);
+        return;
     }
-    else if (i_argc == 2) {
-        if (!strcmp(p_argv[0], "open")) {
-            char *path = p_argv[1];
-            int len = strlen(path);
-            char *uri = malloc(len * 3 + 1);
-            if (!uri) {
-                Notify(p_intf, "oops\n");
-                goto out;
-            }
-            int i, j;
-            for (i = 0, j = 0; i < len; i++) {
-                uint8_t ch = path[i];
-
-                if (ch < 32 || ch > 127) {
-                    uri[j] = '%';
-                    uri[j + 1] = ch >> 4;
-                    uri[j + 1] += (uri[j + 1] > 9 ? 0x37 : 0x30);
-                    uri[j + 2] = ch & 15;
-                    uri[j + 2] += (uri[j + 2] > 9 ? 0x37 : 0x30);
-                    j += 3;
-                }
-                else {
-                    uri[j] = path[i];
-                    j++;
-                }
-            }
-            uri[j] = '\0';
-            char *name = malloc(len + 1);
-            if (name) {
-                int i;
-                for (i = len - 1; i >= 0; i--) {
-                    if (path[i] == '/')
-                        break;
-                }
-                i += 1;
-                strcpy(name, path + i);
-            }
-            input_item_t *p_item = input_item_New(p_intf, uri, name);
-            if (name)
-                free(name);
-            int i_ret = playlist_AddInput(p_playlist, p_item, PLAYLIST_GO | PLAYLIST_APPEND, PLAYLIST_END, true, pl_Unlocked);
-            vlc_gc_decref(p_item);
+    if (!var_GetBool(p_input, "can-seek")) {
+        Notify(p_intf, EVENT_INPUT_ERROR, COMMAND_SEEK, ERROR_CANNOT_SEEK, 0);
+        return;
+    }
+    if ((i_flags & (SEEK_FAST | SEEK_PRECISE)) == (SEEK_FAST | SEEK_PRECISE)) {
+        Notify(p_intf, EVENT_INPUT_ERROR, COMMAND_SEEK, ERROR_BAD_ARGUMENT, 0);
+        return;
+    }
+    if (i_flags & SEEK_FAST)
+        b_fast = true;
+    else if (i_flags & SEEK_PRECISE)
+        b_fast = false;
+    else
+        b_fast = var_InheritBool(p_intf, "input-fast-seek");
+    if (i_flags & SEEK_RELATIVE)
+        i_time += var_GetTime(p_input, "time");
+    if (i_time < 0)
+        i_time = 0;
+    if (p_sys->i_speed != 1)
+        SetSpeed(p_intf, 1);
+    SeekTo(p_intf, i_time, b_fast, true);
+}
+
+/* Plays at i_speed times the normal speed, backwards if negative */
+static void SetSpeed(intf_thread_t *p_intf, int i_speed) {
+    intf_sys_t *p_sys = p_intf->p_sys;
+    input_thread_t *p_input = p_sys->p_input;
+
+    if (!p_input)
+        return;
+    if (i_speed != 1 && !var_GetBool(p_input, "can-seek")) {
+        Notify(p_intf, EVENT_INPUT_ERROR, COMMAND_FAST_FORWARD, ERROR_CANNOT_SEEK, 0);
+        return;
+    }
+    /* a rate change is enough when the decoders can keep up */
+    if (i_speed > 0 && i_speed <= NOTIFY_RATE_MAX) {
+        ScanStop(p_intf);
+        var_SetFloat(p_input, "rate", (float)i_speed);
+    }
+    else {
+        var_SetFloat(p_input, "rate", 1.f);
+        if (!p_sys->b_scan) {
+            p_sys->b_scan = true;
+            p_sys->i_scan_time = var_GetTime(p_input, "time");
+            p_sys->i_scan_date = mdate();
+            /* the audio would only be bits and pieces */
+            p_sys->b_scan_muted = !aout_IsMuted(VLC_OBJECT(p_intf));
+            if (p_sys->b_scan_muted)
+                aout_SetMute(VLC_OBJECT(p_intf), NULL, true);
+            if (var_GetInteger(p_input, "state") == PAUSE_S)
+                input_Control(p_input, INPUT_SET_STATE, PLAYING_S);
         }
-        else if (!strcmp(p_argv[0], "seek")) {
+    }
+    p_sys->i_speed = i_speed;
+    Notify(p_intf, EVENT_INPUT_SPEED, i_speed, 0, 0);
+}
+
+/* ff/fb: i_dir is 1 for ff and -1 for fb. Without a speed (0), doubles
+ * the current one, starting over at 2 past NOTIFY_SPEED_MAX. */
+static void Speed(intf_thread_t *p_intf, int i_dir, int i_speed) {
+    intf_sys_t *p_sys = p_intf->p_sys;
 
+    if (i_speed) {
+        if (i_speed < 1 || i_speed > NOTIFY_SPEED_MAX) {
+            Notify(p_intf, EVENT_INPUT_ERROR, i_dir > 0 ? COMMAND_FAST_FORWARD : COMMAND_FAST_BACKWARD,
+                   ERROR_BAD_ARGUMENT, i_speed);
+            return;
         }
-        else
-            goto msg;
+        i_speed *= i_dir;
+    }
+    else if (p_sys->i_speed * i_dir > 1) {
+        i_speed = p_sys->i_speed * 2;
+        if (abs(i_speed) > NOTIFY_SPEED_MAX)
+            i_speed = 2 * i_dir;
     }
     else
-        goto msg;
-    goto out;
-msg:
-    msg_Dbg(VLC_OBJECT(p_intf), "unable to process command `%s'", p_string);
-out:
-    if (p_argv)
-        free(p_argv);
-    if (p_line)
-        free(p_line);
-    return;
+        i_speed = 2 * i_dir;
+    SetSpeed(p_intf, i_speed);
+}
+
+static void ScanStop(intf_thread_t *p_intf) {
+    intf_sys_t *p_sys = p_intf->p_sys;
+
+    if (!p_sys->b_scan)
+        return;
+    p_sys->b_scan = false;
+    if (p_sys->b_scan_muted)
+        aout_SetMute(VLC_OBJECT(p_intf), NULL, false);
+    p_sys->b_scan_muted = false;
+}
+
+/* Moves the scan position by the elapsed time times the speed, once the
+ * previous key frame is on screen. Returns the delay until the next call
+ * is due, or 0 when not scanning. */
+static mtime_t ScanTick(intf_thread_t *p_intf) {
+    intf_sys_t *p_sys = p_intf->p_sys;
+    input_thread_t *p_input = p_sys->p_input;
+    mtime_t i_now = mdate(), i_length, i_pending;
+
+    if (!p_sys->b_scan || !p_input)
+        return 0;
+    if (i_now < p_sys->i_scan_date + NOTIFY_SCAN_PERIOD)
+        return p_sys->i_scan_date + NOTIFY_SCAN_PERIOD - i_now;
+    vlc_mutex_lock(&p_sys->o_seek_lock);
+    i_pending = p_sys->i_seek_date;
+    vlc_mutex_unlock(&p_sys->o_seek_lock);
+    /* do not queue seeks faster than they complete */
+    if (i_pending && i_now < i_pending + NOTIFY_SEEK_TIMEOUT)
+        return NOTIFY_SCAN_PERIOD / 5;
+
+    p_sys->i_scan_time += p_sys->i_speed * (i_now - p_sys->i_scan_date);
+    p_sys->i_scan_date = i_now;
+    i_length = var_GetTime(p_input, "length");
+    if (p_sys->i_scan_time <= 0 || (i_length > 0 && p_sys->i_scan_time >= i_length)) {
+        /* reached an end, play from there */
+        p_sys->i_scan_time = p_sys->i_scan_time <= 0 ? 0 : i_length;
+        SeekTo(p_intf, p_sys->i_scan_time, true, false);
+        SetSpeed(p_intf, 1);
+        return 0;
+    }
+    SeekTo(p_intf, p_sys->i_scan_time, true, false);
+    return NOTIFY_SCAN_PERIOD;
 }
 
 static int InputEvent(vlc_object_t *p_this, char const *psz_cmd, vlc_value_t oldval, vlc_value_t newval, void *p_data) {
@@ -452,12 +531,10 @@ static int InputEvent(vlc_object_t *p_this, char const *psz_cmd, vlc_value_t old
         vlc_value_t val;
 
         var_Get(p_input, "state", &val);
-        Notify(p_intf, "input state %d\n", val.i_int);
+        Notify(p_intf, EVENT_INPUT_STATE, val.i_int, 0, 0);
         if (val.i_int == PLAYING_S) {
-            var_Get(p_input, "can-pause", &val);
-            Notify(p_intf, "input can-pause %d\n", val.i_int);
-            var_Get(p_input, "can-seek", &val);
-            Notify(p_intf, "input can-seek %d\n", val.i_int);
+            Notify(p_intf, EVENT_INPUT_CAN_PAUSE, var_GetBool(p_input, "can-pause"), 0, 0);
+            Notify(p_intf, EVENT_INPUT_CAN_SEEK, var_GetBool(p_input, "can-seek"), 0, 0);
         }
         break;
     }
@@ -468,17 +545,51 @@ static int InputEvent(vlc_object_t *p_this, char const *psz_cmd, vlc_value_t old
         break;
     }
     case INPUT_EVENT_POSITION: {
-        vlc_value_t val;
-
-        var_Get(p_input, "time", &val);
-        Notify(p_intf, "input time %"PRIu64"\n", val.i_time / 1000000);
+        /* far too frequent to be forwarded, see FlushTime() */
+        intf_sys_t *p_sys = p_intf->p_sys;
+        mtime_t i_time = var_GetTime(p_input, "time");
+        bool b_wakeup;
+
+        vlc_mutex_lock(&p_sys->o_time_lock);
+        b_wakeup = !p_sys->b_time_pending;
+        p_sys->i_time = i_time;
+        p_sys->b_time_pending = true;
+        vlc_mutex_unlock(&p_sys->o_time_lock);
+        if (b_wakeup)
+            write(p_sys->i_wakeup[1], &p_sys, 1);
+        break;
+    }
+    case INPUT_EVENT_CACHE: {
+        intf_sys_t *p_sys = p_intf->p_sys;
+        float f_cache = var_GetFloat(p_input, "cache");
+        mtime_t i_latency = 0, i_target = 0;
+        bool b_fast = false, b_report = false;
+
+        /* a seek empties the buffers, it is done once they are full again
+         * and the target picture is shown */
+        vlc_mutex_lock(&p_sys->o_seek_lock);
+        if (p_sys->i_seek_date) {
+            if (f_cache < 1.f)
+                p_sys->b_seek_started = true;
+            else if (p_sys->b_seek_started) {
+                i_latency = mdate() - p_sys->i_seek_date;
+                i_target = p_sys->i_seek_target;
+                b_fast = p_sys->b_seek_fast;
+                b_report = p_sys->b_seek_report;
+                p_sys->i_seek_date = 0;
+            }
+        }
+        vlc_mutex_unlock(&p_sys->o_seek_lock);
+        /* target and latency in milliseconds */
+        if (b_report)
+            Notify(p_intf, EVENT_INPUT_SEEK_DONE, i_target / 1000, i_latency / 1000, b_fast);
         break;
     }
     case INPUT_EVENT_LENGTH: {
         vlc_value_t val;
 
         var_Get(p_input, "length", &val);
-        Notify(p_intf, "input length %"PRIu64"\n", val.i_time / 1000000);
+        Notify(p_intf, EVENT_INPUT_LENGTH, val.i_time / CLOCK_FREQ, 0, 0);
         break;
     }
     case INPUT_EVENT_VOUT: {
@@ -490,13 +601,14 @@ static int InputEvent(vlc_object_t *p_this, char const *psz_cmd, vlc_value_t old
 
             //width = p_vout->i_window_width;
             //height = p_vout->i_window_height;
-            //Notify(p_intf, "video size %dx%d\n", width, height);
+            //Notify(p_intf, EVENT_INPUT_VOUT, width, height, 0);
+            vlc_object_release(p_vout);
         }
         break;
     }
     default:
         break;
     }
-
+    return VLC_SUCCESS;
 }
 
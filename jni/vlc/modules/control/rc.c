@@ -1898,6 +1898,8 @@ static int updateStatistics( intf_thread_t *p_intf, input_item_t *p_item )
             p_item->p_stats->i_displayed_pictures );
     msg_rc(_("| frames lost      :    %5"PRIi64),
             p_item->p_stats->i_lost_pictures );
+    msg_rc(_("| frames copied    :    %5"PRIi64),
+            p_item->p_stats->i_copied_pictures );
     msg_rc("|");
     /* Audio*/
     msg_rc("%s", _("+-[Audio Decoding]"));
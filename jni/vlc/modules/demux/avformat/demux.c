@@ -100,6 +100,7 @@ static int IORead( void *opaque, uint8_t *buf, int buf_size );
 static int64_t IOSeek( void *opaque, int64_t offset, int whence );
 
 static block_t *BuildSsaFrame( const AVPacket *p_pkt, unsigned i_order );
+static block_t *BuildFrame( AVPacket *p_pkt );
 static void UpdateSeekPoint( demux_t *p_demux, int64_t i_time );
 
 /*****************************************************************************
@@ -548,12 +549,9 @@ static int Demux( demux_t *p_demux )
     }
     else
     {
-        if( ( p_frame = block_New( p_demux, pkt.size ) ) == NULL )
-        {
-            av_free_packet( &pkt );
+        /* The block takes over the packet data */
+        if( ( p_frame = BuildFrame( &pkt ) ) == NULL )
             return 0;
-        }
-        memcpy( p_frame->p_buffer, pkt.data, pkt.size );
     }
 
     if( pkt.flags & PKT_FLAG_KEY )
@@ -603,6 +601,38 @@ static int Demux( demux_t *p_demux )
     return 1;
 }
 
+static void FreePacket( void *opaque )
+{
+    AVPacket *p_pkt = opaque;
+
+    av_free_packet( p_pkt );
+    free( p_pkt );
+}
+
+/* Wraps the packet data in a block without copying it.
+ * On success the packet is emptied, the block owns its data. */
+static block_t *BuildFrame( AVPacket *p_pkt )
+{
+    AVPacket *p_owned;
+
+    /* Packets pointing into the demuxer internal buffers get their own copy
+     * here, the usual allocated ones are left untouched */
+    if( av_dup_packet( p_pkt ) || ( p_owned = malloc( sizeof(*p_owned) ) ) == NULL )
+    {
+        av_free_packet( p_pkt );
+        return NULL;
+    }
+    *p_owned = *p_pkt;
+    p_pkt->data = NULL;
+    p_pkt->size = 0;
+    p_pkt->destruct = NULL;
+
+    /* libavformat allocates FF_INPUT_BUFFER_PADDING_SIZE bytes after the
+     * data, so the decoders can pad the block in place */
+    return block_foreign_Alloc( p_owned, FreePacket, p_owned->data,
+                                p_owned->size, FF_INPUT_BUFFER_PADDING_SIZE );
+}
+
 static void UpdateSeekPoint( demux_t *p_demux, int64_t i_time )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -730,20 +760,31 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             return VLC_SUCCESS;
 
         case DEMUX_SET_TIME:
-            i64 = (int64_t)va_arg( args, int64_t );
-            i64 = i64 *AV_TIME_BASE / 1000000;
+        {
+            const int64_t i_time = (int64_t)va_arg( args, int64_t );
+            const bool b_precise = (bool)va_arg( args, int );
+
+            i64 = i_time *AV_TIME_BASE / 1000000;
             if( p_sys->ic->start_time != (int64_t)AV_NOPTS_VALUE )
                 i64 += p_sys->ic->start_time;
 
-            msg_Warn( p_demux, "DEMUX_SET_TIME: %"PRId64, i64 );
+            msg_Warn( p_demux, "DEMUX_SET_TIME: %"PRId64"%s", i64,
+                      b_precise ? " (precise)" : "" );
 
-            if( av_seek_frame( p_sys->ic, -1, i64, 0 ) < 0 )
+            /* A precise seek starts from the key frame before the target
+             * and hides what is decoded until the target */
+            if( av_seek_frame( p_sys->ic, -1, i64,
+                               b_precise ? AVSEEK_FLAG_BACKWARD : 0 ) < 0 )
             {
                 return VLC_EGENERIC;
             }
+            if( b_precise )
+                es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME,
+                                VLC_TS_0 + i_time );
             p_sys->i_pcr = -1; /* Invalidate time display */
             UpdateSeekPoint( p_demux, i64 );
             return VLC_SUCCESS;
+        }
 
         case DEMUX_HAS_UNSUPPORTED_META:
         {
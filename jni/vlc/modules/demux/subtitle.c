@@ -37,6 +37,7 @@
 #include <vlc_memory.h>
 
 #include <ctype.h>
+#include <limits.h>
 
 #include <vlc_demux.h>
 #include <vlc_charset.h>
@@ -124,17 +125,23 @@ typedef struct
     int     i_line_count;
     int     i_line;
     char    **line;
+    char    *p_data;    /* Holds all the lines when they were read at once */
 } text_t;
 
 static int  TextLoad( text_t *, stream_t *s );
 static void TextUnload( text_t * );
 
+/* The formats with a pf_text function only record where the text of a
+ * subtitle is while loading, psz_text is then NULL and the text is built
+ * from the loaded lines when the subtitle is sent. */
 typedef struct
 {
     int64_t i_start;
     int64_t i_stop;
 
     char    *psz_text;
+    int     i_line;     /* First line of the text */
+    int     i_order;    /* In the file */
 } subtitle_t;
 
 
@@ -148,9 +155,12 @@ struct demux_sys_t
     int64_t     i_microsecperframe;
 
     char        *psz_header;
+    size_t      i_header;
     int         i_subtitle;
     int         i_subtitles;
     subtitle_t  *subtitle;
+    int64_t     *pi_stop_max;   /* running max of the stop dates */
+    char        *(*pf_text)( demux_t *, const subtitle_t * );
 
     int64_t     i_length;
 
@@ -190,34 +200,39 @@ static int  ParseRealText   ( demux_t *, subtitle_t *, int );
 static int  ParseDKS        ( demux_t *, subtitle_t *, int );
 static int  ParseSubViewer1 ( demux_t *, subtitle_t *, int );
 
+static char *TextSubRip     ( demux_t *, const subtitle_t * );
+static char *TextSubViewer  ( demux_t *, const subtitle_t * );
+static char *TextSSA        ( demux_t *, const subtitle_t * );
+
 static const struct
 {
     const char *psz_type_name;
     int  i_type;
     const char *psz_name;
     int  (*pf_read)( demux_t *, subtitle_t*, int );
+    char *(*pf_text)( demux_t *, const subtitle_t * );
 } sub_read_subtitle_function [] =
 {
-    { "microdvd",   SUB_TYPE_MICRODVD,    "MicroDVD",    ParseMicroDvd },
-    { "subrip",     SUB_TYPE_SUBRIP,      "SubRIP",      ParseSubRip },
-    { "subrip-dot", SUB_TYPE_SUBRIP_DOT,  "SubRIP(Dot)", ParseSubRipDot },
-    { "subviewer",  SUB_TYPE_SUBVIEWER,   "SubViewer",   ParseSubViewer },
-    { "ssa1",       SUB_TYPE_SSA1,        "SSA-1",       ParseSSA },
-    { "ssa2-4",     SUB_TYPE_SSA2_4,      "SSA-2/3/4",   ParseSSA },
-    { "ass",        SUB_TYPE_ASS,         "SSA/ASS",     ParseSSA },
-    { "vplayer",    SUB_TYPE_VPLAYER,     "VPlayer",     ParseVplayer },
-    { "sami",       SUB_TYPE_SAMI,        "SAMI",        ParseSami },
-    { "dvdsubtitle",SUB_TYPE_DVDSUBTITLE, "DVDSubtitle", ParseDVDSubtitle },
-    { "mpl2",       SUB_TYPE_MPL2,        "MPL2",        ParseMPL2 },
-    { "aqt",        SUB_TYPE_AQT,         "AQTitle",     ParseAQT },
-    { "pjs",        SUB_TYPE_PJS,         "PhoenixSub",  ParsePJS },
-    { "mpsub",      SUB_TYPE_MPSUB,       "MPSub",       ParseMPSub },
-    { "jacosub",    SUB_TYPE_JACOSUB,     "JacoSub",     ParseJSS },
-    { "psb",        SUB_TYPE_PSB,         "PowerDivx",   ParsePSB },
-    { "realtext",   SUB_TYPE_RT,          "RealText",    ParseRealText },
-    { "dks",        SUB_TYPE_DKS,         "DKS",         ParseDKS },
-    { "subviewer1", SUB_TYPE_SUBVIEW1,    "Subviewer 1", ParseSubViewer1 },
-    { NULL,         SUB_TYPE_UNKNOWN,     "Unknown",     NULL }
+    { "microdvd",   SUB_TYPE_MICRODVD,    "MicroDVD",    ParseMicroDvd,    NULL },
+    { "subrip",     SUB_TYPE_SUBRIP,      "SubRIP",      ParseSubRip,      TextSubRip },
+    { "subrip-dot", SUB_TYPE_SUBRIP_DOT,  "SubRIP(Dot)", ParseSubRipDot,   TextSubRip },
+    { "subviewer",  SUB_TYPE_SUBVIEWER,   "SubViewer",   ParseSubViewer,   TextSubViewer },
+    { "ssa1",       SUB_TYPE_SSA1,        "SSA-1",       ParseSSA,         TextSSA },
+    { "ssa2-4",     SUB_TYPE_SSA2_4,      "SSA-2/3/4",   ParseSSA,         TextSSA },
+    { "ass",        SUB_TYPE_ASS,         "SSA/ASS",     ParseSSA,         TextSSA },
+    { "vplayer",    SUB_TYPE_VPLAYER,     "VPlayer",     ParseVplayer,     NULL },
+    { "sami",       SUB_TYPE_SAMI,        "SAMI",        ParseSami,        NULL },
+    { "dvdsubtitle",SUB_TYPE_DVDSUBTITLE, "DVDSubtitle", ParseDVDSubtitle, NULL },
+    { "mpl2",       SUB_TYPE_MPL2,        "MPL2",        ParseMPL2,        NULL },
+    { "aqt",        SUB_TYPE_AQT,         "AQTitle",     ParseAQT,         NULL },
+    { "pjs",        SUB_TYPE_PJS,         "PhoenixSub",  ParsePJS,         NULL },
+    { "mpsub",      SUB_TYPE_MPSUB,       "MPSub",       ParseMPSub,       NULL },
+    { "jacosub",    SUB_TYPE_JACOSUB,     "JacoSub",     ParseJSS,         NULL },
+    { "psb",        SUB_TYPE_PSB,         "PowerDivx",   ParsePSB,         NULL },
+    { "realtext",   SUB_TYPE_RT,          "RealText",    ParseRealText,    NULL },
+    { "dks",        SUB_TYPE_DKS,         "DKS",         ParseDKS,         NULL },
+    { "subviewer1", SUB_TYPE_SUBVIEW1,    "Subviewer 1", ParseSubViewer1,  NULL },
+    { NULL,         SUB_TYPE_UNKNOWN,     "Unknown",     NULL,             NULL }
 };
 /* When adding support for more formats, be sure to add their file extension
  * to src/input/subtitles.c to enable auto-detection.
@@ -227,6 +242,8 @@ static int Demux( demux_t * );
 static int Control( demux_t *, int, va_list );
 
 static void Fix( demux_t * );
+static int  Find( demux_sys_t *, int64_t i_date );
+static int  FindDisplayed( demux_sys_t *, int64_t i_date );
 
 /*****************************************************************************
  * Module initializer
@@ -254,9 +271,12 @@ static int Open ( vlc_object_t *p_this )
         return VLC_ENOMEM;
 
     p_sys->psz_header         = NULL;
+    p_sys->i_header           = 0;
     p_sys->i_subtitle         = 0;
     p_sys->i_subtitles        = 0;
     p_sys->subtitle           = NULL;
+    p_sys->pi_stop_max        = NULL;
+    p_sys->pf_text            = NULL;
     p_sys->i_microsecperframe = 40000;
 
     p_sys->jss.b_inited       = false;
@@ -467,14 +487,19 @@ static int Open ( vlc_object_t *p_this )
             msg_Dbg( p_demux, "detected %s format",
                      sub_read_subtitle_function[i].psz_name );
             pf_read = sub_read_subtitle_function[i].pf_read;
+            p_sys->pf_text = sub_read_subtitle_function[i].pf_text;
             break;
         }
     }
 
     msg_Dbg( p_demux, "loading all subtitles..." );
 
-    /* Load the whole file */
-    TextLoad( &p_sys->txt, p_demux->s );
+    /* Load the whole file, it is kept for the formats read lazily */
+    if( TextLoad( &p_sys->txt, p_demux->s ) )
+    {
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
 
     /* Parse it */
     for( i_max = 0;; )
@@ -491,18 +516,22 @@ static int Open ( vlc_object_t *p_this )
             }
         }
 
-        if( pf_read( p_demux, &p_sys->subtitle[p_sys->i_subtitles],
-                     p_sys->i_subtitles ) )
+        subtitle_t *p_subtitle = &p_sys->subtitle[p_sys->i_subtitles];
+
+        p_subtitle->psz_text = NULL;
+        p_subtitle->i_line = -1;
+        if( pf_read( p_demux, p_subtitle, p_sys->i_subtitles ) )
             break;
 
-        p_sys->i_subtitles++;
+        p_subtitle->i_order = p_sys->i_subtitles++;
     }
-    /* Unload */
-    TextUnload( &p_sys->txt );
+    if( !p_sys->pf_text )
+        TextUnload( &p_sys->txt );
 
     msg_Dbg(p_demux, "loaded %d subtitles", p_sys->i_subtitles );
 
     /* Fix subtitle (order and time) *** */
+    Fix( p_demux );
     p_sys->i_subtitle = 0;
     p_sys->i_length = 0;
     if( p_sys->i_subtitles > 0 )
@@ -518,7 +547,6 @@ static int Open ( vlc_object_t *p_this )
              p_sys->i_type == SUB_TYPE_SSA2_4 ||
              p_sys->i_type == SUB_TYPE_ASS )
     {
-        Fix( p_demux );
         es_format_Init( &fmt, SPU_ES, VLC_CODEC_SSA );
     }
     else
@@ -553,7 +581,11 @@ static void Close( vlc_object_t *p_this )
     for( i = 0; i < p_sys->i_subtitles; i++ )
         free( p_sys->subtitle[i].psz_text );
     free( p_sys->subtitle );
+    free( p_sys->pi_stop_max );
+    if( p_sys->pf_text )
+        TextUnload( &p_sys->txt );
 
+    free( p_sys->psz_header );
     free( p_sys );
 }
 
@@ -584,18 +616,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         case DEMUX_SET_TIME:
             i64 = (int64_t)va_arg( args, int64_t );
-            p_sys->i_subtitle = 0;
-            while( p_sys->i_subtitle < p_sys->i_subtitles )
-            {
-                const subtitle_t *p_subtitle = &p_sys->subtitle[p_sys->i_subtitle];
-
-                if( p_subtitle->i_start > i64 )
-                    break;
-                if( p_subtitle->i_stop > p_subtitle->i_start && p_subtitle->i_stop > i64 )
-                    break;
-
-                p_sys->i_subtitle++;
-            }
+            p_sys->i_subtitle = FindDisplayed( p_sys, i64 );
 
             if( p_sys->i_subtitle >= p_sys->i_subtitles )
                 return VLC_EGENERIC;
@@ -622,12 +643,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             f = (double)va_arg( args, double );
             i64 = f * p_sys->i_length;
 
-            p_sys->i_subtitle = 0;
-            while( p_sys->i_subtitle < p_sys->i_subtitles &&
-                   p_sys->subtitle[p_sys->i_subtitle].i_start < i64 )
-            {
-                p_sys->i_subtitle++;
-            }
+            p_sys->i_subtitle = Find( p_sys, i64 - 1 );
             if( p_sys->i_subtitle >= p_sys->i_subtitles )
                 return VLC_EGENERIC;
             return VLC_SUCCESS;
@@ -673,18 +689,20 @@ static int Demux( demux_t *p_demux )
            p_sys->subtitle[p_sys->i_subtitle].i_start < i_maxdate )
     {
         const subtitle_t *p_subtitle = &p_sys->subtitle[p_sys->i_subtitle];
+        const char *psz_text = p_subtitle->psz_text;
+        char *psz_lazy = NULL;
 
         block_t *p_block;
-        int i_len = strlen( p_subtitle->psz_text ) + 1;
 
-        if( i_len <= 1 || p_subtitle->i_start < 0 )
-        {
-            p_sys->i_subtitle++;
-            continue;
-        }
+        if( !psz_text && p_sys->pf_text )
+            psz_text = psz_lazy = p_sys->pf_text( p_demux, p_subtitle );
 
-        if( ( p_block = block_New( p_demux, i_len ) ) == NULL )
+        int i_len = psz_text ? strlen( psz_text ) + 1 : 0;
+
+        if( i_len <= 1 || p_subtitle->i_start < 0 ||
+            ( p_block = block_New( p_demux, i_len ) ) == NULL )
         {
+            free( psz_lazy );
             p_sys->i_subtitle++;
             continue;
         }
@@ -694,7 +712,8 @@ static int Demux( demux_t *p_demux )
         if( p_subtitle->i_stop >= 0 && p_subtitle->i_stop >= p_subtitle->i_start )
             p_block->i_length = p_subtitle->i_stop - p_subtitle->i_start;
 
-        memcpy( p_block->p_buffer, p_subtitle->psz_text, i_len );
+        memcpy( p_block->p_buffer, psz_text, i_len );
+        free( psz_lazy );
 
         es_out_Send( p_demux->out, p_sys->es, p_block );
 
@@ -710,47 +729,117 @@ static int Demux( demux_t *p_demux )
 /*****************************************************************************
  * Fix: fix time stamp and order of subtitle
  *****************************************************************************/
+static int SubtitleCmp( const void *a, const void *b )
+{
+    const subtitle_t *p_a = a, *p_b = b;
+
+    if( p_a->i_start != p_b->i_start )
+        return p_a->i_start < p_b->i_start ? -1 : 1;
+    /* Keep the file order, it is the drawing order of SSA */
+    return p_a->i_order - p_b->i_order;
+}
+
 static void Fix( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    bool b_done;
+    int i_index;
 
-    /* *** fix order (to be sure...) *** */
-    /* We suppose that there are near in order and this durty bubble sort
-     * wont take too much time
-     */
-    do
+    /* They are nearly always in order already */
+    for( i_index = 1; i_index < p_sys->i_subtitles; i_index++ )
+    {
+        if( p_sys->subtitle[i_index].i_start <
+            p_sys->subtitle[i_index - 1].i_start )
+            break;
+    }
+    if( i_index < p_sys->i_subtitles )
+        qsort( p_sys->subtitle, p_sys->i_subtitles, sizeof(*p_sys->subtitle),
+               SubtitleCmp );
+
+    /* Stop dates are not sorted, a long subtitle may still be displayed
+     * after many shorter ones: keep their running max for the seeks */
+    if( p_sys->i_subtitles <= 0 )
+        return;
+    p_sys->pi_stop_max = malloc( p_sys->i_subtitles * sizeof(*p_sys->pi_stop_max) );
+    if( !p_sys->pi_stop_max )
+        return;
+
+    int64_t i_stop_max = INT64_MIN;
+    for( i_index = 0; i_index < p_sys->i_subtitles; i_index++ )
+    {
+        const subtitle_t *p_subtitle = &p_sys->subtitle[i_index];
+
+        /* Without a valid stop date, a subtitle is not displayed after its start */
+        const int64_t i_stop = p_subtitle->i_stop > p_subtitle->i_start ?
+                               p_subtitle->i_stop : p_subtitle->i_start;
+        if( i_stop > i_stop_max )
+            i_stop_max = i_stop;
+        p_sys->pi_stop_max[i_index] = i_stop_max;
+    }
+}
+
+/*****************************************************************************
+ * Find: index of the first subtitle starting after i_date
+ *****************************************************************************/
+static int Find( demux_sys_t *p_sys, int64_t i_date )
+{
+    int i_low = 0;
+    int i_high = p_sys->i_subtitles;
+
+    while( i_low < i_high )
+    {
+        const int i_mid = i_low + ( i_high - i_low ) / 2;
+
+        if( p_sys->subtitle[i_mid].i_start > i_date )
+            i_high = i_mid;
+        else
+            i_low = i_mid + 1;
+    }
+    return i_low;
+}
+
+/*****************************************************************************
+ * FindDisplayed: index of the first subtitle displayed at or after i_date
+ *****************************************************************************/
+static int FindDisplayed( demux_sys_t *p_sys, int64_t i_date )
+{
+    const int i_end = Find( p_sys, i_date );
+
+    if( !p_sys->pi_stop_max )
     {
-        b_done = true;
-        for( int i_index = 1; i_index < p_sys->i_subtitles; i_index++ )
+        /* Check every subtitle already started */
+        for( int i = 0; i < i_end; i++ )
         {
-            if( p_sys->subtitle[i_index].i_start <
-                p_sys->subtitle[i_index - 1].i_start )
-            {
-                subtitle_t sub_xch;
-                memcpy( &sub_xch,
-                        p_sys->subtitle + i_index - 1,
-                        sizeof( subtitle_t ) );
-                memcpy( p_sys->subtitle + i_index - 1,
-                        p_sys->subtitle + i_index,
-                        sizeof( subtitle_t ) );
-                memcpy( p_sys->subtitle + i_index,
-                        &sub_xch,
-                        sizeof( subtitle_t ) );
-                b_done = false;
-            }
+            const subtitle_t *p_subtitle = &p_sys->subtitle[i];
+
+            if( p_subtitle->i_stop > p_subtitle->i_start &&
+                p_subtitle->i_stop > i_date )
+                return i;
         }
-    } while( !b_done );
+        return i_end;
+    }
+
+    /* First subtitle for which one up to it stops after i_date */
+    int i_low = 0;
+    int i_high = i_end;
+
+    while( i_low < i_high )
+    {
+        const int i_mid = i_low + ( i_high - i_low ) / 2;
+
+        if( p_sys->pi_stop_max[i_mid] > i_date )
+            i_high = i_mid;
+        else
+            i_low = i_mid + 1;
+    }
+    return i_low;
 }
 
-static int TextLoad( text_t *txt, stream_t *s )
+static int TextLoadLines( text_t *txt, stream_t *s )
 {
     int   i_line_max;
 
     /* init txt */
     i_line_max          = 500;
-    txt->i_line_count   = 0;
-    txt->i_line         = 0;
     txt->line           = calloc( i_line_max, sizeof( char * ) );
     if( !txt->line )
         return VLC_ENOMEM;
@@ -781,13 +870,92 @@ static int TextLoad( text_t *txt, stream_t *s )
 
     return VLC_SUCCESS;
 }
+
+static int TextLoad( text_t *txt, stream_t *s )
+{
+    const int64_t i_size = stream_Size( s ) - stream_Tell( s );
+    const uint8_t *p_peek;
+
+    /* init txt */
+    txt->i_line_count   = 0;
+    txt->i_line         = 0;
+    txt->line           = NULL;
+    txt->p_data         = NULL;
+
+    /* stream_ReadLine() converts UTF-16, such files are read line by line */
+    if( i_size <= 0 || i_size >= INT_MAX ||
+        ( stream_Peek( s, &p_peek, 2 ) == 2 &&
+          ( ( p_peek[0] == 0xFF && p_peek[1] == 0xFE ) ||
+            ( p_peek[0] == 0xFE && p_peek[1] == 0xFF ) ) ) )
+        return TextLoadLines( txt, s );
+
+    /* Read the file at once and cut the lines in place */
+    char *p_data = malloc( i_size + 1 );
+    if( !p_data )
+        return VLC_ENOMEM;
+
+    const int i_data = stream_Read( s, p_data, i_size );
+    if( i_data <= 0 )
+    {
+        free( p_data );
+        return VLC_EGENERIC;
+    }
+    p_data[i_data] = '\0';
+
+    char *p = p_data;
+    char *p_end = p_data + i_data;
+    int i_line_max = 1;
+
+    if( i_data >= 3 && !memcmp( p, "\xEF\xBB\xBF", 3 ) )
+        p += 3;
+    for( const char *q = p; ( q = memchr( q, '\n', p_end - q ) ) != NULL; q++ )
+        i_line_max++;
+
+    txt->line = malloc( i_line_max * sizeof( char * ) );
+    if( !txt->line )
+    {
+        free( p_data );
+        return VLC_ENOMEM;
+    }
+
+    while( p < p_end )
+    {
+        char *psz_eol = memchr( p, '\n', p_end - p );
+        char *psz_next = psz_eol ? psz_eol + 1 : p_end;
+
+        if( !psz_eol )
+            psz_eol = p_end;
+        /* Same lines as stream_ReadLine() */
+        while( psz_eol > p && psz_eol[-1] == '\r' )
+            psz_eol--;
+        *psz_eol = '\0';
+
+        txt->line[txt->i_line_count++] = p;
+        p = psz_next;
+    }
+
+    if( txt->i_line_count <= 0 )
+    {
+        free( txt->line );
+        free( p_data );
+        return VLC_EGENERIC;
+    }
+    txt->p_data = p_data;
+
+    return VLC_SUCCESS;
+}
 static void TextUnload( text_t *txt )
 {
     int i;
 
-    for( i = 0; i < txt->i_line_count; i++ )
+    if( txt->p_data )
     {
-        free( txt->line[i] );
+        free( txt->p_data );
+    }
+    else
+    {
+        for( i = 0; i < txt->i_line_count; i++ )
+            free( txt->line[i] );
     }
     free( txt->line );
     txt->i_line       = 0;
@@ -885,12 +1053,10 @@ static int ParseMicroDvd( demux_t *p_demux, subtitle_t *p_subtitle,
  *  We ignore line number for SubRip
  */
 static int ParseSubRipSubViewer( demux_t *p_demux, subtitle_t *p_subtitle,
-                                 const char *psz_fmt,
-                                 bool b_replace_br )
+                                 const char *psz_fmt )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
     text_t      *txt = &p_sys->txt;
-    char    *psz_text;
 
     for( ;; )
     {
@@ -918,45 +1084,68 @@ static int ParseSubRipSubViewer( demux_t *p_demux, subtitle_t *p_subtitle,
         }
     }
 
-    /* Now read text until an empty line */
-    psz_text = strdup("");
-    if( !psz_text )
-        return VLC_ENOMEM;
-
+    /* The text goes until an empty line, it is read by TextSubRipSubViewer */
+    p_subtitle->i_line = txt->i_line;
     for( ;; )
     {
         const char *s = TextGetLine( txt );
-        int i_len;
-        int i_old;
 
-        i_len = s ? strlen( s ) : 0;
-        if( i_len <= 0 )
-        {
-            p_subtitle->psz_text = psz_text;
+        if( !s || *s == '\0' )
             return VLC_SUCCESS;
-        }
+    }
+}
+static char *TextSubRipSubViewer( demux_t *p_demux,
+                                  const subtitle_t *p_subtitle,
+                                  bool b_replace_br )
+{
+    const text_t *txt = &p_demux->p_sys->txt;
+    size_t i_len = 0;
+    int i_line;
+    char *psz_text, *p;
 
-        i_old = strlen( psz_text );
-        psz_text = realloc_or_free( psz_text, i_old + i_len + 1 + 1 );
-        if( !psz_text )
-        {
-            return VLC_ENOMEM;
-        }
-        strcat( psz_text, s );
-        strcat( psz_text, "\n" );
+    for( i_line = p_subtitle->i_line;
+         i_line < txt->i_line_count && *txt->line[i_line]; i_line++ )
+        i_len += strlen( txt->line[i_line] ) + 1;
+
+    psz_text = p = malloc( i_len + 1 );
+    if( !psz_text )
+        return NULL;
+
+    for( i_line = p_subtitle->i_line;
+         i_line < txt->i_line_count && *txt->line[i_line]; i_line++ )
+    {
+        const char *s = txt->line[i_line];
+        size_t i_rest;
 
-        /* replace [br] by \n */
         if( b_replace_br )
         {
-            char *p;
+            /* replace [br] by \n */
+            const char *psz_br;
 
-            while( ( p = strstr( psz_text, "[br]" ) ) )
+            while( ( psz_br = strstr( s, "[br]" ) ) )
             {
+                memcpy( p, s, psz_br - s );
+                p += psz_br - s;
                 *p++ = '\n';
-                memmove( p, &p[3], strlen(&p[3])+1 );
+                s = psz_br + 4;
             }
         }
+        i_rest = strlen( s );
+        memcpy( p, s, i_rest );
+        p += i_rest;
+        *p++ = '\n';
     }
+    *p = '\0';
+
+    return psz_text;
+}
+static char *TextSubRip( demux_t *p_demux, const subtitle_t *p_subtitle )
+{
+    return TextSubRipSubViewer( p_demux, p_subtitle, false );
+}
+static char *TextSubViewer( demux_t *p_demux, const subtitle_t *p_subtitle )
+{
+    return TextSubRipSubViewer( p_demux, p_subtitle, true );
 }
 /* ParseSubRip
  */
@@ -965,8 +1154,7 @@ static int  ParseSubRip( demux_t *p_demux, subtitle_t *p_subtitle,
 {
     VLC_UNUSED( i_idx );
     return ParseSubRipSubViewer( p_demux, p_subtitle,
-                                 "%d:%d:%d,%d --> %d:%d:%d,%d",
-                                 false );
+                                 "%d:%d:%d,%d --> %d:%d:%d,%d" );
 }
 /* ParseSubRipDot
  * Special version for buggy file using '.' instead of ','
@@ -976,8 +1164,7 @@ static int  ParseSubRipDot( demux_t *p_demux, subtitle_t *p_subtitle,
 {
     VLC_UNUSED( i_idx );
     return ParseSubRipSubViewer( p_demux, p_subtitle,
-                                 "%d:%d:%d.%d --> %d:%d:%d.%d",
-                                 false );
+                                 "%d:%d:%d.%d --> %d:%d:%d.%d" );
 }
 /* ParseSubViewer
  */
@@ -987,8 +1174,47 @@ static int  ParseSubViewer( demux_t *p_demux, subtitle_t *p_subtitle,
     VLC_UNUSED( i_idx );
 
     return ParseSubRipSubViewer( p_demux, p_subtitle,
-                                 "%d:%d:%d.%d,%d:%d:%d.%d",
-                                 true );
+                                 "%d:%d:%d.%d,%d:%d:%d.%d" );
+}
+
+/* SSAScanDialogue:
+ *  Reads the layer (or marked) field and the times of a dialogue line,
+ *  returns the offset of the remaining fields or -1
+ */
+static int SSAScanDialogue( const char *s, char psz_layer[16],
+                            int64_t *pi_start, int64_t *pi_stop )
+{
+    int h1, m1, s1, c1, h2, m2, s2, c2;
+    int i_text = 0;
+
+    /* We expect (SSA2-4):
+     * Format: Marked, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text
+     * Dialogue: Marked=0,0:02:40.65,0:02:41.79,Wolf main,Cher,0000,0000,0000,,Et les enregistrements de ses ondes delta ?
+     *
+     * SSA-1 is similar but only has 8 commas up untill the subtitle text. Probably the Effect field is no present, but not 100 % sure.
+     */
+
+    /* For ASS:
+     * Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text
+     * Dialogue: Layer#,0:02:40.65,0:02:41.79,Wolf main,Cher,0000,0000,0000,,Et les enregistrements de ses ondes delta ?
+     */
+    if( sscanf( s,
+                "Dialogue: %15[^,],%d:%d:%d.%d,%d:%d:%d.%d,%n",
+                psz_layer,
+                &h1, &m1, &s1, &c1,
+                &h2, &m2, &s2, &c2,
+                &i_text ) != 9 || i_text <= 0 || s[i_text] == '\0' )
+        return -1;
+
+    *pi_start = ( (int64_t)h1 * 3600*1000 +
+                  (int64_t)m1 * 60*1000 +
+                  (int64_t)s1 * 1000 +
+                  (int64_t)c1 * 10 ) * 1000;
+    *pi_stop  = ( (int64_t)h2 * 3600*1000 +
+                  (int64_t)m2 * 60*1000 +
+                  (int64_t)s2 * 1000 +
+                  (int64_t)c2 * 10 ) * 1000;
+    return i_text;
 }
 
 /* ParseSSA
@@ -996,82 +1222,70 @@ static int  ParseSubViewer( demux_t *p_demux, subtitle_t *p_subtitle,
 static int  ParseSSA( demux_t *p_demux, subtitle_t *p_subtitle,
                       int i_idx )
 {
+    VLC_UNUSED( i_idx );
     demux_sys_t *p_sys = p_demux->p_sys;
     text_t      *txt = &p_sys->txt;
 
     for( ;; )
     {
         const char *s = TextGetLine( txt );
-        int h1, m1, s1, c1, h2, m2, s2, c2;
-        char *psz_text;
         char temp[16];
 
         if( !s )
             return VLC_EGENERIC;
 
-        /* We expect (SSA2-4):
-         * Format: Marked, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text
-         * Dialogue: Marked=0,0:02:40.65,0:02:41.79,Wolf main,Cher,0000,0000,0000,,Et les enregistrements de ses ondes delta ?
-         *
-         * SSA-1 is similar but only has 8 commas up untill the subtitle text. Probably the Effect field is no present, but not 100 % sure.
-         */
-
-        /* For ASS:
-         * Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text
-         * Dialogue: Layer#,0:02:40.65,0:02:41.79,Wolf main,Cher,0000,0000,0000,,Et les enregistrements de ses ondes delta ?
-         */
-
-        /* The output text is - at least, not removing numbers - 18 chars shorter than the input text. */
-        psz_text = malloc( strlen(s) );
-        if( !psz_text )
-            return VLC_ENOMEM;
-
-        if( sscanf( s,
-                    "Dialogue: %15[^,],%d:%d:%d.%d,%d:%d:%d.%d,%[^\r\n]",
-                    temp,
-                    &h1, &m1, &s1, &c1,
-                    &h2, &m2, &s2, &c2,
-                    psz_text ) == 10 )
+        if( SSAScanDialogue( s, temp, &p_subtitle->i_start,
+                             &p_subtitle->i_stop ) >= 0 )
         {
-            /* The dec expects: ReadOrder, Layer, Style, Name, MarginL, MarginR, MarginV, Effect, Text */
-            /* (Layer comes from ASS specs ... it's empty for SSA.) */
-            if( p_sys->i_type == SUB_TYPE_SSA1 )
-            {
-                /* SSA1 has only 8 commas before the text starts, not 9 */
-                memmove( &psz_text[1], psz_text, strlen(psz_text)+1 );
-                psz_text[0] = ',';
-            }
-            else
-            {
-                int i_layer = ( p_sys->i_type == SUB_TYPE_ASS ) ? atoi( temp ) : 0;
-
-                /* ReadOrder, Layer, %s(rest of fields) */
-                snprintf( temp, sizeof(temp), "%d,%d,", i_idx, i_layer );
-                memmove( psz_text + strlen(temp), psz_text, strlen(psz_text)+1 );
-                memcpy( psz_text, temp, strlen(temp) );
-            }
-
-            p_subtitle->i_start = ( (int64_t)h1 * 3600*1000 +
-                                    (int64_t)m1 * 60*1000 +
-                                    (int64_t)s1 * 1000 +
-                                    (int64_t)c1 * 10 ) * 1000;
-            p_subtitle->i_stop  = ( (int64_t)h2 * 3600*1000 +
-                                    (int64_t)m2 * 60*1000 +
-                                    (int64_t)s2 * 1000 +
-                                    (int64_t)c2 * 10 ) * 1000;
-            p_subtitle->psz_text = psz_text;
+            /* The text is formatted by TextSSA */
+            p_subtitle->i_line = txt->i_line - 1;
             return VLC_SUCCESS;
         }
-        free( psz_text );
 
         /* All the other stuff we add to the header field */
-        char *psz_header;
-        if( asprintf( &psz_header, "%s%s\n",
-                       p_sys->psz_header ? p_sys->psz_header : "", s ) == -1 )
+        const size_t i_len = strlen( s );
+        char *psz_header = realloc( p_sys->psz_header,
+                                    p_sys->i_header + i_len + 2 );
+        if( !psz_header )
             return VLC_ENOMEM;
+        memcpy( &psz_header[p_sys->i_header], s, i_len );
+        p_sys->i_header += i_len;
+        psz_header[p_sys->i_header++] = '\n';
+        psz_header[p_sys->i_header] = '\0';
         p_sys->psz_header = psz_header;
     }
 }
+static char *TextSSA( demux_t *p_demux, const subtitle_t *p_subtitle )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const char *s = p_sys->txt.line[p_subtitle->i_line];
+    int64_t i_start, i_stop;
+    char temp[16];
+    char *psz_text;
+
+    const int i_text = SSAScanDialogue( s, temp, &i_start, &i_stop );
+    if( i_text < 0 )
+        return NULL;
+
+    /* The dec expects: ReadOrder, Layer, Style, Name, MarginL, MarginR, MarginV, Effect, Text */
+    /* (Layer comes from ASS specs ... it's empty for SSA.) */
+    if( p_sys->i_type == SUB_TYPE_SSA1 )
+    {
+        /* SSA1 has only 8 commas before the text starts, not 9 */
+        if( asprintf( &psz_text, ",%s", &s[i_text] ) == -1 )
+            return NULL;
+    }
+    else
+    {
+        int i_layer = ( p_sys->i_type == SUB_TYPE_ASS ) ? atoi( temp ) : 0;
+
+        /* ReadOrder, Layer, %s(rest of fields) */
+        if( asprintf( &psz_text, "%d,%d,%s", p_subtitle->i_order, i_layer,
+                      &s[i_text] ) == -1 )
+            return NULL;
+    }
+    return psz_text;
+}
 
 /* ParseVplayer
  *  Format
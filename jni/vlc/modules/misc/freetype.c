@@ -113,6 +113,11 @@ static void Destroy( vlc_object_t * );
     "fonts that will be rendered on the video. If absolute font size is set, "\
     "relative size will be overridden." )
 
+#define CACHE_TEXT N_("Glyph cache size (kB)")
+#define CACHE_LONGTEXT N_("Memory used to keep the rasterized glyphs, so " \
+    "that the characters of a subtitle are not rendered again each time " \
+    "it is drawn." )
+
 static const int pi_sizes[] = { 20, 18, 16, 12, 6 };
 static const char *const ppsz_sizes_text[] = {
     N_("Smaller"), N_("Small"), N_("Normal"), N_("Large"), N_("Larger") };
@@ -176,6 +181,8 @@ vlc_module_begin ()
 
     add_bool( "freetype-yuvp", false, YUVP_TEXT,
               YUVP_LONGTEXT, true )
+    add_integer( "freetype-cache-size", 1024, CACHE_TEXT,
+                 CACHE_LONGTEXT, true )
     set_capability( "text renderer", 100 )
     add_shortcut( "text" )
     set_callbacks( Create, Destroy )
@@ -249,6 +256,90 @@ static int Render( filter_t *, subpicture_region_t *, line_desc_t *, int, int);
 static void FreeLines( line_desc_t * );
 static void FreeLine( line_desc_t * );
 
+/*****************************************************************************
+ * Glyph cache
+ *****************************************************************************
+ * The bitmaps of the glyphs are kept in a hash table and a LRU list, keyed by
+ * face, pixel size, glyph index and synthetic style. The lines only borrow
+ * them, so the cache is trimmed once a string has been rendered.
+ *****************************************************************************/
+#define GLYPH_CACHE_HASH 256
+
+#define GLYPH_BOLD   0x1
+#define GLYPH_ITALIC 0x2
+
+typedef struct glyph_entry_t glyph_entry_t;
+struct glyph_entry_t
+{
+    FT_Face         p_face; /* NULL once a transient face is gone */
+    FT_UShort       i_ppem;
+    FT_UInt         i_index;
+    int             i_style;
+    unsigned        i_hash;
+
+    FT_BitmapGlyph  p_glyph;
+    FT_BBox         bbox;      /* control box, in pixels */
+    int             i_advance; /* in pixels */
+    size_t          i_size;
+    /* glyph of a face loaded for a single string */
+    bool            b_transient;
+
+    glyph_entry_t  *p_hash_next;
+    glyph_entry_t  *p_lru_prev;
+    glyph_entry_t  *p_lru_next;
+};
+
+typedef struct
+{
+    glyph_entry_t  *pp_hash[GLYPH_CACHE_HASH];
+    glyph_entry_t  *p_first; /* most recently used */
+    glyph_entry_t  *p_last;  /* least recently used */
+    size_t          i_size;
+    size_t          i_max_size;
+    unsigned        i_transient;
+} glyph_cache_t;
+
+static int GlyphCacheGet( filter_t *, FT_Face, FT_UInt, int,
+                          const glyph_entry_t ** );
+static void GlyphCacheTrim( glyph_cache_t * );
+static void GlyphCacheClean( glyph_cache_t * );
+
+/*****************************************************************************
+ * Text cache
+ *****************************************************************************
+ * Subtitles and OSD strings are rendered again each time they are redrawn.
+ * The last rendered strings are kept with their pictures, which are only
+ * read by the spu, so a hit costs a picture reference.
+ *****************************************************************************/
+#define TEXT_CACHE_SIZE 8
+
+typedef struct
+{
+    int             i_font_size;
+    int             i_font_color;
+    int             i_font_alpha;
+    unsigned        i_max_width;
+    unsigned        i_visible_width;
+    unsigned        i_visible_height;
+    bool            b_yuvp;
+} text_key_t;
+
+typedef struct
+{
+    char           *psz_text;
+    text_key_t      key;
+    video_format_t  fmt;
+    video_palette_t palette; /* YUVP only */
+    picture_t      *p_picture;
+    unsigned        i_last_use;
+} text_entry_t;
+
+static bool TextCacheGet( filter_t *, const char *, const text_key_t *,
+                          subpicture_region_t * );
+static void TextCachePut( filter_t *, const char *, const text_key_t *,
+                          const subpicture_region_t * );
+static void TextCacheClean( filter_t * );
+
 /*****************************************************************************
  * filter_sys_t: freetype local data
  *****************************************************************************
@@ -275,6 +366,9 @@ struct filter_sys_t
     input_attachment_t **pp_font_attachments;
     int                  i_font_attachments;
 
+    glyph_cache_t  glyphs;
+    text_entry_t   p_texts[TEXT_CACHE_SIZE];
+    unsigned       i_text_use;
 };
 
 #define UCHAR uint32_t
@@ -316,6 +410,11 @@ static int Create( vlc_object_t *p_this )
     p_sys->p_library = 0;
     p_sys->i_font_size = 0;
     p_sys->i_display_height = 0;
+    memset( &p_sys->glyphs, 0, sizeof( p_sys->glyphs ) );
+    p_sys->glyphs.i_max_size =
+        __MAX( var_InheritInteger( p_filter, "freetype-cache-size" ), 0 ) * 1024;
+    memset( p_sys->p_texts, 0, sizeof( p_sys->p_texts ) );
+    p_sys->i_text_use = 0;
 
     var_Create( p_filter, "freetype-rel-fontsize",
                 VLC_VAR_INTEGER | VLC_VAR_DOINHERIT );
@@ -527,6 +626,8 @@ static void Destroy( vlc_object_t *p_this )
      * even if no other library functions have been made since FcInit(),
      * so don't call it. */
 
+    TextCacheClean( p_filter );
+    GlyphCacheClean( &p_sys->glyphs );
     FT_Done_Face( p_sys->p_face );
     FT_Done_FreeType( p_sys->p_library );
     free( p_sys );
@@ -1044,11 +1145,11 @@ static int RenderText( filter_t *p_filter, subpicture_region_t *p_region_out,
     int i_font_color, i_font_alpha, i_font_size, i_red, i_green, i_blue;
     vlc_value_t val;
     int i_scale = 1000;
+    text_key_t key;
 
     FT_BBox line;
     FT_BBox glyph_size;
     FT_Vector result;
-    FT_Glyph tmp_glyph;
 
     /* Sanity check */
     if( !p_region_in || !p_region_out ) return VLC_EGENERIC;
@@ -1073,6 +1174,22 @@ static int RenderText( filter_t *p_filter, subpicture_region_t *p_region_out,
 
     if( i_font_color == 0xFFFFFF ) i_font_color = p_sys->i_font_color;
     if( !i_font_alpha ) i_font_alpha = 255 - p_sys->i_font_opacity;
+    if( !i_font_size ) i_font_size = GetFontSize( p_filter );
+
+    memset( &key, 0, sizeof( key ) );
+    key.i_font_size = i_font_size;
+    key.i_font_color = i_font_color;
+    key.i_font_alpha = i_font_alpha;
+    key.i_max_width = p_filter->fmt_out.video.i_visible_width;
+    key.i_visible_width = p_region_in->fmt.i_visible_width;
+    key.i_visible_height = p_region_in->fmt.i_visible_height;
+    key.b_yuvp = var_InheritBool( p_filter, "freetype-yuvp" );
+
+    p_region_out->i_x = p_region_in->i_x;
+    p_region_out->i_y = p_region_in->i_y;
+    if( TextCacheGet( p_filter, psz_string, &key, p_region_out ) )
+        return VLC_SUCCESS;
+
     SetFontSize( p_filter, i_font_size );
 
     i_red   = ( i_font_color & 0x00FF0000 ) >> 16;
@@ -1152,7 +1269,6 @@ static int RenderText( filter_t *p_filter, subpicture_region_t *p_region_out,
     psz_line_start = psz_unicode;
 
 #define face p_sys->p_face
-#define glyph face->glyph
 
     while( *psz_unicode )
     {
@@ -1201,39 +1317,20 @@ static int RenderText( filter_t *p_filter, subpicture_region_t *p_region_out,
         }
         p_line->p_glyph_pos[ i ].x = i_pen_x;
         p_line->p_glyph_pos[ i ].y = i_pen_y;
-        i_error = FT_Load_Glyph( face, i_glyph_index, FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT );
-        if( i_error )
-        {
-            i_error = FT_Load_Glyph( face, i_glyph_index, FT_LOAD_DEFAULT );
-            if( i_error )
-            {
-                msg_Err( p_filter, "unable to render text FT_Load_Glyph returned"
-                                   " %d", i_error );
-                goto error;
-            }
-        }
-        i_error = FT_Get_Glyph( glyph, &tmp_glyph );
-        if( i_error )
-        {
-            msg_Err( p_filter, "unable to render text FT_Get_Glyph returned "
-                               "%d", i_error );
+
+        const glyph_entry_t *p_entry;
+        if( GlyphCacheGet( p_filter, face, i_glyph_index, 0, &p_entry ) )
             goto error;
-        }
-        FT_Glyph_Get_CBox( tmp_glyph, ft_glyph_bbox_pixels, &glyph_size );
-        i_error = FT_Glyph_To_Bitmap( &tmp_glyph, ft_render_mode_normal, 0, 1);
-        if( i_error )
-        {
-            FT_Done_Glyph( tmp_glyph );
+        if( !p_entry )
             continue;
-        }
-        p_line->pp_glyphs[ i ] = (FT_BitmapGlyph)tmp_glyph;
+        glyph_size = p_entry->bbox;
+        p_line->pp_glyphs[ i ] = p_entry->p_glyph;
 
         /* Do rest */
         line.xMax = p_line->p_glyph_pos[i].x + glyph_size.xMax -
-            glyph_size.xMin + ((FT_BitmapGlyph)tmp_glyph)->left;
+            glyph_size.xMin + p_entry->p_glyph->left;
         if( line.xMax > (int)p_filter->fmt_out.video.i_visible_width - 20 )
         {
-            FT_Done_Glyph( (FT_Glyph)p_line->pp_glyphs[ i ] );
             p_line->pp_glyphs[ i ] = NULL;
             FreeLine( p_line );
             p_line = NewLine( strlen( psz_string ));
@@ -1274,7 +1371,7 @@ static int RenderText( filter_t *p_filter, subpicture_region_t *p_region_out,
         line.yMin = __MIN( line.yMin, glyph_size.yMin );
 
         i_previous = i_glyph_index;
-        i_pen_x += glyph->advance.x >> 6;
+        i_pen_x += p_entry->i_advance;
         i++;
     }
 
@@ -1289,23 +1386,22 @@ static int RenderText( filter_t *p_filter, subpicture_region_t *p_region_out,
     result.y += line.yMax - line.yMin;
 
 #undef face
-#undef glyph
-
-    p_region_out->i_x = p_region_in->i_x;
-    p_region_out->i_y = p_region_in->i_y;
 
-    if( var_InheritBool( p_filter, "freetype-yuvp" ) )
+    if( key.b_yuvp )
         Render( p_filter, p_region_out, p_lines, result.x, result.y );
     else
         RenderYUVA( p_filter, p_region_out, p_lines, result.x, result.y );
+    TextCachePut( p_filter, psz_string, &key, p_region_out );
 
     free( psz_unicode_orig );
     FreeLines( p_lines );
+    GlyphCacheTrim( &p_sys->glyphs );
     return VLC_SUCCESS;
 
  error:
     free( psz_unicode_orig );
     FreeLines( p_lines );
+    GlyphCacheTrim( &p_sys->glyphs );
     return VLC_EGENERIC;
 }
 
@@ -1446,8 +1542,8 @@ static int RenderTag( filter_t *p_filter, FT_Face p_face, int i_font_color,
     while( *psz_unicode && ( *psz_unicode != '\n' ) )
     {
         FT_BBox glyph_size;
-        FT_Glyph tmp_glyph;
-        int i_error;
+        const glyph_entry_t *p_entry;
+        int i_style = 0;
 
         int i_glyph_index = FT_Get_Char_Index( p_face, *psz_unicode++ );
         if( FT_HAS_KERNING( p_face ) && i_glyph_index
@@ -1461,43 +1557,24 @@ static int RenderTag( filter_t *p_filter, FT_Face p_face, int i_font_color,
         p_line->p_glyph_pos[ i ].x = *pi_pen_x;
         p_line->p_glyph_pos[ i ].y = i_pen_y;
 
-        i_error = FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT );
-        if( i_error )
-        {
-            i_error = FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT );
-            if( i_error )
-            {
-                msg_Err( p_filter,
-                       "unable to render text FT_Load_Glyph returned %d", i_error );
-                p_line->pp_glyphs[ i ] = NULL;
-                return VLC_EGENERIC;
-            }
-        }
-
         /* Do synthetic styling now that Freetype supports it;
          * ie. if the font we have loaded is NOT already in the
          * style that the tags want, then switch it on; if they
          * are then don't. */
         if (b_bold && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ))
-            FT_GlyphSlot_Embolden( p_face->glyph );
+            i_style |= GLYPH_BOLD;
         if (b_italic && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ))
-            FT_GlyphSlot_Oblique( p_face->glyph );
+            i_style |= GLYPH_ITALIC;
 
-        i_error = FT_Get_Glyph( p_face->glyph, &tmp_glyph );
-        if( i_error )
+        if( GlyphCacheGet( p_filter, p_face, i_glyph_index, i_style,
+                           &p_entry ) )
         {
-            msg_Err( p_filter,
-                    "unable to render text FT_Get_Glyph returned %d", i_error );
             p_line->pp_glyphs[ i ] = NULL;
             return VLC_EGENERIC;
         }
-        FT_Glyph_Get_CBox( tmp_glyph, ft_glyph_bbox_pixels, &glyph_size );
-        i_error = FT_Glyph_To_Bitmap( &tmp_glyph, FT_RENDER_MODE_NORMAL, 0, 1);
-        if( i_error )
-        {
-            FT_Done_Glyph( tmp_glyph );
+        if( !p_entry )
             continue;
-        }
+        glyph_size = p_entry->bbox;
         if( b_uline || b_through )
         {
             float aOffset = FT_FLOOR(FT_MulFix(p_face->underline_position,
@@ -1522,17 +1599,15 @@ static int RenderTag( filter_t *p_filter, FT_Face p_face, int i_font_color,
             }
         }
 
-        p_line->pp_glyphs[ i ] = (FT_BitmapGlyph)tmp_glyph;
+        p_line->pp_glyphs[ i ] = p_entry->p_glyph;
         p_line->p_fg_rgb[ i ] = i_font_color & 0x00ffffff;
         p_line->p_bg_rgb[ i ] = i_karaoke_bgcolor & 0x00ffffff;
         p_line->p_fg_bg_ratio[ i ] = 0x00;
 
         line.xMax = p_line->p_glyph_pos[i].x + glyph_size.xMax -
-                    glyph_size.xMin + ((FT_BitmapGlyph)tmp_glyph)->left;
+                    glyph_size.xMin + p_entry->p_glyph->left;
         if( line.xMax > (int)p_filter->fmt_out.video.i_visible_width - 20 )
         {
-            for( ; i >= *pi_start; i-- )
-                FT_Done_Glyph( (FT_Glyph)p_line->pp_glyphs[ i ] );
             i = *pi_start;
 
             while( psz_unicode > psz_unicode_start && *psz_unicode != ' ' )
@@ -1576,7 +1651,7 @@ static int RenderTag( filter_t *p_filter, FT_Face p_face, int i_font_color,
         line.yMin = __MIN( line.yMin, glyph_size.yMin );
 
         i_previous = i_glyph_index;
-        *pi_pen_x += p_face->glyph->advance.x >> 6;
+        *pi_pen_x += p_entry->i_advance;
         i++;
     }
     p_line->i_width = line.xMax;
@@ -1711,6 +1786,21 @@ static int CheckForEmbeddedFont( filter_sys_t *p_sys, FT_Face *pp_face, ft_style
     return VLC_EGENERIC;
 }
 
+/* The glyphs of a face must not be found again once it is released, as
+ * another face may be allocated at the same address */
+static void DoneFace( filter_sys_t *p_sys, FT_Face p_face )
+{
+    glyph_entry_t *p_entry;
+
+    for( p_entry = p_sys->glyphs.p_first; p_entry != NULL;
+         p_entry = p_entry->p_lru_next )
+    {
+        if( p_entry->p_face == p_face )
+            p_entry->p_face = NULL;
+    }
+    FT_Done_Face( p_face );
+}
+
 static int ProcessLines( filter_t *p_filter,
                          uint32_t *psz_text,
                          int i_len,
@@ -1972,7 +2062,7 @@ static int ProcessLines( filter_t *p_filter,
                 /* We've loaded a font face which is unhelpful for actually
                  * rendering text - fallback to the default one.
                  */
-                 FT_Done_Face( p_face );
+                 DoneFace( p_sys, p_face );
                  p_face = NULL;
             }
 
@@ -1981,7 +2071,7 @@ static int ProcessLines( filter_t *p_filter,
                 FT_Set_Pixel_Sizes( p_face ? p_face : p_sys->p_face, 0,
                     p_style->i_font_size ) )
             {
-                if( p_face ) FT_Done_Face( p_face );
+                if( p_face ) DoneFace( p_sys, p_face );
                 free( pp_char_styles );
 #if defined(HAVE_FRIBIDI)
                 free( psz_text );
@@ -1997,7 +2087,7 @@ static int ProcessLines( filter_t *p_filter,
                               malloc( (k - i_prev + 1) * sizeof( uint32_t ));
             if( !psz_unicode )
             {
-                if( p_face ) FT_Done_Face( p_face );
+                if( p_face ) DoneFace( p_sys, p_face );
                 free( pp_char_styles );
                 free( psz_unicode );
 #if defined(HAVE_FRIBIDI)
@@ -2015,7 +2105,7 @@ static int ProcessLines( filter_t *p_filter,
                 {
                     if( !(p_line = NewLine( i_len - i_prev)) )
                     {
-                        if( p_face ) FT_Done_Face( p_face );
+                        if( p_face ) DoneFace( p_sys, p_face );
                         free( pp_char_styles );
                         free( psz_unicode );
 #if defined(HAVE_FRIBIDI)
@@ -2052,7 +2142,7 @@ static int ProcessLines( filter_t *p_filter,
                                p_line, psz_unicode, &i_pen_x, i_pen_y, &i_posn,
                                &tmp_result ) != VLC_SUCCESS )
                 {
-                    if( p_face ) FT_Done_Face( p_face );
+                    if( p_face ) DoneFace( p_sys, p_face );
                     free( pp_char_styles );
                     free( psz_unicode );
 #if defined(HAVE_FRIBIDI)
@@ -2082,7 +2172,7 @@ static int ProcessLines( filter_t *p_filter,
                 }
             }
             free( psz_unicode );
-            if( p_face ) FT_Done_Face( p_face );
+            if( p_face ) DoneFace( p_sys, p_face );
             i_prev = k;
         }
     }
@@ -2261,6 +2351,7 @@ static int RenderHtml( filter_t *p_filter, subpicture_region_t *p_region_out,
         }
         p_filter->p_sys->p_xml = xml_ReaderReset( p_xml_reader, NULL );
         FreeLines( p_lines );
+        GlyphCacheTrim( &p_filter->p_sys->glyphs );
     }
     stream_Delete( p_sub );
     return rv;
@@ -2359,11 +2450,7 @@ static ft_style_t *GetStyleFromFontStack( filter_sys_t *p_sys,
 
 static void FreeLine( line_desc_t *p_line )
 {
-    unsigned int i;
-    for( i = 0; p_line->pp_glyphs[ i ] != NULL; i++ )
-    {
-        FT_Done_Glyph( (FT_Glyph)p_line->pp_glyphs[ i ] );
-    }
+    /* the glyphs belong to the glyph cache */
     free( p_line->pp_glyphs );
     free( p_line->p_glyph_pos );
     free( p_line->p_fg_rgb );
@@ -2387,6 +2474,255 @@ static void FreeLines( line_desc_t *p_lines )
     }
 }
 
+/*****************************************************************************
+ * Glyph cache
+ *****************************************************************************/
+static unsigned GlyphHash( FT_Face p_face, FT_UShort i_ppem, FT_UInt i_index,
+                           int i_style )
+{
+    uint32_t i_hash = (uint32_t)(uintptr_t)p_face >> 4;
+
+    i_hash = i_hash * 31 + i_ppem;
+    i_hash = i_hash * 31 + i_index;
+    i_hash = i_hash * 31 + i_style;
+    return (i_hash * 2654435761u) >> 24;
+}
+
+static void GlyphCacheUnlink( glyph_cache_t *p_cache, glyph_entry_t *p_entry )
+{
+    if( p_entry->p_lru_prev )
+        p_entry->p_lru_prev->p_lru_next = p_entry->p_lru_next;
+    else
+        p_cache->p_first = p_entry->p_lru_next;
+    if( p_entry->p_lru_next )
+        p_entry->p_lru_next->p_lru_prev = p_entry->p_lru_prev;
+    else
+        p_cache->p_last = p_entry->p_lru_prev;
+}
+
+static void GlyphCacheLink( glyph_cache_t *p_cache, glyph_entry_t *p_entry )
+{
+    p_entry->p_lru_prev = NULL;
+    p_entry->p_lru_next = p_cache->p_first;
+    if( p_cache->p_first )
+        p_cache->p_first->p_lru_prev = p_entry;
+    else
+        p_cache->p_last = p_entry;
+    p_cache->p_first = p_entry;
+}
+
+static void GlyphCacheDelete( glyph_cache_t *p_cache, glyph_entry_t *p_entry )
+{
+    glyph_entry_t **pp_entry = &p_cache->pp_hash[p_entry->i_hash];
+
+    while( *pp_entry != p_entry )
+        pp_entry = &(*pp_entry)->p_hash_next;
+    *pp_entry = p_entry->p_hash_next;
+
+    GlyphCacheUnlink( p_cache, p_entry );
+    p_cache->i_size -= p_entry->i_size;
+    if( p_entry->b_transient )
+        p_cache->i_transient--;
+    FT_Done_Glyph( (FT_Glyph)p_entry->p_glyph );
+    free( p_entry );
+}
+
+/**
+ * Returns the bitmap of a glyph of the current size of the face, rasterizing
+ * it on a miss. *pp_entry is NULL if the glyph cannot be rendered, and stays
+ * valid until the next GlyphCacheTrim().
+ */
+static int GlyphCacheGet( filter_t *p_filter, FT_Face p_face, FT_UInt i_index,
+                          int i_style, const glyph_entry_t **pp_entry )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    glyph_cache_t *p_cache = &p_sys->glyphs;
+    const FT_UShort i_ppem = p_face->size->metrics.y_ppem;
+    const unsigned i_hash = GlyphHash( p_face, i_ppem, i_index, i_style );
+    glyph_entry_t *p_entry;
+    FT_Glyph tmp_glyph;
+    FT_BBox bbox;
+    int i_error;
+
+    *pp_entry = NULL;
+    for( p_entry = p_cache->pp_hash[i_hash]; p_entry != NULL;
+         p_entry = p_entry->p_hash_next )
+    {
+        if( p_entry->p_face == p_face && p_entry->i_ppem == i_ppem &&
+            p_entry->i_index == i_index && p_entry->i_style == i_style )
+        {
+            GlyphCacheUnlink( p_cache, p_entry );
+            GlyphCacheLink( p_cache, p_entry );
+            *pp_entry = p_entry;
+            return VLC_SUCCESS;
+        }
+    }
+
+    i_error = FT_Load_Glyph( p_face, i_index, FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT );
+    if( i_error )
+    {
+        i_error = FT_Load_Glyph( p_face, i_index, FT_LOAD_DEFAULT );
+        if( i_error )
+        {
+            msg_Err( p_filter, "unable to render text FT_Load_Glyph returned"
+                               " %d", i_error );
+            return VLC_EGENERIC;
+        }
+    }
+    if( i_style & GLYPH_BOLD )
+        FT_GlyphSlot_Embolden( p_face->glyph );
+    if( i_style & GLYPH_ITALIC )
+        FT_GlyphSlot_Oblique( p_face->glyph );
+
+    i_error = FT_Get_Glyph( p_face->glyph, &tmp_glyph );
+    if( i_error )
+    {
+        msg_Err( p_filter, "unable to render text FT_Get_Glyph returned "
+                           "%d", i_error );
+        return VLC_EGENERIC;
+    }
+    FT_Glyph_Get_CBox( tmp_glyph, ft_glyph_bbox_pixels, &bbox );
+    i_error = FT_Glyph_To_Bitmap( &tmp_glyph, FT_RENDER_MODE_NORMAL, 0, 1 );
+    if( i_error )
+    {
+        FT_Done_Glyph( tmp_glyph );
+        return VLC_SUCCESS;
+    }
+
+    p_entry = malloc( sizeof( *p_entry ) );
+    if( !p_entry )
+    {
+        FT_Done_Glyph( tmp_glyph );
+        return VLC_ENOMEM;
+    }
+    p_entry->p_face = p_face;
+    p_entry->i_ppem = i_ppem;
+    p_entry->i_index = i_index;
+    p_entry->i_style = i_style;
+    p_entry->i_hash = i_hash;
+    p_entry->p_glyph = (FT_BitmapGlyph)tmp_glyph;
+    p_entry->bbox = bbox;
+    p_entry->i_advance = p_face->glyph->advance.x >> 6;
+    p_entry->i_size = sizeof( *p_entry ) +
+        abs( p_entry->p_glyph->bitmap.pitch ) * p_entry->p_glyph->bitmap.rows;
+    p_entry->b_transient = p_face != p_sys->p_face;
+
+    p_entry->p_hash_next = p_cache->pp_hash[i_hash];
+    p_cache->pp_hash[i_hash] = p_entry;
+    GlyphCacheLink( p_cache, p_entry );
+    p_cache->i_size += p_entry->i_size;
+    if( p_entry->b_transient )
+        p_cache->i_transient++;
+
+    *pp_entry = p_entry;
+    return VLC_SUCCESS;
+}
+
+/**
+ * Drops the glyphs of the transient faces and the least recently used ones
+ * above the size limit. No line may reference the glyphs anymore.
+ */
+static void GlyphCacheTrim( glyph_cache_t *p_cache )
+{
+    glyph_entry_t *p_entry = p_cache->p_last;
+
+    while( p_entry != NULL &&
+           ( p_cache->i_transient > 0 || p_cache->i_size > p_cache->i_max_size ) )
+    {
+        glyph_entry_t *p_prev = p_entry->p_lru_prev;
+
+        if( p_entry->b_transient || p_cache->i_size > p_cache->i_max_size )
+            GlyphCacheDelete( p_cache, p_entry );
+        p_entry = p_prev;
+    }
+}
+
+static void GlyphCacheClean( glyph_cache_t *p_cache )
+{
+    while( p_cache->p_last != NULL )
+        GlyphCacheDelete( p_cache, p_cache->p_last );
+}
+
+/*****************************************************************************
+ * Text cache
+ *****************************************************************************/
+static bool TextCacheGet( filter_t *p_filter, const char *psz_text,
+                          const text_key_t *p_key,
+                          subpicture_region_t *p_region )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    for( int i = 0; i < TEXT_CACHE_SIZE; i++ )
+    {
+        text_entry_t *p_entry = &p_sys->p_texts[i];
+        video_format_t fmt;
+
+        if( !p_entry->psz_text || strcmp( p_entry->psz_text, psz_text ) ||
+            memcmp( &p_entry->key, p_key, sizeof( *p_key ) ) )
+            continue;
+
+        fmt = p_entry->fmt;
+        if( fmt.i_chroma == VLC_CODEC_YUVP )
+        {
+            fmt.p_palette = p_region->fmt.p_palette ? p_region->fmt.p_palette
+                                                    : malloc( sizeof( *fmt.p_palette ) );
+            if( !fmt.p_palette )
+                return false;
+            *fmt.p_palette = p_entry->palette;
+        }
+        p_region->fmt = fmt;
+        p_region->p_picture = picture_Hold( p_entry->p_picture );
+        p_entry->i_last_use = ++p_sys->i_text_use;
+        return true;
+    }
+    return false;
+}
+
+static void TextCacheDelete( text_entry_t *p_entry )
+{
+    free( p_entry->psz_text );
+    p_entry->psz_text = NULL;
+    if( p_entry->p_picture )
+        picture_Release( p_entry->p_picture );
+    p_entry->p_picture = NULL;
+}
+
+static void TextCachePut( filter_t *p_filter, const char *psz_text,
+                          const text_key_t *p_key,
+                          const subpicture_region_t *p_region )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    text_entry_t *p_entry = &p_sys->p_texts[0];
+
+    if( !p_region->p_picture )
+        return;
+
+    for( int i = 1; i < TEXT_CACHE_SIZE && p_entry->psz_text; i++ )
+    {
+        if( !p_sys->p_texts[i].psz_text ||
+            p_sys->p_texts[i].i_last_use < p_entry->i_last_use )
+            p_entry = &p_sys->p_texts[i];
+    }
+    TextCacheDelete( p_entry );
+
+    p_entry->psz_text = strdup( psz_text );
+    if( !p_entry->psz_text )
+        return;
+    p_entry->key = *p_key;
+    p_entry->fmt = p_region->fmt;
+    if( p_entry->fmt.p_palette )
+        p_entry->palette = *p_entry->fmt.p_palette;
+    p_entry->fmt.p_palette = NULL;
+    p_entry->p_picture = picture_Hold( p_region->p_picture );
+    p_entry->i_last_use = ++p_sys->i_text_use;
+}
+
+static void TextCacheClean( filter_t *p_filter )
+{
+    for( int i = 0; i < TEXT_CACHE_SIZE; i++ )
+        TextCacheDelete( &p_filter->p_sys->p_texts[i] );
+}
+
 static line_desc_t *NewLine( int i_count )
 {
     line_desc_t *p_line = malloc( sizeof(line_desc_t) );
@@ -0,0 +1,1181 @@
+/*****************************************************************************
+ * danmaku.c : scrolling comments overlay
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* The filter sends a single subpicture that stays on its own channel; its
+ * updater lays the comments out against the media clock every time the spu
+ * renders. Each comment is rasterized once by the text renderer into an
+ * atlas slot, then only copied into a screen sized canvas. The canvas is
+ * cut into horizontal bands and only the span of a band that holds comments
+ * is handed to the blender, so the cost follows the covered area. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+#include <vlc_input.h>
+#include <vlc_spu.h>
+#include <vlc_url.h>
+#include <vlc_fs.h>
+
+#include <stdio.h>
+#include <limits.h>
+
+#include "danmaku.h"
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define FILE_TEXT N_("Comments file")
+#define FILE_LONGTEXT N_("Bilibili or AcFun XML comment list. By default " \
+    "the .xml file with the same name as the played file is used.")
+#define DURATION_TEXT N_("Duration")
+#define DURATION_LONGTEXT N_("Time a comment stays on the screen, " \
+    "in milliseconds.")
+#define OPACITY_TEXT N_("Opacity")
+#define OPACITY_LONGTEXT N_("Opacity of the comments, from 0 (transparent) " \
+    "to 255 (opaque).")
+
+#define CFG_PREFIX "danmaku-"
+
+vlc_module_begin ()
+    set_shortname( N_("Danmaku") )
+    set_description( N_("Scrolling comments overlay") )
+    set_category( CAT_VIDEO )
+    set_subcategory( SUBCAT_VIDEO_SUBPIC )
+    set_capability( "sub filter", 0 )
+
+    add_loadfile( CFG_PREFIX "file", NULL, FILE_TEXT, FILE_LONGTEXT, false )
+    add_integer_with_range( CFG_PREFIX "duration", 4000, 1000, 20000, NULL,
+                            DURATION_TEXT, DURATION_LONGTEXT, false )
+    add_integer_with_range( CFG_PREFIX "opacity", 224, 0, 255, NULL,
+                            OPACITY_TEXT, OPACITY_LONGTEXT, false )
+
+    set_callbacks( Open, Close )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+/* Height of the stage the comment sizes are authored for */
+#define DANMAKU_STAGE_HEIGHT  385
+/* Comments allowed to overlap older ones when the tracks are full */
+#define DANMAKU_LAYERS        4
+#define DANMAKU_MAX_ACTIVE    1024
+
+#define ATLAS_WIDTH           2048
+#define ATLAS_HEIGHT          512
+
+#define INPUT_CHECK_PERIOD    (CLOCK_FREQ / 2)
+/* Clock error corrected at once instead of smoothed out */
+#define CLOCK_MAX_JITTER      (CLOCK_FREQ * 3 / 10)
+/* Jump of the media clock, either way, handled as a seek */
+#define SEEK_THRESHOLD        (2 * CLOCK_FREQ)
+
+typedef struct
+{
+    danmaku_slot_t slot;
+    int            i_mode;
+    mtime_t        i_start;
+    int            i_y;
+} active_t;
+
+typedef struct
+{
+    /* last comment of the track, for DANMAKU_SCROLL and DANMAKU_REVERSE */
+    mtime_t  pi_start[2];
+    unsigned pi_width[2];  /* 0 if there is none */
+    /* end of the last comment, for DANMAKU_TOP and DANMAKU_BOTTOM */
+    mtime_t  pi_end[2];
+} track_t;
+
+typedef struct
+{
+    unsigned i_x0, i_x1;   /* empty if i_x0 >= i_x1 */
+} span_t;
+
+/* State shared by the filter and its subpicture */
+typedef struct
+{
+    vlc_mutex_t lock;
+    unsigned    i_refcount;
+    filter_t   *p_text;    /* NULL until comments are loaded */
+    bool        b_subpicture;
+
+    mtime_t     i_duration;
+    int         i_opacity;
+
+    danmaku_comment_t *p_comments;
+    size_t      i_comments;
+    size_t      i_next;    /* first comment not shown yet */
+
+    /* media clock */
+    mtime_t     i_clock_time;
+    mtime_t     i_clock_date;
+    mtime_t     i_clock_reported;
+    float       f_rate;
+    bool        b_playing;
+    mtime_t     i_last_time;
+
+    /* layout, in pixels of the destination */
+    unsigned    i_width, i_height;
+    unsigned    i_band;
+    unsigned    i_tracks;
+    unsigned    i_bands;
+    track_t    *p_tracks;  /* i_tracks per layer */
+    span_t     *p_spans;   /* i_bands, what the canvas holds */
+    active_t    p_active[DANMAKU_MAX_ACTIVE];
+    unsigned    i_active;
+
+    danmaku_atlas_t *p_atlas;
+    picture_t  *p_canvas;
+
+    /* comments of an older input are dropped by the loader */
+    unsigned    i_generation;
+    bool        b_loaded;  /* the loader thread is done */
+} danmaku_t;
+
+struct subpicture_updater_sys_t
+{
+    danmaku_t *p_dm;
+};
+
+struct filter_sys_t
+{
+    danmaku_t      *p_dm;
+    int             i_channel;
+    input_thread_t *p_input;
+    mtime_t         i_next_check;
+
+    /* comments file read and parsed away from the vout thread */
+    vlc_thread_t    loader;
+    bool            b_loading;  /* loader thread to join */
+    bool            b_pending;  /* the input changed, loader to start */
+    char           *psz_path;
+    unsigned        i_generation;
+};
+
+static subpicture_t *Filter( filter_t *, mtime_t );
+
+/*****************************************************************************
+ * Shared state
+ *****************************************************************************/
+static danmaku_t *DanmakuNew( void )
+{
+    danmaku_t *p_dm = calloc( 1, sizeof(*p_dm) );
+    if( !p_dm )
+        return NULL;
+    vlc_mutex_init( &p_dm->lock );
+    p_dm->i_refcount = 1;
+    p_dm->f_rate = 1.f;
+    p_dm->i_last_time = INT64_MIN;
+    return p_dm;
+}
+
+static danmaku_t *DanmakuHold( danmaku_t *p_dm )
+{
+    vlc_mutex_lock( &p_dm->lock );
+    p_dm->i_refcount++;
+    vlc_mutex_unlock( &p_dm->lock );
+    return p_dm;
+}
+
+/* Forgets the comments on the screen */
+static void ResetLayout( danmaku_t *p_dm )
+{
+    for( unsigned i = 0; i < p_dm->i_active; i++ )
+        danmaku_AtlasFree( p_dm->p_atlas, &p_dm->p_active[i].slot );
+    p_dm->i_active = 0;
+    if( p_dm->p_tracks )
+        memset( p_dm->p_tracks, 0,
+                DANMAKU_LAYERS * p_dm->i_tracks * sizeof(*p_dm->p_tracks) );
+    p_dm->i_last_time = INT64_MIN;
+}
+
+static void CleanLayout( danmaku_t *p_dm )
+{
+    ResetLayout( p_dm );
+    if( p_dm->p_atlas )
+        danmaku_AtlasDelete( p_dm->p_atlas );
+    if( p_dm->p_canvas )
+        picture_Release( p_dm->p_canvas );
+    free( p_dm->p_tracks );
+    free( p_dm->p_spans );
+    p_dm->p_atlas = NULL;
+    p_dm->p_canvas = NULL;
+    p_dm->p_tracks = NULL;
+    p_dm->p_spans = NULL;
+    p_dm->i_width = p_dm->i_height = 0;
+    p_dm->i_tracks = p_dm->i_bands = 0;
+}
+
+static void DanmakuRelease( danmaku_t *p_dm )
+{
+    vlc_mutex_lock( &p_dm->lock );
+    const unsigned i_refcount = --p_dm->i_refcount;
+    vlc_mutex_unlock( &p_dm->lock );
+    if( i_refcount > 0 )
+        return;
+
+    CleanLayout( p_dm );
+    if( p_dm->p_comments )
+        danmaku_CommentsDelete( p_dm->p_comments, p_dm->i_comments );
+    vlc_mutex_destroy( &p_dm->lock );
+    free( p_dm );
+}
+
+/*****************************************************************************
+ * Media clock
+ *****************************************************************************/
+static mtime_t ClockGet( const danmaku_t *p_dm, mtime_t i_date )
+{
+    if( !p_dm->b_playing )
+        return p_dm->i_clock_time;
+    return p_dm->i_clock_time +
+           (mtime_t)( ( i_date - p_dm->i_clock_date ) * p_dm->f_rate );
+}
+
+/* The input time is only updated a few times per second, so it is
+ * extrapolated in between and the small errors are slewed away. */
+static void ClockUpdate( danmaku_t *p_dm, input_thread_t *p_input,
+                         mtime_t i_date )
+{
+    if( !p_input )
+    {
+        p_dm->b_playing = false;
+        return;
+    }
+
+    const mtime_t i_time = var_GetTime( p_input, "time" );
+    const bool b_playing = var_GetInteger( p_input, "state" ) == PLAYING_S;
+    const float f_rate = var_GetFloat( p_input, "rate" );
+    const mtime_t i_predicted = ClockGet( p_dm, i_date );
+
+    if( !b_playing || !p_dm->b_playing || f_rate != p_dm->f_rate ||
+        llabs( i_time - i_predicted ) > CLOCK_MAX_JITTER )
+    {
+        p_dm->i_clock_time = i_time;
+        p_dm->i_clock_date = i_date;
+    }
+    else if( i_time != p_dm->i_clock_reported )
+    {
+        p_dm->i_clock_time = i_predicted + ( i_time - i_predicted ) / 8;
+        p_dm->i_clock_date = i_date;
+    }
+    p_dm->i_clock_reported = i_time;
+    p_dm->b_playing = b_playing;
+    p_dm->f_rate = f_rate > 0.f ? f_rate : 1.f;
+}
+
+/*****************************************************************************
+ * Rasterization
+ *****************************************************************************/
+static unsigned FontSize( const danmaku_t *p_dm, int i_size )
+{
+    unsigned i_px = i_size * p_dm->i_height / DANMAKU_STAGE_HEIGHT;
+    return __MAX( __MIN( i_px, 255 ), 8 );
+}
+
+static subpicture_region_t *Rasterize( danmaku_t *p_dm, const char *psz_text,
+                                       unsigned i_px, uint32_t i_color )
+{
+    filter_t *p_text = p_dm->p_text;
+    video_format_t fmt;
+
+    memset( &fmt, 0, sizeof(fmt) );
+    fmt.i_chroma = VLC_CODEC_TEXT;
+    subpicture_region_t *p_region = subpicture_region_New( &fmt );
+    if( !p_region )
+        return NULL;
+    p_region->psz_text = strdup( psz_text );
+    p_region->p_style = text_style_New();
+    if( !p_region->psz_text || !p_region->p_style )
+        goto error;
+    p_region->p_style->i_font_size = i_px;
+    p_region->p_style->i_font_color = i_color;
+    p_region->p_style->i_font_alpha = 0;
+
+    if( p_text->pf_render_text( p_text, p_region, p_region ) ||
+        p_region->fmt.i_chroma != VLC_CODEC_YUVA || !p_region->p_picture )
+        goto error;
+    return p_region;
+
+error:
+    subpicture_region_Delete( p_region );
+    return NULL;
+}
+
+static void CopyToSlot( const subpicture_region_t *p_region,
+                        const danmaku_slot_t *p_slot )
+{
+    const video_format_t *p_fmt = &p_region->fmt;
+
+    for( int i = 0; i < 4; i++ )
+    {
+        const plane_t *p_src = &p_region->p_picture->p[i];
+        plane_t *p_dst = &p_slot->p_page->p[i];
+
+        for( unsigned y = 0; y < p_slot->i_height; y++ )
+            memcpy( &p_dst->p_pixels[(p_slot->i_y + y) * p_dst->i_pitch +
+                                     p_slot->i_x],
+                    &p_src->p_pixels[(p_fmt->i_y_offset + y) * p_src->i_pitch +
+                                     p_fmt->i_x_offset],
+                    p_slot->i_width );
+    }
+}
+
+/*****************************************************************************
+ * Layout
+ *****************************************************************************/
+static bool TrackFree( const danmaku_t *p_dm, const track_t *p_track,
+                       int i_mode, mtime_t i_start, unsigned i_width )
+{
+    const int64_t i_screen = p_dm->i_width;
+    const mtime_t i_duration = p_dm->i_duration;
+
+    if( i_mode == DANMAKU_TOP || i_mode == DANMAKU_BOTTOM )
+        return p_track->pi_end[i_mode == DANMAKU_BOTTOM] <= i_start;
+
+    const int d = i_mode == DANMAKU_REVERSE;
+    const int64_t i_prev = p_track->pi_width[d];
+    if( i_prev == 0 )
+        return true;
+
+    /* A comment moves by (W + w) in the duration. The previous one must have
+     * fully entered the screen, and the new one must not catch up with it
+     * before it leaves. */
+    const mtime_t i_delta = i_start - p_track->pi_start[d];
+    if( i_delta * ( i_screen + i_prev ) < i_prev * i_duration )
+        return false;
+    return ( i_delta - i_duration ) * ( i_screen + i_width ) +
+           i_duration * i_screen >= 0;
+}
+
+static void TrackTake( const danmaku_t *p_dm, track_t *p_track,
+                       int i_mode, mtime_t i_start, unsigned i_width )
+{
+    if( i_mode == DANMAKU_TOP || i_mode == DANMAKU_BOTTOM )
+    {
+        p_track->pi_end[i_mode == DANMAKU_BOTTOM] = i_start + p_dm->i_duration;
+    }
+    else
+    {
+        p_track->pi_start[i_mode == DANMAKU_REVERSE] = i_start;
+        p_track->pi_width[i_mode == DANMAKU_REVERSE] = i_width;
+    }
+}
+
+/* Finds free tracks for a comment, returns the top row or -1 */
+static int Place( danmaku_t *p_dm, int i_mode, mtime_t i_start,
+                  unsigned i_width, unsigned i_height )
+{
+    const unsigned i_tracks = p_dm->i_tracks;
+    const unsigned n = ( i_height + p_dm->i_band - 1 ) / p_dm->i_band;
+    const bool b_bottom = i_mode == DANMAKU_BOTTOM;
+
+    if( n > i_tracks )
+        return -1;
+
+    for( unsigned l = 0; l < DANMAKU_LAYERS; l++ )
+    {
+        track_t *p_layer = &p_dm->p_tracks[l * i_tracks];
+
+        for( unsigned i_first = 0; i_first + n <= i_tracks; i_first++ )
+        {
+            unsigned k;
+
+            for( k = 0; k < n; k++ )
+            {
+                const unsigned t = i_first + k;
+                if( !TrackFree( p_dm, &p_layer[b_bottom ? i_tracks - 1 - t : t],
+                                i_mode, i_start, i_width ) )
+                    break;
+            }
+            if( k < n )
+                continue;
+
+            for( k = 0; k < n; k++ )
+            {
+                const unsigned t = i_first + k;
+                TrackTake( p_dm, &p_layer[b_bottom ? i_tracks - 1 - t : t],
+                           i_mode, i_start, i_width );
+            }
+            if( b_bottom )
+                return p_dm->i_height - ( i_first + n ) * p_dm->i_band;
+            return i_first * p_dm->i_band;
+        }
+    }
+    return -1;
+}
+
+static void Spawn( danmaku_t *p_dm, const danmaku_comment_t *p_comment )
+{
+    subpicture_region_t *p_region;
+    danmaku_slot_t slot;
+    int i_y;
+
+    if( p_dm->i_active >= DANMAKU_MAX_ACTIVE )
+        return;
+
+    p_region = Rasterize( p_dm, p_comment->psz_text,
+                          FontSize( p_dm, p_comment->i_size ),
+                          p_comment->i_color );
+    if( !p_region )
+        return;
+
+    const unsigned i_width = p_region->fmt.i_visible_width;
+    const unsigned i_height = p_region->fmt.i_visible_height;
+    if( danmaku_AtlasAlloc( p_dm->p_atlas, i_width, i_height, &slot ) )
+    {
+        subpicture_region_Delete( p_region );
+        return;
+    }
+    CopyToSlot( p_region, &slot );
+    subpicture_region_Delete( p_region );
+
+    i_y = Place( p_dm, p_comment->i_mode, p_comment->i_time, i_width,
+                 i_height );
+    if( i_y < 0 )
+    {
+        danmaku_AtlasFree( p_dm->p_atlas, &slot );
+        return;
+    }
+
+    active_t *p_active = &p_dm->p_active[p_dm->i_active++];
+    p_active->slot = slot;
+    p_active->i_mode = p_comment->i_mode;
+    p_active->i_start = p_comment->i_time;
+    p_active->i_y = i_y;
+}
+
+/* Index of the first comment at or after i_time */
+static size_t Search( const danmaku_t *p_dm, mtime_t i_time )
+{
+    size_t i_min = 0, i_max = p_dm->i_comments;
+
+    while( i_min < i_max )
+    {
+        const size_t i_mid = i_min + ( i_max - i_min ) / 2;
+        if( p_dm->p_comments[i_mid].i_time < i_time )
+            i_min = i_mid + 1;
+        else
+            i_max = i_mid;
+    }
+    return i_min;
+}
+
+static void Advance( danmaku_t *p_dm, mtime_t i_time )
+{
+    if( p_dm->i_last_time == INT64_MIN ||
+        llabs( i_time - p_dm->i_last_time ) > SEEK_THRESHOLD )
+    {
+        /* Seek: start again with the comments that would be on screen */
+        ResetLayout( p_dm );
+        p_dm->i_next = Search( p_dm, i_time - p_dm->i_duration );
+    }
+
+    for( unsigned i = 0; i < p_dm->i_active; )
+    {
+        active_t *p_active = &p_dm->p_active[i];
+
+        if( i_time < p_active->i_start + p_dm->i_duration )
+        {
+            i++;
+            continue;
+        }
+        danmaku_AtlasFree( p_dm->p_atlas, &p_active->slot );
+        *p_active = p_dm->p_active[--p_dm->i_active];
+    }
+
+    for( ; p_dm->i_next < p_dm->i_comments; p_dm->i_next++ )
+    {
+        const danmaku_comment_t *p_comment = &p_dm->p_comments[p_dm->i_next];
+
+        if( p_comment->i_time > i_time )
+            break;
+        if( p_comment->i_time + p_dm->i_duration > i_time )
+            Spawn( p_dm, p_comment );
+    }
+    p_dm->i_last_time = i_time;
+}
+
+static int Setup( danmaku_t *p_dm, unsigned i_width, unsigned i_height )
+{
+    subpicture_region_t *p_sample;
+
+    CleanLayout( p_dm );
+    p_dm->i_width = i_width;
+    p_dm->i_height = i_height;
+
+    p_dm->p_text->fmt_out.video.i_width =
+    p_dm->p_text->fmt_out.video.i_visible_width = 4096; /* no wrapping */
+    p_dm->p_text->fmt_out.video.i_height =
+    p_dm->p_text->fmt_out.video.i_visible_height = i_height;
+
+    p_sample = Rasterize( p_dm, "Mg", FontSize( p_dm, DANMAKU_NORMAL_SIZE ),
+                          0xffffff );
+    if( !p_sample )
+        goto error;
+    p_dm->i_band = p_sample->fmt.i_visible_height;
+    subpicture_region_Delete( p_sample );
+    if( p_dm->i_band == 0 || p_dm->i_band > i_height )
+        goto error;
+
+    p_dm->i_tracks = i_height / p_dm->i_band;
+    p_dm->i_bands = ( i_height + p_dm->i_band - 1 ) / p_dm->i_band;
+    p_dm->p_tracks = calloc( DANMAKU_LAYERS * p_dm->i_tracks,
+                             sizeof(*p_dm->p_tracks) );
+    p_dm->p_spans = calloc( p_dm->i_bands, sizeof(*p_dm->p_spans) );
+    p_dm->p_atlas = danmaku_AtlasNew( ATLAS_WIDTH, ATLAS_HEIGHT );
+    if( !p_dm->p_tracks || !p_dm->p_spans || !p_dm->p_atlas )
+        goto error;
+    return VLC_SUCCESS;
+
+error:
+    CleanLayout( p_dm );
+    /* do not try again until the size changes */
+    p_dm->i_width = i_width;
+    p_dm->i_height = i_height;
+    return VLC_EGENERIC;
+}
+
+/*****************************************************************************
+ * Composition
+ *****************************************************************************/
+static int GetX( const danmaku_t *p_dm, const active_t *p_active,
+                 mtime_t i_time )
+{
+    const int64_t i_screen = p_dm->i_width;
+    const int64_t i_width = p_active->slot.i_width;
+    const int64_t i_run = ( i_time - p_active->i_start ) *
+                          ( i_screen + i_width ) / p_dm->i_duration;
+
+    switch( p_active->i_mode )
+    {
+        case DANMAKU_SCROLL:
+            return i_screen - i_run;
+        case DANMAKU_REVERSE:
+            return i_run - i_width;
+        default:
+            return ( i_screen - i_width ) / 2;
+    }
+}
+
+/* Draws a comment over the canvas, clipped to it */
+static void Draw( picture_t *p_canvas, unsigned i_width, unsigned i_height,
+                  const danmaku_slot_t *p_slot, int i_x, int i_y )
+{
+    const int i_sx = __MAX( -i_x, 0 );
+    const int i_dx = __MAX( i_x, 0 );
+    const int i_w = __MIN( i_x + (int)p_slot->i_width, (int)i_width ) - i_dx;
+    const int i_h = __MIN( i_y + (int)p_slot->i_height, (int)i_height ) - i_y;
+    const picture_t *p_page = p_slot->p_page;
+
+    if( i_w <= 0 || i_h <= 0 || i_y < 0 )
+        return;
+
+    for( int y = 0; y < i_h; y++ )
+    {
+        const uint8_t *p_src[4];
+        uint8_t *p_dst[4];
+
+        for( int i = 0; i < 4; i++ )
+        {
+            p_src[i] = &p_page->p[i].p_pixels[(p_slot->i_y + y) *
+                       p_page->p[i].i_pitch + p_slot->i_x + i_sx];
+            p_dst[i] = &p_canvas->p[i].p_pixels[(i_y + y) *
+                       p_canvas->p[i].i_pitch + i_dx];
+        }
+
+        for( int x = 0; x < i_w; x++ )
+        {
+            const unsigned i_a = p_src[A_PLANE][x];
+            const unsigned i_d = p_dst[A_PLANE][x];
+
+            if( i_a == 0 )
+                continue;
+            if( i_d == 0 || i_a == 255 )
+            {
+                p_dst[Y_PLANE][x] = p_src[Y_PLANE][x];
+                p_dst[U_PLANE][x] = p_src[U_PLANE][x];
+                p_dst[V_PLANE][x] = p_src[V_PLANE][x];
+                p_dst[A_PLANE][x] = i_a;
+                continue;
+            }
+
+            /* Porter-Duff over */
+            const unsigned i_under = i_d * ( 255 - i_a ) / 255;
+            const unsigned i_out = i_a + i_under;
+            for( int i = 0; i < 3; i++ )
+                p_dst[i][x] = ( p_src[i][x] * i_a + p_dst[i][x] * i_under )
+                              / i_out;
+            p_dst[A_PLANE][x] = i_out;
+        }
+    }
+}
+
+static void ClearAlpha( picture_t *p_canvas, unsigned i_y0, unsigned i_y1,
+                        unsigned i_x0, unsigned i_x1 )
+{
+    plane_t *p_alpha = &p_canvas->p[A_PLANE];
+
+    for( unsigned y = i_y0; y < i_y1; y++ )
+        memset( &p_alpha->p_pixels[y * p_alpha->i_pitch + i_x0], 0,
+                i_x1 - i_x0 );
+}
+
+static void ViewRelease( picture_t *p_view )
+{
+    if( --p_view->i_refcount > 0 )
+        return;
+    picture_Release( (picture_t *)p_view->p_release_sys );
+    p_view->p_release_sys = NULL;
+    picture_Delete( p_view );
+}
+
+/* Region pointing into the canvas, without copy */
+static subpicture_region_t *NewView( danmaku_t *p_dm,
+                                     const video_format_t *p_fmt_dst,
+                                     unsigned i_x0, unsigned i_y0,
+                                     unsigned i_x1, unsigned i_y1 )
+{
+    picture_t *p_canvas = p_dm->p_canvas;
+    picture_resource_t resource;
+    video_format_t fmt;
+
+    memset( &resource, 0, sizeof(resource) );
+    for( int i = 0; i < p_canvas->i_planes; i++ )
+    {
+        resource.p[i].p_pixels = &p_canvas->p[i].p_pixels[i_y0 *
+                                 p_canvas->p[i].i_pitch + i_x0];
+        resource.p[i].i_lines = i_y1 - i_y0;
+        resource.p[i].i_pitch = p_canvas->p[i].i_pitch;
+    }
+    video_format_Setup( &fmt, VLC_CODEC_YUVA, i_x1 - i_x0, i_y1 - i_y0,
+                        p_fmt_dst->i_sar_num ? p_fmt_dst->i_sar_num : 1,
+                        p_fmt_dst->i_sar_den ? p_fmt_dst->i_sar_den : 1 );
+
+    picture_t *p_view = picture_NewFromResource( &fmt, &resource );
+    if( !p_view )
+        return NULL;
+    p_view->pf_release = ViewRelease;
+    p_view->p_release_sys = (picture_release_sys_t *)picture_Hold( p_canvas );
+
+    /* A text region does not allocate its own picture */
+    fmt.i_chroma = VLC_CODEC_TEXT;
+    subpicture_region_t *p_region = subpicture_region_New( &fmt );
+    if( !p_region )
+    {
+        picture_Release( p_view );
+        return NULL;
+    }
+    p_region->fmt.i_chroma = VLC_CODEC_YUVA;
+    p_region->p_picture = p_view;
+    p_region->i_x = p_fmt_dst->i_x_offset + i_x0;
+    p_region->i_y = p_fmt_dst->i_y_offset + i_y0;
+    p_region->i_align = SUBPICTURE_ALIGN_LEFT | SUBPICTURE_ALIGN_TOP;
+    p_region->i_alpha = p_dm->i_opacity;
+    return p_region;
+}
+
+static subpicture_region_t *Compose( danmaku_t *p_dm,
+                                     const video_format_t *p_fmt_dst,
+                                     mtime_t i_time )
+{
+    const unsigned i_width = p_dm->i_width, i_height = p_dm->i_height;
+    const unsigned i_band = p_dm->i_band;
+
+    /* The previous canvas may still be blended by the vout */
+    if( p_dm->p_canvas && picture_IsReferenced( p_dm->p_canvas ) )
+    {
+        picture_Release( p_dm->p_canvas );
+        p_dm->p_canvas = NULL;
+    }
+    if( !p_dm->p_canvas )
+    {
+        video_format_t fmt;
+
+        video_format_Setup( &fmt, VLC_CODEC_YUVA, i_width, i_height, 1, 1 );
+        p_dm->p_canvas = picture_NewFromFormat( &fmt );
+        if( !p_dm->p_canvas )
+            return NULL;
+        ClearAlpha( p_dm->p_canvas, 0, i_height, 0, i_width );
+        memset( p_dm->p_spans, 0, p_dm->i_bands * sizeof(*p_dm->p_spans) );
+    }
+
+    for( unsigned b = 0; b < p_dm->i_bands; b++ )
+    {
+        span_t *p_span = &p_dm->p_spans[b];
+
+        if( p_span->i_x0 < p_span->i_x1 )
+            ClearAlpha( p_dm->p_canvas, b * i_band,
+                        __MIN( ( b + 1 ) * i_band, i_height ),
+                        p_span->i_x0, p_span->i_x1 );
+        p_span->i_x0 = i_width;
+        p_span->i_x1 = 0;
+    }
+
+    for( unsigned i = 0; i < p_dm->i_active; i++ )
+    {
+        const active_t *p_active = &p_dm->p_active[i];
+        const int i_x = GetX( p_dm, p_active, i_time );
+        const int i_x0 = __MAX( i_x, 0 );
+        const int i_x1 = __MIN( i_x + (int)p_active->slot.i_width,
+                                (int)i_width );
+
+        if( i_x0 >= i_x1 )
+            continue;
+        Draw( p_dm->p_canvas, i_width, i_height, &p_active->slot, i_x,
+              p_active->i_y );
+
+        const unsigned i_last = __MIN( p_active->i_y + p_active->slot.i_height,
+                                       i_height ) - 1;
+        for( unsigned b = p_active->i_y / i_band; b <= i_last / i_band; b++ )
+        {
+            p_dm->p_spans[b].i_x0 = __MIN( p_dm->p_spans[b].i_x0,
+                                           (unsigned)i_x0 );
+            p_dm->p_spans[b].i_x1 = __MAX( p_dm->p_spans[b].i_x1,
+                                           (unsigned)i_x1 );
+        }
+    }
+
+    subpicture_region_t *p_head = NULL, **pp_last = &p_head;
+    for( unsigned b = 0; b < p_dm->i_bands; b++ )
+    {
+        const span_t *p_span = &p_dm->p_spans[b];
+
+        if( p_span->i_x0 >= p_span->i_x1 )
+            continue;
+        *pp_last = NewView( p_dm, p_fmt_dst, p_span->i_x0, b * i_band,
+                            p_span->i_x1,
+                            __MIN( ( b + 1 ) * i_band, i_height ) );
+        if( *pp_last )
+            pp_last = &(*pp_last)->p_next;
+    }
+    return p_head;
+}
+
+/* Lays out and draws the comments at i_time, with the lock held */
+static subpicture_region_t *Render( danmaku_t *p_dm,
+                                    const video_format_t *p_fmt_dst,
+                                    mtime_t i_time )
+{
+    const unsigned i_width = p_fmt_dst->i_visible_width;
+    const unsigned i_height = p_fmt_dst->i_visible_height;
+
+    if( !p_dm->p_text || i_width == 0 || i_height == 0 )
+        return NULL;
+    if( ( i_width != p_dm->i_width || i_height != p_dm->i_height ) &&
+        Setup( p_dm, i_width, i_height ) )
+        return NULL;
+    if( !p_dm->p_atlas )
+        return NULL;
+
+    Advance( p_dm, i_time );
+    return Compose( p_dm, p_fmt_dst, i_time );
+}
+
+/*****************************************************************************
+ * Subpicture
+ *****************************************************************************/
+static int SubpictureValidate( subpicture_t *p_subpic,
+                               bool b_src_changed, const video_format_t *p_fmt_src,
+                               bool b_dst_changed, const video_format_t *p_fmt_dst,
+                               mtime_t i_ts )
+{
+    danmaku_t *p_dm = p_subpic->updater.p_sys->p_dm;
+    VLC_UNUSED( b_src_changed ); VLC_UNUSED( p_fmt_src );
+    VLC_UNUSED( p_fmt_dst );
+
+    vlc_mutex_lock( &p_dm->lock );
+    const mtime_t i_time = ClockGet( p_dm, i_ts );
+    /* Nothing moves while paused */
+    const bool b_valid = !b_dst_changed && i_time == p_dm->i_last_time;
+    vlc_mutex_unlock( &p_dm->lock );
+
+    return b_valid ? VLC_SUCCESS : VLC_EGENERIC;
+}
+
+static void SubpictureUpdate( subpicture_t *p_subpic,
+                              const video_format_t *p_fmt_src,
+                              const video_format_t *p_fmt_dst,
+                              mtime_t i_ts )
+{
+    danmaku_t *p_dm = p_subpic->updater.p_sys->p_dm;
+    VLC_UNUSED( p_fmt_src );
+
+    vlc_mutex_lock( &p_dm->lock );
+    p_subpic->p_region = Render( p_dm, p_fmt_dst, ClockGet( p_dm, i_ts ) );
+    vlc_mutex_unlock( &p_dm->lock );
+
+    p_subpic->i_original_picture_width = p_fmt_dst->i_width;
+    p_subpic->i_original_picture_height = p_fmt_dst->i_height;
+}
+
+static void SubpictureDestroy( subpicture_t *p_subpic )
+{
+    danmaku_t *p_dm = p_subpic->updater.p_sys->p_dm;
+
+    vlc_mutex_lock( &p_dm->lock );
+    p_dm->b_subpicture = false;
+    vlc_mutex_unlock( &p_dm->lock );
+
+    DanmakuRelease( p_dm );
+    free( p_subpic->updater.p_sys );
+}
+
+static subpicture_t *SubpictureNew( filter_t *p_filter, mtime_t i_date )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    subpicture_updater_sys_t *p_upd_sys = malloc( sizeof(*p_upd_sys) );
+    if( !p_upd_sys )
+        return NULL;
+    p_upd_sys->p_dm = DanmakuHold( p_sys->p_dm );
+
+    subpicture_updater_t updater = {
+        .pf_validate = SubpictureValidate,
+        .pf_update   = SubpictureUpdate,
+        .pf_destroy  = SubpictureDestroy,
+        .p_sys       = p_upd_sys,
+    };
+    subpicture_t *p_subpic = subpicture_New( &updater );
+    if( !p_subpic )
+    {
+        DanmakuRelease( p_upd_sys->p_dm );
+        free( p_upd_sys );
+        return NULL;
+    }
+
+    /* Lives until the filter clears its channel */
+    p_subpic->i_channel = p_sys->i_channel;
+    p_subpic->i_start = i_date;
+    p_subpic->i_stop = 0;
+    p_subpic->b_ephemer = true;
+    p_subpic->b_absolute = true;
+    return p_subpic;
+}
+
+/*****************************************************************************
+ * Comments loading
+ *****************************************************************************/
+static char *GetCommentsPath( filter_t *p_filter, input_thread_t *p_input )
+{
+    char *psz_path = var_InheritString( p_filter, CFG_PREFIX "file" );
+    if( psz_path && *psz_path )
+        return psz_path;
+    free( psz_path );
+
+    char *psz_uri = input_item_GetURI( input_GetItem( p_input ) );
+    if( !psz_uri )
+        return NULL;
+    char *psz_media = make_path( psz_uri );
+    free( psz_uri );
+    if( !psz_media )
+        return NULL;
+
+    const char *psz_name = strrchr( psz_media, '/' );
+    const char *psz_ext = strrchr( psz_name ? psz_name : psz_media, '.' );
+    int i_len = psz_ext ? psz_ext - psz_media : (int)strlen( psz_media );
+    if( asprintf( &psz_path, "%.*s.xml", i_len, psz_media ) < 0 )
+        psz_path = NULL;
+    free( psz_media );
+    return psz_path;
+}
+
+static char *ReadFile( const char *psz_path )
+{
+    FILE *p_file = vlc_fopen( psz_path, "rb" );
+    char *psz_data = NULL;
+    long i_size;
+
+    if( !p_file )
+        return NULL;
+    if( fseek( p_file, 0, SEEK_END ) || ( i_size = ftell( p_file ) ) <= 0 ||
+        i_size > 64 * 1024 * 1024 || fseek( p_file, 0, SEEK_SET ) )
+        goto out;
+
+    psz_data = malloc( i_size + 1 );
+    if( psz_data )
+    {
+        if( fread( psz_data, 1, i_size, p_file ) == (size_t)i_size )
+            psz_data[i_size] = '\0';
+        else
+        {
+            free( psz_data );
+            psz_data = NULL;
+        }
+    }
+out:
+    fclose( p_file );
+    return psz_data;
+}
+
+static filter_t *CreateText( filter_t *p_filter )
+{
+    filter_t *p_text = vlc_object_create( p_filter, sizeof(*p_text) );
+    if( !p_text )
+        return NULL;
+
+    es_format_Init( &p_text->fmt_in, VIDEO_ES, 0 );
+    es_format_Init( &p_text->fmt_out, VIDEO_ES, 0 );
+    p_text->fmt_out.video.i_width =
+    p_text->fmt_out.video.i_visible_width = 4096;
+    p_text->fmt_out.video.i_height =
+    p_text->fmt_out.video.i_visible_height = 32;
+
+    vlc_object_attach( p_text, p_filter );
+    p_text->p_module = module_need( p_text, "text renderer",
+                                    "$text-renderer", false );
+    if( !p_text->p_module )
+    {
+        vlc_object_release( p_text );
+        return NULL;
+    }
+    return p_text;
+}
+
+/* Replaces the comments, with the lock held */
+static void SetComments( danmaku_t *p_dm, danmaku_comment_t *p_comments,
+                         size_t i_comments )
+{
+    ResetLayout( p_dm );
+    if( p_dm->p_comments )
+        danmaku_CommentsDelete( p_dm->p_comments, p_dm->i_comments );
+    p_dm->p_comments = p_comments;
+    p_dm->i_comments = i_comments;
+    p_dm->i_next = 0;
+}
+
+/* A comments file takes a while to read and parse, so it is not done on
+ * the vout thread. Neither is the text renderer loaded before there is
+ * something to show, the filter is enabled for every playback. */
+static void *Loader( void *p_data )
+{
+    filter_t *p_filter = p_data;
+    filter_sys_t *p_sys = p_filter->p_sys;
+    danmaku_t *p_dm = p_sys->p_dm;
+    danmaku_comment_t *p_comments = NULL;
+    size_t i_comments = 0;
+    filter_t *p_text = NULL;
+    const int canc = vlc_savecancel();
+
+    char *psz_xml = ReadFile( p_sys->psz_path );
+    if( psz_xml )
+    {
+        if( !danmaku_ParseXml( VLC_OBJECT(p_filter), psz_xml, &p_comments,
+                               &i_comments ) )
+            msg_Dbg( p_filter, "%zu comments loaded from %s", i_comments,
+                     p_sys->psz_path );
+        free( psz_xml );
+    }
+
+    /* Only the loader sets the text renderer until the filter is closed */
+    if( i_comments > 0 && !p_dm->p_text )
+    {
+        p_text = CreateText( p_filter );
+        if( !p_text )
+            msg_Err( p_filter, "no text renderer" );
+    }
+
+    vlc_mutex_lock( &p_dm->lock );
+    if( p_text )
+        p_dm->p_text = p_text;
+    if( p_comments && p_sys->i_generation == p_dm->i_generation )
+    {
+        SetComments( p_dm, p_comments, i_comments );
+        p_comments = NULL;
+    }
+    p_dm->b_loaded = true;
+    vlc_mutex_unlock( &p_dm->lock );
+
+    if( p_comments )
+        danmaku_CommentsDelete( p_comments, i_comments );
+    vlc_restorecancel( canc );
+    return NULL;
+}
+
+static void StartLoader( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    p_sys->b_pending = false;
+    free( p_sys->psz_path );
+    p_sys->psz_path = p_sys->p_input ? GetCommentsPath( p_filter,
+                                                        p_sys->p_input )
+                                     : NULL;
+    if( !p_sys->psz_path )
+        return;
+
+    /* No loader is running, the fields are not shared yet */
+    p_sys->i_generation = p_sys->p_dm->i_generation;
+    p_sys->p_dm->b_loaded = false;
+    if( vlc_clone( &p_sys->loader, Loader, p_filter,
+                   VLC_THREAD_PRIORITY_LOW ) )
+        return;
+    p_sys->b_loading = true;
+}
+
+/* Follows the input of the video, which is not the playlist one when the
+ * player runs the input itself. A sub filter is a child of the spu, which
+ * is attached to the input by its vout. */
+static void CheckInput( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    danmaku_t *p_dm = p_sys->p_dm;
+    input_thread_t *p_input = spu_HoldInput( (spu_t *)p_filter->p_parent );
+
+    if( p_input != p_sys->p_input )
+    {
+        if( p_sys->p_input )
+            vlc_object_release( p_sys->p_input );
+        p_sys->p_input = p_input;
+
+        vlc_mutex_lock( &p_dm->lock );
+        p_dm->i_generation++;
+        SetComments( p_dm, NULL, 0 );
+        vlc_mutex_unlock( &p_dm->lock );
+        p_sys->b_pending = true;
+    }
+    else if( p_input )
+        vlc_object_release( p_input );
+
+    /* The loader is only joined once it is done, and the next one started
+     * after it */
+    if( p_sys->b_loading )
+    {
+        vlc_mutex_lock( &p_dm->lock );
+        const bool b_loaded = p_dm->b_loaded;
+        vlc_mutex_unlock( &p_dm->lock );
+        if( !b_loaded )
+            return;
+        vlc_join( p_sys->loader, NULL );
+        p_sys->b_loading = false;
+    }
+    if( p_sys->b_pending )
+        StartLoader( p_filter );
+}
+
+/*****************************************************************************
+ * Filter
+ *****************************************************************************/
+static subpicture_t *Filter( filter_t *p_filter, mtime_t i_date )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    danmaku_t *p_dm = p_sys->p_dm;
+
+    if( i_date >= p_sys->i_next_check )
+    {
+        CheckInput( p_filter );
+        p_sys->i_next_check = i_date + INPUT_CHECK_PERIOD;
+    }
+
+    vlc_mutex_lock( &p_dm->lock );
+    ClockUpdate( p_dm, p_sys->p_input, i_date );
+    const bool b_new = !p_dm->b_subpicture && p_dm->i_comments > 0 &&
+                       p_dm->p_text;
+    vlc_mutex_unlock( &p_dm->lock );
+    if( !b_new )
+        return NULL;
+
+    /* The channel is only known from the subpictures given by the spu */
+    if( p_sys->i_channel < 0 )
+    {
+        subpicture_t *p_probe = filter_NewSubpicture( p_filter );
+        if( !p_probe )
+            return NULL;
+        p_sys->i_channel = p_probe->i_channel;
+        filter_DeleteSubpicture( p_filter, p_probe );
+    }
+
+    subpicture_t *p_subpic = SubpictureNew( p_filter, i_date );
+    if( p_subpic )
+    {
+        vlc_mutex_lock( &p_dm->lock );
+        p_dm->b_subpicture = true;
+        vlc_mutex_unlock( &p_dm->lock );
+    }
+    return p_subpic;
+}
+
+/*****************************************************************************
+ * Open/Close
+ *****************************************************************************/
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys;
+
+    p_filter->p_sys = p_sys = malloc( sizeof(*p_sys) );
+    if( !p_sys )
+        return VLC_ENOMEM;
+    p_sys->p_dm = DanmakuNew();
+    if( !p_sys->p_dm )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    p_sys->i_channel = -1;
+    p_sys->p_input = NULL;
+    p_sys->i_next_check = 0;
+    p_sys->b_loading = false;
+    p_sys->b_pending = false;
+    p_sys->psz_path = NULL;
+    p_sys->i_generation = 0;
+
+    danmaku_t *p_dm = p_sys->p_dm;
+    p_dm->i_duration = var_InheritInteger( p_filter, CFG_PREFIX "duration" )
+                       * 1000;
+    p_dm->i_opacity = var_InheritInteger( p_filter, CFG_PREFIX "opacity" );
+
+    p_filter->pf_sub_filter = Filter;
+    return VLC_SUCCESS;
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+    danmaku_t *p_dm = p_sys->p_dm;
+
+    if( p_sys->b_loading )
+        vlc_join( p_sys->loader, NULL );
+    free( p_sys->psz_path );
+
+    /* The subpicture may outlive the filter */
+    vlc_mutex_lock( &p_dm->lock );
+    if( p_dm->p_text )
+    {
+        module_unneed( p_dm->p_text, p_dm->p_text->p_module );
+        vlc_object_release( p_dm->p_text );
+        p_dm->p_text = NULL;
+    }
+    vlc_mutex_unlock( &p_dm->lock );
+
+    if( p_sys->p_input )
+        vlc_object_release( p_sys->p_input );
+    DanmakuRelease( p_dm );
+    free( p_sys );
+}
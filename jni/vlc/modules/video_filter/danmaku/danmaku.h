@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * danmaku.h : scrolling comments overlay
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef DANMAKU_H
+#define DANMAKU_H 1
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+
+/*****************************************************************************
+ * Comments
+ *****************************************************************************/
+enum
+{
+    DANMAKU_SCROLL = 0,  /* right to left */
+    DANMAKU_REVERSE,     /* left to right */
+    DANMAKU_TOP,         /* fixed, from the top */
+    DANMAKU_BOTTOM,      /* fixed, from the bottom */
+};
+
+/* font size of the normal comments, as authored */
+#define DANMAKU_NORMAL_SIZE 25
+
+typedef struct
+{
+    mtime_t   i_time;   /* media time */
+    int       i_mode;
+    int       i_size;   /* relative to DANMAKU_NORMAL_SIZE */
+    uint32_t  i_color;  /* RGB */
+    char     *psz_text; /* UTF-8 */
+} danmaku_comment_t;
+
+/* Parses a Bilibili (<d p="...">) or AcFun (<data><playTime>) comment list.
+ * The comments are returned sorted by time. */
+int  danmaku_ParseXml( vlc_object_t *, char *psz_xml,
+                       danmaku_comment_t **pp_comments, size_t *pi_count );
+void danmaku_CommentsDelete( danmaku_comment_t *, size_t );
+
+/*****************************************************************************
+ * Atlas: YUVA pages shared by the rasterized comments
+ *****************************************************************************/
+typedef struct danmaku_atlas_t danmaku_atlas_t;
+
+typedef struct
+{
+    picture_t *p_page; /* owned by the atlas */
+    unsigned   i_page;
+    unsigned   i_shelf;
+    unsigned   i_x, i_y;
+    unsigned   i_width, i_height;
+} danmaku_slot_t;
+
+danmaku_atlas_t *danmaku_AtlasNew( unsigned i_page_width,
+                                   unsigned i_page_height );
+void danmaku_AtlasDelete( danmaku_atlas_t * );
+/* Reserves a i_width x i_height rectangle in a page */
+int  danmaku_AtlasAlloc( danmaku_atlas_t *, unsigned i_width,
+                         unsigned i_height, danmaku_slot_t * );
+void danmaku_AtlasFree( danmaku_atlas_t *, const danmaku_slot_t * );
+
+#endif
@@ -0,0 +1,203 @@
+/*****************************************************************************
+ * danmaku_atlas.c : shelf packed YUVA pages for the rasterized comments
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Comments of a given size have the same height, so the pages are cut into
+ * horizontal shelves filled from the left. A shelf is emptied once all its
+ * comments have left the screen, which happens roughly in the order they
+ * were added. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+
+#include <assert.h>
+#include <limits.h>
+
+#include "danmaku.h"
+
+#define ATLAS_MAX_PAGES   8
+#define ATLAS_MAX_SHELVES 64
+
+typedef struct
+{
+    unsigned i_y;
+    unsigned i_height;
+    unsigned i_x;    /* first free column */
+    unsigned i_live; /* slots in use */
+} shelf_t;
+
+typedef struct
+{
+    picture_t *p_picture; /* NULL if the page is not allocated */
+    shelf_t    p_shelves[ATLAS_MAX_SHELVES];
+    unsigned   i_shelves;
+    unsigned   i_used;    /* height taken by the shelves */
+    unsigned   i_live;
+} page_t;
+
+struct danmaku_atlas_t
+{
+    unsigned i_width;
+    unsigned i_height;
+    page_t   p_pages[ATLAS_MAX_PAGES];
+};
+
+danmaku_atlas_t *danmaku_AtlasNew( unsigned i_width, unsigned i_height )
+{
+    danmaku_atlas_t *p_atlas = calloc( 1, sizeof(*p_atlas) );
+    if( !p_atlas )
+        return NULL;
+    p_atlas->i_width = i_width;
+    p_atlas->i_height = i_height;
+    return p_atlas;
+}
+
+void danmaku_AtlasDelete( danmaku_atlas_t *p_atlas )
+{
+    for( unsigned i = 0; i < ATLAS_MAX_PAGES; i++ )
+        if( p_atlas->p_pages[i].p_picture )
+            picture_Release( p_atlas->p_pages[i].p_picture );
+    free( p_atlas );
+}
+
+static int PageNew( danmaku_atlas_t *p_atlas, page_t *p_page )
+{
+    video_format_t fmt;
+
+    video_format_Setup( &fmt, VLC_CODEC_YUVA, p_atlas->i_width,
+                        p_atlas->i_height, 1, 1 );
+    p_page->p_picture = picture_NewFromFormat( &fmt );
+    if( !p_page->p_picture )
+        return VLC_ENOMEM;
+    p_page->i_shelves = 0;
+    p_page->i_used = 0;
+    p_page->i_live = 0;
+    return VLC_SUCCESS;
+}
+
+static void SlotTake( danmaku_atlas_t *p_atlas, unsigned i_page,
+                      unsigned i_shelf, unsigned i_width, unsigned i_height,
+                      danmaku_slot_t *p_slot )
+{
+    page_t *p_page = &p_atlas->p_pages[i_page];
+    shelf_t *p_shelf = &p_page->p_shelves[i_shelf];
+
+    p_slot->p_page = p_page->p_picture;
+    p_slot->i_page = i_page;
+    p_slot->i_shelf = i_shelf;
+    p_slot->i_x = p_shelf->i_x;
+    p_slot->i_y = p_shelf->i_y;
+    p_slot->i_width = i_width;
+    p_slot->i_height = i_height;
+
+    p_shelf->i_x += i_width;
+    p_shelf->i_live++;
+    p_page->i_live++;
+}
+
+int danmaku_AtlasAlloc( danmaku_atlas_t *p_atlas, unsigned i_width,
+                        unsigned i_height, danmaku_slot_t *p_slot )
+{
+    unsigned i_best_page = 0, i_best_shelf = 0, i_best_waste = UINT_MAX;
+
+    if( i_width == 0 || i_height == 0 ||
+        i_width > p_atlas->i_width || i_height > p_atlas->i_height )
+        return VLC_EGENERIC;
+
+    /* Existing shelf of about the right height */
+    for( unsigned i = 0; i < ATLAS_MAX_PAGES; i++ )
+    {
+        const page_t *p_page = &p_atlas->p_pages[i];
+
+        if( !p_page->p_picture )
+            continue;
+        for( unsigned j = 0; j < p_page->i_shelves; j++ )
+        {
+            const shelf_t *p_shelf = &p_page->p_shelves[j];
+
+            if( p_shelf->i_height < i_height ||
+                p_shelf->i_height > i_height + i_height / 4 ||
+                p_shelf->i_x + i_width > p_atlas->i_width )
+                continue;
+            if( p_shelf->i_height - i_height < i_best_waste )
+            {
+                i_best_waste = p_shelf->i_height - i_height;
+                i_best_page = i;
+                i_best_shelf = j;
+            }
+        }
+    }
+    if( i_best_waste != UINT_MAX )
+    {
+        SlotTake( p_atlas, i_best_page, i_best_shelf, i_width, i_height,
+                  p_slot );
+        return VLC_SUCCESS;
+    }
+
+    /* New shelf, in a new page if needed */
+    for( unsigned i = 0; i < ATLAS_MAX_PAGES; i++ )
+    {
+        page_t *p_page = &p_atlas->p_pages[i];
+
+        if( !p_page->p_picture && PageNew( p_atlas, p_page ) )
+            return VLC_ENOMEM;
+        if( p_page->i_shelves >= ATLAS_MAX_SHELVES ||
+            p_page->i_used + i_height > p_atlas->i_height )
+            continue;
+
+        shelf_t *p_shelf = &p_page->p_shelves[p_page->i_shelves];
+        p_shelf->i_y = p_page->i_used;
+        p_shelf->i_height = i_height;
+        p_shelf->i_x = 0;
+        p_shelf->i_live = 0;
+        p_page->i_used += i_height;
+
+        SlotTake( p_atlas, i, p_page->i_shelves++, i_width, i_height, p_slot );
+        return VLC_SUCCESS;
+    }
+    return VLC_EGENERIC;
+}
+
+void danmaku_AtlasFree( danmaku_atlas_t *p_atlas, const danmaku_slot_t *p_slot )
+{
+    page_t *p_page = &p_atlas->p_pages[p_slot->i_page];
+    shelf_t *p_shelf = &p_page->p_shelves[p_slot->i_shelf];
+
+    assert( p_page->p_picture == p_slot->p_page && p_shelf->i_live > 0 );
+    if( --p_shelf->i_live == 0 )
+        p_shelf->i_x = 0;
+
+    /* Give the empty shelves at the bottom back to the page */
+    while( p_page->i_shelves > 0 &&
+           p_page->p_shelves[p_page->i_shelves - 1].i_live == 0 )
+    {
+        p_page->i_shelves--;
+        p_page->i_used = p_page->p_shelves[p_page->i_shelves].i_y;
+    }
+
+    /* Keep the first page, it will be used again soon */
+    if( --p_page->i_live == 0 && p_slot->i_page > 0 )
+    {
+        picture_Release( p_page->p_picture );
+        p_page->p_picture = NULL;
+    }
+}
@@ -0,0 +1,283 @@
+/*****************************************************************************
+ * danmaku_xml.c : Bilibili and AcFun comment lists
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* The lists are flat and come in two flavours:
+ *   <d p="time,mode,size,color,...">text</d>
+ *   <data><playTime>time</playTime>
+ *         <message fontsize="size" color="color" mode="mode">text</message>
+ *   </data>
+ * No XML parser is available in the Android build, and none is needed. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_strings.h>
+#include <vlc_charset.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "danmaku.h"
+
+/* Returns the '<' of the next <psz_tag ...> or <psz_tag>, before psz_end */
+static char *FindTag( char *p, const char *psz_end, const char *psz_tag )
+{
+    const size_t i_len = strlen( psz_tag );
+
+    while( (p = strchr( p, '<' )) != NULL && (!psz_end || p < psz_end) )
+    {
+        if( !strncmp( p + 1, psz_tag, i_len ) && p[1 + i_len] &&
+            strchr( " \t\r\n/>", p[1 + i_len] ) )
+            return p;
+        p++;
+    }
+    return NULL;
+}
+
+/* Returns a copy of the value of an attribute of the tag starting at p */
+static char *GetAttribute( const char *p, const char *psz_name )
+{
+    const char *psz_end = strchr( p, '>' );
+    const size_t i_len = strlen( psz_name );
+
+    if( !psz_end )
+        return NULL;
+    while( (p = strstr( p, psz_name )) != NULL && p < psz_end )
+    {
+        const char *psz_value = p + i_len;
+
+        if( strchr( " \t\r\n", p[-1] ) && *psz_value == '=' &&
+            ( psz_value[1] == '"' || psz_value[1] == '\'' ) )
+        {
+            const char *psz_stop = strchr( psz_value + 2, psz_value[1] );
+            if( !psz_stop || psz_stop > psz_end )
+                return NULL;
+            return strndup( psz_value + 2, psz_stop - psz_value - 2 );
+        }
+        p += i_len;
+    }
+    return NULL;
+}
+
+/* Returns a copy of the text content of the element starting at p, and
+ * moves *pp_next after its closing tag */
+static char *GetText( char *p, const char *psz_tag, char **pp_next )
+{
+    char psz_close[32];
+    char *psz_text, *psz_stop;
+
+    snprintf( psz_close, sizeof(psz_close), "</%s>", psz_tag );
+    psz_text = strchr( p, '>' );
+    if( !psz_text || psz_text[-1] == '/' )
+        return NULL;
+    psz_text++;
+
+    if( !strncmp( psz_text, "<![CDATA[", 9 ) )
+    {
+        psz_text += 9;
+        psz_stop = strstr( psz_text, "]]>" );
+        if( !psz_stop )
+            return NULL;
+        *pp_next = psz_stop + 3;
+        return strndup( psz_text, psz_stop - psz_text );
+    }
+
+    psz_stop = strstr( psz_text, psz_close );
+    if( !psz_stop )
+        return NULL;
+    *pp_next = psz_stop + strlen( psz_close );
+
+    char *psz_ret = strndup( psz_text, psz_stop - psz_text );
+    if( psz_ret )
+        resolve_xml_special_chars( psz_ret );
+    return psz_ret;
+}
+
+static int ModeFromXml( int i_mode )
+{
+    switch( i_mode )
+    {
+        case 1: case 2: case 3:
+            return DANMAKU_SCROLL;
+        case 4:
+            return DANMAKU_BOTTOM;
+        case 5:
+            return DANMAKU_TOP;
+        case 6:
+            return DANMAKU_REVERSE;
+        default: /* scripted and positioned comments */
+            return -1;
+    }
+}
+
+typedef struct
+{
+    danmaku_comment_t *p_comments;
+    size_t             i_count;
+    size_t             i_size;
+} comment_array_t;
+
+static void Append( comment_array_t *p_array, double f_time, int i_mode,
+                    int i_size, unsigned long i_color, char *psz_text )
+{
+    i_mode = ModeFromXml( i_mode );
+    if( i_mode < 0 || f_time < 0. || !psz_text || !*psz_text )
+    {
+        free( psz_text );
+        return;
+    }
+
+    if( p_array->i_count >= p_array->i_size )
+    {
+        size_t i_size = p_array->i_size ? 2 * p_array->i_size : 256;
+        danmaku_comment_t *p_new =
+            realloc( p_array->p_comments, i_size * sizeof(*p_new) );
+        if( !p_new )
+        {
+            free( psz_text );
+            return;
+        }
+        p_array->p_comments = p_new;
+        p_array->i_size = i_size;
+    }
+
+    danmaku_comment_t *p_comment = &p_array->p_comments[p_array->i_count++];
+    p_comment->i_time = (mtime_t)(f_time * CLOCK_FREQ);
+    p_comment->i_mode = i_mode;
+    p_comment->i_size = i_size > 0 ? i_size : DANMAKU_NORMAL_SIZE;
+    p_comment->i_color = i_color & 0xffffff;
+    p_comment->psz_text = psz_text;
+}
+
+static void ParseBilibili( comment_array_t *p_array, char *p )
+{
+    while( (p = FindTag( p, NULL, "d" )) != NULL )
+    {
+        char *psz_p = GetAttribute( p, "p" );
+        char *psz_text = GetText( p, "d", &p );
+
+        if( !psz_text )
+        {
+            free( psz_p );
+            p++;
+            continue;
+        }
+        if( !psz_p )
+        {
+            free( psz_text );
+            continue;
+        }
+
+        /* time,mode,size,color,date,pool,user,id */
+        char *psz_field = psz_p;
+        double f_time = us_strtod( psz_field, &psz_field );
+        int i_mode = -1, i_size = 0;
+        unsigned long i_color = 0xffffff;
+        if( *psz_field == ',' )
+            i_mode = strtol( psz_field + 1, &psz_field, 10 );
+        if( *psz_field == ',' )
+            i_size = strtol( psz_field + 1, &psz_field, 10 );
+        if( *psz_field == ',' )
+            i_color = strtoul( psz_field + 1, &psz_field, 10 );
+        free( psz_p );
+
+        Append( p_array, f_time, i_mode, i_size, i_color, psz_text );
+    }
+}
+
+static void ParseAcfun( comment_array_t *p_array, char *p )
+{
+    while( (p = FindTag( p, NULL, "data" )) != NULL )
+    {
+        char *psz_end = strstr( p, "</data>" );
+        char *psz_time, *psz_message, *psz_value, *psz_text;
+        double f_time;
+        int i_mode = 1, i_size = 0;
+        unsigned long i_color = 0xffffff;
+
+        if( !psz_end )
+            break;
+
+        psz_time = FindTag( p, psz_end, "playTime" );
+        psz_message = FindTag( p, psz_end, "message" );
+        p = psz_end + 7;
+        if( !psz_time || !psz_message )
+            continue;
+
+        psz_value = GetText( psz_time, "playTime", &psz_time );
+        if( !psz_value )
+            continue;
+        f_time = us_strtod( psz_value, NULL );
+        free( psz_value );
+
+        if( (psz_value = GetAttribute( psz_message, "mode" )) != NULL )
+            i_mode = atoi( psz_value );
+        free( psz_value );
+        if( (psz_value = GetAttribute( psz_message, "fontsize" )) != NULL )
+            i_size = atoi( psz_value );
+        free( psz_value );
+        if( (psz_value = GetAttribute( psz_message, "color" )) != NULL )
+            i_color = strtoul( psz_value, NULL, 10 );
+        free( psz_value );
+
+        psz_text = GetText( psz_message, "message", &psz_message );
+        Append( p_array, f_time, i_mode, i_size, i_color, psz_text );
+    }
+}
+
+static int CommentCmp( const void *a, const void *b )
+{
+    const danmaku_comment_t *p_a = a, *p_b = b;
+
+    return p_a->i_time < p_b->i_time ? -1 : p_a->i_time > p_b->i_time;
+}
+
+int danmaku_ParseXml( vlc_object_t *p_obj, char *psz_xml,
+                      danmaku_comment_t **pp_comments, size_t *pi_count )
+{
+    comment_array_t array = { NULL, 0, 0 };
+
+    if( FindTag( psz_xml, NULL, "d" ) )
+        ParseBilibili( &array, psz_xml );
+    else if( FindTag( psz_xml, NULL, "data" ) )
+        ParseAcfun( &array, psz_xml );
+
+    if( array.i_count == 0 )
+    {
+        msg_Warn( p_obj, "no comment found" );
+        free( array.p_comments );
+        return VLC_EGENERIC;
+    }
+
+    qsort( array.p_comments, array.i_count, sizeof(*array.p_comments),
+           CommentCmp );
+    *pp_comments = array.p_comments;
+    *pi_count = array.i_count;
+    return VLC_SUCCESS;
+}
+
+void danmaku_CommentsDelete( danmaku_comment_t *p_comments, size_t i_count )
+{
+    for( size_t i = 0; i < i_count; i++ )
+        free( p_comments[i].psz_text );
+    free( p_comments );
+}
@@ -27,7 +27,10 @@ LOCAL_C_INCLUDES += \
 LOCAL_CPPFLAGS += $(COMMON_OPT_CFLAGS)
 
 LOCAL_SRC_FILES := \
-    android_Surface.cpp
+    android_Surface.cpp \
+    android_scale.cpp \
+    android_scale_neon.S \
+    ../arm_neon/i420_rgb565.S
 
 LOCAL_LDFLAGS += -L$(DEPROOT)/android-3/lib
 LOCAL_LDLIBS += -lui
@@ -62,7 +65,10 @@ LOCAL_C_INCLUDES += \
     $(VLCROOT)/src
 
 LOCAL_SRC_FILES := \
-    android_Surface.cpp
+    android_Surface.cpp \
+    android_scale.cpp \
+    android_scale_neon.S \
+    ../arm_neon/i420_rgb565.S
 
 LOCAL_LDFLAGS += -L$(DEPROOT)/android-4/lib
 LOCAL_LDLIBS += -lui
@@ -97,7 +103,10 @@ LOCAL_C_INCLUDES += \
     $(VLCROOT)/src
 
 LOCAL_SRC_FILES := \
-    android_Surface.cpp
+    android_Surface.cpp \
+    android_scale.cpp \
+    android_scale_neon.S \
+    ../arm_neon/i420_rgb565.S
 
 LOCAL_LDFLAGS += -L$(DEPROOT)/android-5/lib
 LOCAL_LDLIBS += -lui
@@ -132,7 +141,10 @@ LOCAL_C_INCLUDES += \
     $(VLCROOT)/src
 
 LOCAL_SRC_FILES := \
-    android_Surface.cpp
+    android_Surface.cpp \
+    android_scale.cpp \
+    android_scale_neon.S \
+    ../arm_neon/i420_rgb565.S
 
 LOCAL_LDFLAGS += -L$(DEPROOT)/android-8/lib
 LOCAL_LDLIBS += -lsurfaceflinger_client
@@ -167,7 +179,10 @@ LOCAL_C_INCLUDES += \
     $(VLCROOT)/src
 
 LOCAL_SRC_FILES := \
-    android_Surface.cpp
+    android_Surface.cpp \
+    android_scale.cpp \
+    android_scale_neon.S \
+    ../arm_neon/i420_rgb565.S
 
 LOCAL_LDFLAGS += -L$(DEPROOT)/android-9/lib
 LOCAL_LDLIBS += -lsurfaceflinger_client
@@ -7,6 +7,7 @@
 #include <vlc_plugin.h>
 #include <vlc_vout_display.h>
 #include <vlc_picture_pool.h>
+#include <vlc_cpu.h>
 
 #ifndef __PLATFORM__
 #error "android api level is not defined!"
@@ -18,6 +19,8 @@
 #include <surfaceflinger/Surface.h>
 #endif
 
+#include "android_scale.h"
+
 using namespace android;
 
 extern "C" void LockSurface();
@@ -27,6 +30,22 @@ extern "C" void *GetSurface();
 static int Open (vlc_object_t *);
 static void Close(vlc_object_t *);
 
+#define SCALE_TEXT N_("Scaling mode")
+#define SCALE_LONGTEXT N_("Scaling mode used to fit the video into the surface.")
+
+#define YUV_TEXT N_("Direct YUV rendering")
+#define YUV_LONGTEXT N_("Convert I420 and NV12 pictures to RGB while " \
+    "scaling them into the surface, instead of through a chroma filter.")
+
+#define BENCH_TEXT N_("Benchmark the scaler")
+#define BENCH_LONGTEXT N_("Compare the scaler with the plain C loop on a " \
+    "synthetic frame when the output is opened, and log the timings.")
+
+static const int pi_scale_values[] = { SCALE_NEAREST, SCALE_BILINEAR };
+static const char *const ppsz_scale_descriptions[] = {
+    N_("Nearest neighbour (fast)"), N_("Bilinear")
+};
+
 vlc_module_begin()
     set_shortname("AndroidSurface")
     set_category(CAT_VIDEO)
@@ -34,6 +53,10 @@ vlc_module_begin()
     set_description(N_("Android Surface video output"))
     set_capability("vout display", __PLATFORM__)
     add_shortcut("android")
+    add_integer("android-scale-mode", SCALE_NEAREST, SCALE_TEXT, SCALE_LONGTEXT, true)
+        change_integer_list(pi_scale_values, ppsz_scale_descriptions)
+    add_bool("android-yuv", true, YUV_TEXT, YUV_LONGTEXT, true)
+    add_bool("android-scale-bench", false, BENCH_TEXT, BENCH_LONGTEXT, true)
     set_callbacks(Open, Close)
 vlc_module_end()
 
@@ -53,8 +76,10 @@ struct vout_display_sys_t {
     int stride;
 #endif
     int w, h;
+    vlc_fourcc_t chroma;
     picture_t *picture;
     picture_pool_t *pool;
+    scaler_t *scaler;
 };
 
 static int Open(vlc_object_t *object) {
@@ -89,6 +114,18 @@ static int Open(vlc_object_t *object) {
         msg_Err(vd, "unsupported chroma format %s", chroma_format);
         return VLC_EGENERIC;
     }
+    // YUV 4:2:0 is converted while scaling, which saves the chroma filter
+    // its intermediate picture and a full frame pass
+    if (chroma == VLC_CODEC_RGB16 && var_InheritBool(vd, "android-yuv")) {
+        switch (fmt.i_chroma) {
+        case VLC_CODEC_I420:
+        case VLC_CODEC_NV12:
+            chroma = fmt.i_chroma;
+            break;
+        default:
+            break;
+        }
+    }
     fmt.i_chroma = chroma;
     switch (chroma) {
     case VLC_CODEC_RGB16:
@@ -113,17 +150,26 @@ static int Open(vlc_object_t *object) {
 #endif
     sys->w = fmt.i_width;
     sys->h = fmt.i_height;
+    sys->chroma = fmt.i_chroma;
 #if __PLATFORM__ > 4
     msg_Dbg(object, "SurfaceInfo w = %d, h = %d, s = %d", sys->width, sys->height, sys->stride);
 #else
     msg_Dbg(object, "SurfaceInfo w = %d, h = %d", sys->width, sys->height);
 #endif
+    msg_Dbg(object, "rendering %4.4s pictures", (const char *)&fmt.i_chroma);
     sys->pool = NULL;
+    sys->scaler = scaler_New(var_InheritInteger(vd, "android-scale-mode"), vlc_CPU());
+    if (!sys->scaler) {
+        free(sys);
+        return VLC_ENOMEM;
+    }
     vd->sys = sys;
     vout_display_cfg_t cfg = *vd->cfg;
     cfg.display.width = info.w;
     cfg.display.height = info.h;
     vout_display_PlacePicture(&sys->place, &vd->source, &cfg, true);
+    if (var_InheritBool(vd, "android-scale-bench"))
+        scaler_Benchmark(object, sys->scaler, vd->source.i_visible_width, vd->source.i_visible_height, sys->place.width, sys->place.height);
     vd->info.has_hide_mouse = true;
     //vd->info.is_slow = true;
     // uncomment to disable dr
@@ -144,6 +190,7 @@ static void Close(vlc_object_t *object) {
 
     if (sys->pool)
         picture_pool_Delete(sys->pool);
+    scaler_Delete(sys->scaler);
     free(sys);
 }
 
@@ -215,80 +262,54 @@ static void Manage(vout_display_t *vd) {
     VLC_UNUSED(vd);
 }
 
-static inline void copyrow2(uint16_t *src, int src_w, uint16_t *dst, int dst_w) {
-    int i;
-    int pos, inc;
-    uint16_t pixel = 0;
-
-    if (src_w == dst_w) {
-        vlc_memcpy(dst, src, src_w * sizeof(*src));
-    }
-    else {
-        pos = 0x10000;
-        inc = (src_w << 16) / dst_w;
-        for (i = dst_w; i > 0; --i) {
-            while (pos >= 0x10000) {
-                pixel = *src++;
-                pos -= 0x10000;
-            }
-            *dst++ = pixel;
-            pos += inc;
-        }
-    }
-}
-
 static void picture_Strech2(vout_display_t *vd, picture_t *dst_p, picture_t *src_p) {
     vout_display_sys_t *sys = vd->sys;
     vout_display_place_t *place = &sys->place;
 
-    if (src_p->i_planes != 1 || dst_p->i_planes != 1)
+    if (dst_p->i_planes != 1)
         return;
     if ((sys->width < place->x + place->width) || (sys->height < place->y + place->height)) {
         msg_Dbg(VLC_OBJECT(vd), "Surface %dx%d, place %d, %d %dx%d, out of region", sys->width, sys->height, place->x, place->y, place->width, place->height);
         return;
     }
-    plane_t *sp = &src_p->p[0];
     plane_t *dp = &dst_p->p[0];
-    uint16_t *src, *dst;
-    uint16_t *srcp, *dstp;
-    int sw, sh, ss, dw, dh, ds;
-    int srx, sry, srh, srw;
-    int drx, dry, drh, drw;
-    int pos, inc;
-    int dst_max_row;
-    int src_row, dst_row;
-
-    src = (uint16_t*)sp->p_pixels;
-    dst = (uint16_t*)dp->p_pixels;
-    sw = sp->i_visible_pitch / sp->i_pixel_pitch;
-    sh = sp->i_visible_lines;
-    ss = sp->i_pitch / sp->i_pixel_pitch;
-    srx = 0;
-    sry = 0;
-    srw = sp->i_visible_pitch / sp->i_pixel_pitch;
-    srh = sp->i_visible_lines;
-    dw = dp->i_visible_pitch / dp->i_pixel_pitch;
-    dh = dp->i_visible_lines;
-    ds = dp->i_pitch / dp->i_pixel_pitch;
-    drx = place->x;
-    dry = place->y;
-    drw = place->width;
-    drh = place->height;
-    //msg_Dbg(VLC_OBJECT(vd), "%dx%d %d %d,%d %dx%d -> %dx%d %d %d,%d %dx%d", sw, sh, ss, srx, sry, srw, srh, dw, dh, ds, drx, dry, drw, drh);
-    pos = 0x10000;
-    inc = (srh << 16) / drh;
-    src_row = sry;
-    dst_row = dry;
-
-    for (dst_max_row = dst_row + drh; dst_row < dst_max_row; ++dst_row ) {
-        while (pos >= 0x10000) {
-            srcp = src + src_row * ss + srx;
-            ++src_row;
-            pos -= 0x10000;
+    uint8_t *dst;
+
+    dst = dp->p_pixels + place->y * dp->i_pitch + place->x * dp->i_pixel_pitch;
+    switch (sys->chroma) {
+    case VLC_CODEC_I420:
+    case VLC_CODEC_NV12: {
+            const video_format_t *fmt = &vd->fmt;
+            const bool nv12 = sys->chroma == VLC_CODEC_NV12;
+            const int step = nv12 ? 2 : 1;
+            const int x = fmt->i_x_offset, y = fmt->i_y_offset;
+            const uint8_t *planes[3];
+            int pitches[3];
+
+            if (src_p->i_planes != (nv12 ? 2 : 3))
+                return;
+            pitches[0] = src_p->p[0].i_pitch;
+            pitches[1] = src_p->p[1].i_pitch;
+            pitches[2] = nv12 ? src_p->p[1].i_pitch : src_p->p[2].i_pitch;
+            planes[0] = src_p->p[0].p_pixels + y * pitches[0] + x;
+            planes[1] = src_p->p[1].p_pixels + (y >> 1) * pitches[1] + (x >> 1) * step;
+            planes[2] = nv12 ? planes[1] + 1 : src_p->p[2].p_pixels + (y >> 1) * pitches[2] + (x >> 1);
+            scaler_Yuv420(sys->scaler,
+                          (uint16_t*)dst, dp->i_pitch, place->width, place->height,
+                          planes, pitches, step,
+                          fmt->i_visible_width, fmt->i_visible_height);
+        }
+        break;
+    default: {
+            plane_t *sp = &src_p->p[0];
+
+            if (src_p->i_planes != 1)
+                return;
+            scaler_Rgb565(sys->scaler,
+                          (uint16_t*)dst, dp->i_pitch, place->width, place->height,
+                          (const uint16_t*)sp->p_pixels, sp->i_pitch,
+                          sp->i_visible_pitch / sp->i_pixel_pitch, sp->i_visible_lines);
         }
-        dstp = dst + dst_row * ds + drx;
-        copyrow2(srcp, srw, dstp, drw);
-        pos += inc;
+        break;
     }
 }
-
@@ -0,0 +1,527 @@
+/*****************************************************************************
+ * android_scale.cpp: RGB565 scaler engine for the Android Surface vout
+ *****************************************************************************
+ * The scaling is split in a horizontal pass working on one source row and a
+ * vertical pass working on whole destination rows. Both passes have a plain C
+ * version and an ARM NEON version (android_scale_neon.S), picked at creation
+ * time from the CPU flags. YUV 4:2:0 sources are converted on the fly while
+ * scaling, so they never need an intermediate RGB picture, with the same
+ * conversion as the arm_neon chroma converter (i420_rgb565.S). Weights are 5 bits so that every intermediate value
+ * of a 565 channel fits in 16 bits, which keeps the C and NEON outputs bit
+ * exact.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include <assert.h>
+
+#include "android_scale.h"
+#include "../arm_neon/i420_rgb565.h"
+
+#define SCALE_BITS  5
+#define SCALE_ONE   (1 << SCALE_BITS)
+#define SCALE_ROUND (1 << (SCALE_BITS - 1))
+
+typedef void (*h_nearest_t)(uint16_t *, const uint16_t *, const int32_t *,
+                            unsigned);
+typedef void (*h_bilinear_t)(uint16_t *, const uint16_t *, const int32_t *,
+                             const uint16_t *, unsigned);
+typedef void (*v_bilinear_t)(uint16_t *, const uint16_t *, const uint16_t *,
+                             unsigned, unsigned);
+typedef void (*yuv_line_t)(uint16_t *, const uint8_t *, const uint8_t *,
+                           const uint8_t *, int, unsigned);
+
+/* source of the frame being scaled */
+typedef struct {
+    const uint8_t *p_pixels[3];
+    int i_pitch[3];
+    int i_uv_step;          /* 0 for RGB565, else distance between chroma samples */
+} source_t;
+
+struct scaler_t {
+    int i_mode;
+    source_t src;
+    /* geometry the tables below were computed for */
+    int sw, sh, dw, dh;
+    int32_t *p_xofs;        /* byte offset of the (left) source pixel */
+    uint16_t *p_xfrac;      /* weight of the right source pixel */
+    uint16_t *p_rows[2];    /* horizontally scaled source rows */
+    uint16_t *p_line;       /* one source row converted to RGB565 */
+    int i_row_y[2];
+    h_nearest_t pf_h_nearest;
+    h_bilinear_t pf_h_bilinear;
+    v_bilinear_t pf_v_bilinear;
+    yuv_line_t pf_yuv_line;
+    const char *psz_kernel;
+};
+
+/*****************************************************************************
+ * C kernels
+ *****************************************************************************/
+static inline unsigned Lerp565(unsigned a, unsigned b, unsigned w) {
+    const unsigned iw = SCALE_ONE - w;
+    unsigned r, g, bl;
+
+    r = ((a >> 11) * iw + (b >> 11) * w + SCALE_ROUND) >> SCALE_BITS;
+    g = (((a >> 5) & 0x3f) * iw + ((b >> 5) & 0x3f) * w + SCALE_ROUND) >> SCALE_BITS;
+    bl = ((a & 0x1f) * iw + (b & 0x1f) * w + SCALE_ROUND) >> SCALE_BITS;
+    return (r << 11) | (g << 5) | bl;
+}
+
+static void HNearestC(uint16_t *dst, const uint16_t *src,
+                      const int32_t *xofs, unsigned count) {
+    const uint8_t *base = (const uint8_t *)src;
+    unsigned i;
+
+    for (i = 0; i < count; i++)
+        dst[i] = *(const uint16_t *)(base + xofs[i]);
+}
+
+static void HBilinearC(uint16_t *dst, const uint16_t *src, const int32_t *xofs,
+                       const uint16_t *xfrac, unsigned count) {
+    const uint8_t *base = (const uint8_t *)src;
+    unsigned i;
+
+    for (i = 0; i < count; i++) {
+        const uint16_t *p = (const uint16_t *)(base + xofs[i]);
+        dst[i] = Lerp565(p[0], p[1], xfrac[i]);
+    }
+}
+
+static void VBilinearC(uint16_t *dst, const uint16_t *a, const uint16_t *b,
+                       unsigned count, unsigned weight) {
+    unsigned i;
+
+    for (i = 0; i < count; i++)
+        dst[i] = Lerp565(a[i], b[i], weight);
+}
+
+/* Converts count pixels of a row, chroma samples being step bytes apart */
+static void YuvLineC(uint16_t *dst, const uint8_t *py, const uint8_t *pu,
+                     const uint8_t *pv, int step, unsigned count) {
+    unsigned i;
+
+    for (i = 0; i < count; i++) {
+        const int c = (i >> 1) * step;
+
+        dst[i] = yuv_rgb565(py[i], pu[c], pv[c]);
+    }
+}
+
+/* Converts the pixels of source row y picked by xofs (RGB565 byte offsets) */
+static void YuvRow(uint16_t *dst, const source_t *src, int y,
+                   const int32_t *xofs, unsigned count) {
+    const uint8_t *py = src->p_pixels[0] + y * src->i_pitch[0];
+    const uint8_t *pu = src->p_pixels[1] + (y >> 1) * src->i_pitch[1];
+    const uint8_t *pv = src->p_pixels[2] + (y >> 1) * src->i_pitch[2];
+    const int step = src->i_uv_step;
+    unsigned i;
+
+    for (i = 0; i < count; i++) {
+        const int sx = xofs[i] >> 1;
+        const int c = (sx >> 1) * step;
+
+        dst[i] = yuv_rgb565(py[sx], pu[c], pv[c]);
+    }
+}
+
+/*****************************************************************************
+ * NEON kernels, they handle multiples of 8 pixels, C does the tail
+ *****************************************************************************/
+#if defined(__arm__)
+extern "C" {
+void scale_h_nearest_rgb565_neon(uint16_t *, const uint16_t *,
+                                 const int32_t *, unsigned);
+void scale_h_bilinear_rgb565_neon(uint16_t *, const uint16_t *,
+                                  const int32_t *, const uint16_t *, unsigned);
+void scale_v_bilinear_rgb565_neon(uint16_t *, const uint16_t *,
+                                  const uint16_t *, unsigned, unsigned);
+}
+
+static void HNearestNEON(uint16_t *dst, const uint16_t *src,
+                         const int32_t *xofs, unsigned count) {
+    const unsigned n = count & ~7;
+
+    if (n)
+        scale_h_nearest_rgb565_neon(dst, src, xofs, n);
+    HNearestC(dst + n, src, xofs + n, count - n);
+}
+
+static void HBilinearNEON(uint16_t *dst, const uint16_t *src, const int32_t *xofs,
+                          const uint16_t *xfrac, unsigned count) {
+    const unsigned n = count & ~7;
+
+    if (n)
+        scale_h_bilinear_rgb565_neon(dst, src, xofs, xfrac, n);
+    HBilinearC(dst + n, src, xofs + n, xfrac + n, count - n);
+}
+
+static void VBilinearNEON(uint16_t *dst, const uint16_t *a, const uint16_t *b,
+                          unsigned count, unsigned weight) {
+    const unsigned n = count & ~7;
+
+    if (n)
+        scale_v_bilinear_rgb565_neon(dst, a, b, n, weight);
+    VBilinearC(dst + n, a + n, b + n, count - n, weight);
+}
+
+/* the YUV kernels of the arm_neon chroma converter, 16 pixels at a time */
+static void YuvLineNEON(uint16_t *dst, const uint8_t *py, const uint8_t *pu,
+                        const uint8_t *pv, int step, unsigned count) {
+    const unsigned n = count & ~15;
+
+    if (n) {
+        if (step == 1)
+            i420_rgb565_neon(dst, py, pu, pv, n);
+        else if (step == 2 && pv == pu + 1)
+            nv12_rgb565_neon(dst, py, pu, n);
+        else {
+            YuvLineC(dst, py, pu, pv, step, count);
+            return;
+        }
+    }
+    YuvLineC(dst + n, py + n, pu + n / 2 * step, pv + n / 2 * step, step, count - n);
+}
+#endif
+
+/*****************************************************************************
+ * Engine
+ *****************************************************************************/
+scaler_t *scaler_New(int i_mode, unsigned i_cpu) {
+    scaler_t *s = (scaler_t *)calloc(1, sizeof(*s));
+
+    if (!s)
+        return NULL;
+    s->i_mode = i_mode;
+    s->pf_h_nearest = HNearestC;
+    s->pf_h_bilinear = HBilinearC;
+    s->pf_v_bilinear = VBilinearC;
+    s->pf_yuv_line = YuvLineC;
+    s->psz_kernel = "C";
+#if defined(__arm__)
+    if (i_cpu & CPU_CAPABILITY_NEON) {
+        s->pf_h_nearest = HNearestNEON;
+        s->pf_h_bilinear = HBilinearNEON;
+        s->pf_v_bilinear = VBilinearNEON;
+        s->pf_yuv_line = YuvLineNEON;
+        s->psz_kernel = "NEON";
+    }
+#else
+    VLC_UNUSED(i_cpu);
+#endif
+    return s;
+}
+
+static void Clean(scaler_t *s) {
+    free(s->p_xofs);
+    free(s->p_xfrac);
+    free(s->p_rows[0]);
+    free(s->p_rows[1]);
+    free(s->p_line);
+    s->p_xofs = NULL;
+    s->p_xfrac = NULL;
+    s->p_rows[0] = s->p_rows[1] = NULL;
+    s->p_line = NULL;
+    s->sw = s->sh = s->dw = s->dh = 0;
+}
+
+void scaler_Delete(scaler_t *s) {
+    if (!s)
+        return;
+    Clean(s);
+    free(s);
+}
+
+static bool IsBilinear(const scaler_t *s, int sw, int sh) {
+    /* bilinear needs two source pixels in each direction */
+    return s->i_mode == SCALE_BILINEAR && sw > 1 && sh > 1;
+}
+
+static int Setup(scaler_t *s, int sw, int sh, int dw, int dh) {
+    int x;
+
+    if (s->sw == sw && s->sh == sh && s->dw == dw && s->dh == dh)
+        return VLC_SUCCESS;
+    Clean(s);
+    s->p_xofs = (int32_t *)malloc(dw * sizeof(*s->p_xofs));
+    s->p_xfrac = (uint16_t *)malloc(dw * sizeof(*s->p_xfrac));
+    s->p_rows[0] = (uint16_t *)malloc(dw * sizeof(uint16_t));
+    s->p_rows[1] = (uint16_t *)malloc(dw * sizeof(uint16_t));
+    s->p_line = (uint16_t *)malloc(sw * sizeof(uint16_t));
+    if (!s->p_xofs || !s->p_xfrac || !s->p_rows[0] || !s->p_rows[1] || !s->p_line) {
+        Clean(s);
+        return VLC_ENOMEM;
+    }
+    if (IsBilinear(s, sw, sh)) {
+        /* sample at pixel centers */
+        const int32_t inc = (sw << 16) / dw;
+        int32_t fx = inc / 2 - 0x8000;
+
+        for (x = 0; x < dw; x++, fx += inc) {
+            int sx = 0, w = 0;
+
+            if (fx > 0) {
+                sx = fx >> 16;
+                w = ((fx & 0xffff) + (1 << (15 - SCALE_BITS))) >> (16 - SCALE_BITS);
+            }
+            if (sx >= sw - 1) {
+                sx = sw - 2;
+                w = SCALE_ONE;
+            }
+            s->p_xofs[x] = sx * sizeof(uint16_t);
+            s->p_xfrac[x] = w;
+        }
+    }
+    else {
+        /* same stepping as the historical copyrow2() */
+        const uint32_t inc = ((uint32_t)sw << 16) / dw;
+
+        for (x = 0; x < dw; x++) {
+            s->p_xofs[x] = ((x * inc) >> 16) * sizeof(uint16_t);
+            s->p_xfrac[x] = 0;
+        }
+    }
+    s->sw = sw;
+    s->sh = sh;
+    s->dw = dw;
+    s->dh = dh;
+    return VLC_SUCCESS;
+}
+
+/* Converts the whole source row y */
+static void YuvLine(scaler_t *s, uint16_t *dst, int y) {
+    const source_t *src = &s->src;
+
+    s->pf_yuv_line(dst, src->p_pixels[0] + y * src->i_pitch[0],
+                   src->p_pixels[1] + (y >> 1) * src->i_pitch[1],
+                   src->p_pixels[2] + (y >> 1) * src->i_pitch[2],
+                   src->i_uv_step, s->sw);
+}
+
+static const uint16_t *SourceRow(scaler_t *s, int y) {
+    const source_t *src = &s->src;
+
+    if (src->i_uv_step) {
+        YuvLine(s, s->p_line, y);
+        return s->p_line;
+    }
+    return (const uint16_t *)(src->p_pixels[0] + y * src->i_pitch[0]);
+}
+
+static const uint16_t *GetRow(scaler_t *s, int y) {
+    int i;
+
+    if (s->sw == s->dw && !s->src.i_uv_step)
+        return SourceRow(s, y);
+    if (s->i_row_y[0] == y)
+        return s->p_rows[0];
+    if (s->i_row_y[1] == y)
+        return s->p_rows[1];
+    /* rows are requested in increasing order, drop the oldest */
+    i = s->i_row_y[0] < s->i_row_y[1] ? 0 : 1;
+    if (s->sw == s->dw)
+        YuvLine(s, s->p_rows[i], y);
+    else
+        s->pf_h_bilinear(s->p_rows[i], SourceRow(s, y), s->p_xofs, s->p_xfrac, s->dw);
+    s->i_row_y[i] = y;
+    return s->p_rows[i];
+}
+
+static void ScaleNearest(scaler_t *s, uint16_t *dst, int i_dst_pitch) {
+    const uint32_t inc = ((uint32_t)s->sh << 16) / s->dh;
+    const size_t i_row = s->dw * sizeof(uint16_t);
+    const uint16_t *scaled = NULL;
+    int last = -1;
+    int y;
+
+    for (y = 0; y < s->dh; y++) {
+        const int sy = (y * inc) >> 16;
+        uint16_t *d = (uint16_t *)((uint8_t *)dst + y * i_dst_pitch);
+
+        /* rows repeated by upscaling are scaled only once, and never read
+         * back from the surface which may be uncached */
+        if (sy != last) {
+            if (s->src.i_uv_step && s->sw > s->dw) {
+                /* convert only the sampled pixels */
+                YuvRow(s->p_rows[0], &s->src, sy, s->p_xofs, s->dw);
+                scaled = s->p_rows[0];
+            }
+            else if (s->sw == s->dw)
+                scaled = SourceRow(s, sy);
+            else {
+                s->pf_h_nearest(s->p_rows[0], SourceRow(s, sy), s->p_xofs, s->dw);
+                scaled = s->p_rows[0];
+            }
+            last = sy;
+        }
+        vlc_memcpy(d, scaled, i_row);
+    }
+}
+
+static void ScaleBilinear(scaler_t *s, uint16_t *dst, int i_dst_pitch) {
+    const int32_t inc = (s->sh << 16) / s->dh;
+    const size_t i_row = s->dw * sizeof(uint16_t);
+    int32_t fy = inc / 2 - 0x8000;
+    int y;
+
+    s->i_row_y[0] = s->i_row_y[1] = -1;
+    for (y = 0; y < s->dh; y++, fy += inc) {
+        uint16_t *d = (uint16_t *)((uint8_t *)dst + y * i_dst_pitch);
+        const uint16_t *a, *b;
+        int sy = 0, w = 0;
+
+        if (fy > 0) {
+            sy = fy >> 16;
+            w = ((fy & 0xffff) + (1 << (15 - SCALE_BITS))) >> (16 - SCALE_BITS);
+        }
+        if (sy >= s->sh - 1) {
+            sy = s->sh - 1;
+            w = 0;
+        }
+        else if (w == SCALE_ONE) {
+            sy++;
+            w = 0;
+        }
+        a = GetRow(s, sy);
+        if (w == 0)
+            vlc_memcpy(d, a, i_row);
+        else {
+            b = GetRow(s, sy + 1);
+            s->pf_v_bilinear(d, a, b, s->dw, w);
+        }
+    }
+}
+
+static void Scale(scaler_t *s, uint16_t *dst, int i_dst_pitch,
+                  int dw, int dh, int sw, int sh) {
+    if (sw <= 0 || sh <= 0 || dw <= 0 || dh <= 0)
+        return;
+    if (Setup(s, sw, sh, dw, dh))
+        return;
+    if (IsBilinear(s, sw, sh))
+        ScaleBilinear(s, dst, i_dst_pitch);
+    else
+        ScaleNearest(s, dst, i_dst_pitch);
+}
+
+void scaler_Rgb565(scaler_t *s,
+                   uint16_t *dst, int i_dst_pitch, int dw, int dh,
+                   const uint16_t *src, int i_src_pitch, int sw, int sh) {
+    memset(&s->src, 0, sizeof(s->src));
+    s->src.p_pixels[0] = (const uint8_t *)src;
+    s->src.i_pitch[0] = i_src_pitch;
+    Scale(s, dst, i_dst_pitch, dw, dh, sw, sh);
+}
+
+void scaler_Yuv420(scaler_t *s,
+                   uint16_t *dst, int i_dst_pitch, int dw, int dh,
+                   const uint8_t *const pp_src[3], const int pi_src_pitch[3],
+                   int i_uv_step, int sw, int sh) {
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        s->src.p_pixels[i] = pp_src[i];
+        s->src.i_pitch[i] = pi_src_pitch[i];
+    }
+    s->src.i_uv_step = i_uv_step;
+    Scale(s, dst, i_dst_pitch, dw, dh, sw, sh);
+}
+
+/*****************************************************************************
+ * Benchmark
+ *****************************************************************************/
+/* The scalar loop the vout used before the engine, kept as a reference */
+static inline void copyrow2(const uint16_t *src, int src_w, uint16_t *dst, int dst_w) {
+    int i;
+    int pos, inc;
+    uint16_t pixel = 0;
+
+    if (src_w == dst_w) {
+        vlc_memcpy(dst, src, src_w * sizeof(*src));
+    }
+    else {
+        pos = 0x10000;
+        inc = (src_w << 16) / dst_w;
+        for (i = dst_w; i > 0; --i) {
+            while (pos >= 0x10000) {
+                pixel = *src++;
+                pos -= 0x10000;
+            }
+            *dst++ = pixel;
+            pos += inc;
+        }
+    }
+}
+
+static void LegacyStretch(uint16_t *dst, int ds, int drw, int drh,
+                          const uint16_t *src, int ss, int srw, int srh) {
+    const uint16_t *srcp = src;
+    int pos = 0x10000;
+    int inc = (srh << 16) / drh;
+    int src_row = 0;
+    int dst_row;
+
+    for (dst_row = 0; dst_row < drh; ++dst_row) {
+        while (pos >= 0x10000) {
+            srcp = src + src_row * ss;
+            ++src_row;
+            pos -= 0x10000;
+        }
+        copyrow2(srcp, srw, dst + dst_row * ds, drw);
+        pos += inc;
+    }
+}
+
+int scaler_Benchmark(vlc_object_t *obj, scaler_t *s, int sw, int sh, int dw, int dh) {
+    const int i_runs = 20;
+    const size_t i_src = sw * sh, i_dst = dw * dh;
+    uint16_t *src = (uint16_t *)malloc(i_src * sizeof(uint16_t));
+    uint16_t *ref = (uint16_t *)malloc(i_dst * sizeof(uint16_t));
+    uint16_t *res = (uint16_t *)malloc(i_dst * sizeof(uint16_t));
+    scaler_t *c = NULL;
+    uint32_t seed = 0x12345678;
+    mtime_t t0, t1, t2;
+    size_t i;
+    int i_ret = VLC_ENOMEM;
+
+    if (!src || !ref || !res || sw <= 0 || sh <= 0 || dw <= 0 || dh <= 0)
+        goto out;
+
+    for (i = 0; i < i_src; i++) {
+        seed = seed * 1103515245 + 12345;
+        src[i] = seed >> 16;
+    }
+
+    t0 = mdate();
+    for (i = 0; i < (size_t)i_runs; i++)
+        LegacyStretch(ref, dw, dw, dh, src, sw, sw, sh);
+    t1 = mdate();
+    for (i = 0; i < (size_t)i_runs; i++)
+        scaler_Rgb565(s, res, dw * 2, dw, dh, src, sw * 2, sw, sh);
+    t2 = mdate();
+
+    /* nearest must match the historical loop, bilinear must match C */
+    if (IsBilinear(s, sw, sh)) {
+        c = scaler_New(SCALE_BILINEAR, 0);
+        if (!c)
+            goto out;
+        scaler_Rgb565(c, ref, dw * 2, dw, dh, src, sw * 2, sw, sh);
+    }
+    i_ret = memcmp(ref, res, i_dst * sizeof(uint16_t)) ? VLC_EGENERIC : VLC_SUCCESS;
+    msg_Info(obj, "scaler %s/%s %dx%d -> %dx%d: C loop %lld us, engine %lld us per frame, output %s",
+             IsBilinear(s, sw, sh) ? "bilinear" : "nearest", s->psz_kernel,
+             sw, sh, dw, dh,
+             (long long)((t1 - t0) / i_runs), (long long)((t2 - t1) / i_runs),
+             i_ret ? "MISMATCH" : "ok");
+out:
+    scaler_Delete(c);
+    free(src);
+    free(ref);
+    free(res);
+    return i_ret;
+}
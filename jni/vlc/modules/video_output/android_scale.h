@@ -0,0 +1,35 @@
+/*****************************************************************************
+ * android_scale.h: RGB565 scaler engine for the Android Surface vout
+ *****************************************************************************/
+
+#ifndef ANDROID_SCALE_H
+#define ANDROID_SCALE_H 1
+
+enum {
+    SCALE_NEAREST = 0,
+    SCALE_BILINEAR,
+};
+
+typedef struct scaler_t scaler_t;
+
+/* i_cpu is a vlc_CPU() mask, the kernels are chosen from it */
+scaler_t *scaler_New(int i_mode, unsigned i_cpu);
+void scaler_Delete(scaler_t *);
+
+/* Scales a sw x sh RGB565 rectangle into a dw x dh one, pitches in bytes */
+void scaler_Rgb565(scaler_t *,
+                   uint16_t *dst, int i_dst_pitch, int dw, int dh,
+                   const uint16_t *src, int i_src_pitch, int sw, int sh);
+
+/* Same as scaler_Rgb565() for a YUV 4:2:0 source (Y, U, V planes), the
+ * chroma samples being i_uv_step bytes apart (1 for I420, 2 for NV12) */
+void scaler_Yuv420(scaler_t *,
+                   uint16_t *dst, int i_dst_pitch, int dw, int dh,
+                   const uint8_t *const pp_src[3], const int pi_src_pitch[3],
+                   int i_uv_step, int sw, int sh);
+
+/* Runs the legacy C loop and the selected kernels on a synthetic frame,
+ * checks that the outputs agree and logs timings. */
+int scaler_Benchmark(vlc_object_t *, scaler_t *, int sw, int sh, int dw, int dh);
+
+#endif
@@ -172,9 +172,15 @@ int aout_OutputNew( aout_instance_t * p_aout,
     p_aout->mixer_format = p_aout->output.output;
     if ( !AOUT_FMT_NON_LINEAR(&p_aout->output.output) )
     {
-        /* Non-S/PDIF mixer only deals with float32 or fixed32. */
-        p_aout->mixer_format.i_format
-                     = HAVE_FPU ? VLC_CODEC_FL32 : VLC_CODEC_FI32;
+        /* Non-S/PDIF mixer only deals with float32 or fixed32. Without
+         * FPU, mix straight in S16 for the outputs that take it: the
+         * decoders mostly output S16 and the chain stays integer. */
+        if( HAVE_FPU )
+            p_aout->mixer_format.i_format = VLC_CODEC_FL32;
+        else if( p_aout->output.output.i_format == VLC_CODEC_S16N )
+            p_aout->mixer_format.i_format = VLC_CODEC_S16N;
+        else
+            p_aout->mixer_format.i_format = VLC_CODEC_FI32;
         aout_FormatPrepare( &p_aout->mixer_format );
     }
     else
@@ -37,6 +37,7 @@
 #include <vlc_keys.h>
 
 #include "libvlc.h"
+#include "input/input_interface.h" // input_CreatePreroll()
 
 #include "libvlc_internal.h"
 #include "media_internal.h" // libvlc_media_set_state()
@@ -116,6 +117,32 @@ static inline void unlock_input(libvlc_media_player_t *mp)
     vlc_mutex_unlock(&mp->input.lock);
 }
 
+static void add_input_callbacks( libvlc_media_player_t *p_mi,
+                                 input_thread_t *p_input_thread )
+{
+    var_AddCallback( p_input_thread, "can-seek", input_seekable_changed, p_mi );
+    var_AddCallback( p_input_thread, "can-pause", input_pausable_changed, p_mi );
+    var_AddCallback( p_input_thread, "intf-event", input_event_changed, p_mi );
+}
+
+static void del_input_callbacks( libvlc_media_player_t *p_mi,
+                                 input_thread_t *p_input_thread )
+{
+    var_DelCallback( p_input_thread, "intf-event", input_event_changed, p_mi );
+    var_DelCallback( p_input_thread, "can-pause", input_pausable_changed, p_mi );
+    var_DelCallback( p_input_thread, "can-seek", input_seekable_changed, p_mi );
+}
+
+/*
+ * Stop an input opened ahead of time, nobody listens to its events.
+ */
+static void release_preroll_thread( input_thread_t *p_input_thread )
+{
+    input_Stop( p_input_thread, true );
+    vlc_thread_join( p_input_thread );
+    vlc_object_release( p_input_thread );
+}
+
 /*
  * Release the associated input thread.
  *
@@ -130,12 +157,7 @@ static void release_input_thread( libvlc_media_player_t *p_mi, bool b_input_abor
     if( !p_input_thread )
         return;
 
-    var_DelCallback( p_input_thread, "can-seek",
-                     input_seekable_changed, p_mi );
-    var_DelCallback( p_input_thread, "can-pause",
-                    input_pausable_changed, p_mi );
-    var_DelCallback( p_input_thread, "intf-event",
-                     input_event_changed, p_mi );
+    del_input_callbacks( p_mi, p_input_thread );
 
     /* We owned this one */
     input_Stop( p_input_thread, b_input_abort );
@@ -464,6 +486,7 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     mp->state = libvlc_NothingSpecial;
     mp->p_libvlc_instance = instance;
     mp->input.p_thread = NULL;
+    mp->input.p_preroll = NULL;
     mp->input.p_resource = NULL;
     vlc_mutex_init (&mp->input.lock);
     mp->i_refcount = 1;
@@ -545,6 +568,8 @@ static void libvlc_media_player_destroy( libvlc_media_player_t *p_mi )
     /* No need for lock_input() because no other threads knows us anymore */
     if( p_mi->input.p_thread )
         release_input_thread(p_mi, true);
+    if( p_mi->input.p_preroll )
+        release_preroll_thread( p_mi->input.p_preroll );
     if( p_mi->input.p_resource )
     {
         input_resource_Terminate( p_mi->input.p_resource );
@@ -696,9 +721,35 @@ int libvlc_media_player_play( libvlc_media_player_t *p_mi )
 
     if( !p_mi->input.p_resource )
         p_mi->input.p_resource = input_resource_New( VLC_OBJECT( p_mi ) );
-    p_input_thread = input_Create( p_mi, p_mi->p_md->p_input_item, NULL,
-                                   p_mi->input.p_resource );
+    input_item_t *p_item = p_mi->p_md->p_input_item;
     unlock(p_mi);
+
+    /* Start from the input opened ahead of time if it is for this media */
+    input_thread_t *p_preroll = p_mi->input.p_preroll;
+    p_mi->input.p_preroll = NULL;
+    if( p_preroll && input_GetItem( p_preroll ) != p_item )
+    {
+        release_preroll_thread( p_preroll );
+        p_preroll = NULL;
+    }
+    if( p_preroll )
+    {
+        add_input_callbacks( p_mi, p_preroll );
+        /* It may have failed or been killed before it had our callbacks,
+         * and then its end would never be reported */
+        const int i_state = var_GetInteger( p_preroll, "state" );
+        if( !p_preroll->b_dead && i_state != ERROR_S && i_state != END_S )
+        {
+            input_Control( p_preroll, INPUT_SET_STATE, PLAYING_S );
+            p_mi->input.p_thread = p_preroll;
+            unlock_input(p_mi);
+            return 0;
+        }
+        del_input_callbacks( p_mi, p_preroll );
+        release_preroll_thread( p_preroll );
+    }
+
+    p_input_thread = input_Create( p_mi, p_item, NULL, p_mi->input.p_resource );
     if( !p_input_thread )
     {
         unlock_input(p_mi);
@@ -706,16 +757,12 @@ int libvlc_media_player_play( libvlc_media_player_t *p_mi )
         return -1;
     }
 
-    var_AddCallback( p_input_thread, "can-seek", input_seekable_changed, p_mi );
-    var_AddCallback( p_input_thread, "can-pause", input_pausable_changed, p_mi );
-    var_AddCallback( p_input_thread, "intf-event", input_event_changed, p_mi );
+    add_input_callbacks( p_mi, p_input_thread );
 
     if( input_Start( p_input_thread ) )
     {
         unlock_input(p_mi);
-        var_DelCallback( p_input_thread, "intf-event", input_event_changed, p_mi );
-        var_DelCallback( p_input_thread, "can-pause", input_pausable_changed, p_mi );
-        var_DelCallback( p_input_thread, "can-seek", input_seekable_changed, p_mi );
+        del_input_callbacks( p_mi, p_input_thread );
         vlc_object_release( p_input_thread );
         libvlc_printerr( "Input initialization failure" );
         return -1;
@@ -725,6 +772,46 @@ int libvlc_media_player_play( libvlc_media_player_t *p_mi )
     return 0;
 }
 
+/**************************************************************************
+ * Open the media that is likely to be played next, or drop the one opened
+ * before if p_md is NULL. Only its access and demuxer are opened, see
+ * input_CreatePreroll(). libvlc_media_player_play() starts from it if the
+ * player is set to the same media by then.
+ **************************************************************************/
+int libvlc_media_player_preroll( libvlc_media_player_t *p_mi,
+                                 libvlc_media_t *p_md )
+{
+    input_thread_t *p_input_thread = NULL;
+
+    lock_input( p_mi );
+    if( p_mi->input.p_preroll )
+    {
+        release_preroll_thread( p_mi->input.p_preroll );
+        p_mi->input.p_preroll = NULL;
+    }
+    if( !p_md )
+    {
+        unlock_input( p_mi );
+        return 0;
+    }
+
+    lock( p_mi );
+    if( !p_mi->input.p_resource )
+        p_mi->input.p_resource = input_resource_New( VLC_OBJECT( p_mi ) );
+    unlock( p_mi );
+
+    p_input_thread = input_CreatePreroll( p_mi, p_md->p_input_item,
+                                          p_mi->input.p_resource );
+    if( p_input_thread && input_Start( p_input_thread ) )
+    {
+        vlc_object_release( p_input_thread );
+        p_input_thread = NULL;
+    }
+    p_mi->input.p_preroll = p_input_thread;
+    unlock_input( p_mi );
+    return p_input_thread ? 0 : -1;
+}
+
 void libvlc_media_player_set_pause( libvlc_media_player_t *p_mi, int paused )
 {
     input_thread_t * p_input_thread = libvlc_get_input_thread( p_mi );
@@ -782,6 +869,11 @@ void libvlc_media_player_stop( libvlc_media_player_t *p_mi )
 
     lock_input(p_mi);
     release_input_thread( p_mi, true ); /* This will stop the input thread */
+    if( p_mi->input.p_preroll )
+    {
+        release_preroll_thread( p_mi->input.p_preroll );
+        p_mi->input.p_preroll = NULL;
+    }
 
     /* Force to go to stopped state, in case we were in Ended, or Error
      * state. */
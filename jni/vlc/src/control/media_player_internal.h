@@ -44,6 +44,7 @@ struct libvlc_media_player_t
     struct
     {
         input_thread_t   *p_thread;
+        input_thread_t   *p_preroll; /* next media, opened ahead of time */
         input_resource_t *p_resource;
         vlc_mutex_t       lock;
     } input;
@@ -56,6 +57,7 @@ struct libvlc_media_player_t
 
 /* Media player - audio, video */
 input_thread_t *libvlc_get_input_thread(libvlc_media_player_t * );
+int libvlc_media_player_preroll( libvlc_media_player_t *, libvlc_media_t * );
 
 
 libvlc_track_description_t * libvlc_get_track_description(
@@ -99,6 +99,18 @@ int input_vaControl( input_thread_t *p_input, int i_query, va_list args )
             i_64 = (int64_t)va_arg( args, int64_t );
             return var_SetTime( p_input, "time", i_64 );
 
+        case INPUT_SEEK_TIME:
+        {
+            vlc_value_t val;
+
+            val.i_time = (int64_t)va_arg( args, int64_t );
+            b_bool = (bool)va_arg( args, int );
+            input_ControlPush( p_input, b_bool ? INPUT_CONTROL_SET_TIME_FAST
+                                               : INPUT_CONTROL_SET_TIME_PRECISE,
+                               &val );
+            return VLC_SUCCESS;
+        }
+
         case INPUT_GET_RATE:
             pi_int = (int*)va_arg( args, int * );
             *pi_int = INPUT_RATE_DEFAULT / var_GetFloat( p_input, "rate" );
@@ -30,6 +30,7 @@
 # include "config.h"
 #endif
 #include <assert.h>
+#include <time.h>
 
 #include <vlc_common.h>
 
@@ -122,6 +123,15 @@ struct decoder_owner_sys_t
 
     vout_thread_t   *p_vout;
 
+    /* CPU used per second of audio, see "audio-benchmark" */
+    struct
+    {
+        bool    b_enabled;
+        mtime_t i_cpu;   /* decoding, filtering and mixing */
+        mtime_t i_audio; /* duration of the decoded audio */
+        mtime_t i_last;  /* i_audio at the last report */
+    } bench;
+
     /* -- Theses variables need locking on read *and* write -- */
     /* */
     /* Pause */
@@ -676,6 +686,13 @@ static mtime_t DecoderGetDisplayDate( decoder_t *p_dec, mtime_t i_ts )
     if( input_clock_ConvertTS( p_owner->p_clock, NULL, &i_ts, NULL, INT64_MAX ) )
         return VLC_TS_INVALID;
 
+    /* A picture is late as soon as the video output cannot display it in
+     * time anymore, so account for the time it needs */
+    vlc_mutex_lock( &p_owner->lock );
+    if( p_owner->p_vout )
+        i_ts -= vout_GetDisplayDelay( p_owner->p_vout );
+    vlc_mutex_unlock( &p_owner->lock );
+
     return i_ts;
 }
 static int DecoderGetDisplayRate( decoder_t *p_dec )
@@ -726,6 +743,7 @@ static decoder_t * CreateDecoder( input_thread_t *p_input,
     p_dec->pf_decode_sub = NULL;
     p_dec->pf_get_cc = NULL;
     p_dec->pf_packetize = NULL;
+    p_dec->i_extra_picture_buffers = 0;
 
     /* Initialize the decoder */
     p_dec->p_module = NULL;
@@ -847,6 +865,13 @@ static decoder_t * CreateDecoder( input_thread_t *p_input,
     p_owner->pause.i_date = VLC_TS_INVALID;
     p_owner->pause.i_ignore = 0;
 
+    p_owner->bench.b_enabled = !b_packetizer &&
+                               fmt->i_cat == AUDIO_ES &&
+                               var_InheritBool( p_dec, "audio-benchmark" );
+    p_owner->bench.i_cpu = 0;
+    p_owner->bench.i_audio = 0;
+    p_owner->bench.i_last = 0;
+
     p_owner->b_buffering = false;
     p_owner->buffer.b_first = true;
     p_owner->buffer.b_full = false;
@@ -1239,6 +1264,32 @@ static void DecoderPlayAudio( decoder_t *p_dec, aout_buffer_t *p_audio,
     }
 }
 
+/* CPU time of the calling thread, the decoder runs the whole audio chain */
+static mtime_t ThreadCpuTime( void )
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+
+    if( !clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts ) )
+        return INT64_C(1000000) * ts.tv_sec + ts.tv_nsec / 1000;
+#endif
+    return mdate();
+}
+
+static void DecoderBenchReport( decoder_t *p_dec )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    if( p_owner->bench.i_audio <= 0 )
+        return;
+    msg_Info( p_dec, "audio benchmark: %"PRId64" us of CPU per second of "
+              "`%4.4s' audio (%"PRId64" s decoded)",
+              p_owner->bench.i_cpu * CLOCK_FREQ / p_owner->bench.i_audio,
+              (const char *)&p_dec->fmt_in.i_codec,
+              p_owner->bench.i_audio / CLOCK_FREQ );
+    p_owner->bench.i_last = p_owner->bench.i_audio;
+}
+
 static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
@@ -1247,6 +1298,7 @@ static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
     int i_decoded = 0;
     int i_lost = 0;
     int i_played = 0;
+    const mtime_t i_cpu_start = p_owner->bench.b_enabled ? ThreadCpuTime() : 0;
 
     while( (p_aout_buf = p_dec->pf_decode_audio( p_dec, &p_block )) )
     {
@@ -1279,9 +1331,20 @@ static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
             p_owner->i_preroll_end = VLC_TS_INVALID;
         }
 
+        if( p_owner->bench.b_enabled && p_dec->fmt_out.audio.i_rate > 0 )
+            p_owner->bench.i_audio += CLOCK_FREQ * p_aout_buf->i_nb_samples
+                                    / p_dec->fmt_out.audio.i_rate;
+
         DecoderPlayAudio( p_dec, p_aout_buf, &i_played, &i_lost );
     }
 
+    if( p_owner->bench.b_enabled )
+    {
+        p_owner->bench.i_cpu += ThreadCpuTime() - i_cpu_start;
+        if( p_owner->bench.i_audio - p_owner->bench.i_last >= 10 * CLOCK_FREQ )
+            DecoderBenchReport( p_dec );
+    }
+
     /* Update ugly stat */
     if( i_decoded > 0 || i_lost > 0 || i_played > 0 )
     {
@@ -1343,7 +1406,8 @@ static void DecoderGetCc( decoder_t *p_dec, decoder_t *p_dec_cc )
 }
 
 static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
-                              int *pi_played_sum, int *pi_lost_sum )
+                              int *pi_played_sum, int *pi_lost_sum,
+                              int *pi_copied_sum )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
     vout_thread_t  *p_vout = p_owner->p_vout;
@@ -1448,10 +1512,13 @@ static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
         }
         int i_tmp_display;
         int i_tmp_lost;
-        vout_GetResetStatistic( p_vout, &i_tmp_display, &i_tmp_lost );
+        int i_tmp_copied;
+        vout_GetResetStatistic( p_vout, &i_tmp_display, &i_tmp_lost,
+                                &i_tmp_copied );
 
         *pi_played_sum += i_tmp_display;
         *pi_lost_sum += i_tmp_lost;
+        *pi_copied_sum += i_tmp_copied;
 
         if( !b_has_more || b_buffering_first )
             break;
@@ -1473,6 +1540,7 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
     int i_lost = 0;
     int i_decoded = 0;
     int i_displayed = 0;
+    int i_copied = 0;
 
     while( (p_pic = p_dec->pf_decode_video( p_dec, &p_block )) )
     {
@@ -1507,9 +1575,9 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
             ( !p_owner->p_packetizer || !p_owner->p_packetizer->pf_get_cc ) )
             DecoderGetCc( p_dec, p_dec );
 
-        DecoderPlayVideo( p_dec, p_pic, &i_displayed, &i_lost );
+        DecoderPlayVideo( p_dec, p_pic, &i_displayed, &i_lost, &i_copied );
     }
-    if( i_decoded > 0 || i_lost > 0 || i_displayed > 0 )
+    if( i_decoded > 0 || i_lost > 0 || i_displayed > 0 || i_copied > 0 )
     {
         vlc_mutex_lock( &p_input->p->counters.counters_lock );
 
@@ -1521,6 +1589,9 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
         stats_UpdateInteger( p_dec, p_input->p->counters.p_displayed_pictures,
                              i_displayed, NULL);
 
+        stats_UpdateInteger( p_dec, p_input->p->counters.p_copied_pictures,
+                             i_copied, NULL);
+
         vlc_mutex_unlock( &p_input->p->counters.counters_lock );
     }
 }
@@ -2054,6 +2125,9 @@ static void DeleteDecoder( decoder_t * p_dec )
              (char*)&p_dec->fmt_in.i_codec,
              (unsigned)block_FifoCount( p_owner->p_fifo ) );
 
+    if( p_owner->bench.b_enabled )
+        DecoderBenchReport( p_dec );
+
     /* Free all packets still in the decoder fifo. */
     block_FifoEmpty( p_owner->p_fifo );
     block_FifoRelease( p_owner->p_fifo );
@@ -2352,7 +2426,9 @@ static picture_t *vout_new_buffer( decoder_t *p_dec )
         }
         p_vout = input_resource_RequestVout( p_owner->p_input->p->p_resource,
                                              p_vout, &fmt,
-                                             dpb_size + 1 + DECODER_MAX_BUFFERING_COUNT,
+                                             dpb_size +
+                                             p_dec->i_extra_picture_buffers +
+                                             1 + DECODER_MAX_BUFFERING_COUNT,
                                              true );
         vlc_mutex_lock( &p_owner->lock );
         p_owner->p_vout = p_vout;
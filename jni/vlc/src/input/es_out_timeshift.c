@@ -37,6 +37,13 @@
 #ifdef HAVE_SYS_STAT_H
 #   include <sys/stat.h>
 #endif
+#ifdef HAVE_UNISTD_H
+#   include <unistd.h>
+#endif
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#   include <sys/uio.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
@@ -151,20 +158,53 @@ typedef struct attribute_packed
     } u;
 } ts_cmd_t;
 
+/* Header of a block spilled to a segment, followed by its data */
+typedef struct
+{
+    int64_t  i_pts;
+    int64_t  i_dts;
+    int64_t  i_length;
+    uint32_t i_flags;
+    uint32_t i_nb_samples;
+    int32_t  i_rate;
+    uint32_t i_buffer;
+} ts_segment_block_t;
+
+/* The blocks stay in memory until the buffer holds more than
+ * i_memory_max bytes. The oldest ones are then appended to the segment
+ * file of their storage, and read back through a window mapped over the
+ * written part. The commands themselves are always in memory, in order,
+ * so a block is found from its command without any file access. If the
+ * segment cannot be written, i_memory_max becomes a hard limit and the
+ * new blocks are dropped. */
+
+/* Size mapped at once to read the spilled blocks back */
+#define TS_MAP_WINDOW (1024 * 1024)
+
 typedef struct ts_storage_t ts_storage_t;
 struct ts_storage_t
 {
     ts_storage_t *p_next;
 
     /* */
-    char    *psz_file;  /* Filename */
+    const char *psz_tmp_path;
     size_t  i_file_max; /* Max size in bytes */
-    int64_t i_file_size;/* Current size in bytes */
-    FILE    *p_filew;   /* FILE handle for data writing */
-    FILE    *p_filer;   /* FILE handle for data reading */
+    int64_t i_file_size;/* Current size in bytes, spilled or not */
+
+    /* Segment file, created on the first spill */
+    int     i_fd;
+    uint8_t *p_map;
+    size_t  i_map_offset; /* Part of the segment mapped at p_map */
+    size_t  i_map_size;
+    size_t  i_spill_size; /* Bytes written to the segment */
+    bool    b_spill_error;
+
+    /* Size of the blocks still in memory */
+    size_t  i_memory;
 
     /* */
     int      i_cmd_r;
+    int      i_cmd_s;   /* First command whose block may be in memory */
     int      i_cmd_w;
     int      i_cmd_max;
     ts_cmd_t *p_cmd;
@@ -179,6 +219,7 @@ typedef struct
     es_out_t       *p_out;
     int64_t        i_tmp_size_max;
     const char     *psz_tmp_path;
+    size_t         i_memory_max;
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
@@ -200,6 +241,7 @@ typedef struct
     /* */
     ts_storage_t   *p_storage_r;
     ts_storage_t   *p_storage_w;
+    bool           b_dropping; /* The memory is full and cannot be spilled */
 
     mtime_t        i_cmd_delay;
 
@@ -218,6 +260,7 @@ struct es_out_sys_t
     /* Configuration */
     int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
     char           *psz_tmp_path;     /* Path for temporary files */
+    size_t         i_memory_max;      /* Maximal size kept in memory in byte */
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
@@ -253,6 +296,8 @@ static bool         TsHasCmd( ts_thread_t * );
 static bool         TsIsUnused( ts_thread_t * );
 static int          TsChangePause( ts_thread_t *, bool b_source_paused, bool b_paused, mtime_t i_date );
 static int          TsChangeRate( ts_thread_t *, int i_src_rate, int i_rate );
+static size_t       TsMemoryLocked( ts_thread_t * );
+static void         TsSpillLocked( ts_thread_t * );
 
 static void         *TsRun( vlc_object_t * );
 
@@ -261,7 +306,8 @@ static void         TsStorageDelete( ts_storage_t * );
 static void         TsStoragePack( ts_storage_t *p_storage );
 static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
-static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
+static size_t       TsStorageSpill( ts_storage_t *, size_t i_wanted );
+static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd );
 static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
 
 static void CmdClean( ts_cmd_t * );
@@ -285,7 +331,9 @@ static int  CmdExecuteControl( es_out_t *, ts_cmd_t * );
 
 /* File helpers */
 static char *GetTmpPath( char *psz_path );
-static FILE *GetTmpFile( char **ppsz_file, const char *psz_path );
+#ifdef HAVE_MMAP
+static int  GetTmpFile( const char *psz_path );
+#endif
 
 /*****************************************************************************
  * input_EsOutTimeshiftNew:
@@ -335,6 +383,9 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     msg_Dbg( p_input, "using timeshift granularity of %d MiB",
              (int)p_sys->i_tmp_size_max/(1024*1024) );
 
+    const int i_memory_max = var_CreateGetInteger( p_input, "input-timeshift-memory" );
+    p_sys->i_memory_max = __MAX( i_memory_max, 0 );
+
     char *psz_tmp_path = var_CreateGetNonEmptyString( p_input, "input-timeshift-path" );
     p_sys->psz_tmp_path = GetTmpPath( psz_tmp_path );
     msg_Dbg( p_input, "using timeshift path '%s'", p_sys->psz_tmp_path );
@@ -746,6 +797,7 @@ static int TsStart( es_out_t *p_out )
 
     p_ts->i_tmp_size_max = p_sys->i_tmp_size_max;
     p_ts->psz_tmp_path = p_sys->psz_tmp_path;
+    p_ts->i_memory_max = p_sys->i_memory_max;
     p_ts->p_input = p_sys->p_input;
     p_ts->p_out = p_sys->p_out;
     vlc_mutex_init( &p_ts->lock );
@@ -760,6 +812,7 @@ static int TsStart( es_out_t *p_out )
     p_ts->i_cmd_delay = 0;
     p_ts->p_storage_r = NULL;
     p_ts->p_storage_w = NULL;
+    p_ts->b_dropping = false;
 
     vlc_object_set_destructor( p_ts, TsDestructor );
 
@@ -814,6 +867,28 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 {
     vlc_mutex_lock( &p_ts->lock );
 
+    /* The segment cannot be written: keep to the memory limit, as the
+     * commands are dropped when no storage can be created */
+    if( p_cmd->i_type == C_SEND && p_ts->p_storage_w &&
+        p_ts->p_storage_w->b_spill_error )
+    {
+        const bool b_drop = TsMemoryLocked( p_ts ) +
+                            p_cmd->u.send.p_block->i_buffer > p_ts->i_memory_max;
+        if( b_drop != p_ts->b_dropping )
+        {
+            if( b_drop )
+                msg_Warn( p_ts->p_input, "timeshift memory is full and "
+                          "cannot be written to disk, dropping data" );
+            p_ts->b_dropping = b_drop;
+        }
+        if( b_drop )
+        {
+            CmdClean( p_cmd );
+            vlc_mutex_unlock( &p_ts->lock );
+            return;
+        }
+    }
+
     if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
     {
         ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
@@ -838,8 +913,8 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
         }
     }
 
-    /* TODO return error and warn the user (but only once) */
-    TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w );
+    TsStoragePushCmd( p_ts->p_storage_w, p_cmd );
+    TsSpillLocked( p_ts );
 
     vlc_cond_signal( &p_ts->wait );
 
@@ -866,6 +941,26 @@ static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
 
     return VLC_SUCCESS;
 }
+static size_t TsMemoryLocked( ts_thread_t *p_ts )
+{
+    size_t i_memory = 0;
+
+    vlc_assert_locked( &p_ts->lock );
+
+    for( ts_storage_t *p = p_ts->p_storage_r; p; p = p->p_next )
+        i_memory += p->i_memory;
+    return i_memory;
+}
+static void TsSpillLocked( ts_thread_t *p_ts )
+{
+    size_t i_memory = TsMemoryLocked( p_ts );
+
+    /* Oldest blocks first: they are replayed first, but a segment file is
+     * only appended to, and the most recent blocks stay in memory */
+    for( ts_storage_t *p = p_ts->p_storage_r;
+         p && i_memory > p_ts->i_memory_max; p = p->p_next )
+        i_memory -= TsStorageSpill( p, i_memory - p_ts->i_memory_max );
+}
 static bool TsHasCmd( ts_thread_t *p_ts )
 {
     bool b_cmd;
@@ -1059,6 +1154,11 @@ static void *TsRun( vlc_object_t *p_thread )
 /*****************************************************************************
  *
  *****************************************************************************/
+static size_t TsSegmentBlockSize( const block_t *p_block )
+{
+    /* Keep the headers aligned */
+    return sizeof(ts_segment_block_t) + ((p_block->i_buffer + 7) & ~(size_t)7);
+}
 static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max )
 {
     ts_storage_t *p_storage = calloc( 1, sizeof(ts_storage_t) );
@@ -1069,20 +1169,20 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     p_storage->p_next = NULL;
 
     /* */
+    p_storage->psz_tmp_path = psz_tmp_path;
     p_storage->i_file_max = i_tmp_size_max;
     p_storage->i_file_size = 0;
-    p_storage->p_filew = GetTmpFile( &p_storage->psz_file, psz_tmp_path );
-    if( p_storage->psz_file )
-        p_storage->p_filer = vlc_fopen( p_storage->psz_file, "rb" );
+    p_storage->i_fd = -1;
+    p_storage->p_map = NULL;
 
     /* */
     p_storage->i_cmd_w = 0;
+    p_storage->i_cmd_s = 0;
     p_storage->i_cmd_r = 0;
     p_storage->i_cmd_max = 30000;
     p_storage->p_cmd = malloc( p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) );
-    //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
 
-    if( !p_storage->p_cmd || !p_storage->p_filew || !p_storage->p_filer )
+    if( !p_storage->p_cmd )
     {
         TsStorageDelete( p_storage );
         return NULL;
@@ -1101,16 +1201,12 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     }
     free( p_storage->p_cmd );
 
-    if( p_storage->p_filer )
-        fclose( p_storage->p_filer );
-    if( p_storage->p_filew )
-        fclose( p_storage->p_filew );
-
-    if( p_storage->psz_file )
-    {
-        vlc_unlink( p_storage->psz_file );
-        free( p_storage->psz_file );
-    }
+#ifdef HAVE_MMAP
+    if( p_storage->p_map )
+        munmap( p_storage->p_map, p_storage->i_map_size );
+    if( p_storage->i_fd >= 0 )
+        close( p_storage->i_fd );
+#endif
 
     free( p_storage );
 }
@@ -1130,7 +1226,7 @@ static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
     if( p_cmd && p_cmd->i_type == C_SEND && p_storage->i_cmd_w > 0 )
     {
-        size_t i_size = sizeof(*p_cmd->u.send.p_block) + p_cmd->u.send.p_block->i_buffer;
+        size_t i_size = TsSegmentBlockSize( p_cmd->u.send.p_block );
 
         if( p_storage->i_file_size + i_size >= p_storage->i_file_max )
             return true;
@@ -1141,73 +1237,167 @@ static bool TsStorageIsEmpty( ts_storage_t *p_storage )
 {
     return !p_storage || p_storage->i_cmd_r >= p_storage->i_cmd_w;
 }
-static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
+#ifdef HAVE_MMAP
+/* Returns the written segment data from i_offset to i_offset + i_size,
+ * mapping at least TS_MAP_WINDOW bytes around it if it is not mapped yet.
+ * The reads go forward, as the spills do. */
+static const uint8_t *TsStorageMapRange( ts_storage_t *p_storage,
+                                         size_t i_offset, size_t i_size )
 {
-    ts_cmd_t cmd = *p_cmd;
+    assert( i_offset + i_size <= p_storage->i_spill_size );
+
+    if( p_storage->p_map && i_offset >= p_storage->i_map_offset &&
+        i_offset + i_size <= p_storage->i_map_offset + p_storage->i_map_size )
+        return &p_storage->p_map[i_offset - p_storage->i_map_offset];
+
+    if( p_storage->p_map )
+        munmap( p_storage->p_map, p_storage->i_map_size );
+    p_storage->p_map = NULL;
+
+    const size_t i_page = sysconf( _SC_PAGESIZE );
+    const size_t i_start = i_offset - i_offset % i_page;
+    /* Not beyond the written part, it is not backed by the file yet */
+    const size_t i_length = __MIN( __MAX( i_offset + i_size - i_start,
+                                          (size_t)TS_MAP_WINDOW ),
+                                   p_storage->i_spill_size - i_start );
+
+    void *p_map = mmap( NULL, i_length, PROT_READ, MAP_SHARED,
+                        p_storage->i_fd, i_start );
+    if( p_map == MAP_FAILED )
+        return NULL;
 
-    assert( !TsStorageIsFull( p_storage, p_cmd ) );
+    p_storage->p_map = p_map;
+    p_storage->i_map_offset = i_start;
+    p_storage->i_map_size = i_length;
+    return &p_storage->p_map[i_offset - i_start];
+}
+#endif
+static size_t TsStorageSpill( ts_storage_t *p_storage, size_t i_wanted )
+{
+#ifdef HAVE_MMAP
+    size_t i_freed = 0;
 
-    if( cmd.i_type == C_SEND )
+    if( p_storage->i_memory == 0 || p_storage->b_spill_error )
+        return 0;
+    if( p_storage->i_fd < 0 )
     {
-        block_t *p_block = cmd.u.send.p_block;
-
-        cmd.u.send.p_block = NULL;
-        cmd.u.send.i_offset = ftell( p_storage->p_filew );
-
-        if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
+        p_storage->i_fd = GetTmpFile( p_storage->psz_tmp_path );
+        if( p_storage->i_fd < 0 )
         {
-            block_Release( p_block );
-            return;
+            p_storage->b_spill_error = true;
+            return 0;
         }
-        p_storage->i_file_size += sizeof(*p_block);
-        if( p_block->i_buffer > 0 )
+    }
+
+    while( i_freed < i_wanted && p_storage->i_cmd_s < p_storage->i_cmd_w )
+    {
+        ts_cmd_t *p_cmd = &p_storage->p_cmd[p_storage->i_cmd_s];
+        block_t *p_block = p_cmd->i_type == C_SEND ? p_cmd->u.send.p_block : NULL;
+
+        if( p_block )
         {
-            if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
+            ts_segment_block_t header = {
+                .i_pts        = p_block->i_pts,
+                .i_dts        = p_block->i_dts,
+                .i_length     = p_block->i_length,
+                .i_flags      = p_block->i_flags,
+                .i_nb_samples = p_block->i_nb_samples,
+                .i_rate       = p_block->i_rate,
+                .i_buffer     = p_block->i_buffer,
+            };
+            static const uint8_t p_padding[8];
+            const size_t i_size = TsSegmentBlockSize( p_block );
+            struct iovec iov[3] = {
+                { .iov_base = &header, .iov_len = sizeof(header) },
+                { .iov_base = p_block->p_buffer, .iov_len = p_block->i_buffer },
+                { .iov_base = (void *)p_padding,
+                  .iov_len = i_size - sizeof(header) - p_block->i_buffer },
+            };
+
+            /* Append only, so the file offset is always i_spill_size */
+            if( writev( p_storage->i_fd, iov, 3 ) != (ssize_t)i_size )
             {
-                block_Release( p_block );
-                return;
+                /* Keep the remaining blocks in memory */
+                p_storage->b_spill_error = true;
+                break;
             }
+
+            p_cmd->u.send.p_block = NULL;
+            p_cmd->u.send.i_offset = p_storage->i_spill_size;
+            p_storage->i_spill_size += i_size;
+            p_storage->i_memory -= p_block->i_buffer;
+            i_freed += p_block->i_buffer;
+            block_Release( p_block );
         }
-        p_storage->i_file_size += p_block->i_buffer;
-        block_Release( p_block );
+        p_storage->i_cmd_s++;
+    }
+    return i_freed;
+#else
+    VLC_UNUSED(p_storage); VLC_UNUSED(i_wanted);
+    return 0;
+#endif
+}
+static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
+{
+    assert( !TsStorageIsFull( p_storage, p_cmd ) );
+
+    if( p_cmd->i_type == C_SEND )
+    {
+        const block_t *p_block = p_cmd->u.send.p_block;
 
-        if( b_flush )
-            fflush( p_storage->p_filew );
+        p_storage->i_file_size += TsSegmentBlockSize( p_block );
+        p_storage->i_memory += p_block->i_buffer;
     }
-    p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
+    p_storage->p_cmd[p_storage->i_cmd_w++] = *p_cmd;
 }
 static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
 {
     assert( !TsStorageIsEmpty( p_storage ) );
 
     *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
-    if( p_cmd->i_type == C_SEND )
+    if( p_storage->i_cmd_s < p_storage->i_cmd_r )
+        p_storage->i_cmd_s = p_storage->i_cmd_r;
+
+    if( p_cmd->i_type != C_SEND )
+        return;
+
+    if( p_cmd->u.send.p_block )
     {
-        block_t block;
+        p_storage->i_memory -= p_cmd->u.send.p_block->i_buffer;
+        return;
+    }
 
-        if( !b_flush &&
-            !fseek( p_storage->p_filer, p_cmd->u.send.i_offset, SEEK_SET ) &&
-            fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
-        {
-            block_t *p_block = block_Alloc( block.i_buffer );
-            if( p_block )
-            {
-                p_block->i_dts      = block.i_dts;
-                p_block->i_pts      = block.i_pts;
-                p_block->i_flags    = block.i_flags;
-                p_block->i_length   = block.i_length;
-                p_block->i_rate     = block.i_rate;
-                p_block->i_nb_samples = block.i_nb_samples;
-                p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
-            }
-            p_cmd->u.send.p_block = p_block;
-        }
-        else
+    /* Spilled block */
+    block_t *p_block = NULL;
+#ifdef HAVE_MMAP
+    const size_t i_offset = p_cmd->u.send.i_offset;
+    const uint8_t *p_data = NULL;
+    ts_segment_block_t header;
+
+    if( !b_flush )
+        p_data = TsStorageMapRange( p_storage, i_offset, sizeof(header) );
+    if( p_data )
+    {
+        memcpy( &header, p_data, sizeof(header) );
+        /* The block may span beyond the window */
+        p_data = TsStorageMapRange( p_storage, i_offset,
+                                    sizeof(header) + header.i_buffer );
+        p_block = p_data ? block_Alloc( header.i_buffer ) : NULL;
+        if( p_block )
         {
-            //fprintf( stderr, "TsStoragePopCmd: %m\n" );
-            p_cmd->u.send.p_block = block_Alloc( 1 );
+            p_block->i_dts      = header.i_dts;
+            p_block->i_pts      = header.i_pts;
+            p_block->i_flags    = header.i_flags;
+            p_block->i_length   = header.i_length;
+            p_block->i_rate     = header.i_rate;
+            p_block->i_nb_samples = header.i_nb_samples;
+            memcpy( p_block->p_buffer, p_data + sizeof(header), header.i_buffer );
         }
     }
+#else
+    VLC_UNUSED(b_flush);
+#endif
+    p_cmd->u.send.p_block = p_block;
 }
 
 /*****************************************************************************
@@ -1590,29 +1780,22 @@ static char *GetTmpPath( char *psz_path )
     return psz_path;
 }
 
-static FILE *GetTmpFile( char **ppsz_file, const char *psz_path )
+#ifdef HAVE_MMAP
+static int GetTmpFile( const char *psz_path )
 {
     char *psz_name;
     int fd;
-    FILE *f;
 
     /* */
-    *ppsz_file = NULL;
     if( asprintf( &psz_name, "%s/vlc-timeshift.XXXXXX", psz_path ) < 0 )
-        return NULL;
+        return -1;
 
-    /* */
+    /* Only the descriptor is used, so the file never outlives it */
     fd = vlc_mkstemp( psz_name );
-    *ppsz_file = psz_name;
-
-    if( fd < 0 )
-        return NULL;
-
-    /* */
-    f = fdopen( fd, "w+b" );
-    if( !f )
-        close( fd );
+    if( fd >= 0 )
+        vlc_unlink( psz_name );
+    free( psz_name );
 
-    return f;
+    return fd;
 }
-
+#endif
@@ -59,6 +59,12 @@ void input_SendEventAbort( input_thread_t *p_input )
 {
     Trigger( p_input, INPUT_EVENT_ABORT );
 }
+void input_SendEventPrerolled( input_thread_t *p_input )
+{
+    /* The events sent while pre-rolling went to nobody */
+    Trigger( p_input, INPUT_EVENT_LENGTH );
+    Trigger( p_input, INPUT_EVENT_STATE );
+}
 
 void input_SendEventPosition( input_thread_t *p_input, double f_position, mtime_t i_time )
 {
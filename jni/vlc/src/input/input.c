@@ -67,8 +67,9 @@ static void Destructor( input_thread_t * p_input );
 static  void *Run            ( vlc_object_t *p_this );
 
 static input_thread_t * Create  ( vlc_object_t *, input_item_t *,
-                                  const char *, bool, input_resource_t * );
+                                  const char *, bool, bool, input_resource_t * );
 static  int             Init    ( input_thread_t *p_input );
+static void             Preroll ( input_thread_t *p_input );
 static void             End     ( input_thread_t *p_input );
 static void             MainLoop( input_thread_t *p_input, bool b_interactive );
 
@@ -79,8 +80,8 @@ static void       ControlRelease( int i_type, vlc_value_t val );
 static bool       ControlIsSeekRequest( int i_type );
 static bool       Control( input_thread_t *, int, vlc_value_t );
 
-static int  UpdateTitleSeekpointFromAccess( input_thread_t * );
-static void UpdateGenericFromAccess( input_thread_t * );
+static int  UpdateTitleSeekpointFromAccess( input_thread_t *, int, int, int );
+static void UpdateGenericFromAccess( input_thread_t *, int );
 
 static int  UpdateTitleSeekpointFromDemux( input_thread_t * );
 static void UpdateGenericFromDemux( input_thread_t * );
@@ -134,7 +135,30 @@ input_thread_t *input_Create( vlc_object_t *p_parent,
                               input_item_t *p_item,
                               const char *psz_log, input_resource_t *p_resource )
 {
-    return Create( p_parent, p_item, psz_log, false, p_resource );
+    return Create( p_parent, p_item, psz_log, false, false, p_resource );
+}
+
+#undef input_CreatePreroll
+/**
+ * Create a new input_thread_t for the item to be played after the one
+ * currently using p_resource.
+ *
+ * Once started, it opens the access and the demuxer, then waits with no
+ * elementary stream selected, and without using p_resource, until it is
+ * played with input_Control( INPUT_SET_STATE, PLAYING_S ) or stopped.
+ * p_resource must not be in use anymore by then.
+ *
+ * It may fail to open, or be killed, before the caller listens to its
+ * events: the caller must check b_dead and the "state" variable once it
+ * has added its callbacks, and use a new input if it is over.
+ *
+ * \see input_Create
+ */
+input_thread_t *input_CreatePreroll( vlc_object_t *p_parent,
+                                     input_item_t *p_item,
+                                     input_resource_t *p_resource )
+{
+    return Create( p_parent, p_item, NULL, false, true, p_resource );
 }
 
 #undef input_CreateAndStart
@@ -168,7 +192,7 @@ input_thread_t *input_CreateAndStart( vlc_object_t *p_parent,
  */
 int input_Read( vlc_object_t *p_parent, input_item_t *p_item )
 {
-    input_thread_t *p_input = Create( p_parent, p_item, NULL, false, NULL );
+    input_thread_t *p_input = Create( p_parent, p_item, NULL, false, false, NULL );
     if( !p_input )
         return VLC_EGENERIC;
 
@@ -195,7 +219,7 @@ int input_Preparse( vlc_object_t *p_parent, input_item_t *p_item )
     input_thread_t *p_input;
 
     /* Allocate descriptor */
-    p_input = Create( p_parent, p_item, NULL, true, NULL );
+    p_input = Create( p_parent, p_item, NULL, true, false, NULL );
     if( !p_input )
         return VLC_EGENERIC;
 
@@ -293,7 +317,7 @@ static void ObjectKillChildrens( input_thread_t *p_input, vlc_object_t *p_obj )
  *****************************************************************************/
 static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
                                const char *psz_header, bool b_quick,
-                               input_resource_t *p_resource )
+                               bool b_preroll, input_resource_t *p_resource )
 {
     static const char input_name[] = "input";
     input_thread_t *p_input = NULL;                 /* thread descriptor */
@@ -399,7 +423,10 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
         p_input->p->p_resource_private = input_resource_New( VLC_OBJECT( p_input ) );
         p_input->p->p_resource = input_resource_Hold( p_input->p->p_resource_private );
     }
-    input_resource_SetInput( p_input->p->p_resource, p_input );
+    /* a pre-rolled input takes the resource when it is played */
+    p_input->p->b_preroll = b_preroll;
+    if( !b_preroll )
+        input_resource_SetInput( p_input->p->p_resource, p_input );
 
     /* Init control buffer */
     vlc_mutex_init( &p_input->p->lock_control );
@@ -539,6 +566,9 @@ static void *Run( vlc_object_t *p_this )
     if( Init( p_input ) )
         goto exit;
 
+    if( p_input->p->b_preroll )
+        Preroll( p_input );
+
     MainLoop( p_input, true ); /* FIXME it can be wrong (like with VLM) */
 
     /* Clean up */
@@ -593,12 +623,28 @@ static void MainLoopDemux( input_thread_t *p_input, bool *pb_changed, bool *pb_d
         else if( p_input->p->input.p_access &&
                  p_input->p->input.p_access->info.i_update )
         {
+            /* The read-ahead thread may be inside the access, so the
+             * flags are taken through the stream */
+            int i_update, i_title, i_seekpoint;
+
+            if( stream_Control( p_input->p->input.p_stream,
+                                STREAM_GET_ACCESS_UPDATE,
+                                &i_update, &i_title, &i_seekpoint ) )
+            {
+                access_t *p_access = p_input->p->input.p_access;
+
+                i_update = p_access->info.i_update;
+                i_title = p_access->info.i_title;
+                i_seekpoint = p_access->info.i_seekpoint;
+                p_access->info.i_update = 0;
+            }
             if( !p_input->p->input.b_title_demux )
             {
-                i_ret = UpdateTitleSeekpointFromAccess( p_input );
+                i_ret = UpdateTitleSeekpointFromAccess( p_input, i_update,
+                                                        i_title, i_seekpoint );
                 *pb_changed = true;
             }
-            UpdateGenericFromAccess( p_input );
+            UpdateGenericFromAccess( p_input, i_update );
         }
     }
 
@@ -856,6 +902,8 @@ static void InitStatistics( input_thread_t * p_input )
         INIT_COUNTER( read_packets, INTEGER, COUNTER );
         INIT_COUNTER( demux_read, INTEGER, COUNTER );
         INIT_COUNTER( input_bitrate, FLOAT, DERIVATIVE );
+        INIT_COUNTER( stream_cache_size, INTEGER, LAST );
+        INIT_COUNTER( stream_cache_resizes, INTEGER, COUNTER );
         INIT_COUNTER( demux_bitrate, FLOAT, DERIVATIVE );
         INIT_COUNTER( demux_corrupted, INTEGER, COUNTER );
         INIT_COUNTER( demux_discontinuity, INTEGER, COUNTER );
@@ -863,6 +911,7 @@ static void InitStatistics( input_thread_t * p_input )
         INIT_COUNTER( lost_abuffers, INTEGER, COUNTER );
         INIT_COUNTER( displayed_pictures, INTEGER, COUNTER );
         INIT_COUNTER( lost_pictures, INTEGER, COUNTER );
+        INIT_COUNTER( copied_pictures, INTEGER, COUNTER );
         INIT_COUNTER( decoded_audio, INTEGER, COUNTER );
         INIT_COUNTER( decoded_video, INTEGER, COUNTER );
         INIT_COUNTER( decoded_sub, INTEGER, COUNTER );
@@ -905,7 +954,7 @@ static int InitSout( input_thread_t * p_input )
                          1000000;
         }
     }
-    else
+    else if( !p_input->p->b_preroll )
     {
         input_resource_RequestSout( p_input->p->p_resource, NULL, NULL );
     }
@@ -1186,7 +1235,10 @@ static void InitPrograms( input_thread_t * p_input )
             free( prgms );
         }
     }
-    es_out_SetMode( p_input->p->p_es_out, i_es_out_mode );
+    /* no decoder, and thus no output, before the input is played */
+    p_input->p->i_preroll_mode = i_es_out_mode;
+    if( !p_input->p->b_preroll )
+        es_out_SetMode( p_input->p->p_es_out, i_es_out_mode );
 
     /* Inform the demuxer about waited group (needed only for DVB) */
     if( i_es_out_mode == ES_OUT_MODE_ALL )
@@ -1318,7 +1370,8 @@ error:
         if( p_input->p->p_sout )
             input_resource_RequestSout( p_input->p->p_resource,
                                          p_input->p->p_sout, NULL );
-        input_resource_SetInput( p_input->p->p_resource, NULL );
+        if( !p_input->p->b_preroll )
+            input_resource_SetInput( p_input->p->p_resource, NULL );
         if( p_input->p->p_resource_private )
             input_resource_Terminate( p_input->p->p_resource_private );
     }
@@ -1332,6 +1385,8 @@ error:
         EXIT_COUNTER( read_packets );
         EXIT_COUNTER( demux_read );
         EXIT_COUNTER( input_bitrate );
+        EXIT_COUNTER( stream_cache_size );
+        EXIT_COUNTER( stream_cache_resizes );
         EXIT_COUNTER( demux_bitrate );
         EXIT_COUNTER( demux_corrupted );
         EXIT_COUNTER( demux_discontinuity );
@@ -1339,6 +1394,7 @@ error:
         EXIT_COUNTER( lost_abuffers );
         EXIT_COUNTER( displayed_pictures );
         EXIT_COUNTER( lost_pictures );
+        EXIT_COUNTER( copied_pictures );
         EXIT_COUNTER( decoded_audio );
         EXIT_COUNTER( decoded_video );
         EXIT_COUNTER( decoded_sub );
@@ -1362,6 +1418,35 @@ error:
     return VLC_EGENERIC;
 }
 
+/*****************************************************************************
+ * Preroll: waits, with the demuxer open, to be played or stopped
+ *****************************************************************************/
+static void Preroll( input_thread_t * p_input )
+{
+    msg_Dbg( p_input, "pre-rolled, waiting to be played" );
+
+    vlc_mutex_lock( &p_input->p->lock_control );
+    while( p_input->p->i_control == 0 && vlc_object_alive( p_input ) )
+        vlc_cond_wait( &p_input->p->wait_control, &p_input->p->lock_control );
+    bool b_die = !vlc_object_alive( p_input ) || p_input->p->b_abort;
+    for( int i = 0; i < p_input->p->i_control; i++ )
+        if( p_input->p->control[i].i_type == INPUT_CONTROL_SET_DIE )
+            b_die = true;
+    vlc_mutex_unlock( &p_input->p->lock_control );
+
+    /* MainLoop() will handle the stop */
+    if( b_die )
+        return;
+
+    /* The previous input is gone, take its outputs */
+    input_resource_SetInput( p_input->p->p_resource, p_input );
+    if( !p_input->p->p_sout )
+        input_resource_RequestSout( p_input->p->p_resource, NULL, NULL );
+    p_input->p->b_preroll = false;
+    es_out_SetMode( p_input->p->p_es_out, p_input->p->i_preroll_mode );
+    input_SendEventPrerolled( p_input );
+}
+
 /*****************************************************************************
  * End: end the input thread
  *****************************************************************************/
@@ -1405,6 +1490,8 @@ static void End( input_thread_t * p_input )
             CL_CO( read_packets );
             CL_CO( demux_read );
             CL_CO( input_bitrate );
+            CL_CO( stream_cache_size );
+            CL_CO( stream_cache_resizes );
             CL_CO( demux_bitrate );
             CL_CO( demux_corrupted );
             CL_CO( demux_discontinuity );
@@ -1412,6 +1499,7 @@ static void End( input_thread_t * p_input )
             CL_CO( lost_abuffers );
             CL_CO( displayed_pictures );
             CL_CO( lost_pictures );
+            CL_CO( copied_pictures );
             CL_CO( decoded_audio) ;
             CL_CO( decoded_video );
             CL_CO( decoded_sub) ;
@@ -1437,9 +1525,12 @@ static void End( input_thread_t * p_input )
     vlc_mutex_unlock( &p_input->p->p_item->lock );
 
     /* */
-    input_resource_RequestSout( p_input->p->p_resource,
-                                 p_input->p->p_sout, NULL );
-    input_resource_SetInput( p_input->p->p_resource, NULL );
+    if( !p_input->p->b_preroll )
+    {
+        input_resource_RequestSout( p_input->p->p_resource,
+                                     p_input->p->p_sout, NULL );
+        input_resource_SetInput( p_input->p->p_resource, NULL );
+    }
     if( p_input->p->p_resource_private )
         input_resource_Terminate( p_input->p->p_resource_private );
 }
@@ -1497,6 +1588,8 @@ static int ControlGetReducedIndexLocked( input_thread_t *p_input )
               i_ct == INPUT_CONTROL_SET_RATE ||
               i_ct == INPUT_CONTROL_SET_POSITION ||
               i_ct == INPUT_CONTROL_SET_TIME ||
+              i_ct == INPUT_CONTROL_SET_TIME_FAST ||
+              i_ct == INPUT_CONTROL_SET_TIME_PRECISE ||
               i_ct == INPUT_CONTROL_SET_PROGRAM ||
               i_ct == INPUT_CONTROL_SET_TITLE ||
               i_ct == INPUT_CONTROL_SET_SEEKPOINT ||
@@ -1564,6 +1657,8 @@ static bool ControlIsSeekRequest( int i_type )
     {
     case INPUT_CONTROL_SET_POSITION:
     case INPUT_CONTROL_SET_TIME:
+    case INPUT_CONTROL_SET_TIME_FAST:
+    case INPUT_CONTROL_SET_TIME_PRECISE:
     case INPUT_CONTROL_SET_TITLE:
     case INPUT_CONTROL_SET_TITLE_NEXT:
     case INPUT_CONTROL_SET_TITLE_PREV:
@@ -1600,8 +1695,9 @@ static void ControlPause( input_thread_t *p_input, mtime_t i_control_date )
     if( p_input->p->b_can_pause )
     {
         if( p_input->p->input.p_access )
-            i_ret = access_Control( p_input->p->input.p_access,
-                                     ACCESS_SET_PAUSE_STATE, true );
+            i_ret = stream_Control( p_input->p->input.p_stream,
+                                    STREAM_CONTROL_ACCESS,
+                                    ACCESS_SET_PAUSE_STATE, true );
         else
             i_ret = demux_Control( p_input->p->input.p_demux,
                                     DEMUX_SET_PAUSE_STATE, true );
@@ -1634,8 +1730,9 @@ static void ControlUnpause( input_thread_t *p_input, mtime_t i_control_date )
     if( p_input->p->b_can_pause )
     {
         if( p_input->p->input.p_access )
-            i_ret = access_Control( p_input->p->input.p_access,
-                                     ACCESS_SET_PAUSE_STATE, false );
+            i_ret = stream_Control( p_input->p->input.p_stream,
+                                    STREAM_CONTROL_ACCESS,
+                                    ACCESS_SET_PAUSE_STATE, false );
         else
             i_ret = demux_Control( p_input->p->input.p_demux,
                                     DEMUX_SET_PAUSE_STATE, false );
@@ -1710,8 +1807,11 @@ static bool Control( input_thread_t *p_input,
         }
 
         case INPUT_CONTROL_SET_TIME:
+        case INPUT_CONTROL_SET_TIME_FAST:
+        case INPUT_CONTROL_SET_TIME_PRECISE:
         {
             int64_t i_time;
+            bool b_fast_seek;
             int i_ret;
 
             if( p_input->p->b_recording )
@@ -1721,18 +1821,22 @@ static bool Control( input_thread_t *p_input,
             }
 
             i_time = val.i_time;
-            if( i_type != INPUT_CONTROL_SET_TIME )
-                i_time += var_GetTime( p_input, "time" );
-
             if( i_time < 0 )
                 i_time = 0;
 
+            /* Interfaces may pick the seek mode per request */
+            if( i_type == INPUT_CONTROL_SET_TIME_FAST )
+                b_fast_seek = true;
+            else if( i_type == INPUT_CONTROL_SET_TIME_PRECISE )
+                b_fast_seek = false;
+            else
+                b_fast_seek = p_input->p->b_fast_seek;
+
             /* Reset the decoders states and clock sync (before calling the demuxer */
             es_out_SetTime( p_input->p->p_es_out, -1 );
 
             i_ret = demux_Control( p_input->p->input.p_demux,
-                                   DEMUX_SET_TIME, i_time,
-                                   !p_input->p->b_fast_seek );
+                                   DEMUX_SET_TIME, i_time, !b_fast_seek );
             if( i_ret )
             {
                 int64_t i_length;
@@ -1744,7 +1848,7 @@ static bool Control( input_thread_t *p_input,
                     double f_pos = (double)i_time / (double)i_length;
                     i_ret = demux_Control( p_input->p->input.p_demux,
                                             DEMUX_SET_POSITION, f_pos,
-                                            !p_input->p->b_fast_seek );
+                                            !b_fast_seek );
                 }
             }
             if( i_ret )
@@ -2259,61 +2363,47 @@ static void UpdateGenericFromDemux( input_thread_t *p_input )
 /*****************************************************************************
  * Update*FromAccess:
  *****************************************************************************/
-static int UpdateTitleSeekpointFromAccess( input_thread_t *p_input )
+static int UpdateTitleSeekpointFromAccess( input_thread_t *p_input,
+                                           int i_update, int i_title,
+                                           int i_seekpoint )
 {
-    access_t *p_access = p_input->p->input.p_access;
-
-    if( p_access->info.i_update & INPUT_UPDATE_TITLE )
+    if( i_update & INPUT_UPDATE_TITLE )
     {
-        input_SendEventTitle( p_input, p_access->info.i_title );
+        input_SendEventTitle( p_input, i_title );
 
         stream_Control( p_input->p->input.p_stream, STREAM_UPDATE_SIZE );
-
-        p_access->info.i_update &= ~INPUT_UPDATE_TITLE;
     }
-    if( p_access->info.i_update & INPUT_UPDATE_SEEKPOINT )
-    {
-        input_SendEventSeekpoint( p_input,
-                                  p_access->info.i_title, p_access->info.i_seekpoint );
+    if( i_update & INPUT_UPDATE_SEEKPOINT )
+        input_SendEventSeekpoint( p_input, i_title, i_seekpoint );
 
-        p_access->info.i_update &= ~INPUT_UPDATE_SEEKPOINT;
-    }
-    /* Hmmm only works with master input */
-    if( p_input->p->input.p_access == p_access )
-        return UpdateTitleSeekpoint( p_input,
-                                     p_access->info.i_title,
-                                     p_access->info.i_seekpoint );
-    return 1;
+    return UpdateTitleSeekpoint( p_input, i_title, i_seekpoint );
 }
-static void UpdateGenericFromAccess( input_thread_t *p_input )
+static void UpdateGenericFromAccess( input_thread_t *p_input, int i_update )
 {
-    access_t *p_access = p_input->p->input.p_access;
+    stream_t *p_stream = p_input->p->input.p_stream;
 
-    if( p_access->info.i_update & INPUT_UPDATE_META )
+    if( i_update & INPUT_UPDATE_META )
     {
         /* TODO maybe multi - access ? */
         vlc_meta_t *p_meta = vlc_meta_New();
         if( p_meta )
         {
-            access_Control( p_input->p->input.p_access, ACCESS_GET_META, p_meta );
+            stream_Control( p_stream, STREAM_CONTROL_ACCESS,
+                            ACCESS_GET_META, p_meta );
             InputUpdateMeta( p_input, p_meta );
         }
-        p_access->info.i_update &= ~INPUT_UPDATE_META;
     }
-    if( p_access->info.i_update & INPUT_UPDATE_SIGNAL )
+    if( i_update & INPUT_UPDATE_SIGNAL )
     {
         double f_quality;
         double f_strength;
 
-        if( access_Control( p_access, ACCESS_GET_SIGNAL, &f_quality, &f_strength ) )
+        if( stream_Control( p_stream, STREAM_CONTROL_ACCESS,
+                            ACCESS_GET_SIGNAL, &f_quality, &f_strength ) )
             f_quality = f_strength = -1;
 
         input_SendEventSignal( p_input, f_quality, f_strength );
-
-        p_access->info.i_update &= ~INPUT_UPDATE_SIGNAL;
     }
-
-    p_access->info.i_update &= ~INPUT_UPDATE_SIZE;
 }
 
 /*****************************************************************************
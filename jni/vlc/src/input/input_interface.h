@@ -38,6 +38,10 @@ void input_item_SetEpgOffline( input_item_t * );
 
 int input_Preparse( vlc_object_t *, input_item_t * );
 
+input_thread_t *input_CreatePreroll( vlc_object_t *, input_item_t *,
+                                     input_resource_t * );
+#define input_CreatePreroll(a,b,c) input_CreatePreroll(VLC_OBJECT(a),b,c)
+
 /* misc/stats.c
  * FIXME it should NOT be defined here or not coded in misc/stats.c */
 input_stats_t *stats_NewInputStats( input_thread_t *p_input );
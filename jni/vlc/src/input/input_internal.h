@@ -91,6 +91,10 @@ struct input_thread_private_t
     bool        b_recording;
     int         i_rate;
 
+    /* Opened ahead of time, see input_CreatePreroll() */
+    bool        b_preroll;
+    int         i_preroll_mode; /* es_out mode once played */
+
     /* Playtime configuration and state */
     int64_t     i_start;    /* :start-time,0 by default */
     int64_t     i_stop;     /* :stop-time, 0 if none */
@@ -140,6 +144,8 @@ struct input_thread_private_t
         counter_t *p_read_packets;
         counter_t *p_read_bytes;
         counter_t *p_input_bitrate;
+        counter_t *p_stream_cache_size;
+        counter_t *p_stream_cache_resizes;
         counter_t *p_demux_read;
         counter_t *p_demux_bitrate;
         counter_t *p_demux_corrupted;
@@ -154,6 +160,7 @@ struct input_thread_private_t
         counter_t *p_lost_abuffers;
         counter_t *p_displayed_pictures;
         counter_t *p_lost_pictures;
+        counter_t *p_copied_pictures;
         vlc_mutex_t counters_lock;
     } counters;
 
@@ -180,6 +187,8 @@ enum input_control_e
     INPUT_CONTROL_SET_POSITION,
 
     INPUT_CONTROL_SET_TIME,
+    INPUT_CONTROL_SET_TIME_FAST,    /* whatever b_fast_seek */
+    INPUT_CONTROL_SET_TIME_PRECISE,
 
     INPUT_CONTROL_SET_PROGRAM,
 
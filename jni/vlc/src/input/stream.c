@@ -58,17 +58,34 @@
  *      It should probably defaulted (instead of the stream method (2)).
  */
 
-/* How many tracks we have, currently only used for stream mode */
+/* How many tracks we have at most, currently only used for stream mode */
 #ifdef OPTIMIZE_MEMORY
 #   define STREAM_CACHE_TRACK 1
-    /* Max size of our cache 128Ko per track */
-#   define STREAM_CACHE_SIZE  (STREAM_CACHE_TRACK*1024*128)
+    /* Bounds of our cache: 128Ko */
+#   define STREAM_CACHE_MIN_SIZE (STREAM_CACHE_TRACK*1024*128)
+#   define STREAM_CACHE_MAX_SIZE (STREAM_CACHE_TRACK*1024*128)
 #else
 #   define STREAM_CACHE_TRACK 3
-    /* Max size of our cache 4Mo per track */
-#   define STREAM_CACHE_SIZE  (4*STREAM_CACHE_TRACK*1024*1024)
+    /* Bounds of our cache: 256Ko to 4Mo per track */
+#   define STREAM_CACHE_MIN_SIZE (STREAM_CACHE_TRACK*1024*256)
+#   define STREAM_CACHE_MAX_SIZE (4*STREAM_CACHE_TRACK*1024*1024)
 #endif
 
+/* Cache sizing, common to both methods:
+ *  - the cache may use 1/STREAM_CACHE_MEMORY_RATIO of the available memory
+ *    (within the bounds above), this is checked every STREAM_CACHE_UPDATE
+ *    so that the cache shrinks under memory pressure.
+ *  - in stream mode, a track holds STREAM_CACHE_DURATION worth of data at
+ *    the measured consumption rate (twice that if the access throughput is
+ *    less than 4 times the rate). Tracks are only resized when the wanted
+ *    size is off by a factor of 2 or when over the memory budget, and never
+ *    below twice the peek they are refilled for.
+ *  - the track size and the resizes go to the input statistics.
+ */
+#define STREAM_CACHE_MEMORY_RATIO 16
+#define STREAM_CACHE_UPDATE (CLOCK_FREQ)
+#define STREAM_CACHE_DURATION (10*CLOCK_FREQ)
+
 /* How many data we try to prebuffer
  * XXX it should be small to avoid useless latency but big enough for
  * efficient demux probing */
@@ -76,7 +93,7 @@
 
 /* Method1: Simple, for pf_block.
  *  We get blocks and put them in the linked list.
- *  We release blocks once the total size is bigger than CACHE_BLOCK_SIZE
+ *  We release blocks once the total size is bigger than the cache size
  */
 
 /* Method2: A bit more complex, for pf_read
@@ -87,13 +104,28 @@
  *          if close enough, read data and use this ring
  *          else use the oldest ring, seek and use it.
  *
- *  TODO: - with access non seekable: use all space available for only one ring, but
- *          we have to support seekable/non-seekable switch on the fly.
- *        - compute a good value for i_read_size
+ *  - With access non seekable, only one ring is used and gets all the space.
+ *  - i_read_size starts at STREAM_READ_ATONCE, doubles on each sequential
+ *    refill and goes back to STREAM_READ_ATONCE on seek. It is bounded by
+ *    STREAM_READ_MAX, a quarter of a track and what the access can deliver
+ *    in STREAM_READ_DURATION.
+ *
+ *  TODO: - we have to support seekable/non-seekable switch on the fly.
  *        - ?
  */
 #define STREAM_READ_ATONCE 1024
-#define STREAM_CACHE_TRACK_SIZE (STREAM_CACHE_SIZE/STREAM_CACHE_TRACK)
+#define STREAM_READ_MAX (256*1024)
+#define STREAM_READ_DURATION (CLOCK_FREQ/50)
+
+/* Method2 read-ahead (optional, "input-prefetch"):
+ *  A thread reads the access into a ring buffer so that the track refills
+ *  are served from memory. Seeks pause the thread (waiting for the pending
+ *  pf_read to return), move the access and flush the ring.
+ *  The thread reads at most STREAM_PREFETCH_CHUNK bytes at once.
+ *  Block accesses (Method1) do not use it: mapped local files are read
+ *  ahead by the kernel, and the others are live sources.
+ */
+#define STREAM_PREFETCH_CHUNK (64*1024)
 
 typedef struct
 {
@@ -145,6 +177,8 @@ struct stream_sys_t
     {
         unsigned i_offset;   /* Buffer offset in the current track */
         int      i_tk;       /* Current track */
+        int      i_tk_count; /* Tracks in use */
+        unsigned i_tk_size;  /* Size of each track buffer */
         stream_track_t tk[STREAM_CACHE_TRACK];
 
         /* Global buffer */
@@ -152,10 +186,43 @@ struct stream_sys_t
 
         /* */
         unsigned i_used; /* Used since last read */
-        unsigned i_read_size;
+        unsigned i_read_size; /* Minimum refill size */
+        unsigned i_window; /* Size of the pending peek */
 
     } stream;
 
+    /* Cache sizing for both methods */
+    struct
+    {
+        uint64_t i_size;    /* Memory budget */
+        mtime_t  i_date;    /* Date of the last update */
+        uint64_t i_pos;     /* Reading offset at i_date */
+        bool     b_seek;    /* Seek since i_date */
+        uint64_t i_rate;    /* Measured consumption in bytes/s */
+
+    } cache;
+
+    /* Read-ahead thread for method 2 */
+    struct
+    {
+        vlc_thread_t thread;
+        vlc_mutex_t  lock;
+        vlc_cond_t   wait;      /* Signaled to the thread */
+        vlc_cond_t   done;      /* Signaled by the thread */
+
+        uint8_t  *p_buffer;     /* NULL if read-ahead is disabled */
+        unsigned i_size;
+        unsigned i_chunk;
+        unsigned i_begin;       /* Offset of the first unread byte */
+        unsigned i_data;        /* Amount of unread data */
+
+        bool     b_busy;        /* The thread is inside the access */
+        bool     b_paused;
+        bool     b_eof;
+        bool     b_exit;
+
+    } prefetch;
+
     /* Peek temporary buffer */
     unsigned int i_peek;
     uint8_t *p_peek;
@@ -170,10 +237,23 @@ struct stream_sys_t
         uint64_t i_bytes;
         uint64_t i_read_time;
 
+        /* Stat about the access reads alone, made by the read-ahead thread
+         * when there is one (under its lock) */
+        uint64_t i_access_bytes;
+        uint64_t i_access_time;
+
         /* Stat about seek */
         unsigned i_seek_count;
         uint64_t i_seek_time;
 
+        /* Stat about read-ahead */
+        unsigned i_underrun_count;
+        uint64_t i_underrun_time;
+
+        /* Stat about cache sizing */
+        unsigned i_resize_count;
+        unsigned i_read_size_max;
+
     } stat;
 
     /* Streams list */
@@ -196,12 +276,26 @@ static int  AStreamPeekStream( stream_t *s, const uint8_t **pp_peek, unsigned in
 static int  AStreamSeekStream( stream_t *s, uint64_t i_pos );
 static void AStreamPrebufferStream( stream_t *s );
 static int  AReadStream( stream_t *s, void *p_read, unsigned int i_read );
+static int  AStreamResizeStream( stream_t *s, unsigned i_size );
+
+/* Method 2 read-ahead */
+static int  APrefetchStart( stream_t *s, unsigned i_size );
+static void APrefetchStop( stream_t *s );
+static void APrefetchPause( stream_t *s );
+static void APrefetchResume( stream_t *s, bool b_flush );
+static int  APrefetchRead( stream_t *s, void *p_read, unsigned int i_read );
+static int  APrefetchSeek( stream_t *s, uint64_t i_pos );
+static uint64_t APrefetchThroughput( stream_t *s );
 
 /* Common */
 static int AStreamControl( stream_t *s, int i_query, va_list );
+static int AStreamAccessControl( stream_t *s, int i_query, ... );
 static void AStreamDestroy( stream_t *s );
 static void UStreamDestroy( stream_t *s );
 static int  ASeek( stream_t *s, uint64_t i_pos );
+static uint64_t AStreamCacheBudget( void );
+static void AStreamCacheUpdate( stream_t *s );
+static void AStreamCacheStats( stream_t *s, bool b_resized );
 
 /****************************************************************************
  * stream_CommonNew: create an empty stream structure
@@ -320,14 +414,29 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
         p_sys->method = STREAM_METHOD_STREAM;
 
     p_sys->i_pos = p_access->info.i_pos;
+    p_sys->prefetch.p_buffer = NULL;
+    p_sys->prefetch.i_data = 0;
 
     /* Stats */
     access_Control( p_access, ACCESS_CAN_FASTSEEK, &p_sys->stat.b_fastseek );
     p_sys->stat.i_bytes = 0;
     p_sys->stat.i_read_time = 0;
     p_sys->stat.i_read_count = 0;
+    p_sys->stat.i_access_bytes = 0;
+    p_sys->stat.i_access_time = 0;
     p_sys->stat.i_seek_count = 0;
     p_sys->stat.i_seek_time = 0;
+    p_sys->stat.i_underrun_count = 0;
+    p_sys->stat.i_underrun_time = 0;
+    p_sys->stat.i_resize_count = 0;
+    p_sys->stat.i_read_size_max = 0;
+
+    /* Cache sizing */
+    p_sys->cache.i_size = AStreamCacheBudget();
+    p_sys->cache.i_date = mdate();
+    p_sys->cache.i_pos  = p_sys->i_pos;
+    p_sys->cache.b_seek = false;
+    p_sys->cache.i_rate = 0;
 
     TAB_INIT( p_sys->i_list, p_sys->list );
     p_sys->i_list_index = 0;
@@ -408,6 +517,7 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
     else
     {
         int i;
+        bool b_aseek;
 
         assert( p_sys->method == STREAM_METHOD_STREAM );
 
@@ -416,27 +526,42 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
         s->pf_read = AStreamReadStream;
         s->pf_peek = AStreamPeekStream;
 
-        /* Allocate/Setup our tracks */
+        /* Allocate/Setup our tracks, a single one if we cannot seek */
+        access_Control( p_access, ACCESS_CAN_SEEK, &b_aseek );
         p_sys->stream.i_offset = 0;
         p_sys->stream.i_tk     = 0;
-        p_sys->stream.p_buffer = malloc( STREAM_CACHE_SIZE );
+        p_sys->stream.i_tk_count = b_aseek ? STREAM_CACHE_TRACK : 1;
+        p_sys->stream.i_tk_size  =
+            p_sys->cache.i_size / p_sys->stream.i_tk_count & ~4095;
+        p_sys->stream.p_buffer = malloc( (size_t)p_sys->stream.i_tk_size *
+                                         p_sys->stream.i_tk_count );
         if( p_sys->stream.p_buffer == NULL )
             goto error;
+        msg_Dbg( s, "cache: %d track(s) of %u KiB",
+                 p_sys->stream.i_tk_count, p_sys->stream.i_tk_size / 1024 );
+        AStreamCacheStats( s, false );
         p_sys->stream.i_used   = 0;
         p_sys->stream.i_read_size = STREAM_READ_ATONCE;
+        p_sys->stream.i_window = 0;
 #if STREAM_READ_ATONCE < 256
 #   error "Invalid STREAM_READ_ATONCE value"
 #endif
 
-        for( i = 0; i < STREAM_CACHE_TRACK; i++ )
+        for( i = 0; i < p_sys->stream.i_tk_count; i++ )
         {
             p_sys->stream.tk[i].i_date  = 0;
             p_sys->stream.tk[i].i_start = p_sys->i_pos;
             p_sys->stream.tk[i].i_end   = p_sys->i_pos;
             p_sys->stream.tk[i].p_buffer=
-                &p_sys->stream.p_buffer[i * STREAM_CACHE_TRACK_SIZE];
+                &p_sys->stream.p_buffer[i * p_sys->stream.i_tk_size];
         }
 
+        /* Start the read-ahead thread if requested */
+        const int64_t i_prefetch = var_InheritInteger( s, "input-prefetch" );
+        if( i_prefetch > 0 &&
+            APrefetchStart( s, __MIN( i_prefetch, 65536 ) * 1024 ) )
+            msg_Warn( s, "cannot start the read-ahead thread" );
+
         /* Do the prebuffering */
         AStreamPrebufferStream( s );
 
@@ -456,6 +581,7 @@ error:
     }
     else
     {
+        APrefetchStop( s );
         free( p_sys->stream.p_buffer );
     }
     while( p_sys->i_list > 0 )
@@ -474,10 +600,22 @@ static void AStreamDestroy( stream_t *s )
     stream_sys_t *p_sys = s->p_sys;
 
     if( p_sys->method == STREAM_METHOD_BLOCK )
+    {
         block_ChainRelease( p_sys->block.p_first );
+    }
     else
+    {
+        APrefetchStop( s );
         free( p_sys->stream.p_buffer );
 
+        msg_Dbg( s, "cache: %u resize(s), %d track(s) of %u KiB, "
+                 "reads of up to %u KiB, access at %"PRIu64" KiB/s",
+                 p_sys->stat.i_resize_count, p_sys->stream.i_tk_count,
+                 p_sys->stream.i_tk_size / 1024,
+                 p_sys->stat.i_read_size_max / 1024,
+                 APrefetchThroughput( s ) / 1024 );
+    }
+
     free( p_sys->p_peek );
 
     if( p_sys->p_list_access && p_sys->p_list_access != p_sys->p_access )
@@ -509,7 +647,11 @@ static void AStreamControlReset( stream_t *s )
 {
     stream_sys_t *p_sys = s->p_sys;
 
+    /* Whatever was read ahead is discarded */
+    APrefetchPause( s );
     p_sys->i_pos = p_sys->p_access->info.i_pos;
+    APrefetchResume( s, true );
+    p_sys->cache.b_seek = true;
 
     if( p_sys->method == STREAM_METHOD_BLOCK )
     {
@@ -536,8 +678,9 @@ static void AStreamControlReset( stream_t *s )
         p_sys->stream.i_offset = 0;
         p_sys->stream.i_tk     = 0;
         p_sys->stream.i_used   = 0;
+        p_sys->stream.i_read_size = STREAM_READ_ATONCE;
 
-        for( i = 0; i < STREAM_CACHE_TRACK; i++ )
+        for( i = 0; i < p_sys->stream.i_tk_count; i++ )
         {
             p_sys->stream.tk[i].i_date  = 0;
             p_sys->stream.tk[i].i_start = p_sys->i_pos;
@@ -556,7 +699,10 @@ static void AStreamControlUpdate( stream_t *s )
 {
     stream_sys_t *p_sys = s->p_sys;
 
-    p_sys->i_pos = p_sys->p_access->info.i_pos;
+    /* The read-ahead data has not been consumed yet */
+    APrefetchPause( s );
+    p_sys->i_pos = p_sys->p_access->info.i_pos - p_sys->prefetch.i_data;
+    APrefetchResume( s, false );
 
     if( p_sys->i_list )
     {
@@ -597,12 +743,12 @@ static int AStreamControl( stream_t *s, int i_query, va_list args )
 
         case STREAM_CAN_SEEK:
             p_bool = (bool*)va_arg( args, bool * );
-            access_Control( p_access, ACCESS_CAN_SEEK, p_bool );
+            AStreamAccessControl( s, ACCESS_CAN_SEEK, p_bool );
             break;
 
         case STREAM_CAN_FASTSEEK:
             p_bool = (bool*)va_arg( args, bool * );
-            access_Control( p_access, ACCESS_CAN_FASTSEEK, p_bool );
+            AStreamAccessControl( s, ACCESS_CAN_FASTSEEK, p_bool );
             break;
 
         case STREAM_GET_POSITION:
@@ -630,15 +776,23 @@ static int AStreamControl( stream_t *s, int i_query, va_list args )
                 i_int != ACCESS_SET_PRIVATE_ID_CA &&
                 i_int != ACCESS_GET_PRIVATE_ID_STATE &&
                 i_int != ACCESS_SET_TITLE &&
-                i_int != ACCESS_SET_SEEKPOINT )
+                i_int != ACCESS_SET_SEEKPOINT &&
+                i_int != ACCESS_SET_PAUSE_STATE &&
+                i_int != ACCESS_GET_META &&
+                i_int != ACCESS_GET_SIGNAL )
             {
                 msg_Err( s, "Hey, what are you thinking ?"
                             "DON'T USE STREAM_CONTROL_ACCESS !!!" );
                 return VLC_EGENERIC;
             }
+            APrefetchPause( s );
             int i_ret = access_vaControl( p_access, i_int, args );
+            /* The reset flushes the read-ahead before resuming it, so
+             * nothing is read from the new position in between */
             if( i_int == ACCESS_SET_TITLE || i_int == ACCESS_SET_SEEKPOINT )
                 AStreamControlReset( s );
+            else
+                APrefetchResume( s, false );
             return i_ret;
         }
 
@@ -646,9 +800,25 @@ static int AStreamControl( stream_t *s, int i_query, va_list args )
             AStreamControlUpdate( s );
             return VLC_SUCCESS;
 
+        case STREAM_GET_ACCESS_UPDATE:
+        {
+            int *pi_update = va_arg( args, int * );
+            int *pi_title = va_arg( args, int * );
+            int *pi_seekpoint = va_arg( args, int * );
+
+            /* The access sets them from pf_read/pf_block */
+            APrefetchPause( s );
+            *pi_update = p_access->info.i_update;
+            *pi_title = p_access->info.i_title;
+            *pi_seekpoint = p_access->info.i_seekpoint;
+            p_access->info.i_update = 0;
+            APrefetchResume( s, false );
+            return VLC_SUCCESS;
+        }
+
         case STREAM_GET_CONTENT_TYPE:
-            return access_Control( p_access, ACCESS_GET_CONTENT_TYPE,
-                                    va_arg( args, char ** ) );
+            return AStreamAccessControl( s, ACCESS_GET_CONTENT_TYPE,
+                                         va_arg( args, char ** ) );
         case STREAM_SET_RECORD_STATE:
         default:
             msg_Err( s, "invalid stream_vaControl query=0x%x", i_query );
@@ -657,6 +827,138 @@ static int AStreamControl( stream_t *s, int i_query, va_list args )
     return VLC_SUCCESS;
 }
 
+/* access_Control() for the demuxer side, the read-ahead thread may be
+ * inside the access at the same time */
+static int AStreamAccessControl( stream_t *s, int i_query, ... )
+{
+    va_list args;
+    int i_ret;
+
+    APrefetchPause( s );
+    va_start( args, i_query );
+    i_ret = access_vaControl( s->p_sys->p_access, i_query, args );
+    va_end( args );
+    APrefetchResume( s, false );
+    return i_ret;
+}
+
+/****************************************************************************
+ * Cache sizing:
+ ****************************************************************************/
+static uint64_t AStreamCacheBudget( void )
+{
+    uint64_t i_avail = 0;
+
+#ifdef __linux__
+    /* Free memory and page cache, the latter is reclaimed on demand */
+    FILE *p_file = fopen( "/proc/meminfo", "r" );
+    if( p_file )
+    {
+        char psz_line[128];
+        unsigned long i_kb;
+
+        while( fgets( psz_line, sizeof(psz_line), p_file ) )
+        {
+            if( sscanf( psz_line, "MemFree: %lu kB", &i_kb ) == 1 ||
+                sscanf( psz_line, "Cached: %lu kB", &i_kb ) == 1 )
+                i_avail += (uint64_t)i_kb * 1024;
+        }
+        fclose( p_file );
+    }
+#endif
+    if( i_avail == 0 )
+        return STREAM_CACHE_MAX_SIZE;
+
+    i_avail /= STREAM_CACHE_MEMORY_RATIO;
+    return __MAX( __MIN( i_avail, STREAM_CACHE_MAX_SIZE ),
+                  STREAM_CACHE_MIN_SIZE );
+}
+
+/* Measures the consumption rate and adapts the cache size to it and to the
+ * available memory, at most once every STREAM_CACHE_UPDATE */
+static void AStreamCacheUpdate( stream_t *s )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    const mtime_t i_date = mdate();
+
+    if( i_date < p_sys->cache.i_date + STREAM_CACHE_UPDATE )
+        return;
+
+    /* Only sequential periods tell the rate */
+    if( !p_sys->cache.b_seek && p_sys->i_pos > p_sys->cache.i_pos )
+    {
+        const uint64_t i_rate = ( p_sys->i_pos - p_sys->cache.i_pos ) *
+                                CLOCK_FREQ / ( i_date - p_sys->cache.i_date );
+        if( p_sys->cache.i_rate > 0 )
+            p_sys->cache.i_rate = ( 3 * p_sys->cache.i_rate + i_rate ) / 4;
+        else
+            p_sys->cache.i_rate = i_rate;
+    }
+    p_sys->cache.i_date = i_date;
+    p_sys->cache.i_pos  = p_sys->i_pos;
+    p_sys->cache.b_seek = false;
+
+    p_sys->cache.i_size = AStreamCacheBudget();
+    if( p_sys->method != STREAM_METHOD_STREAM )
+        return;
+
+    const int i_tk_count = p_sys->stream.i_tk_count;
+    const uint64_t i_tk_size = p_sys->stream.i_tk_size;
+    uint64_t i_size = p_sys->cache.i_size / i_tk_count;
+
+    if( p_sys->cache.i_rate > 0 )
+    {
+        /* Not the demuxer reads, which only copy from the read-ahead */
+        const uint64_t i_throughput = APrefetchThroughput( s );
+        mtime_t i_duration = STREAM_CACHE_DURATION;
+
+        if( i_throughput < 4 * p_sys->cache.i_rate )
+            i_duration *= 2;
+        i_size = __MIN( i_size,
+                        p_sys->cache.i_rate * i_duration / CLOCK_FREQ );
+    }
+    i_size = __MAX( i_size, STREAM_CACHE_MIN_SIZE / STREAM_CACHE_TRACK );
+    i_size &= ~4095;
+    /* A peek being refilled must still fit once done */
+    i_size = __MAX( i_size, 2 * (uint64_t)p_sys->stream.i_window );
+
+    if( i_tk_size * i_tk_count <= p_sys->cache.i_size &&
+        2 * i_size > i_tk_size && i_size < 2 * i_tk_size )
+        return;
+
+    if( AStreamResizeStream( s, i_size ) )
+        return;
+    assert( p_sys->stream.i_tk_size == i_size );
+
+    p_sys->stat.i_resize_count++;
+    msg_Dbg( s, "cache: %d track(s) resized from %"PRIu64" to %"PRIu64" KiB "
+             "(rate %"PRIu64" KiB/s, budget %"PRIu64" KiB)",
+             i_tk_count, i_tk_size / 1024, i_size / 1024,
+             p_sys->cache.i_rate / 1024, p_sys->cache.i_size / 1024 );
+    AStreamCacheStats( s, true );
+}
+
+/* Reports the size of the tracks with the input statistics */
+static void AStreamCacheStats( stream_t *s, bool b_resized )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    input_thread_t *p_input;
+
+    if( !s->p_parent || !s->p_parent->p_parent ||
+        vlc_internals( s->p_parent->p_parent )->i_object_type != VLC_OBJECT_INPUT )
+        return;
+    p_input = (input_thread_t *)s->p_parent->p_parent;
+
+    vlc_mutex_lock( &p_input->p->counters.counters_lock );
+    stats_UpdateInteger( s, p_input->p->counters.p_stream_cache_size,
+                         p_sys->stream.i_tk_size * p_sys->stream.i_tk_count,
+                         NULL );
+    if( b_resized )
+        stats_UpdateInteger( s, p_input->p->counters.p_stream_cache_resizes,
+                             1, NULL );
+    vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+}
+
 /****************************************************************************
  * Method 1:
  ****************************************************************************/
@@ -916,7 +1218,7 @@ static int AStreamSeekBlock( stream_t *s, uint64_t i_pos )
             int i_th = b_aseekfast ? 1 : 5;
 
             if( i_skip <= i_th * i_avg &&
-                i_skip < STREAM_CACHE_SIZE )
+                i_skip < p_sys->cache.i_size )
                 b_seek = false;
             else
                 b_seek = true;
@@ -952,6 +1254,7 @@ static int AStreamSeekBlock( stream_t *s, uint64_t i_pos )
         /* Update stat */
         p_sys->stat.i_seek_time += i_end - i_start;
         p_sys->stat.i_seek_count++;
+        p_sys->cache.b_seek = true;
         return VLC_SUCCESS;
     }
     else
@@ -987,8 +1290,10 @@ static int AStreamRefillBlock( stream_t *s )
     stream_sys_t *p_sys = s->p_sys;
     block_t      *b;
 
+    AStreamCacheUpdate( s );
+
     /* Release data */
-    while( p_sys->block.i_size >= STREAM_CACHE_SIZE &&
+    while( p_sys->block.i_size >= p_sys->cache.i_size &&
            p_sys->block.p_first != p_sys->block.p_current )
     {
         block_t *b = p_sys->block.p_first;
@@ -999,7 +1304,7 @@ static int AStreamRefillBlock( stream_t *s )
 
         block_Release( b );
     }
-    if( p_sys->block.i_size >= STREAM_CACHE_SIZE &&
+    if( p_sys->block.i_size >= p_sys->cache.i_size &&
         p_sys->block.p_current == p_sys->block.p_first &&
         p_sys->block.p_current->p_next )    /* At least 2 packets */
     {
@@ -1085,9 +1390,11 @@ static int AStreamPeekStream( stream_t *s, const uint8_t **pp_peek, unsigned int
 #endif
 
     /* Avoid problem, but that should *never* happen */
-    if( i_read > STREAM_CACHE_TRACK_SIZE / 2 )
-        i_read = STREAM_CACHE_TRACK_SIZE / 2;
+    if( i_read > p_sys->stream.i_tk_size / 2 )
+        i_read = p_sys->stream.i_tk_size / 2;
 
+    /* The refills may resize the tracks, but not below twice i_read */
+    p_sys->stream.i_window = i_read;
     while( tk->i_end < tk->i_start + p_sys->stream.i_offset + i_read )
     {
         if( p_sys->stream.i_used <= 1 )
@@ -1097,6 +1404,7 @@ static int AStreamPeekStream( stream_t *s, const uint8_t **pp_peek, unsigned int
         }
         if( AStreamRefillStream( s ) ) break;
     }
+    p_sys->stream.i_window = 0;
 
     if( tk->i_end < tk->i_start + p_sys->stream.i_offset + i_read )
     {
@@ -1105,8 +1413,9 @@ static int AStreamPeekStream( stream_t *s, const uint8_t **pp_peek, unsigned int
 
 
     /* Now, direct pointer or a copy ? */
-    i_off = (tk->i_start + p_sys->stream.i_offset) % STREAM_CACHE_TRACK_SIZE;
-    if( i_off + i_read <= STREAM_CACHE_TRACK_SIZE )
+    const unsigned i_tk_size = p_sys->stream.i_tk_size;
+    i_off = (tk->i_start + p_sys->stream.i_offset) % i_tk_size;
+    if( i_off + i_read <= i_tk_size )
     {
         *pp_peek = &tk->p_buffer[i_off];
         return i_read;
@@ -1123,10 +1432,9 @@ static int AStreamPeekStream( stream_t *s, const uint8_t **pp_peek, unsigned int
         p_sys->i_peek = i_read;
     }
 
-    memcpy( p_sys->p_peek, &tk->p_buffer[i_off],
-            STREAM_CACHE_TRACK_SIZE - i_off );
-    memcpy( &p_sys->p_peek[STREAM_CACHE_TRACK_SIZE - i_off],
-            &tk->p_buffer[0], i_read - (STREAM_CACHE_TRACK_SIZE - i_off) );
+    memcpy( p_sys->p_peek, &tk->p_buffer[i_off], i_tk_size - i_off );
+    memcpy( &p_sys->p_peek[i_tk_size - i_off],
+            &tk->p_buffer[0], i_read - (i_tk_size - i_off) );
 
     *pp_peek = p_sys->p_peek;
     return i_read;
@@ -1137,7 +1445,6 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
     stream_sys_t *p_sys = s->p_sys;
 
     stream_track_t *p_current = &p_sys->stream.tk[p_sys->stream.i_tk];
-    access_t *p_access = p_sys->p_access;
 
     if( p_current->i_start >= p_current->i_end  && i_pos >= p_current->i_end )
         return 0; /* EOF */
@@ -1152,7 +1459,7 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
 #endif
 
     bool   b_aseek;
-    access_Control( p_access, ACCESS_CAN_SEEK, &b_aseek );
+    AStreamAccessControl( s, ACCESS_CAN_SEEK, &b_aseek );
     if( !b_aseek && i_pos < p_current->i_start )
     {
         msg_Warn( s, "AStreamSeekStream: can't seek" );
@@ -1160,7 +1467,7 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
     }
 
     bool   b_afastseek;
-    access_Control( p_access, ACCESS_CAN_FASTSEEK, &b_afastseek );
+    AStreamAccessControl( s, ACCESS_CAN_FASTSEEK, &b_afastseek );
 
     /* FIXME compute seek cost (instead of static 'stupid' value) */
     uint64_t i_skip_threshold;
@@ -1185,7 +1492,7 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
     if( !tk )
     {
         /* Try to maximize already read data */
-        for( int i = 0; i < STREAM_CACHE_TRACK; i++ )
+        for( int i = 0; i < p_sys->stream.i_tk_count; i++ )
         {
             stream_track_t *t = &p_sys->stream.tk[i];
 
@@ -1202,7 +1509,7 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
     if( !tk )
     {
         /* Use the oldest unused */
-        for( int i = 0; i < STREAM_CACHE_TRACK; i++ )
+        for( int i = 0; i < p_sys->stream.i_tk_count; i++ )
         {
             stream_track_t *t = &p_sys->stream.tk[i];
 
@@ -1213,7 +1520,7 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
             }
         }
     }
-    assert( i_tk_idx >= 0 && i_tk_idx < STREAM_CACHE_TRACK );
+    assert( i_tk_idx >= 0 && i_tk_idx < p_sys->stream.i_tk_count );
 
     if( tk != p_current )
         i_skip_threshold = 0;
@@ -1232,8 +1539,12 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
             /* Seek at the end of the buffer
              * TODO it is stupid to seek now, it would be better to delay it
              */
-            if( ASeek( s, tk->i_end ) )
+            if( APrefetchSeek( s, tk->i_end ) )
                 return VLC_EGENERIC;
+
+            /* No longer sequential */
+            p_sys->stream.i_read_size = STREAM_READ_ATONCE;
+            p_sys->cache.b_seek = true;
         }
         else if( i_pos > tk->i_end )
         {
@@ -1253,11 +1564,15 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
         msg_Err( s, "AStreamSeekStream: hard seek" );
 #endif
         /* Nothing good, seek and choose oldest segment */
-        if( ASeek( s, i_pos ) )
+        if( APrefetchSeek( s, i_pos ) )
             return VLC_EGENERIC;
 
         tk->i_start = i_pos;
         tk->i_end   = i_pos;
+
+        /* No longer sequential */
+        p_sys->stream.i_read_size = STREAM_READ_ATONCE;
+        p_sys->cache.b_seek = true;
     }
     p_sys->stream.i_offset = i_pos - tk->i_start;
     p_sys->stream.i_tk = i_tk_idx;
@@ -1299,10 +1614,11 @@ static int AStreamReadNoSeekStream( stream_t *s, void *p_read, unsigned int i_re
 
     while( i_data < i_read )
     {
-        unsigned i_off = (tk->i_start + p_sys->stream.i_offset) % STREAM_CACHE_TRACK_SIZE;
+        const unsigned i_tk_size = p_sys->stream.i_tk_size;
+        unsigned i_off = (tk->i_start + p_sys->stream.i_offset) % i_tk_size;
         unsigned int i_current =
             __MIN( tk->i_end - tk->i_start - p_sys->stream.i_offset,
-                   STREAM_CACHE_TRACK_SIZE - i_off );
+                   i_tk_size - i_off );
         int i_copy = __MIN( i_current, i_read - i_data );
 
         if( i_copy <= 0 ) break; /* EOF */
@@ -1349,10 +1665,14 @@ static int AStreamRefillStream( stream_t *s )
     stream_sys_t *p_sys = s->p_sys;
     stream_track_t *tk = &p_sys->stream.tk[p_sys->stream.i_tk];
 
+    AStreamCacheUpdate( s );
+
+    const unsigned i_tk_size = p_sys->stream.i_tk_size;
+
     /* We read but won't increase i_start after initial start + offset */
     int i_toread =
-        __MIN( p_sys->stream.i_used, STREAM_CACHE_TRACK_SIZE -
-               (tk->i_end - tk->i_start - p_sys->stream.i_offset) );
+        __MIN( __MAX( p_sys->stream.i_used, p_sys->stream.i_read_size ),
+               i_tk_size - (tk->i_end - tk->i_start - p_sys->stream.i_offset) );
     bool b_read = false;
     int64_t i_start, i_stop;
 
@@ -1366,14 +1686,14 @@ static int AStreamRefillStream( stream_t *s )
     i_start = mdate();
     while( i_toread > 0 )
     {
-        int i_off = tk->i_end % STREAM_CACHE_TRACK_SIZE;
+        int i_off = tk->i_end % i_tk_size;
         int i_read;
 
         if( s->b_die )
             return VLC_EGENERIC;
 
-        i_read = __MIN( i_toread, STREAM_CACHE_TRACK_SIZE - i_off );
-        i_read = AReadStream( s, &tk->p_buffer[i_off], i_read );
+        i_read = __MIN( i_toread, (int)i_tk_size - i_off );
+        i_read = APrefetchRead( s, &tk->p_buffer[i_off], i_read );
 
         /* msg_Dbg( s, "AStreamRefillStream: read=%d", i_read ); */
         if( i_read <  0 )
@@ -1391,17 +1711,17 @@ static int AStreamRefillStream( stream_t *s )
         /* Update end */
         tk->i_end += i_read;
 
-        /* Windows of STREAM_CACHE_TRACK_SIZE */
-        if( tk->i_start + STREAM_CACHE_TRACK_SIZE < tk->i_end )
+        /* Windows of i_tk_size */
+        if( tk->i_start + i_tk_size < tk->i_end )
         {
-            unsigned i_invalid = tk->i_end - tk->i_start - STREAM_CACHE_TRACK_SIZE;
+            unsigned i_invalid = tk->i_end - tk->i_start - i_tk_size;
 
             tk->i_start += i_invalid;
             p_sys->stream.i_offset -= i_invalid;
         }
 
         i_toread -= i_read;
-        p_sys->stream.i_used -= i_read;
+        p_sys->stream.i_used -= __MIN( p_sys->stream.i_used, (unsigned)i_read );
 
         p_sys->stat.i_bytes += i_read;
         p_sys->stat.i_read_count++;
@@ -1410,6 +1730,65 @@ static int AStreamRefillStream( stream_t *s )
 
     p_sys->stat.i_read_time += i_stop - i_start;
 
+    /* Sequential access: read more at once next time, but no more than
+     * what the access delivers in STREAM_READ_DURATION */
+    uint64_t i_read_max = APrefetchThroughput( s ) * STREAM_READ_DURATION /
+                          CLOCK_FREQ;
+    i_read_max = __MIN( i_read_max, __MIN( STREAM_READ_MAX, i_tk_size / 4 ) );
+    if( p_sys->stream.i_read_size < i_read_max )
+    {
+        p_sys->stream.i_read_size = __MIN( 2 * p_sys->stream.i_read_size,
+                                           i_read_max );
+        if( p_sys->stat.i_read_size_max < p_sys->stream.i_read_size )
+            p_sys->stat.i_read_size_max = p_sys->stream.i_read_size;
+    }
+
+    return VLC_SUCCESS;
+}
+
+/* Moves the tracks into buffers of i_size bytes, keeping their most recent
+ * data. Fails if the unread data of the current track would not fit. */
+static int AStreamResizeStream( stream_t *s, unsigned i_size )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    stream_track_t *p_current = &p_sys->stream.tk[p_sys->stream.i_tk];
+    const unsigned i_old_size = p_sys->stream.i_tk_size;
+    const uint64_t i_read_pos = p_current->i_start + p_sys->stream.i_offset;
+
+    if( p_current->i_end - i_read_pos > i_size )
+        return VLC_EGENERIC;
+
+    uint8_t *p_buffer = malloc( (size_t)i_size * p_sys->stream.i_tk_count );
+    if( p_buffer == NULL )
+        return VLC_ENOMEM;
+
+    for( int i = 0; i < p_sys->stream.i_tk_count; i++ )
+    {
+        stream_track_t *tk = &p_sys->stream.tk[i];
+        uint8_t *p_dst = &p_buffer[i * i_size];
+        const uint64_t i_start =
+            tk->i_end - __MIN( tk->i_end - tk->i_start, i_size );
+
+        /* Both are rings indexed by the stream offset */
+        for( uint64_t i_pos = i_start; i_pos < tk->i_end; )
+        {
+            const unsigned i_src = i_pos % i_old_size;
+            const unsigned i_dst = i_pos % i_size;
+            const unsigned i_copy =
+                __MIN( tk->i_end - i_pos,
+                       __MIN( i_old_size - i_src, i_size - i_dst ) );
+
+            memcpy( &p_dst[i_dst], &tk->p_buffer[i_src], i_copy );
+            i_pos += i_copy;
+        }
+        tk->i_start  = i_start;
+        tk->p_buffer = p_dst;
+    }
+    p_sys->stream.i_offset = i_read_pos - p_current->i_start;
+
+    free( p_sys->stream.p_buffer );
+    p_sys->stream.p_buffer = p_buffer;
+    p_sys->stream.i_tk_size = i_size;
     return VLC_SUCCESS;
 }
 
@@ -1448,10 +1827,11 @@ static void AStreamPrebufferStream( stream_t *s )
             break;
         }
 
-        /* */
-        i_read = STREAM_CACHE_TRACK_SIZE - i_buffered;
+        /* The ring is indexed by the stream offset, which may not be 0 */
+        const int i_off = tk->i_end % p_sys->stream.i_tk_size;
+        i_read = p_sys->stream.i_tk_size - i_off;
         i_read = __MIN( (int)p_sys->stream.i_read_size, i_read );
-        i_read = AReadStream( s, &tk->p_buffer[i_buffered], i_read );
+        i_read = APrefetchRead( s, &tk->p_buffer[i_off], i_read );
         if( i_read <  0 )
             continue;
         else if( i_read == 0 )
@@ -1470,6 +1850,227 @@ static void AStreamPrebufferStream( stream_t *s )
     }
 }
 
+/****************************************************************************
+ * Method 2 read-ahead:
+ ****************************************************************************/
+static void *APrefetchThread( void *data )
+{
+    stream_t *s = data;
+    stream_sys_t *p_sys = s->p_sys;
+
+    vlc_mutex_lock( &p_sys->prefetch.lock );
+    for( ;; )
+    {
+        /* Wait for enough free space */
+        while( !p_sys->prefetch.b_exit &&
+               ( p_sys->prefetch.b_paused || p_sys->prefetch.b_eof ||
+                 p_sys->prefetch.i_size - p_sys->prefetch.i_data <
+                     p_sys->prefetch.i_chunk ) )
+            vlc_cond_wait( &p_sys->prefetch.wait, &p_sys->prefetch.lock );
+        if( p_sys->prefetch.b_exit )
+            break;
+
+        const unsigned i_off = ( p_sys->prefetch.i_begin +
+                                 p_sys->prefetch.i_data ) % p_sys->prefetch.i_size;
+        unsigned i_read = __MIN( p_sys->prefetch.i_size - p_sys->prefetch.i_data,
+                                 p_sys->prefetch.i_size - i_off );
+        i_read = __MIN( i_read, p_sys->prefetch.i_chunk );
+
+        /* The free part of the ring is only written by us */
+        p_sys->prefetch.b_busy = true;
+        vlc_mutex_unlock( &p_sys->prefetch.lock );
+
+        const mtime_t i_start = mdate();
+        const int i_ret = AReadStream( s, &p_sys->prefetch.p_buffer[i_off],
+                                       i_read );
+        const mtime_t i_stop = mdate();
+
+        vlc_mutex_lock( &p_sys->prefetch.lock );
+        p_sys->prefetch.b_busy = false;
+        if( i_ret > 0 )
+        {
+            p_sys->prefetch.i_data += i_ret;
+            p_sys->stat.i_access_bytes += i_ret;
+            p_sys->stat.i_access_time += i_stop - i_start;
+        }
+        else if( i_ret == 0 || s->b_die )
+            p_sys->prefetch.b_eof = true;
+        vlc_cond_signal( &p_sys->prefetch.done );
+    }
+    vlc_mutex_unlock( &p_sys->prefetch.lock );
+    return NULL;
+}
+
+static int APrefetchStart( stream_t *s, unsigned i_size )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    p_sys->prefetch.p_buffer = malloc( i_size );
+    if( p_sys->prefetch.p_buffer == NULL )
+        return VLC_ENOMEM;
+
+    p_sys->prefetch.i_size  = i_size;
+    p_sys->prefetch.i_chunk = __MIN( STREAM_PREFETCH_CHUNK, i_size / 2 );
+    p_sys->prefetch.i_begin = 0;
+    p_sys->prefetch.i_data  = 0;
+    p_sys->prefetch.b_busy   = false;
+    p_sys->prefetch.b_paused = false;
+    p_sys->prefetch.b_eof    = false;
+    p_sys->prefetch.b_exit   = false;
+
+    vlc_mutex_init( &p_sys->prefetch.lock );
+    vlc_cond_init( &p_sys->prefetch.wait );
+    vlc_cond_init( &p_sys->prefetch.done );
+
+    if( vlc_clone( &p_sys->prefetch.thread, APrefetchThread, s,
+                   VLC_THREAD_PRIORITY_INPUT ) )
+    {
+        vlc_cond_destroy( &p_sys->prefetch.done );
+        vlc_cond_destroy( &p_sys->prefetch.wait );
+        vlc_mutex_destroy( &p_sys->prefetch.lock );
+        free( p_sys->prefetch.p_buffer );
+        p_sys->prefetch.p_buffer = NULL;
+        return VLC_EGENERIC;
+    }
+    msg_Dbg( s, "read-ahead of %u KiB enabled", i_size / 1024 );
+    return VLC_SUCCESS;
+}
+
+static void APrefetchStop( stream_t *s )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    if( p_sys->prefetch.p_buffer == NULL )
+        return;
+
+    vlc_mutex_lock( &p_sys->prefetch.lock );
+    p_sys->prefetch.b_exit = true;
+    vlc_cond_signal( &p_sys->prefetch.wait );
+    vlc_mutex_unlock( &p_sys->prefetch.lock );
+
+    vlc_join( p_sys->prefetch.thread, NULL );
+
+    msg_Dbg( s, "read-ahead: %u underruns, %"PRId64" ms spent waiting",
+             p_sys->stat.i_underrun_count,
+             p_sys->stat.i_underrun_time / INT64_C(1000) );
+
+    vlc_cond_destroy( &p_sys->prefetch.done );
+    vlc_cond_destroy( &p_sys->prefetch.wait );
+    vlc_mutex_destroy( &p_sys->prefetch.lock );
+    free( p_sys->prefetch.p_buffer );
+    p_sys->prefetch.p_buffer = NULL;
+    p_sys->prefetch.i_data = 0;
+}
+
+/* Waits for the thread to leave the access, which can then be used
+ * by the caller until APrefetchResume() */
+static void APrefetchPause( stream_t *s )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    if( p_sys->prefetch.p_buffer == NULL )
+        return;
+
+    vlc_mutex_lock( &p_sys->prefetch.lock );
+    p_sys->prefetch.b_paused = true;
+    while( p_sys->prefetch.b_busy )
+        vlc_cond_wait( &p_sys->prefetch.done, &p_sys->prefetch.lock );
+    vlc_mutex_unlock( &p_sys->prefetch.lock );
+}
+
+static void APrefetchResume( stream_t *s, bool b_flush )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    if( p_sys->prefetch.p_buffer == NULL )
+        return;
+
+    vlc_mutex_lock( &p_sys->prefetch.lock );
+    if( b_flush )
+    {
+        p_sys->prefetch.i_begin = 0;
+        p_sys->prefetch.i_data  = 0;
+        p_sys->prefetch.b_eof   = false;
+    }
+    p_sys->prefetch.b_paused = false;
+    vlc_cond_signal( &p_sys->prefetch.wait );
+    vlc_mutex_unlock( &p_sys->prefetch.lock );
+}
+
+static int APrefetchRead( stream_t *s, void *p_read, unsigned int i_read )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    uint8_t *p_data = p_read;
+
+    if( p_sys->prefetch.p_buffer == NULL )
+    {
+        const mtime_t i_start = mdate();
+        const int i_ret = AReadStream( s, p_read, i_read );
+
+        if( i_ret > 0 )
+        {
+            p_sys->stat.i_access_bytes += i_ret;
+            p_sys->stat.i_access_time += mdate() - i_start;
+        }
+        return i_ret;
+    }
+
+    vlc_mutex_lock( &p_sys->prefetch.lock );
+    if( p_sys->prefetch.i_data == 0 && !p_sys->prefetch.b_eof )
+    {
+        /* Underrun: the access is slower than the demuxer */
+        const mtime_t i_start = mdate();
+
+        do
+            vlc_cond_wait( &p_sys->prefetch.done, &p_sys->prefetch.lock );
+        while( p_sys->prefetch.i_data == 0 && !p_sys->prefetch.b_eof );
+
+        p_sys->stat.i_underrun_count++;
+        p_sys->stat.i_underrun_time += mdate() - i_start;
+    }
+
+    const unsigned i_copy = __MIN( i_read, p_sys->prefetch.i_data );
+    const unsigned i_first = __MIN( i_copy, p_sys->prefetch.i_size -
+                                            p_sys->prefetch.i_begin );
+
+    memcpy( p_data, &p_sys->prefetch.p_buffer[p_sys->prefetch.i_begin],
+            i_first );
+    memcpy( &p_data[i_first], p_sys->prefetch.p_buffer, i_copy - i_first );
+
+    p_sys->prefetch.i_begin = ( p_sys->prefetch.i_begin + i_copy ) %
+                              p_sys->prefetch.i_size;
+    p_sys->prefetch.i_data -= i_copy;
+    vlc_cond_signal( &p_sys->prefetch.wait );
+    vlc_mutex_unlock( &p_sys->prefetch.lock );
+
+    return i_copy;
+}
+
+/* Bytes per second delivered by the access itself, 0 if unknown yet */
+static uint64_t APrefetchThroughput( stream_t *s )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    uint64_t i_bytes, i_time;
+
+    if( p_sys->prefetch.p_buffer )
+        vlc_mutex_lock( &p_sys->prefetch.lock );
+    i_bytes = p_sys->stat.i_access_bytes;
+    i_time  = p_sys->stat.i_access_time;
+    if( p_sys->prefetch.p_buffer )
+        vlc_mutex_unlock( &p_sys->prefetch.lock );
+
+    return i_bytes * CLOCK_FREQ / ( i_time + 1 );
+}
+
+static int APrefetchSeek( stream_t *s, uint64_t i_pos )
+{
+    APrefetchPause( s );
+    const int i_ret = ASeek( s, i_pos );
+    /* On failure the access did not move, keep what was read ahead */
+    APrefetchResume( s, i_ret == VLC_SUCCESS );
+    return i_ret;
+}
+
 /****************************************************************************
  * stream_ReadLine:
  ****************************************************************************/
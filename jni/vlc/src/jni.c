@@ -10,6 +10,8 @@
 
 #include <jni.h>
 
+#include "control/media_player_internal.h"
+
 #define CLASS org_videolan_VLC
 #define KLASS "org/videolan/VLC"
 
@@ -17,6 +19,7 @@
 #define NAME2(CLZ, FUN) NAME1(CLZ, FUN)
 
 #define NAME(FUN) NAME2(CLASS, FUN)
+#define VLM_NAME(FUN) NAME2(org_videolan_VLM, FUN)
 
 JavaVM *gJVM = NULL;
 
@@ -36,17 +39,406 @@ void *GetSurface() {
     return vout_android_surf;
 }
 
+/* Control bridge between org.videolan.VLM and the notify interface.
+ *
+ * The events go through a bounded ring with one slot sequence number per
+ * entry: the input threads post without locking, the single VLM thread
+ * drains them in batches, and sleeps on a semaphore only when the ring is
+ * empty. Position updates are dropped first when VLM lags behind, the other
+ * events keep EVENT_RESERVED slots and wait on a condition VLM signals when
+ * it frees slots. The commands are handed to a callback registered by the
+ * interface, which runs them on its own thread. */
+
+/* must be a power of 2 */
+#define EVENT_RING_SIZE 256
+/* at most that many events per VLM.poll() */
+#define EVENT_BATCH 64
+/* slots only the events that cannot be dropped may use */
+#define EVENT_RESERVED 32
+/* how long these wait for VLM when the ring is full */
+#define EVENT_WAIT_MAX  (2 * CLOCK_FREQ)
+
+typedef struct {
+    volatile unsigned seq;
+    int type;
+    int64_t arg1;
+    int64_t arg2;
+    int64_t arg3;
+} jni_event_t;
+
+static jni_event_t event_ring[EVENT_RING_SIZE];
+static volatile unsigned event_head; /* next slot to write */
+static volatile unsigned event_tail; /* next slot to read, VLM thread only */
+static volatile int event_waiting;   /* the VLM thread sleeps on event_sem */
+static volatile int event_interrupt;
+static vlc_sem_t event_sem;
+/* producers waiting for VLM to free slots */
+static vlc_mutex_t event_room_lock;
+static vlc_cond_t event_room;
+static volatile int event_room_waiters;
+
+static vlc_mutex_t command_lock;
+static void (*command_handler)(void *, int, int64_t, int64_t, const char *);
+static void *command_data;
+
+/* keep in sync with org.videolan.VLM and modules/control/notify.c */
+#define COMMAND_INPUT 0
+#define COMMAND_PLAY  3
+
+/* The single instance and media player, between VLC.start() and
+ * VLC.release(). The player is kept from one file to the next, so that its
+ * video and audio outputs are reused. */
+static vlc_mutex_t player_lock;
+static libvlc_instance_t *vlc;
+static libvlc_media_player_t *player;
+/* the media opened ahead of time by VLM.preroll(), and its location */
+static libvlc_media_t *preroll_media;
+static char *preroll_location;
+
+static void EventWakeup(void) {
+    __sync_synchronize();
+    if (event_waiting && __sync_bool_compare_and_swap(&event_waiting, 1, 0))
+        vlc_sem_post(&event_sem);
+}
+
+/* Waits until VLM frees the slot at pos, or until the deadline. Returns
+ * false if the ring is still full. */
+static bool EventWaitRoom(unsigned pos, mtime_t deadline) {
+    const jni_event_t *ev = &event_ring[pos % EVENT_RING_SIZE];
+
+    EventWakeup();
+    vlc_mutex_lock(&event_room_lock);
+    __sync_fetch_and_add(&event_room_waiters, 1);
+    while ((int)(ev->seq - pos) < 0)
+        if (vlc_cond_timedwait(&event_room, &event_room_lock, deadline))
+            break;
+    __sync_fetch_and_sub(&event_room_waiters, 1);
+    vlc_mutex_unlock(&event_room_lock);
+    return (int)(ev->seq - pos) >= 0;
+}
+
+/* Queues an event for VLM. A droppable event is refused when the ring is
+ * nearly full, the others wait up to EVENT_WAIT_MAX for VLM to make room.
+ * Returns -1 if the event was not queued. */
+int PostEvent(int type, int64_t arg1, int64_t arg2, int64_t arg3, bool droppable) {
+    unsigned pos = event_head;
+    mtime_t deadline = 0;
+    jni_event_t *ev;
+
+    for (;;) {
+        if (droppable && pos - event_tail >= EVENT_RING_SIZE - EVENT_RESERVED)
+            return -1;
+        ev = &event_ring[pos % EVENT_RING_SIZE];
+        int diff = (int)(ev->seq - pos);
+        if (diff == 0) {
+            unsigned prev = __sync_val_compare_and_swap(&event_head, pos, pos + 1);
+            if (prev == pos)
+                break;
+            pos = prev;
+        }
+        else if (diff < 0) {
+            if (droppable)
+                return -1;
+            if (deadline == 0)
+                deadline = mdate() + EVENT_WAIT_MAX;
+            if (!EventWaitRoom(pos, deadline))
+                return -1;
+            pos = event_head;
+        }
+        else
+            pos = event_head;
+    }
+    ev->type = type;
+    ev->arg1 = arg1;
+    ev->arg2 = arg2;
+    ev->arg3 = arg3;
+    __sync_synchronize();
+    ev->seq = pos + 1;
+    EventWakeup();
+    return 0;
+}
+
+static bool EventGet(jlong *out) {
+    jni_event_t *ev = &event_ring[event_tail % EVENT_RING_SIZE];
+
+    if ((int)(ev->seq - (event_tail + 1)) < 0)
+        return false;
+    __sync_synchronize();
+    out[0] = ev->type;
+    out[1] = ev->arg1;
+    out[2] = ev->arg2;
+    out[3] = ev->arg3;
+    __sync_synchronize();
+    ev->seq = event_tail + EVENT_RING_SIZE;
+    event_tail++;
+    return true;
+}
+
+static bool EventPending(void) {
+    const jni_event_t *ev = &event_ring[event_tail % EVENT_RING_SIZE];
+
+    return (int)(ev->seq - (event_tail + 1)) >= 0 || event_interrupt;
+}
+
+/* The interface sets its handler when it starts and resets it to NULL
+ * before it goes away */
+void SetCommandHandler(void (*handler)(void *, int, int64_t, int64_t, const char *), void *data) {
+    vlc_mutex_lock(&command_lock);
+    command_handler = handler;
+    command_data = data;
+    vlc_mutex_unlock(&command_lock);
+}
+
+/* For the notify interface, returns the input of the player, held */
+input_thread_t *GetInput(void) {
+    input_thread_t *input = NULL;
+
+    vlc_mutex_lock(&player_lock);
+    if (player)
+        input = libvlc_get_input_thread(player);
+    vlc_mutex_unlock(&player_lock);
+    return input;
+}
+
+static bool Command(int cmd, int64_t arg1, int64_t arg2, const char *text) {
+    bool ok;
+
+    vlc_mutex_lock(&command_lock);
+    ok = command_handler != NULL;
+    if (ok)
+        command_handler(command_data, cmd, arg1, arg2, text);
+    vlc_mutex_unlock(&command_lock);
+    return ok;
+}
+
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
     gJVM = vm;
     vlc_mutex_init(&vout_android_lock);
+    vlc_mutex_init(&command_lock);
+    vlc_mutex_init(&player_lock);
+    vlc_sem_init(&event_sem, 0);
+    vlc_mutex_init(&event_room_lock);
+    vlc_cond_init(&event_room);
+    for (unsigned i = 0; i < EVENT_RING_SIZE; i++)
+        event_ring[i].seq = i;
 
     return JNI_VERSION_1_4;
 }
 
 JNIEXPORT void JNICALL JNI_OnUnload(JavaVM* vm, void* reserved) {
+    vlc_cond_destroy(&event_room);
+    vlc_mutex_destroy(&event_room_lock);
+    vlc_sem_destroy(&event_sem);
+    vlc_mutex_destroy(&player_lock);
+    vlc_mutex_destroy(&command_lock);
     vlc_mutex_destroy(&vout_android_lock);
 }
 
+JNIEXPORT jboolean JNICALL VLM_NAME(command)(JNIEnv *env, jclass klz, jint cmd, jlong arg1, jlong arg2, jstring text) {
+    const char *text_utf8 = text ? (*env)->GetStringUTFChars(env, text, NULL) : NULL;
+    bool ok = Command(cmd, arg1, arg2, text_utf8);
+
+    if (text_utf8)
+        (*env)->ReleaseStringUTFChars(env, text, text_utf8);
+    return ok;
+}
+
+/* Blocks until there are events, and copies up to EVENT_BATCH of them as
+ * (type, arg1, arg2, arg3). Returns their count, or -1 after interrupt(). */
+JNIEXPORT jint JNICALL VLM_NAME(poll)(JNIEnv *env, jclass klz, jlongArray events) {
+    jlong buf[4 * EVENT_BATCH];
+    jsize max = (*env)->GetArrayLength(env, events) / 4;
+    jsize n = 0;
+
+    if (max > EVENT_BATCH)
+        max = EVENT_BATCH;
+    for (;;) {
+        while (n < max && EventGet(buf + 4 * n))
+            n++;
+        if (n > 0)
+            break;
+        if (event_interrupt) {
+            event_interrupt = 0;
+            return -1;
+        }
+        event_waiting = 1;
+        __sync_synchronize();
+        /* a producer may have missed the flag, or taken it already, in
+         * which case it posts the semaphore */
+        if (EventPending() && __sync_bool_compare_and_swap(&event_waiting, 1, 0))
+            continue;
+        vlc_sem_wait(&event_sem);
+    }
+    /* the slots are free, wake the producers waiting for room */
+    __sync_synchronize();
+    if (event_room_waiters) {
+        vlc_mutex_lock(&event_room_lock);
+        vlc_cond_broadcast(&event_room);
+        vlc_mutex_unlock(&event_room_lock);
+    }
+    (*env)->SetLongArrayRegion(env, events, 0, 4 * n, buf);
+    return n;
+}
+
+JNIEXPORT void JNICALL VLM_NAME(interrupt)(JNIEnv *env, jclass klz) {
+    event_interrupt = 1;
+    EventWakeup();
+}
+
+static libvlc_media_t *NewMedia(const char *location) {
+    if (location[0] == '/')
+        return libvlc_media_new_path(vlc, location);
+    return libvlc_media_new_location(vlc, location);
+}
+
+/* Forgets the media of preroll(), the player drops its input by itself */
+static void PrerollReset(void) {
+    if (preroll_media)
+        libvlc_media_release(preroll_media);
+    preroll_media = NULL;
+    free(preroll_location);
+    preroll_location = NULL;
+}
+
+/* Opens the location that open() is likely to get next, so that it starts
+ * at once. location is a local path or an URL. */
+JNIEXPORT jboolean JNICALL VLM_NAME(nativePreroll)(JNIEnv *env, jclass klz, jstring location) {
+    const char *location_utf8 = (*env)->GetStringUTFChars(env, location, NULL);
+    bool ok = false;
+
+    vlc_mutex_lock(&player_lock);
+    if (player) {
+        PrerollReset();
+        preroll_media = NewMedia(location_utf8);
+        preroll_location = strdup(location_utf8);
+        if (preroll_media && preroll_location)
+            ok = libvlc_media_player_preroll(player, preroll_media) == 0;
+        if (!ok) {
+            PrerollReset();
+            libvlc_media_player_preroll(player, NULL);
+        }
+    }
+    vlc_mutex_unlock(&player_lock);
+    (*env)->ReleaseStringUTFChars(env, location, location_utf8);
+    return ok;
+}
+
+/* location is a local path or an URL */
+JNIEXPORT jboolean JNICALL VLM_NAME(nativeOpen)(JNIEnv *env, jclass klz, jstring location) {
+    const char *location_utf8 = (*env)->GetStringUTFChars(env, location, NULL);
+    libvlc_media_t *media;
+    bool ok = false;
+
+    vlc_mutex_lock(&player_lock);
+    if (player) {
+        /* the player starts from the input of preroll() for that media */
+        if (preroll_location && !strcmp(preroll_location, location_utf8)) {
+            media = preroll_media;
+            preroll_media = NULL;
+        }
+        else
+            media = NewMedia(location_utf8);
+        PrerollReset();
+        if (media) {
+            /* only the input is replaced, the outputs stay */
+            libvlc_media_player_set_media(player, media);
+            libvlc_media_release(media);
+            ok = libvlc_media_player_play(player) == 0;
+        }
+    }
+    vlc_mutex_unlock(&player_lock);
+    (*env)->ReleaseStringUTFChars(env, location, location_utf8);
+    Command(COMMAND_INPUT, 0, 0, NULL);
+    return ok;
+}
+
+/* Resumes, or plays the current media again once it is over */
+JNIEXPORT void JNICALL VLM_NAME(nativePlay)(JNIEnv *env, jclass klz) {
+    libvlc_media_t *media;
+
+    vlc_mutex_lock(&player_lock);
+    if (!player) {
+        vlc_mutex_unlock(&player_lock);
+        return;
+    }
+    switch (libvlc_media_player_get_state(player)) {
+    case libvlc_Opening:
+    case libvlc_Buffering:
+    case libvlc_Playing:
+    case libvlc_Paused:
+        vlc_mutex_unlock(&player_lock);
+        /* the interface knows about ff/fb */
+        Command(COMMAND_PLAY, 0, 0, NULL);
+        return;
+    default:
+        break;
+    }
+    media = libvlc_media_player_get_media(player);
+    if (media) {
+        /* drops the finished input but not the outputs, unlike stop */
+        libvlc_media_player_set_media(player, media);
+        libvlc_media_release(media);
+        libvlc_media_player_play(player);
+    }
+    vlc_mutex_unlock(&player_lock);
+    Command(COMMAND_INPUT, 0, 0, NULL);
+}
+
+JNIEXPORT void JNICALL VLM_NAME(nativeStop)(JNIEnv *env, jclass klz) {
+    vlc_mutex_lock(&player_lock);
+    if (player) {
+        libvlc_media_player_stop(player);
+        PrerollReset();
+    }
+    vlc_mutex_unlock(&player_lock);
+}
+
+/* Stops and forgets the media, and the outputs with it */
+JNIEXPORT void JNICALL VLM_NAME(nativeClose)(JNIEnv *env, jclass klz) {
+    vlc_mutex_lock(&player_lock);
+    if (player) {
+        libvlc_media_player_stop(player);
+        libvlc_media_player_set_media(player, NULL);
+        PrerollReset();
+    }
+    vlc_mutex_unlock(&player_lock);
+}
+
+/* Fills stats with the counters of the current media, in the order of
+ * libvlc_media_stats_t, the bitrates in bytes per second. Returns false
+ * if there is no media. */
+JNIEXPORT jboolean JNICALL VLM_NAME(nativeGetStats)(JNIEnv *env, jclass klz, jlongArray stats) {
+    libvlc_media_stats_t st;
+    libvlc_media_t *media = NULL;
+    bool ok = false;
+
+    vlc_mutex_lock(&player_lock);
+    if (player)
+        media = libvlc_media_player_get_media(player);
+    vlc_mutex_unlock(&player_lock);
+    if (media) {
+        ok = libvlc_media_get_stats(media, &st);
+        libvlc_media_release(media);
+    }
+    if (ok) {
+        /* the input stats bitrates are in bytes per microsecond */
+        jlong buf[] = {
+            st.i_read_bytes, st.f_input_bitrate * CLOCK_FREQ,
+            st.i_demux_read_bytes, st.f_demux_bitrate * CLOCK_FREQ,
+            st.i_demux_corrupted, st.i_demux_discontinuity,
+            st.i_decoded_video, st.i_decoded_audio,
+            st.i_displayed_pictures, st.i_lost_pictures,
+            st.i_played_abuffers, st.i_lost_abuffers,
+        };
+        jsize n = (*env)->GetArrayLength(env, stats);
+
+        if (n > (jsize)(sizeof(buf) / sizeof(buf[0])))
+            n = sizeof(buf) / sizeof(buf[0]);
+        (*env)->SetLongArrayRegion(env, stats, 0, n, buf);
+    }
+    return ok;
+}
+
 JNIEXPORT int JNICALL NAME(setenv)(JNIEnv *env, jclass klz, jstring key, jstring val, jboolean overwrite) {
     const char *key_utf8 = (*env)->GetStringUTFChars(env, key, NULL);
     const char *val_utf8 = (*env)->GetStringUTFChars(env, val, NULL);
@@ -85,40 +477,62 @@ JNIEXPORT void JNICALL NAME(detachVideoOutput)(JNIEnv *env, jclass klz) {
     vlc_mutex_unlock(&vout_android_lock);
 }
 
-JNIEXPORT void JNICALL NAME(run)(JNIEnv *env, jobject thiz, jobject args) {
-    jclass clz;
-    jfieldID fid;
+/* Creates the instance, its media player and the notify interface */
+JNIEXPORT jboolean JNICALL NAME(start)(JNIEnv *env, jclass klz, jobject args) {
     jstring arg;
     int i, argc;
     const char **argv;
-    libvlc_instance_t *vlc;
 
-    if (!args)
-        return;
+    if (!args || vlc)
+        return false;
     argc = (*env)->GetArrayLength(env, args);
     if (!argc)
-        return;
+        return false;
     argv = (const char**) malloc(argc * sizeof(char*));
     if (!argv)
-        return;
+        return false;
     for (i = 0; i < argc; i++) {
         arg = (*env)->GetObjectArrayElement(env, args, i);
         argv[i] = (*env)->GetStringUTFChars(env, arg, NULL);
     }
+    vlc_mutex_lock(&player_lock);
     vlc = libvlc_new(argc, argv);
     if (vlc) {
         libvlc_set_user_agent(vlc, "VLC media player", NULL);
-        if (libvlc_add_intf(vlc, NULL) == 0) {
-            libvlc_playlist_play(vlc, -1, 0, NULL);
-            libvlc_wait(vlc);
+        player = libvlc_media_player_new(vlc);
+        if (!player || libvlc_add_intf(vlc, NULL) != 0) {
+            if (player)
+                libvlc_media_player_release(player);
+            player = NULL;
+            libvlc_release(vlc);
+            vlc = NULL;
         }
-        libvlc_release(vlc);
     }
+    vlc_mutex_unlock(&player_lock);
     for (i = 0; i < argc; i++) {
         arg = (*env)->GetObjectArrayElement(env, args, i);
         (*env)->ReleaseStringUTFChars(env, arg, argv[i]);
     }
     free(argv);
+    return vlc != NULL;
+}
+
+JNIEXPORT void JNICALL NAME(release)(JNIEnv *env, jclass klz) {
+    libvlc_media_player_t *mp;
+    libvlc_instance_t *instance;
+
+    vlc_mutex_lock(&player_lock);
+    mp = player;
+    instance = vlc;
+    PrerollReset();
+    player = NULL;
+    vlc = NULL;
+    vlc_mutex_unlock(&player_lock);
+    /* the interfaces go with the last reference to the instance */
+    if (mp)
+        libvlc_media_player_release(mp);
+    if (instance)
+        libvlc_release(instance);
 }
 
 #endif
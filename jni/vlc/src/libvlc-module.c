@@ -355,6 +355,11 @@ static const char *const ppsz_force_dolby_descriptions[] = {
     "This allows to play audio at lower or higher speed without " \
     "affecting the audio pitch" )
 
+#define AUDIO_BENCHMARK_TEXT N_("Audio CPU usage statistics")
+#define AUDIO_BENCHMARK_LONGTEXT N_( \
+    "Log the CPU time spent decoding, filtering and mixing per second " \
+    "of decoded audio." )
+
 
 static const char *const ppsz_replay_gain_mode[] = {
     "none", "track", "album" };
@@ -777,6 +782,11 @@ static const char *const ppsz_clock_descriptions[] =
     "When possible, the input stream will be recorded instead of using " \
     "the stream output module" )
 
+#define INPUT_PREFETCH_TEXT N_("Read-ahead size (kB)")
+#define INPUT_PREFETCH_LONGTEXT N_( \
+    "Amount of data read ahead of the demuxer by a separate thread, so " \
+    "that slow storage does not stall the playback (0 to disable)." )
+
 #define INPUT_TIMESHIFT_PATH_TEXT N_("Timeshift directory")
 #define INPUT_TIMESHIFT_PATH_LONGTEXT N_( \
     "Directory used to store the timeshift temporary files." )
@@ -786,6 +796,12 @@ static const char *const ppsz_clock_descriptions[] =
     "This is the maximum size in bytes of the temporary files " \
     "that will be used to store the timeshifted streams." )
 
+#define INPUT_TIMESHIFT_MEMORY_TEXT N_("Timeshift memory")
+#define INPUT_TIMESHIFT_MEMORY_LONGTEXT N_( \
+    "This is the size in bytes of the most recent part of the timeshifted " \
+    "streams that is kept in memory. Older parts are moved to the " \
+    "temporary files." )
+
 // DEPRECATED
 #define SUB_CAT_LONGTEXT N_( \
     "These options allow you to modify the behavior of the subpictures " \
@@ -1092,6 +1108,11 @@ static const char *const ppsz_clock_descriptions[] =
     "If your processor supports the AltiVec instructions set, VLC can take " \
     "advantage of them.")
 
+#define NEON_TEXT N_("Enable CPU NEON support")
+#define NEON_LONGTEXT N_( \
+    "If your processor supports the ARM NEON instructions set, VLC can take " \
+    "advantage of them.")
+
 // DEPRECATED
 #define MISC_CAT_LONGTEXT N_( \
     "These options allow you to select default modules. Leave these " \
@@ -1623,8 +1644,10 @@ vlc_module_begin ()
     add_bool( "audio-replay-gain-peak-protection", true,
               AUDIO_REPLAY_GAIN_PEAK_PROTECTION_TEXT, AUDIO_REPLAY_GAIN_PEAK_PROTECTION_LONGTEXT, true )
 
-    add_bool( "audio-time-stretch", HAVE_FPU,
+    add_bool( "audio-time-stretch", true,
               AUDIO_TIME_STRETCH_TEXT, AUDIO_TIME_STRETCH_LONGTEXT, false )
+    add_bool( "audio-benchmark", false,
+              AUDIO_BENCHMARK_TEXT, AUDIO_BENCHMARK_LONGTEXT, true )
 
     set_subcategory( SUBCAT_AUDIO_AOUT )
     add_module( "aout", "audio output", NULL, NULL, AOUT_TEXT, AOUT_LONGTEXT,
@@ -1943,10 +1966,15 @@ vlc_module_begin ()
     add_bool( "input-record-native", true, INPUT_RECORD_NATIVE_TEXT,
               INPUT_RECORD_NATIVE_LONGTEXT, true )
 
+    add_integer( "input-prefetch", 0, INPUT_PREFETCH_TEXT,
+                 INPUT_PREFETCH_LONGTEXT, true )
+
     add_string( "input-timeshift-path", NULL, INPUT_TIMESHIFT_PATH_TEXT,
                 INPUT_TIMESHIFT_PATH_LONGTEXT, true )
     add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
                  INPUT_TIMESHIFT_GRANULARITY_LONGTEXT, true )
+    add_integer( "input-timeshift-memory", 8*1024*1024, INPUT_TIMESHIFT_MEMORY_TEXT,
+                 INPUT_TIMESHIFT_MEMORY_LONGTEXT, true )
 
 /* Decoder options */
     add_category_hint( N_("Decoders"), CODEC_CAT_LONGTEXT , true )
@@ -2053,6 +2081,10 @@ vlc_module_begin ()
     add_bool( "altivec", 1, ALTIVEC_TEXT, ALTIVEC_LONGTEXT, true )
         change_need_restart ()
 #endif
+#if defined( __arm__ )
+    add_bool( "neon", 1, NEON_TEXT, NEON_LONGTEXT, true )
+        change_need_restart ()
+#endif
 
 /* Misc options */
     set_subcategory( SUBCAT_ADVANCED_MISC )
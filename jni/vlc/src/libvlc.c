@@ -410,6 +410,16 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
      * list of configuration options exported by each module and loads their
      * default values.
      */
+#if defined( __arm__ )
+    /* The -6/-7 plugin variants are picked from the CPU flags while loading
+     * them, so "neon" must be applied first. Only the main module options
+     * are known here, the command line overrides the config file. */
+    if( !var_InheritBool( p_libvlc, "ignore-config" ) )
+        config_LoadConfigFile( p_libvlc );
+    if( config_LoadCmdLine( p_libvlc, i_argc, ppsz_argv, NULL ) == 0
+     && !var_InheritBool( p_libvlc, "neon" ) )
+        cpu_flags &= ~CPU_CAPABILITY_NEON;
+#endif
     module_LoadPlugins( p_libvlc, builtins_module );
     if( p_libvlc->b_die )
     {
@@ -734,6 +744,8 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
     PRINT_CAPABILITY( CPU_CAPABILITY_ALTIVEC, "AltiVec" );
 
 #elif defined( __arm__ )
+    PRINT_CAPABILITY( CPU_CAPABILITY_ARMv7, "ARMv7" );
+    PRINT_CAPABILITY( CPU_CAPABILITY_VFPv3, "VFPv3" );
     PRINT_CAPABILITY( CPU_CAPABILITY_NEON, "NEONv1" );
 
 #endif
@@ -78,6 +78,9 @@ static void BlockRelease( block_t *p_block )
     free( p_block );
 }
 
+static void block_foreign_Release (block_t *);
+static bool block_foreign_Resize (block_t *, ssize_t, size_t);
+
 static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 {
     out->p_next    = in->p_next;
@@ -151,6 +154,10 @@ block_t *block_Realloc( block_t *p_block, ssize_t i_prebody, size_t i_body )
         return NULL;
     }
 
+    if( p_block->pf_release == block_foreign_Release
+     && block_foreign_Resize( p_block, i_prebody, i_body ) )
+        return p_block;
+
     if( p_block->pf_release != BlockRelease )
     {
         /* Special case when pf_release if overloaded
@@ -307,6 +314,72 @@ block_t *block_heap_Alloc (void *ptr, void *addr, size_t length)
     return &block->self;
 }
 
+typedef struct
+{
+    block_t  self;
+    uint8_t *p_end;
+    void   (*pf_free) (void *);
+    void    *opaque;
+} block_foreign_t;
+
+static void block_foreign_Release (block_t *self)
+{
+    block_foreign_t *block = (block_foreign_t *)self;
+
+    block->pf_free (block->opaque);
+    free (block);
+}
+
+/**
+ * Creates a block from a buffer owned by a third party (typically a library
+ * used by a plugin), so that the data does not need to be copied.
+ *
+ * When block_Release() is called, VLC will call pf_free(opaque).
+ *
+ * If the buffer has writable room after its useful data, block_Realloc()
+ * grows the block in place into that room, instead of copying the data.
+ *
+ * @param opaque owner data passed to pf_free
+ * @param pf_free callback releasing the buffer
+ * @param addr base address of the useful buffer data
+ * @param length bytes length of the useful buffer data
+ * @param padding bytes of writable room following the useful data
+ * @return NULL in case of error (pf_free(opaque) called in that case), or a
+ * valid block_t pointer.
+ */
+block_t *block_foreign_Alloc (void *opaque, void (*pf_free) (void *),
+                              void *addr, size_t length, size_t padding)
+{
+    block_foreign_t *block = malloc (sizeof (*block));
+    if (block == NULL)
+    {
+        pf_free (opaque);
+        return NULL;
+    }
+
+    block_Init (&block->self, (uint8_t *)addr, length);
+    block->self.pf_release = block_foreign_Release;
+    block->p_end = (uint8_t *)addr + length + padding;
+    block->pf_free = pf_free;
+    block->opaque = opaque;
+    return &block->self;
+}
+
+/* Skips head bytes and/or grows the tail within the foreign buffer */
+static bool block_foreign_Resize (block_t *self, ssize_t i_prebody,
+                                  size_t i_body)
+{
+    block_foreign_t *block = (block_foreign_t *)self;
+
+    if (i_prebody > 0 || (size_t)-i_prebody > self->i_buffer)
+        return false;
+    if ((size_t)(block->p_end - (self->p_buffer - i_prebody)) < i_body)
+        return false;
+    self->p_buffer -= i_prebody;
+    self->i_buffer = i_body;
+    return true;
+}
+
 #ifdef HAVE_MMAP
 # include <sys/mman.h>
 
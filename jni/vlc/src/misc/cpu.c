@@ -45,6 +45,10 @@
 
 #include "libvlc.h"
 
+#if HAVE_ANDROID
+#include <cpu-features.h>
+#endif
+
 #if defined(__APPLE__)
 #include <sys/sysctl.h>
 #endif
@@ -266,7 +270,24 @@ out:
 
 #elif defined( __arm__ )
 #   if defined( __ARM_NEON__ )
-    i_capabilities |= CPU_CAPABILITY_NEON;
+    i_capabilities |= CPU_CAPABILITY_NEON | CPU_CAPABILITY_ARMv7;
+#   endif
+#   if HAVE_ANDROID
+    /* The same libvlccore runs on ARMv6 and ARMv7 phones, ask the kernel
+     * (through /proc/cpuinfo) what this one can really do. */
+    if( android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM )
+    {
+        uint64_t i_features = android_getCpuFeatures();
+
+        if( i_features & ANDROID_CPU_ARM_FEATURE_ARMv7 )
+            i_capabilities |= CPU_CAPABILITY_ARMv7;
+        if( i_features & ANDROID_CPU_ARM_FEATURE_VFPv3 )
+            i_capabilities |= CPU_CAPABILITY_VFPv3;
+        if( i_features & ANDROID_CPU_ARM_FEATURE_NEON )
+            i_capabilities |= CPU_CAPABILITY_NEON;
+        else
+            i_capabilities &= ~CPU_CAPABILITY_NEON;
+    }
 #   endif
 
 #elif defined( __powerpc__ ) || defined( __ppc__ ) || defined( __powerpc64__ ) \
@@ -333,6 +354,7 @@ const struct
 #endif
 #if defined (__arm__)
     { CPU_CAPABILITY_NEON,    "arm_neon" },
+    { CPU_CAPABILITY_ARMv7,   "armv7" },
 #endif
 };
 
@@ -355,6 +377,34 @@ unsigned vlc_GetCPUCount(void)
     return count;
 #elif defined(__SYMBIAN32__)
     return 1;
+#elif defined(HAVE_ANDROID)
+    /* Idle cores may be unplugged, so count the present ones rather than the
+     * online ones. The list looks like "0", "0-3" or "0-1,3". */
+    unsigned count = 0;
+    FILE *stream = fopen ("/sys/devices/system/cpu/present", "r");
+    if (stream != NULL)
+    {
+        unsigned first, last;
+        int c;
+
+        while (fscanf (stream, "%u", &first) == 1)
+        {
+            last = first;
+            c = fgetc (stream);
+            if (c == '-')
+            {
+                if (fscanf (stream, "%u", &last) != 1)
+                    break;
+                c = fgetc (stream);
+            }
+            if (last >= first)
+                count += last - first + 1;
+            if (c != ',')
+                break;
+        }
+        fclose (stream);
+    }
+    return count ? count : 1;
 #elif defined(HAVE_SCHED_GETAFFINITY)
     cpu_set_t cpu;
     CPU_ZERO(&cpu);
@@ -169,6 +169,10 @@ void stats_ComputeInputStats( input_thread_t *p_input, input_stats_t *p_stats )
                       &p_stats->i_read_bytes );
     stats_GetFloat( p_input, p_input->p->counters.p_input_bitrate,
                     &p_stats->f_input_bitrate );
+    stats_GetInteger( p_input, p_input->p->counters.p_stream_cache_size,
+                      &p_stats->i_stream_cache_size );
+    stats_GetInteger( p_input, p_input->p->counters.p_stream_cache_resizes,
+                      &p_stats->i_stream_cache_resizes );
     stats_GetInteger( p_input, p_input->p->counters.p_demux_read,
                       &p_stats->i_demux_read_bytes );
     stats_GetFloat( p_input, p_input->p->counters.p_demux_bitrate,
@@ -206,6 +210,8 @@ void stats_ComputeInputStats( input_thread_t *p_input, input_stats_t *p_stats )
                       &p_stats->i_displayed_pictures );
     stats_GetInteger( p_input, p_input->p->counters.p_lost_pictures,
                       &p_stats->i_lost_pictures );
+    stats_GetInteger( p_input, p_input->p->counters.p_copied_pictures,
+                      &p_stats->i_copied_pictures );
 
     vlc_mutex_unlock( &p_stats->lock );
     vlc_mutex_unlock( &p_input->p->counters.counters_lock );
@@ -216,10 +222,12 @@ void stats_ReinitInputStats( input_stats_t *p_stats )
     vlc_mutex_lock( &p_stats->lock );
     p_stats->i_read_packets = p_stats->i_read_bytes =
     p_stats->f_input_bitrate = p_stats->f_average_input_bitrate =
+    p_stats->i_stream_cache_size = p_stats->i_stream_cache_resizes =
     p_stats->i_demux_read_packets = p_stats->i_demux_read_bytes =
     p_stats->f_demux_bitrate = p_stats->f_average_demux_bitrate =
     p_stats->i_demux_corrupted = p_stats->i_demux_discontinuity =
     p_stats->i_displayed_pictures = p_stats->i_lost_pictures =
+    p_stats->i_copied_pictures =
     p_stats->i_played_abuffers = p_stats->i_lost_abuffers =
     p_stats->i_decoded_video = p_stats->i_decoded_audio =
     p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate
@@ -56,11 +56,9 @@
 #include <vlc_fs.h>
 #include "vlc_arrays.h"
 
-#include "modules/modules.h"
+#include <vlc_cpu.h>
 
-#if HAVE_ANDROID
-#include <cpu-features.h>
-#endif
+#include "modules/modules.h"
 
 static module_bank_t *p_module_bank = NULL;
 static vlc_mutex_t module_lock = VLC_STATIC_MUTEX;
@@ -877,17 +875,27 @@ static void AllocatePluginPath( vlc_object_t *p_this, module_bank_t *p_bank,
                                 const char *path, bool b_reset )
 {
     size_t offset = p_module_bank->i_cache;
+    size_t loaded = p_module_bank->i_loaded_cache;
 
     if( b_reset )
         CacheDelete( p_this, path );
     else
         CacheLoad( p_this, p_module_bank, path );
+    loaded = p_module_bank->i_loaded_cache - loaded;
 
     msg_Dbg( p_this, "recursively browsing `%s'", path );
 
     /* Don't go deeper than 5 subdirectories */
+    p_module_bank->b_cache_dirty = false;
     AllocatePluginDir( p_this, p_bank, path, 5 );
 
+    /* Only rewrite the cache if a plugin was added, changed or removed */
+    if( !p_module_bank->b_cache )
+        return;
+    if( !p_module_bank->b_cache_dirty
+     && loaded == p_module_bank->i_cache - offset )
+        return;
+
     CacheSave( p_this, path, p_module_bank->pp_cache + offset,
                p_module_bank->i_cache - offset );
 }
@@ -936,11 +944,11 @@ static void AllocatePluginDir( vlc_object_t *p_this, module_bank_t *p_bank,
          && strncmp (path, "lib", 3)
 #if HAVE_ANDROID
          && ((size_t)pathlen >= sizeof ("_plugin"LIBEXT))) {
-            int flag, arch;
+            int arch;
             char suffix[16];
 
-            flag = android_getCpuFeatures();
-            arch = (flag & ANDROID_CPU_ARM_FEATURE_NEON) ? 7 : 6;
+            /* -7 plugins are built for ARMv7 with NEON, -6 for the others */
+            arch = (vlc_CPU() & CPU_CAPABILITY_NEON) ? 7 : 6;
             sprintf(suffix, "_plugin-%d"LIBEXT, arch);
             if (!strncasecmp (path + pathlen - sizeof ("_plugin"LIBEXT) + 1,
                           "_plugin"LIBEXT, sizeof ("_plugin"LIBEXT))
@@ -983,6 +991,7 @@ static int AllocatePluginFile( vlc_object_t * p_this, module_bank_t *p_bank,
     if( !p_cache_entry )
     {
         p_module = AllocatePlugin( p_this, psz_file );
+        p_bank->b_cache_dirty = true;
     }
     else
     {
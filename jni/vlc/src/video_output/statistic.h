@@ -29,31 +29,52 @@ typedef struct {
 
     int displayed;
     int lost;
+    int copied;
+
+    /* Predicted time between taking a picture and displaying it */
+    mtime_t delay;
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     vlc_spin_init(&stat->spin);
+    stat->delay = 0;
 }
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
 {
     vlc_spin_destroy(&stat->spin);
 }
-static inline void vout_statistic_GetReset(vout_statistic_t *stat, int *displayed, int *lost)
+static inline void vout_statistic_GetReset(vout_statistic_t *stat, int *displayed, int *lost, int *copied)
 {
     vlc_spin_lock(&stat->spin);
     *displayed = stat->displayed;
     *lost      = stat->lost;
+    *copied    = stat->copied;
 
     stat->displayed = 0;
     stat->lost      = 0;
+    stat->copied    = 0;
     vlc_spin_unlock(&stat->spin);
 }
-static inline void vout_statistic_Update(vout_statistic_t *stat, int displayed, int lost)
+static inline void vout_statistic_Update(vout_statistic_t *stat, int displayed, int lost, int copied)
 {
     vlc_spin_lock(&stat->spin);
     stat->displayed += displayed;
     stat->lost      += lost;
+    stat->copied    += copied;
+    vlc_spin_unlock(&stat->spin);
+}
+static inline mtime_t vout_statistic_GetDelay(vout_statistic_t *stat)
+{
+    vlc_spin_lock(&stat->spin);
+    mtime_t delay = stat->delay;
+    vlc_spin_unlock(&stat->spin);
+    return delay;
+}
+static inline void vout_statistic_SetDelay(vout_statistic_t *stat, mtime_t delay)
+{
+    vlc_spin_lock(&stat->spin);
+    stat->delay = delay;
     vlc_spin_unlock(&stat->spin);
 }
 
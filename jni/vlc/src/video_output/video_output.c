@@ -289,9 +289,14 @@ void vout_ChangePause(vout_thread_t *vout, bool is_paused, mtime_t date)
     vout_control_WaitEmpty(&vout->p->control);
 }
 
-void vout_GetResetStatistic(vout_thread_t *vout, int *displayed, int *lost)
+void vout_GetResetStatistic(vout_thread_t *vout, int *displayed, int *lost, int *copied)
 {
-    vout_statistic_GetReset( &vout->p->statistic, displayed, lost );
+    vout_statistic_GetReset( &vout->p->statistic, displayed, lost, copied );
+}
+
+mtime_t vout_GetDisplayDelay(vout_thread_t *vout)
+{
+    return vout_statistic_GetDelay(&vout->p->statistic);
 }
 
 void vout_Flush(vout_thread_t *vout, mtime_t date)
@@ -698,8 +703,12 @@ static int VoutVideoFilterInteractiveAllocationSetup(filter_t *filter, void *dat
     filter->p_owner             = data; /* vout */
     return VLC_SUCCESS;
 }
+static void ThreadRestoreBlended(vout_thread_t *vout);
+
 static void ThreadFilterFlush(vout_thread_t *vout, bool is_locked)
 {
+    ThreadRestoreBlended(vout);
+
     if (vout->p->displayed.current)
         picture_Release( vout->p->displayed.current );
     vout->p->displayed.current = NULL;
@@ -811,6 +820,16 @@ static void ThreadChangeFilters(vout_thread_t *vout,
 }
 
 
+/* Time a picture taken from the decoder fifo now still needs before being
+ * on screen. The low estimations are used so that only the pictures that
+ * cannot be displayed in time are dropped. */
+static mtime_t ThreadDisplayPredictDelay(vout_thread_t *vout)
+{
+    return vout_chrono_GetLow(&vout->p->filter_time) +
+           vout_chrono_GetLow(&vout->p->render) +
+           vout_chrono_GetLow(&vout->p->display_time);
+}
+
 /* */
 static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool is_late_dropped)
 {
@@ -828,9 +847,15 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool is_
         } else {
             decoded = picture_fifo_Pop(vout->p->decoder_fifo);
             if (is_late_dropped && decoded && !decoded->b_force) {
-                const mtime_t predicted = mdate() + 0; /* TODO improve */
+                const mtime_t predicted = mdate() + ThreadDisplayPredictDelay(vout);
                 const mtime_t late = predicted - decoded->date;
-                if (late > VOUT_DISPLAY_LATE_THRESHOLD) {
+                /* Only drop a late picture when another one is already
+                 * queued to replace it, the decoder is told about the
+                 * delay and skips frames itself when it cannot keep up */
+                picture_t *queued = late > VOUT_DISPLAY_LATE_THRESHOLD ?
+                                    picture_fifo_Peek(vout->p->decoder_fifo) : NULL;
+                if (queued) {
+                    picture_Release(queued);
                     msg_Warn(vout, "picture is too late to be displayed (missing %d ms)", (int)(late/1000));
                     picture_Release(decoded);
                     lost_count++;
@@ -855,12 +880,14 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool is_
         vout->p->displayed.is_interlaced = !decoded->b_progressive;
         vout->p->displayed.qtype         = decoded->i_qtype;
 
+        vout_chrono_Start(&vout->p->filter_time);
         picture = filter_chain_VideoFilter(vout->p->filter.chain_static, decoded);
+        vout_chrono_Stop(&vout->p->filter_time);
     }
 
     vlc_mutex_unlock(&vout->p->filter.lock);
 
-    vout_statistic_Update(&vout->p->statistic, 0, lost_count);
+    vout_statistic_Update(&vout->p->statistic, 0, lost_count, 0);
     if (!picture)
         return VLC_EGENERIC;
 
@@ -872,11 +899,115 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool is_
     return VLC_SUCCESS;
 }
 
+/* Returns a picture of the display source format in fast memory, to blend
+ * the subtitles before copying into slow display buffers */
+static picture_t *ThreadGetScratchPicture(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    /* Only one picture is in use at a time while rendering */
+    if (!sys->scratch_pool)
+        sys->scratch_pool = picture_pool_NewFromFormat(&sys->display.vd->source, 1);
+    if (!sys->scratch_pool)
+        return NULL;
+    return picture_pool_Get(sys->scratch_pool);
+}
+
+/* The references the vout thread itself holds on a picture being rendered,
+ * any other one is the decoder's (e.g. a reference frame) */
+static unsigned ThreadPictureOwnRefs(vout_thread_t *vout, const picture_t *picture)
+{
+    unsigned refs = 1;
+
+    if (picture == vout->p->displayed.current)
+        refs++;
+    if (picture == vout->p->displayed.decoded)
+        refs++;
+    return refs;
+}
+
+/* Copies the lines [y, y + height) of the picture from or to buf, the chroma
+ * planes being subsampled in proportion */
+static size_t PictureCopyLines(picture_t *picture, uint8_t *buf,
+                               int y, int height, bool restore)
+{
+    const int lines = picture->p[0].i_lines;
+    size_t size = 0;
+
+    for (int i = 0; i < picture->i_planes; i++) {
+        plane_t *plane = &picture->p[i];
+        const int first = y * plane->i_lines / lines;
+        const int last  = ((y + height) * plane->i_lines + lines - 1) / lines;
+        uint8_t *pixels = &plane->p_pixels[first * plane->i_pitch];
+        const size_t length = (size_t)(last - first) * plane->i_pitch;
+
+        if (buf) {
+            if (restore)
+                vlc_memcpy(pixels, &buf[size], length);
+            else
+                vlc_memcpy(&buf[size], pixels, length);
+        }
+        size += length;
+    }
+    return size;
+}
+
+/* Saves what the subpicture will cover in a picture that is blended in
+ * place, it is restored if the picture has to be rendered again */
+static int ThreadSaveBlended(vout_thread_t *vout, picture_t *picture,
+                             const subpicture_t *subpic)
+{
+    vout_thread_sys_t *sys = vout->p;
+    int top = picture->format.i_height, bottom = 0;
+
+    assert(!sys->blended.picture);
+    for (const subpicture_region_t *r = subpic->p_region; r; r = r->p_next) {
+        top    = __MIN(top, r->i_y);
+        bottom = __MAX(bottom, r->i_y + (int)r->fmt.i_visible_height);
+    }
+    top    = __MAX(top, 0);
+    bottom = __MIN(bottom, (int)picture->format.i_height);
+    if (top >= bottom)
+        return VLC_SUCCESS;
+
+    const size_t size = PictureCopyLines(picture, NULL, top, bottom - top, false);
+    if (size > sys->blended.size) {
+        uint8_t *pixels = realloc(sys->blended.pixels, size);
+        if (!pixels)
+            return VLC_ENOMEM;
+        sys->blended.pixels = pixels;
+        sys->blended.size   = size;
+    }
+    PictureCopyLines(picture, sys->blended.pixels, top, bottom - top, false);
+    sys->blended.picture = picture_Hold(picture);
+    sys->blended.y       = top;
+    sys->blended.height  = bottom - top;
+    return VLC_SUCCESS;
+}
+
+/* Removes the subtitles blended into a picture the vout still holds */
+static void ThreadRestoreBlended(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+    picture_t *picture = sys->blended.picture;
+
+    if (!picture)
+        return;
+    if (picture->i_refcount > 1)
+        PictureCopyLines(picture, sys->blended.pixels,
+                         sys->blended.y, sys->blended.height, true);
+    picture_Release(picture);
+    sys->blended.picture = NULL;
+}
+
 static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 {
     vout_thread_sys_t *sys = vout->p;
     vout_display_t *vd = vout->p->display.vd;
 
+    /* The previous render may have blended into the current picture */
+    ThreadRestoreBlended(vout);
+
     picture_t *torender = picture_Hold(vout->p->displayed.current);
 
     vout_chrono_Start(&vout->p->render);
@@ -958,22 +1089,34 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
      */
     bool is_direct;
     picture_t *todisplay;
+    int copied = 0;
 
     if (filtered && do_early_spu && subpic) {
-        if (vd->info.is_slow) {
-            is_direct = false;
-            todisplay = picture_NewFromFormat(&vd->source); /* FIXME a pool ? */
+        /* Once the decoder is done with the picture, nobody else reads it:
+         * blend into it, keeping what is needed to show it again */
+        const bool is_own = filtered->pf_release && !sys->is_decoder_pool_slow &&
+                            filtered->i_refcount <= ThreadPictureOwnRefs(vout, filtered);
+        if (is_own && (filtered->i_refcount == 1 ||
+                       !ThreadSaveBlended(vout, filtered, subpic))) {
+            is_direct = vout->p->decoder_pool == vout->p->display_pool;
+            todisplay = filtered;
         } else {
-            is_direct = true;
-            todisplay = picture_pool_Get(vout->p->display_pool);
-        }
-        if (todisplay) {
-            VideoFormatCopyCropAr(&todisplay->format, &filtered->format);
-            picture_Copy(todisplay, filtered);
-            if (vout->p->spu_blend)
-                picture_BlendSubpicture(todisplay, vout->p->spu_blend, subpic);
+            if (vd->info.is_slow) {
+                is_direct = false;
+                todisplay = ThreadGetScratchPicture(vout);
+            } else {
+                is_direct = true;
+                todisplay = picture_pool_Get(vout->p->display_pool);
+            }
+            if (todisplay) {
+                VideoFormatCopyCropAr(&todisplay->format, &filtered->format);
+                picture_Copy(todisplay, filtered);
+                copied++;
+            }
+            picture_Release(filtered);
         }
-        picture_Release(filtered);
+        if (todisplay && vout->p->spu_blend)
+            picture_BlendSubpicture(todisplay, vout->p->spu_blend, subpic);
         subpicture_Delete(subpic);
         subpic = NULL;
 
@@ -990,6 +1133,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         if (direct) {
             VideoFormatCopyCropAr(&direct->format, &todisplay->format);
             picture_Copy(direct, todisplay);
+            copied++;
         }
         picture_Release(todisplay);
     } else {
@@ -1042,18 +1186,22 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     if (delay < 1000)
         msg_Warn(vout, "picture is late (%lld ms)", delay / 1000);
 #endif
+    /* Start displaying early enough for the picture to be shown on time */
     if (!is_forced)
-        mwait(direct->date);
+        mwait(direct->date - vout_chrono_GetLow(&vout->p->display_time));
 
     /* Display the direct buffer returned by vout_RenderPicture */
     vout->p->displayed.date = mdate();
+    vout_chrono_Start(&vout->p->display_time);
     vout_display_Display(vd,
                          sys->display.filtered ? sys->display.filtered
                                                 : direct,
                          subpic);
+    vout_chrono_Stop(&vout->p->display_time);
     sys->display.filtered = NULL;
 
-    vout_statistic_Update(&vout->p->statistic, 1, 0);
+    vout_statistic_Update(&vout->p->statistic, 1, 0, copied);
+    vout_statistic_SetDelay(&vout->p->statistic, ThreadDisplayPredictDelay(vout));
 
     return VLC_SUCCESS;
 }
@@ -1074,7 +1222,9 @@ static int ThreadDisplayPicture(vout_thread_t *vout,
     }
 
     const mtime_t date = mdate();
-    const mtime_t render_delay = vout_chrono_GetHigh(&vout->p->render) + VOUT_MWAIT_TOLERANCE;
+    const mtime_t render_delay = vout_chrono_GetHigh(&vout->p->render) +
+                                 vout_chrono_GetLow(&vout->p->display_time) +
+                                 VOUT_MWAIT_TOLERANCE;
 
     mtime_t date_next = VLC_TS_INVALID;
     if (!vout->p->pause.is_on && vout->p->displayed.next)
@@ -1404,7 +1554,9 @@ static void ThreadInit(vout_thread_t *vout)
     vout->p->pause.is_on      = false;
     vout->p->pause.date       = VLC_TS_INVALID;
 
+    vout_chrono_Init(&vout->p->filter_time, 5, 0);
     vout_chrono_Init(&vout->p->render, 5, 10000); /* Arbitrary initial time */
+    vout_chrono_Init(&vout->p->display_time, 5, 0);
 }
 
 static void ThreadClean(vout_thread_t *vout)
@@ -1413,7 +1565,9 @@ static void ThreadClean(vout_thread_t *vout)
         assert(vout->p->window.is_unused);
         vout_window_Delete(vout->p->window.object);
     }
+    vout_chrono_Clean(&vout->p->filter_time);
     vout_chrono_Clean(&vout->p->render);
+    vout_chrono_Clean(&vout->p->display_time);
     vout->p->dead = true;
     vout_control_Dead(&vout->p->control);
 }
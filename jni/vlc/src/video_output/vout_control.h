@@ -38,8 +38,15 @@ void spu_OffsetSubtitleDate( spu_t *p_spu, mtime_t i_duration );
 
 /**
  * This function will return and reset internal statistics.
+ * pi_copied is the number of full picture copies done while rendering.
  */
-void vout_GetResetStatistic( vout_thread_t *p_vout, int *pi_displayed, int *pi_lost );
+void vout_GetResetStatistic( vout_thread_t *p_vout, int *pi_displayed, int *pi_lost, int *pi_copied );
+
+/**
+ * This function will return the time the video output predicts it needs
+ * between taking a decoded picture and displaying it.
+ */
+mtime_t vout_GetDisplayDelay( vout_thread_t *p_vout );
 
 /**
  * This function will ensure that all ready/displayed pciture have at most
@@ -135,9 +135,19 @@ struct vout_thread_sys_t
     picture_pool_t  *private_pool;
     picture_pool_t  *display_pool;
     picture_pool_t  *decoder_pool;
+    picture_pool_t  *scratch_pool;                /**< subtitle blending pool */
     picture_fifo_t  *decoder_fifo;
+    struct {
+        picture_t   *picture;       /**< picture blended in place */
+        int         y;              /**< lines covered by its subtitles */
+        int         height;
+        uint8_t     *pixels;        /**< their content before blending */
+        size_t      size;
+    } blended;
     bool            is_decoder_pool_slow;
+    vout_chrono_t   filter_time;      /**< static filters time estimator */
     vout_chrono_t   render;           /**< picture render time estimator */
+    vout_chrono_t   display_time;     /**< picture display time estimator */
 };
 
 /* TODO to move them to vlc_vout.h */
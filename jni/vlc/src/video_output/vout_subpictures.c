@@ -1607,6 +1607,20 @@ void spu_ChangeFilters( spu_t *p_spu, const char *psz_filters )
     vlc_mutex_unlock( &p_sys->lock );
 }
 
+input_thread_t *spu_HoldInput( spu_t *p_spu )
+{
+    spu_private_t *p_sys = p_spu->p;
+
+    /* The sub filters run with the chain lock only, see spu_Render() */
+    vlc_mutex_lock( &p_sys->lock );
+    vlc_object_t *p_input = p_sys->p_input;
+    if( p_input )
+        vlc_object_hold( p_input );
+    vlc_mutex_unlock( &p_sys->lock );
+
+    return (input_thread_t *)p_input;
+}
+
 void spu_ChangeMargin( spu_t *p_spu, int i_margin )
 {
     spu_private_t *p_sys = p_spu->p;
@@ -164,6 +164,10 @@ int vout_InitWrapper(vout_thread_t *vout)
         sys->is_decoder_pool_slow = false;
     }
     sys->private_pool = picture_pool_Reserve(sys->decoder_pool, private_picture);
+    sys->scratch_pool = NULL;
+    sys->blended.picture = NULL;
+    sys->blended.pixels = NULL;
+    sys->blended.size = 0;
     sys->display.filtered = NULL;
     return VLC_SUCCESS;
 }
@@ -178,6 +182,10 @@ void vout_EndWrapper(vout_thread_t *vout)
     assert(!sys->display.filtered);
     if (sys->private_pool)
         picture_pool_Delete(sys->private_pool);
+    if (sys->scratch_pool)
+        picture_pool_Delete(sys->scratch_pool);
+    assert(!sys->blended.picture);
+    free(sys->blended.pixels);
 
     if (sys->decoder_pool != sys->display_pool) {
         NoDrClean(vout);
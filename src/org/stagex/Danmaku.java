@@ -1,73 +1,166 @@
 package org.stagex;
 
 import java.io.BufferedReader;
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
 import java.io.File;
+import java.io.FileInputStream;
 import java.io.FileOutputStream;
+import java.io.FileReader;
+import java.io.FileWriter;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.InputStreamReader;
 import java.io.OutputStream;
-import java.util.ArrayList;
+import java.util.zip.CRC32;
 
 import org.stagex.helper.SystemUtility;
 import org.videolan.VLC;
 import org.videolan.VLM;
 
 import android.app.Application;
-import android.content.res.AssetManager;
 
 public class Danmaku extends Application {
 
-	protected boolean initialize() {
-		// prepare, orz
-		String root = super.getCacheDir().getAbsolutePath();
+	// name of the file holding the checksum of the extracted index.txt
+	private static final String STAMP = ".index";
+
+	private static byte[] readAll(InputStream is) throws IOException {
+		ByteArrayOutputStream os = new ByteArrayOutputStream();
+		byte[] buffer = new byte[32768];
 		try {
-			ArrayList<String> list = new ArrayList<String>();
-			AssetManager asset = getAssets();
-			InputStream is = asset.open("index.txt");
-			InputStreamReader ir = new InputStreamReader(is);
-			BufferedReader br = new BufferedReader(ir);
+			while (true) {
+				int rc = is.read(buffer);
+				if (rc <= 0)
+					break;
+				os.write(buffer, 0, rc);
+			}
+		} finally {
+			is.close();
+		}
+		return os.toByteArray();
+	}
+
+	private static long checksum(File file) {
+		CRC32 crc = new CRC32();
+		byte[] buffer = new byte[32768];
+		try {
+			InputStream is = new FileInputStream(file);
 			try {
-				while (br.ready()) {
-					String line = br.readLine();
-					list.add(line);
+				while (true) {
+					int rc = is.read(buffer);
+					if (rc <= 0)
+						break;
+					crc.update(buffer, 0, rc);
 				}
 			} finally {
-				br.close();
-				ir.close();
 				is.close();
 			}
-			for (String file : list) {
-				String path = String.format("%s/%s", root, file);
-				String parent = path.substring(0, path.lastIndexOf('/'));
-				File test = new File(parent);
-				if (!test.isDirectory()) {
-					test.mkdirs();
-					if (!test.isDirectory())
-						return false;
+		} catch (IOException e) {
+			return -1;
+		}
+		return crc.getValue();
+	}
+
+	private static String readStamp(File file) {
+		try {
+			BufferedReader br = new BufferedReader(new FileReader(file));
+			try {
+				return br.readLine();
+			} finally {
+				br.close();
+			}
+		} catch (IOException e) {
+			return null;
+		}
+	}
+
+	private void extract(String name, File file) throws IOException {
+		// write aside then rename, so that an interrupted copy is never
+		// taken for a good one
+		File temp = new File(file.getPath() + ".tmp");
+		byte[] buffer = new byte[32768];
+		InputStream is = getAssets().open(name);
+		OutputStream os = new FileOutputStream(temp);
+		try {
+			while (true) {
+				int rc = is.read(buffer);
+				if (rc <= 0)
+					break;
+				os.write(buffer, 0, rc);
+			}
+		} finally {
+			os.close();
+			is.close();
+		}
+		if (!temp.renameTo(file))
+			throw new IOException("cannot rename " + temp.getPath());
+	}
+
+	// each line of index.txt is "path<TAB>crc32<TAB>size", files are only
+	// rewritten when their checksum changed so that their dates, and thus
+	// the plugins cache, remain valid across updates of the package
+	private boolean extractAssets(String root) throws IOException {
+		byte[] index = readAll(getAssets().open("index.txt"));
+		CRC32 crc = new CRC32();
+		crc.update(index);
+		String version = Long.toHexString(crc.getValue());
+		File stamp = new File(root, STAMP);
+		// same package as last time, only check the files are still there
+		boolean fresh = version.equals(readStamp(stamp));
+		BufferedReader br = new BufferedReader(new InputStreamReader(
+				new ByteArrayInputStream(index)));
+		try {
+			while (true) {
+				String line = br.readLine();
+				if (line == null)
+					break;
+				if (line.length() == 0)
+					continue;
+				String[] fields = line.split("\t");
+				long sum = fields.length > 1 ? Long.parseLong(fields[1], 16)
+						: -1;
+				long size = fields.length > 2 ? Long.parseLong(fields[2]) : -1;
+				File file = new File(root, fields[0]);
+				if (file.isFile() && (size < 0 || file.length() == size)) {
+					if (fresh)
+						continue;
+					if (sum >= 0 && checksum(file) == sum)
+						continue;
 				}
-				test = new File(path);
-				// if (test.exists())
-				// continue;
-				byte[] buffer = new byte[32768];
-				is = asset.open(file);
-				OutputStream os = new FileOutputStream(path);
-				try {
-					while (true) {
-						int rc = is.read(buffer);
-						if (rc <= 0)
-							break;
-						os.write(buffer, 0, rc);
-					}
-				} finally {
-					os.close();
-					is.close();
+				File parent = file.getParentFile();
+				if (!parent.isDirectory()) {
+					parent.mkdirs();
+					if (!parent.isDirectory())
+						return false;
 				}
+				extract(fields[0], file);
 			}
+		} finally {
+			br.close();
+		}
+		if (!fresh) {
+			FileWriter fw = new FileWriter(stamp);
+			try {
+				fw.write(version + "\n");
+			} finally {
+				fw.close();
+			}
+		}
+		return true;
+	}
+
+	protected boolean initialize() {
+		// prepare, orz
+		String root = super.getCacheDir().getAbsolutePath();
+		try {
+			if (!extractAssets(root))
+				return false;
 		} catch (IOException e) {
 			return false;
 		}
 		// start VLC
+		VLC.load(root);
 		String libd = String.format("%s/lib", root);
 		VLC.setenv("VLC_PLUGIN_PATH", libd, true);
 		String conf = String.format("%s/etc/vlcrc.3", root);
@@ -81,10 +174,11 @@ public class Danmaku extends Application {
 				.format("vout_android-%d", test.exists() ? code : 5);
 		VLC.getInstance().create(
 				new String[] { "--verbose", "3", "--no-ignore-config",
-						"--config", conf, "--no-plugins-cache", "--intf",
-						"notify", "--aout", aout, "--vout", vout });
+						"--config", conf, "--intf",
+						"notify", "--aout", aout, "--vout", vout,
+						"--input-timeshift-path", root });
 		// start VLM
-		VLM.getInstance().create(new String[] { "127.0.0.1", "21178" });
+		VLM.getInstance().create();
 
 		return true;
 	}
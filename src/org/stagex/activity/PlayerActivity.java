@@ -19,6 +19,7 @@ import android.view.View;
 import android.view.View.OnClickListener;
 import android.widget.ImageButton;
 import android.widget.SeekBar;
+import android.widget.SeekBar.OnSeekBarChangeListener;
 import android.widget.TextView;
 
 public class PlayerActivity extends Activity implements VLI {
@@ -38,6 +39,7 @@ public class PlayerActivity extends Activity implements VLI {
 
 	private ArrayList<String> mPlayList = null;
 	private int mCurrentIndex = -1;
+	private int mPrerollIndex = -1;
 
 	private int mCurrentState = -1;
 	private int mCurrentTime = -1;
@@ -46,6 +48,10 @@ public class PlayerActivity extends Activity implements VLI {
 	private int mCanSeek = -1;
 	private int mCanPause = -1;
 
+	/* scrubbing: one fast seek in flight at a time, precise on release */
+	private boolean mSeeking = false;
+	private int mSeekPending = -1;
+
 	private int mDisplayWidth = -1;
 	private int mDisplayHeight = -1;
 	private int mVideoWidth = -1;
@@ -59,7 +65,7 @@ public class PlayerActivity extends Activity implements VLI {
 				VLC.attachVideoOutput(surface);
 				if (mPlayList != null && mCurrentIndex >= 0
 						&& mCurrentIndex < mPlayList.size()) {
-					VLM.getInstance().open("file://" + mPlayList.get(mCurrentIndex));
+					VLM.getInstance().open(mPlayList.get(mCurrentIndex));
 				}
 				break;
 			}
@@ -79,6 +85,7 @@ public class PlayerActivity extends Activity implements VLI {
 				switch (state) {
 				case VLI.EVENT_INPUT_STATE_PLAY: {
 					mImageButtonPlay.setImageResource(R.drawable.pause);
+					prerollNext();
 					break;
 				}
 				case VLI.EVENT_INPUT_STATE_PAUSE: {
@@ -135,6 +142,15 @@ public class PlayerActivity extends Activity implements VLI {
 				}
 				break;
 			}
+			case VLI.EVENT_INPUT_SEEK_DONE: {
+				mSeeking = false;
+				if (mSeekPending != -1) {
+					mSeeking = true;
+					VLM.getInstance().seek(mSeekPending, true);
+					mSeekPending = -1;
+				}
+				break;
+			}
 			case VLI.EVENT_INPUT_VOUT: {
 				mVideoWidth = msg.arg1;
 				mVideoHeight = msg.arg2;
@@ -146,6 +162,18 @@ public class PlayerActivity extends Activity implements VLI {
 		}
 	};
 
+	/* the next button is the likely way out, open its item ahead of time */
+	private void prerollNext() {
+		if (mCurrentIndex == -1 || mPlayList == null
+				|| mPlayList.size() <= 1)
+			return;
+		int next = (mCurrentIndex + 1) % mPlayList.size();
+		if (next == mPrerollIndex)
+			return;
+		mPrerollIndex = next;
+		VLM.getInstance().preroll(mPlayList.get(next));
+	}
+
 	@Override
 	public void onCreate(Bundle savedInstanceState) {
 		super.onCreate(savedInstanceState);
@@ -184,6 +212,32 @@ public class PlayerActivity extends Activity implements VLI {
 		});
 		mTextViewTime = (TextView) findViewById(R.id.time);
 		mSeekBar = (SeekBar) findViewById(R.id.seekbar);
+		mSeekBar.setOnSeekBarChangeListener(new OnSeekBarChangeListener() {
+			@Override
+			public void onProgressChanged(SeekBar seekBar, int progress,
+					boolean fromUser) {
+				if (!fromUser || mCanSeek != 1)
+					return;
+				if (mSeeking)
+					mSeekPending = progress;
+				else {
+					mSeeking = true;
+					VLM.getInstance().seek(progress, true);
+				}
+			}
+
+			@Override
+			public void onStartTrackingTouch(SeekBar seekBar) {
+			}
+
+			@Override
+			public void onStopTrackingTouch(SeekBar seekBar) {
+				if (mCanSeek != 1)
+					return;
+				mSeekPending = -1;
+				VLM.getInstance().seek(seekBar.getProgress(), false);
+			}
+		});
 		mTextViewLength = (TextView) findViewById(R.id.length);
 		mImageButtonPrev = (ImageButton) findViewById(R.id.prev);
 		mImageButtonPrev.setOnClickListener(new OnClickListener() {
@@ -194,11 +248,18 @@ public class PlayerActivity extends Activity implements VLI {
 					mCurrentIndex--;
 					if (mCurrentIndex < 0)
 						mCurrentIndex = 0;
-					VLM.getInstance().open("file://" + mPlayList.get(mCurrentIndex));
+					VLM.getInstance().open(mPlayList.get(mCurrentIndex));
 				}
 			}
 		});
 		mImageButtonBackward = (ImageButton) findViewById(R.id.backward);
+		mImageButtonBackward.setOnClickListener(new OnClickListener() {
+			@Override
+			public void onClick(View v) {
+				if (mCanSeek == 1)
+					VLM.getInstance().fastBackward();
+			}
+		});
 		mImageButtonStop = (ImageButton) findViewById(R.id.stop);
 		mImageButtonStop.setOnClickListener(new OnClickListener() {
 			@Override
@@ -219,6 +280,13 @@ public class PlayerActivity extends Activity implements VLI {
 			}
 		});
 		mImageButtonForward = (ImageButton) findViewById(R.id.forward);
+		mImageButtonForward.setOnClickListener(new OnClickListener() {
+			@Override
+			public void onClick(View v) {
+				if (mCanSeek == 1)
+					VLM.getInstance().fastForward();
+			}
+		});
 		mImageButtonNext = (ImageButton) findViewById(R.id.next);
 		mImageButtonNext.setOnClickListener(new OnClickListener() {
 			@Override
@@ -228,7 +296,7 @@ public class PlayerActivity extends Activity implements VLI {
 					mCurrentIndex++;
 					if (mCurrentIndex >= mPlayList.size())
 						mCurrentIndex %= mPlayList.size();
-					VLM.getInstance().open("file://" + mPlayList.get(mCurrentIndex));
+					VLM.getInstance().open(mPlayList.get(mCurrentIndex));
 				}
 			}
 		});
@@ -264,42 +332,37 @@ public class PlayerActivity extends Activity implements VLI {
 
 	}
 
-	public void onStateChange(final String module, final String name,
-			final String value) {
-		if (module.compareTo("input") == 0) {
-			if (name.compareTo("time") == 0) {
-				Message msg = new Message();
-				msg.what = VLI.EVENT_INPUT_POSITION;
-				msg.arg1 = Integer.parseInt(value);
-				mEventHandler.sendMessage(msg);
-			} else if (name.compareTo("state") == 0) {
-				Message msg = new Message();
-				msg.what = VLI.EVENT_INPUT_STATE;
-				msg.arg1 = Integer.parseInt(value);
-				mEventHandler.sendMessage(msg);
-			} else if (name.compareTo("length") == 0) {
-				Message msg = new Message();
-				msg.what = VLI.EVENT_INPUT_LENGTH;
-				msg.arg1 = Integer.parseInt(value);
-				mEventHandler.sendMessage(msg);
-			} else if (name.compareTo("can-seek") == 0) {
-				mCanSeek = Integer.parseInt(value);
-			} else if (name.compareTo("can-pause") == 0) {
-				mCanPause = Integer.parseInt(value);
-			}
-		} else if (module.compareTo("video") == 0) {
-			if (name.compareTo("size") == 0) {
-				String[] temp = value.split("x");
-				if (temp.length == 2) {
-					int width = Integer.parseInt(temp[0]);
-					int height = Integer.parseInt(temp[1]);
-					Message msg = new Message();
-					msg.what = VLI.EVENT_INPUT_VOUT;
-					msg.arg1 = width;
-					msg.arg2 = height;
-					mEventHandler.sendMessage(msg);
-				}
-			}
+	public void onEvent(int event, long arg1, long arg2, long arg3) {
+		switch (event) {
+		case VLI.EVENT_INPUT_POSITION:
+		case VLI.EVENT_INPUT_STATE:
+		case VLI.EVENT_INPUT_LENGTH:
+		case VLI.EVENT_INPUT_VOUT: {
+			Message msg = new Message();
+			msg.what = event;
+			msg.arg1 = (int) arg1;
+			msg.arg2 = (int) arg2;
+			mEventHandler.sendMessage(msg);
+			break;
+		}
+		case VLI.EVENT_INPUT_CAN_SEEK: {
+			mCanSeek = (int) arg1;
+			break;
+		}
+		case VLI.EVENT_INPUT_CAN_PAUSE: {
+			mCanPause = (int) arg1;
+			break;
+		}
+		case VLI.EVENT_INPUT_SEEK_DONE: {
+			Log.d("faplayer", String.format("seek %d %s %d ms", arg1,
+					arg3 != 0 ? "fast" : "precise", arg2));
+			Message msg = new Message();
+			msg.what = VLI.EVENT_INPUT_SEEK_DONE;
+			mEventHandler.sendMessage(msg);
+			break;
+		}
+		default:
+			break;
 		}
 	}
 }
@@ -12,6 +12,8 @@ public class SystemUtility {
 
 	private static int mArmArchitecture = -1;
 
+	private static int mArmVariant = -1;
+
 	public static int getArmArchitecture() {
 		if (mArmArchitecture != -1)
 			return mArmArchitecture;
@@ -47,6 +49,48 @@ public class SystemUtility {
 		return mArmArchitecture;
 	}
 
+	private static boolean hasFeature(String feature) {
+		try {
+			InputStream is = new FileInputStream("/proc/cpuinfo");
+			InputStreamReader ir = new InputStreamReader(is);
+			BufferedReader br = new BufferedReader(ir);
+			try {
+				String line;
+				while ((line = br.readLine()) != null) {
+					String[] pair = line.split(":");
+					if (pair.length != 2)
+						continue;
+					if (pair[0].trim().compareToIgnoreCase("Features") != 0)
+						continue;
+					for (String f : pair[1].trim().split("\\s+")) {
+						if (f.compareToIgnoreCase(feature) == 0)
+							return true;
+					}
+					break;
+				}
+			} finally {
+				br.close();
+				ir.close();
+				is.close();
+			}
+		} catch (Exception e) {
+		}
+		return false;
+	}
+
+	/* the -7 libraries are built for ARMv7 with NEON, which e.g. Tegra 2
+	 * lacks, the -6 ones run everywhere. libvlccore makes the same choice
+	 * for its plugins. */
+	public static int getArmVariant() {
+		if (mArmVariant != -1)
+			return mArmVariant;
+		if (getArmArchitecture() >= 7 && hasFeature("neon"))
+			mArmVariant = 7;
+		else
+			mArmVariant = 6;
+		return mArmVariant;
+	}
+
 	public static int getSDKVersionCode() {
 		// TODO: fix this
 		return Build.VERSION.SDK_INT;
@@ -1,16 +1,32 @@
 package org.videolan;
 
+import java.io.File;
+
 import org.stagex.helper.SystemUtility;
 
+import android.util.Log;
 import android.view.Surface;
 
 public class VLC {
 
-	static {
-		System.loadLibrary("vlccore");
-		int arch = SystemUtility.getArmArchitecture();
+	private static boolean mLoaded = false;
+
+	/* must be called before any native method, root being where the assets
+	 * were extracted. The ARMv7 core ships as core/armv7/libvlccore.so so
+	 * that the plugins, linked against libvlccore.so, bind to it. */
+	public static void load(String root) {
+		if (mLoaded)
+			return;
+		int arch = SystemUtility.getArmVariant();
+		File core = new File(String.format("%s/core/armv%d/libvlccore.so",
+				root, arch));
+		if (core.exists())
+			System.load(core.getAbsolutePath());
+		else
+			System.loadLibrary("vlccore");
 		String ffmpeg = String.format("ffmpeg-%d", arch);
 		System.loadLibrary(ffmpeg);
+		mLoaded = true;
 	}
 
 	private static VLC mInstance = null;
@@ -24,7 +40,10 @@ public class VLC {
 	
 	public static native int setenv(String key, String val, boolean overwrite);
 
-	private native void run(String[] args);
+	/* creates libvlc, its media player and the notify interface */
+	private static native boolean start(String[] args);
+
+	private static native void release();
 
 	public static native void attachVideoOutput(Surface surface);
 
@@ -42,13 +61,21 @@ public class VLC {
 		mVLCMain = new Thread(new Runnable() {
 			@Override
 			public void run() {
-				VLC.this.run(args);
+				if (!start(args))
+					Log.e("faplayer-java", "cannot start libvlc");
 			}
 		});
 		mVLCMain.start();
 	}
 
 	public void destroy() {
-		// ...
+		if (mVLCMain == null)
+			return;
+		try {
+			mVLCMain.join();
+		} catch (InterruptedException e) {
+		}
+		mVLCMain = null;
+		release();
 	}
 }
@@ -10,6 +10,13 @@ public interface VLI {
 	public final static int EVENT_INPUT_POSITION = 4;
 	public final static int EVENT_INPUT_LENGTH = 5;
 	public final static int EVENT_INPUT_VOUT = 23;
+	/* target (ms), latency (ms), fast */
+	public final static int EVENT_INPUT_SEEK_DONE = 1101;
+	public final static int EVENT_INPUT_CAN_PAUSE = 1102;
+	public final static int EVENT_INPUT_CAN_SEEK = 1103;
+	public final static int EVENT_INPUT_SPEED = 1104;
+	/* command, error, detail */
+	public final static int EVENT_INPUT_ERROR = 1105;
 
 	public final static int EVENT_INPUT_STATE_INIT = 0;
 	public final static int EVENT_INPUT_STATE_OPEN = 1;
@@ -18,6 +25,11 @@ public interface VLI {
 	public final static int EVENT_INPUT_STATE_END = 4;
 	public final static int EVENT_INPUT_STATE_ERROR = 5;
 
-	public void onStateChange(final String module, final String name, final String value);
+	public final static int ERROR_NO_INPUT = 1;
+	public final static int ERROR_CANNOT_SEEK = 2;
+	public final static int ERROR_BAD_ARGUMENT = 3;
+
+	/* called on the VLM thread */
+	public void onEvent(int event, long arg1, long arg2, long arg3);
 
 }
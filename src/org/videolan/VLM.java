@@ -1,136 +1,55 @@
 package org.videolan;
 
-import java.io.IOException;
-import java.io.UnsupportedEncodingException;
-import java.net.InetSocketAddress;
-import java.nio.ByteBuffer;
-import java.nio.channels.SelectionKey;
-import java.nio.channels.Selector;
-import java.nio.channels.SocketChannel;
-import java.util.Iterator;
-
 import android.util.Log;
 
 public class VLM {
 
+	/* keep in sync with modules/control/notify.c, the others are run by
+	 * the media player directly */
+	private final static int COMMAND_PAUSE = 4;
+	private final static int COMMAND_SEEK = 6;
+	private final static int COMMAND_FAST_FORWARD = 7;
+	private final static int COMMAND_FAST_BACKWARD = 8;
+
+	private final static int SEEK_FAST = 1;
+	private final static int SEEK_PRECISE = 2;
+
+	/* events are (type, arg1, arg2, arg3) */
+	private final static int EVENT_BATCH = 64;
+
 	private static VLM mInstance;
 
 	private VLI mCallbackHandler = null;
 
 	private Thread mVLMThread = null;
 
-	private ByteBuffer mSendBuffer = ByteBuffer.allocate(512);
-	private ByteBuffer mRecvBuffer = ByteBuffer.allocate(512);
-	private Selector mSelector;
-	private SocketChannel mClientChannel = null;
-
-	private int mLineOffset = 0;
-	private int mLineLength = 0;
-	private byte[] mLineBuffer = new byte[512];
-
 	protected VLM() {
 	}
 
-	protected void triggerCallback(String line) {
-		if (line == null || line.length() == 0 || mCallbackHandler == null)
-			return;
-		// TODO: quote
-		String[] temp = line.split("\\s+");
-		if (temp.length != 3)
-			return;
-		mCallbackHandler.onStateChange(temp[0], temp[1], temp[2]);
-	}
+	/* runs cmd on the interface thread, false if there is no interface */
+	private static native boolean command(int cmd, long arg1, long arg2,
+			String text);
 
-	protected boolean wantRead() {
-		return true;
-	}
+	/* waits for events, returns their count, or -1 after interrupt() */
+	private static native int poll(long[] events);
 
-	protected boolean wantWrite() {
-		synchronized (mSendBuffer) {
-			return (mSendBuffer.position() > 0);
-		}
-	}
+	private static native void interrupt();
 
-	protected void doRead() throws IOException {
-		synchronized (mRecvBuffer) {
-			mRecvBuffer.clear();
-			int read = mClientChannel.read(mRecvBuffer);
-			if (read == 0)
-				return;
-			mRecvBuffer.flip();
-			while (mRecvBuffer.position() != mRecvBuffer.limit()) {
-				byte ch = mRecvBuffer.get();
-				mLineBuffer[(mLineOffset + mLineLength++) % mLineBuffer.length] = ch;
-				if ((ch == '\n' || ch == '\r' || ch == '\0')
-						|| (mLineLength == mLineBuffer.length)) {
-					if ((ch == '\n' || ch == '\r' || ch == '\0'))
-						mLineLength -= 1;
-					String line = null;
-					try {
-						if (mLineOffset + mLineLength <= mLineBuffer.length)
-							line = new String(mLineBuffer, mLineOffset,
-									mLineLength, "utf-8");
-						else {
-							byte[] temp = new byte[mLineLength];
-							int part1 = mLineBuffer.length - mLineOffset;
-							int part2 = (mLineOffset + mLineLength)
-									% mLineBuffer.length;
-							System.arraycopy(mLineBuffer, mLineOffset, temp, 0,
-									part1);
-							System.arraycopy(mLineBuffer, 0, temp, part1, part2);
-							line = new String(temp, 0, mLineLength, "utf-8");
-						}
-					} catch (UnsupportedEncodingException e) {
-					}
-					if (line != null) {
-						// Log.d("faplayer-java", line);
-						triggerCallback(line);
-					}
-					mLineOffset += mLineLength;
-					mLineOffset %= mLineBuffer.length;
-					mLineLength = 0;
-				}
-			}
-		}
-	}
+	/* the media player of libvlc, kept from one file to the next */
+	private static native boolean nativeOpen(String location);
 
-	protected void doWrite() throws IOException {
-		synchronized (mSendBuffer) {
-			int position = mSendBuffer.position();
-			mSendBuffer.flip();
-			int written = 0;
-			written = mClientChannel.write(mSendBuffer);
-			if (written < position) {
-				mSendBuffer.position(position - written);
-			}
-			mSendBuffer.compact();
-		}
-	}
+	private static native boolean nativePreroll(String location);
 
-	protected void writeBytes(String str) {
-		if (str == null || str.length() == 0)
-			return;
-		if (!str.endsWith("\n"))
-			str += "\n";
-		byte[] data = null;
-		try {
-			data = str.getBytes("utf-8");
-		} catch (UnsupportedEncodingException e) {
-		}
-		writeBytes(data);
-	}
+	private static native void nativePlay();
 
-	protected void writeBytes(byte[] data) {
-		if (data != null && data.length > 0) {
-			synchronized (mSendBuffer) {
-				mSendBuffer.put(data, 0,
-						mSendBuffer.remaining() >= data.length ? data.length
-								: mSendBuffer.remaining());
-			}
-		}
-		if (mSelector != null)
-			mSelector.wakeup();
-	}
+	private static native void nativeStop();
+
+	private static native void nativeClose();
+
+	/* read bytes, input bitrate, demux read bytes, demux bitrate, corrupted,
+	 * discontinuities, decoded video, decoded audio, displayed pictures, lost
+	 * pictures, played audio buffers, lost audio buffers */
+	private static native boolean nativeGetStats(long[] stats);
 
 	public static VLM getInstance() {
 		if (mInstance == null)
@@ -138,64 +57,24 @@ public class VLM {
 		return mInstance;
 	}
 
-	public void create(final String[] args) {
-		if (args == null || args.length != 2 || mVLMThread != null)
+	public void create() {
+		if (mVLMThread != null)
 			return;
 		mVLMThread = new Thread(new Runnable() {
 			@Override
 			public void run() {
+				long[] events = new long[4 * EVENT_BATCH];
 				for (;;) {
-					mLineOffset = 0;
-					mLineLength = 0;
-					mRecvBuffer.clear();
-					mSendBuffer.clear();
-					try {
-						mSelector = Selector.open();
-						mClientChannel = SocketChannel
-								.open(new InetSocketAddress(args[0], Integer
-										.parseInt(args[1])));
-						mClientChannel.configureBlocking(false);
-						mClientChannel.register(mSelector, SelectionKey.OP_READ
-								| SelectionKey.OP_WRITE);
-						while (true) {
-							mClientChannel
-									.register(
-											mSelector,
-											(wantRead() ? SelectionKey.OP_READ
-													: 0)
-													| (wantWrite() ? SelectionKey.OP_WRITE
-															: 0));
-							// TODO: when the connection hangs up unexpectedly,
-							// figure it out
-							int n = mSelector.select();
-							if (n < 0)
-								break;
-							Iterator<SelectionKey> it = mSelector
-									.selectedKeys().iterator();
-							while (it.hasNext()) {
-								SelectionKey key = (SelectionKey) it.next();
-								it.remove();
-								if (key.isReadable()) {
-									doRead();
-								}
-								if (key.isWritable()) {
-									doWrite();
-								}
-							}
-						}
-					} catch (IOException e) {
-						try {
-							if (mClientChannel != null)
-								mClientChannel.close();
-							if (mSelector != null)
-								mSelector.close();
-						} catch (IOException ex) {
-						}
-						try {
-							Thread.sleep(100);
-						} catch (InterruptedException ex) {
-						}
-					}
+					int n = poll(events);
+					if (n < 0)
+						break;
+					VLI handler = mCallbackHandler;
+					if (handler == null)
+						continue;
+					for (int i = 0; i < n; i++)
+						handler.onEvent((int) events[4 * i],
+								events[4 * i + 1], events[4 * i + 2],
+								events[4 * i + 3]);
 				}
 			}
 		});
@@ -203,43 +82,71 @@ public class VLM {
 	}
 
 	public void destroy() {
-		if (mVLMThread.isAlive()) {
-			mVLMThread.interrupt();
-			mVLMThread = null;
+		if (mVLMThread == null)
+			return;
+		interrupt();
+		try {
+			mVLMThread.join();
+		} catch (InterruptedException e) {
 		}
+		mVLMThread = null;
 	}
 
 	public void setCallbackHandler(VLI handler) {
 		mCallbackHandler = handler;
 	}
 
-	public void open(String file) {
-		String line;
-		line = String.format("open \"%s\"", file);
-		writeBytes(line);
+	protected void send(int cmd, long arg1, long arg2, String text) {
+		if (!command(cmd, arg1, arg2, text))
+			Log.d("faplayer-java", "no interface for command " + cmd);
+	}
+
+	/* a local path or an URL, replaces the current one */
+	public void open(String location) {
+		if (!nativeOpen(location))
+			Log.d("faplayer-java", "cannot open " + location);
+	}
+
+	/* opens the location that open() is likely to get next, ahead of time */
+	public void preroll(String location) {
+		if (!nativePreroll(location))
+			Log.d("faplayer-java", "cannot preroll " + location);
 	}
 
 	public void close() {
-		String line;
-		line = String.format("close");
-		writeBytes(line);
+		nativeClose();
 	}
 
 	public void play() {
-		String line;
-		line = String.format("play");
-		writeBytes(line);
+		nativePlay();
 	}
 
 	public void pause() {
-		String line;
-		line = String.format("pause");
-		writeBytes(line);
+		send(COMMAND_PAUSE, 0, 0, null);
 	}
 
 	public void stop() {
-		String line;
-		line = String.format("stop");
-		writeBytes(line);
+		nativeStop();
+	}
+
+	/* null when there is no media */
+	public long[] getStats() {
+		long[] stats = new long[12];
+		return nativeGetStats(stats) ? stats : null;
+	}
+
+	/* fast stops at the closest key frame, for scrubbing */
+	public void seek(int second, boolean fast) {
+		send(COMMAND_SEEK, second * 1000L, fast ? SEEK_FAST : SEEK_PRECISE,
+				null);
+	}
+
+	/* doubles the speed at each call */
+	public void fastForward() {
+		send(COMMAND_FAST_FORWARD, 0, 0, null);
+	}
+
+	public void fastBackward() {
+		send(COMMAND_FAST_BACKWARD, 0, 0, null);
 	}
 }
@@ -1,5 +1,7 @@
 #!/usr/local/bin/ruby
 
+require 'zlib'
+
 all = Hash.new
 list = `find . -name Android.mk`.split("\n")
 list.each { |l|
@@ -27,10 +29,16 @@ all.each { |k, a|
         `mv libs/armeabi/#{v} assets/lib/#{k}`
     }
 }
+# the ARMv7/NEON core, loaded by org.videolan.VLC.load() from the cache
+# under the name the plugins are linked against
+`mkdir -p assets/core/armv7`
+`mv libs/armeabi/libvlccore-7.so assets/core/armv7/libvlccore.so`
 `rm -f assets/index.txt`
 list = `cd assets && find . -type f`.split("\n")
+# path, crc32 and size: Danmaku only extracts the files that changed
 File.open('assets/index.txt', 'w') { |f|
    list.each { |l|
-        f.write(l[2..-1] + "\n")
+        data = File.open('assets/' + l[2..-1], 'rb') { |x| x.read }
+        f.write(l[2..-1] + "\t" + ("%08x" % Zlib.crc32(data)) + "\t" + data.size.to_s + "\n")
     }
 }